@@ -1,7 +1,7 @@
 #version 430
 
 layout(location = 0) in vec3 iPosition;
-layout(location = 1) in vec3 iColor;
+layout(location = 1) in uint iMaterial;
 layout(location = 2) in vec3 iNormal;
 layout(location = 3) in vec2 iTexCoord;
 
@@ -10,6 +10,12 @@ layout(location = 1) uniform mat3 uNormalMatrix;
 //layout(location = 2) uniform vec3 uLightDirection;
 
 
+// Material table, see create_material_buffer()
+layout(std140, binding = 0) uniform Materials
+{
+    vec4 uMaterialColor[256];
+};
+
 out vec3 v2fColor;
 out vec3 v2fPosition;
 out vec3 v2fNormal;
@@ -17,7 +23,7 @@ out vec2 v2fTexCoord;
 
 void main()
 {
-    v2fColor = iColor;
+    v2fColor = uMaterialColor[iMaterial].rgb;
     v2fPosition = iPosition;
     gl_Position = uProjCameraWorld * vec4(iPosition, 1.0);
     v2fNormal = normalize(uNormalMatrix * iNormal);
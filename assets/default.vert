@@ -1,6 +1,6 @@
 #version 430
 layout(location = 0) in vec3 iPosition;
-layout(location = 1) in vec3 iColor;
+layout(location = 1) in uint iMaterial;
 layout(location = 2) in vec3 iNormal;
 layout(location = 3) in vec2 iTexCoord;
 
@@ -9,13 +9,19 @@ uniform mat3 uNormalMatrix;
 //layout(location = 2) uniform vec3 uLightDirection;
 
 
+// Material table, see create_material_buffer()
+layout(std140, binding = 0) uniform Materials
+{
+    vec4 uMaterialColor[256];
+};
+
 out vec3 v2fColor;
 out vec3 v2fNormal;
 out vec2 v2fTexCoord;
 
 void main()
 {
-   v2fColor = iColor;
+   v2fColor = uMaterialColor[iMaterial].rgb;
     gl_Position = uProjCameraWorld * vec4(iPosition, 1.0);
     v2fNormal = normalize(uNormalMatrix * iNormal);
     v2fTexCoord = iTexCoord;
@@ -1,5 +1,7 @@
 #include "button.hpp"
 
+#include <algorithm>
+
 GLuint create_launch_button_vao(){
 	GLuint positionVBO = 0;
     glGenBuffers(1, &positionVBO);
@@ -60,4 +62,20 @@ GLuint create_reset_button_vao(){
     glDeleteBuffers(1, &positionVBO);
 
     return vao;
-}
\ No newline at end of file
+}
+
+bool button_contains(float const (&aPositions)[12], float aNdcX, float aNdcY){
+	// The buttons are axis-aligned rectangles: test against the bounds of
+	// their vertices.
+	float minX = aPositions[0], maxX = aPositions[0];
+	float minY = aPositions[1], maxY = aPositions[1];
+	for (std::size_t i = 2; i < 12; i += 2)
+	{
+		minX = std::min(minX, aPositions[i]);
+		maxX = std::max(maxX, aPositions[i]);
+		minY = std::min(minY, aPositions[i+1]);
+		maxY = std::max(maxY, aPositions[i+1]);
+	}
+
+	return aNdcX >= minX && aNdcX <= maxX && aNdcY >= minY && aNdcY <= maxY;
+}
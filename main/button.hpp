@@ -43,4 +43,9 @@ constexpr float const resetButColors[] = {
 GLuint create_launch_button_vao();
 GLuint create_reset_button_vao();
 
+// True if the point (aNdcX, aNdcY), in normalized device coordinates, is on
+// the button with the vertex positions aPositions (e.g. launchButPos). The
+// buttons are drawn in NDC, so this holds at any window size.
+bool button_contains(float const (&aPositions)[12], float aNdcX, float aNdcY);
+
 #endif // BUTTON_HPP_6874B39C_112D_4D34_BD85_AB81A730955B
@@ -0,0 +1,72 @@
+#include "cache_file.hpp"
+
+#include <utility>
+#include <filesystem>
+#include <system_error>
+
+#include "../support/error.hpp"
+
+std::uint64_t cache_align(std::uint64_t aOffset)
+{
+    return (aOffset + kCacheAlignment - 1) & ~std::uint64_t(kCacheAlignment - 1);
+}
+
+bool cache_section_in_file(std::uint64_t aOffset, std::uint64_t aSize, std::uint64_t aFileSize)
+{
+    return aOffset % kCacheAlignment == 0 && aOffset <= aFileSize && aSize <= aFileSize - aOffset;
+}
+
+CacheFileWriter::CacheFileWriter(std::string aPath)
+    : mPath(std::move(aPath))
+    , mTemp(mPath + ".tmp")
+{
+    mFile = std::fopen(mTemp.c_str(), "wb");
+    if (!mFile)
+        throw Error("Unable to create cache '%s'", mTemp.c_str());
+}
+
+CacheFileWriter::~CacheFileWriter()
+{
+    if (mFile)
+    {
+        std::fclose(mFile);
+        std::remove(mTemp.c_str());
+    }
+}
+
+void CacheFileWriter::section(void const* aData, std::size_t aSize)
+{
+    static char const kZeros[kCacheAlignment] = {};
+    std::size_t const padding = std::size_t(cache_align(mOffset) - mOffset);
+
+    append(kZeros, padding);
+    append(aData, aSize);
+}
+
+void CacheFileWriter::append(void const* aData, std::size_t aSize)
+{
+    if (aSize != std::fwrite(aData, 1, aSize, mFile))
+        throw Error("Unable to write cache '%s'", mTemp.c_str());
+
+    mOffset += aSize;
+}
+
+std::uint64_t CacheFileWriter::offset() const noexcept
+{
+    return mOffset;
+}
+
+void CacheFileWriter::commit()
+{
+    std::error_code ec;
+    if (0 != std::fclose(std::exchange(mFile, nullptr)))
+        ec = std::make_error_code(std::errc::io_error);
+    else
+        std::filesystem::rename(mTemp, mPath, ec);
+
+    if (ec)
+    {
+        std::remove(mTemp.c_str());
+        throw Error("Unable to write cache '%s': %s", mPath.c_str(), ec.message().c_str());
+    }
+}
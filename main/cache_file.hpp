@@ -0,0 +1,57 @@
+#ifndef CACHE_FILE_HPP_7C21B5E8_3F90_4D6A_A1E4_92D05B8C6F13
+#define CACHE_FILE_HPP_7C21B5E8_3F90_4D6A_A1E4_92D05B8C6F13
+
+#include <string>
+
+#include <cstdio>
+#include <cstddef>
+#include <cstdint>
+
+// Helpers shared by the binary caches (mesh_cache.hpp, texture_cache.hpp).
+// A cache file is a header followed by sections; each section starts at a
+// multiple of kCacheAlignment bytes, so that it can be used in place once
+// the file is mapped.
+constexpr std::size_t kCacheAlignment = 16;
+
+// aOffset rounded up to the next multiple of kCacheAlignment.
+std::uint64_t cache_align(std::uint64_t aOffset);
+
+// Whether a section of aSize bytes at aOffset is aligned, and lies within a
+// file of aFileSize bytes. Use this on offsets read from a cache before
+// trusting them.
+bool cache_section_in_file(std::uint64_t aOffset, std::uint64_t aSize, std::uint64_t aFileSize);
+
+// Writes a cache to a temporary file next to it (aPath + ".tmp"), and
+// replaces the old cache (if any) only in commit(), so that an interrupted
+// write never leaves a truncated cache behind. The temporary file is removed
+// if the writer is destroyed without commit(). Throws Error on failure.
+class CacheFileWriter
+{
+public:
+    explicit CacheFileWriter(std::string aPath);
+    ~CacheFileWriter();
+
+    CacheFileWriter(CacheFileWriter const&) = delete;
+    CacheFileWriter& operator=(CacheFileWriter const&) = delete;
+
+    // Starts a new section: pads to kCacheAlignment, then writes aSize bytes.
+    void section(void const* aData, std::size_t aSize);
+
+    // Writes aSize bytes directly after the previous ones, e.g., to fill a
+    // large section in several steps.
+    void append(void const* aData, std::size_t aSize);
+
+    // Bytes written so far
+    std::uint64_t offset() const noexcept;
+
+    // Closes the file, and renames it to the cache path.
+    void commit();
+
+private:
+    std::string mPath;
+    std::string mTemp;
+    std::FILE* mFile = nullptr;
+    std::uint64_t mOffset = 0;
+};
+
+#endif // CACHE_FILE_HPP_7C21B5E8_3F90_4D6A_A1E4_92D05B8C6F13
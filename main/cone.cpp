@@ -1,60 +1,68 @@
 #include "cone.hpp"
-#include <typeinfo>
-#include <stdexcept>
+#include <vector>
 #include "../vmlib/vec3.hpp"
-#include "../vmlib/vec4.hpp"
-#include "../vmlib/mat33.hpp"
-#include "../vmlib/mat44.cpp"
+#include "../vmlib/fast_math.hpp"
 
-SimpleMeshDataWithoutTexture make_cone( bool aCapped, std::size_t aSubdivs, Vec3f aColor, Mat44f aPreTransform )
+namespace
+{
+	// Sides: one triangle per segment, up to the tip at (1,0,0). Cap: one
+	// triangle per segment, facing -x at x = 0.
+	UnitPrimitive make_unit_cone_( bool aCapped, std::size_t aSubdivs )
+	{
+		// All angles at once; index 0 is the starting angle (0).
+		std::vector<float> angles(aSubdivs + 1), sines(aSubdivs + 1), cosines(aSubdivs + 1);
+		for (std::size_t i = 0; i <= aSubdivs; ++i)
+			angles[i] = i / float(aSubdivs) * 2.f * 3.1415926f;
+		fast_sincos_n(angles.size(), angles.data(), sines.data(), cosines.data());
+
+		UnitPrimitive ret;
+		ret.positions.reserve( cone_vertex_count( aCapped, aSubdivs ) );
+		ret.normals.reserve( cone_vertex_count( aCapped, aSubdivs ) );
+
+		auto const emit = [&ret] (Vec3f aPosition, Vec3f aNormal) {
+			ret.positions.emplace_back( aPosition );
+			ret.normals.emplace_back( aNormal );
+		};
+
+		for (std::size_t i = 0; i < aSubdivs; ++i) {
+			float const prevY = cosines[i], prevZ = sines[i];
+			float const y = cosines[i + 1], z = sines[i + 1];
+
+			emit( { 0.f, prevY, prevZ }, { 0.f, prevY, prevZ } );
+			emit( { 0.f, y, z }, { 0.f, y, z } );
+			emit( { 1.f, 0.f, 0.f }, { 1.f, 0.f, 0.f } );
+
+			if (aCapped) {
+				emit( { 0.f, 0.f, 0.f }, { -1.f, 0.f, 0.f } );
+				emit( { 0.f, y, z }, { -1.f, 0.f, 0.f } );
+				emit( { 0.f, prevY, prevZ }, { -1.f, 0.f, 0.f } );
+			}
+		}
+
+		return ret;
+	}
+
+	UnitPrimitiveCache gUnitCones_( &make_unit_cone_ );
+}
+
+std::size_t cone_vertex_count( bool aCapped, std::size_t aSubdivs )
+{
+	return (aCapped ? 6 : 3) * aSubdivs;
+}
+
+UnitPrimitive const& unit_cone( bool aCapped, std::size_t aSubdivs )
+{
+	return gUnitCones_.get( aCapped, aSubdivs );
+}
+
+void make_cone( MeshBuilder& aBuilder, bool aCapped, std::size_t aSubdivs, Vec3f aColor, Mat44f aPreTransform )
 {
-	std::vector<Vec3f> pos;
-    std::vector<Vec3f> normals;
-    float prevY = std::cos(0.f);
-    float prevZ = std::sin(0.f);
-
-    Mat33f const N = mat44_to_mat33(transpose(invert(aPreTransform)));
-
-    for (std::size_t i = 0; i < aSubdivs; ++i) {
-        float const angle = (i + 1) / float(aSubdivs) * 2.f * 3.1415926f;
-        float y = std::cos(angle);
-        float z = std::sin(angle);
-        
-        // // Use 0 for x-coordinate to create a cone
-        // pos.emplace_back(Vec3f{ 0.f, prevY, prevZ });
-        // pos.emplace_back(Vec3f{ 0.f, y, z });
-        // pos.emplace_back(Vec3f{ 1.f, 0.f, 0.f });  // Tip of the cone
-
-        Vec3f p1{0.f, prevY, prevZ};
-        Vec3f p2{0.f, y, z};
-        Vec3f p3{1.f, 0.f, 0.f};
-
-        Vec3f normal1 = normalize(p1 - Vec3f{0.f, 0.f, 0.f});
-        Vec3f normal2 = normalize(p2 - Vec3f{0.f, 0.f, 0.f});
-        Vec3f normal3 = normalize(p3 - Vec3f{0.f, 0.f, 0.f});
-
-        pos.emplace_back(p1);
-        normals.emplace_back(normal1);
-
-        pos.emplace_back(p2);
-        normals.emplace_back(normal2);
-
-        pos.emplace_back(p3);
-        normals.emplace_back(normal3);
-
-        
-        prevY = y;
-        prevZ = z;
-    }
-    
-    for (auto& p : pos) {
-        Vec4f p4{ p.x, p.y, p.z, 1.f };
-        Vec4f t = aPreTransform * p4;
-        t /= t.w;
-        p = Vec3f{ t.x, t.y, t.z };
-    }
-
-    std::vector col(pos.size(), aColor);
-    return SimpleMeshDataWithoutTexture{ std::move(pos), std::move(col), std::move(normals) };
+	instantiate_primitive( aBuilder, unit_cone( aCapped, aSubdivs ), aColor, aPreTransform );
 }
 
+SimpleMeshDataWithoutTexture make_cone( bool aCapped, std::size_t aSubdivs, Vec3f aColor, Mat44f aPreTransform )
+{
+	MeshBuilder builder( cone_vertex_count( aCapped, aSubdivs ), 1 );
+	make_cone( builder, aCapped, aSubdivs, aColor, aPreTransform );
+	return builder.release();
+}
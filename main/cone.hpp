@@ -6,6 +6,8 @@
 #include <cstdlib>
 
 #include "simple_mesh.hpp"
+#include "mesh_builder.hpp"
+#include "unit_primitive.hpp"
 
 #include "../vmlib/vec3.hpp"
 #include "../vmlib/mat44.hpp"
@@ -17,4 +19,19 @@ SimpleMeshDataWithoutTexture make_cone(
 	Mat44f aPreTransform = kIdentity44f
 );
 
+// Writes the cone into aBuilder as a new sub-mesh of cone_vertex_count()
+// vertices, by instantiating unit_cone().
+std::size_t cone_vertex_count( bool aCapped, std::size_t aSubdivs );
+
+// Memoised unit cone (see unit_primitive.hpp).
+UnitPrimitive const& unit_cone( bool aCapped, std::size_t aSubdivs );
+
+void make_cone(
+	MeshBuilder& aBuilder,
+	bool aCapped = true,
+	std::size_t aSubdivs = 16,
+	Vec3f aColor = { 1.f, 1.f, 1.f },
+	Mat44f aPreTransform = kIdentity44f
+);
+
 #endif // CONE_HPP_CB812C27_5E45_4ED9_9A7F_D66774954C29
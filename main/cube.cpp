@@ -1,14 +1,16 @@
 #include "cube.hpp"
+#include <iterator>
 #include <typeinfo>
 #include <stdexcept>
 #include "../vmlib/vec3.hpp"
 #include "../vmlib/vec4.hpp"
 #include "../vmlib/mat33.hpp"
-#include "../vmlib/mat44.cpp"
+#include "../vmlib/transform_batch.hpp"
+#include "../vmlib/vertex_normals.hpp"
 
-SimpleMeshDataWithoutTexture make_cube(Vec3f aColor, Mat44f aPreTransform)
+namespace
 {
-    std::vector<Vec3f> pos = {
+    Vec3f const kCubePositions_[] = {
         
         //one face
         {-1.0f,-1.0f,-1.0f}, {-1.0f,-1.0f, 1.0f}, {-1.0f, 1.0f, 1.0f}, 
@@ -29,26 +31,29 @@ SimpleMeshDataWithoutTexture make_cube(Vec3f aColor, Mat44f aPreTransform)
         {1.0f, 1.0f, 1.0f}, {-1.0f, 1.0f,-1.0f}, {-1.0f, 1.0f, 1.0f},
         {1.0f, 1.0f, 1.0f}, {-1.0f, 1.0f, 1.0f}, {1.0f,-1.0f, 1.0f}
     };
+}
+
+std::size_t cube_vertex_count()
+{
+    return std::size(kCubePositions_);
+}
+
+void make_cube(MeshBuilder& aBuilder, Vec3f aColor, Mat44f aPreTransform)
+{
+    auto const out = aBuilder.add_submesh(cube_vertex_count(), Material{ aColor });
+    Vec3f const* pos = kCubePositions_;
 
-    std::vector<Vec3f> normals;
-    for(size_t i = 0; i < pos.size(); i += 3)
-    {
-        Vec3f v1 = pos[i + 1] - pos[i];
-        Vec3f v2 = pos[i + 2] - pos[i];
-        Vec3f normal = normalize(cross(v1, v2));
-
-        normals.push_back(normal);
-        normals.push_back(normal);
-        normals.push_back(normal);
-    }
- 
-    for (auto& p : pos) {
-        Vec4f p4{ p.x, p.y, p.z, 1.f };
-        Vec4f t = aPreTransform * p4;
-        t /= t.w;
-        p = Vec3f{ t.x, t.y, t.z };
-    }
-    std::vector col(pos.size(), aColor);
-
-    return SimpleMeshDataWithoutTexture{ std::move(pos), std::move(col), std::move(normals)};
+    // Unindexed, so each vertex gets the normal of its own triangle.
+    compute_vertex_normals(out.count, nullptr, out.count, pos, out.normals);
+
+    Mat33f const N = normal_matrix(aPreTransform);
+    transform_points(aPreTransform, out.count, pos, out.positions);
+    transform_vectors(N, out.count, out.normals, out.normals, true);
+}
+
+SimpleMeshDataWithoutTexture make_cube(Vec3f aColor, Mat44f aPreTransform)
+{
+    MeshBuilder builder(cube_vertex_count(), 1);
+    make_cube(builder, aColor, aPreTransform);
+    return builder.release();
 }
\ No newline at end of file
@@ -6,6 +6,7 @@
 #include <cstdlib>
 
 #include "simple_mesh.hpp"
+#include "mesh_builder.hpp"
 
 #include "../vmlib/vec3.hpp"
 #include "../vmlib/mat44.hpp"
@@ -17,4 +18,14 @@ SimpleMeshDataWithoutTexture make_cube(
     Mat44f aPreTransform = kIdentity44f
 );
 
+// Writes the cube into aBuilder as a new sub-mesh of cube_vertex_count()
+// vertices.
+std::size_t cube_vertex_count();
+
+void make_cube(
+    MeshBuilder& aBuilder,
+    Vec3f aColor = { 1.f, 1.f, 1.f },
+    Mat44f aPreTransform = kIdentity44f
+);
+
 #endif // CUBE_HPP_6874B39C_112D_4D34_BD85_AB81A730955B
\ No newline at end of file
@@ -1,85 +1,79 @@
 #include "cylinder.hpp"
-#include <typeinfo>
-#include <stdexcept>
+#include <vector>
 #include "../vmlib/vec3.hpp"
-#include "../vmlib/vec4.hpp"
-#include "../vmlib/mat33.hpp"
-#include "../vmlib/mat44.cpp"
+#include "../vmlib/fast_math.hpp"
 
-SimpleMeshDataWithoutTexture make_cylinder(bool aCapped, std::size_t aSubdivs, Vec3f aColor, Mat44f aPreTransform)
+namespace
 {
-    std::vector<Vec3f> pos;
-    std::vector<Vec3f> normals;
-    
-    float prevY = std::cos(0.f);
-    float prevZ = std::sin(0.f);
+    // Sides: two triangles per segment, with radial normals. Caps: one
+    // triangle per segment and end, facing -x at x = 0 and +x at x = 1.
+    UnitPrimitive make_unit_cylinder_(bool aCapped, std::size_t aSubdivs)
+    {
+        // All angles at once; index 0 is the starting angle (0).
+        std::vector<float> angles(aSubdivs + 1), sines(aSubdivs + 1), cosines(aSubdivs + 1);
+        for (std::size_t i = 0; i <= aSubdivs; ++i)
+            angles[i] = i / float(aSubdivs) * 2.f * 3.1415926f;
+        fast_sincos_n(angles.size(), angles.data(), sines.data(), cosines.data());
 
-	Mat33f const N = mat44_to_mat33(transpose(invert(aPreTransform)));
+        UnitPrimitive ret;
+        ret.positions.reserve(cylinder_vertex_count(aCapped, aSubdivs));
+        ret.normals.reserve(cylinder_vertex_count(aCapped, aSubdivs));
 
-    for (std::size_t i = 0; i < aSubdivs; ++i) {
-        float const angle = (i + 1) / float(aSubdivs) * 2.f * 3.1415926f;
-        float y = std::cos(angle);
-        float z = std::sin(angle);
-       
-        Vec3f p1{ 0.f, prevY, prevZ };
-		Vec3f p2{ 0.f, y, z };
-		Vec3f p3{ 1.f, prevY, prevZ };
-		Vec3f p4{ 0.f, y, z };
-		Vec3f p5{ 1.f, y, z };
-		Vec3f p6{ 1.f, prevY, prevZ };
-        // base 
-		Vec3f p7{ 0.f, 0.f, 0.f };
-		Vec3f p8{ 1.f, 0.f, 0.f };
-		Vec3f p9{ 0.f, 0.f, 1.f };
+        auto const emit = [&ret] (Vec3f aPosition, Vec3f aNormal) {
+            ret.positions.emplace_back(aPosition);
+            ret.normals.emplace_back(aNormal);
+        };
 
-		Vec3f normal1 = normalize(p1 - Vec3f{ 0.f, 0.f, 0.f });
-        Vec3f normal2 = normalize(p2 - Vec3f{ 0.f, 0.f, 0.f });
-        Vec3f normal3 = normalize(p3 - Vec3f{ 0.f, 0.f, 0.f });
-        Vec3f normal4 = normalize(p4 - Vec3f{ 0.f, 0.f, 0.f });
-        Vec3f normal5 = normalize(p5 - Vec3f{ 0.f, 0.f, 0.f });
-        Vec3f normal6 = normalize(p6 - Vec3f{ 0.f, 0.f, 0.f });
-        // base
-        Vec3f normal7 = Vec3f{ 0.f, -1.f, 0.f };
-        Vec3f normal8 = Vec3f{ 0.f, -1.f, 0.f };
-        Vec3f normal9 = Vec3f{ 0.f, 1.f, 0.f };
+        for (std::size_t i = 0; i < aSubdivs; ++i) {
+            float const prevY = cosines[i], prevZ = sines[i];
+            float const y = cosines[i + 1], z = sines[i + 1];
 
-		pos.emplace_back(p1);
-		normals.emplace_back(normal1);
+            Vec3f const prevNormal{ 0.f, prevY, prevZ };
+            Vec3f const normal{ 0.f, y, z };
 
-		pos.emplace_back(p2);
-		normals.emplace_back(normal2);
+            emit({ 0.f, prevY, prevZ }, prevNormal);
+            emit({ 0.f, y, z }, normal);
+            emit({ 1.f, prevY, prevZ }, prevNormal);
 
-		pos.emplace_back(p3);
-		normals.emplace_back(normal3);
+            emit({ 0.f, y, z }, normal);
+            emit({ 1.f, y, z }, normal);
+            emit({ 1.f, prevY, prevZ }, prevNormal);
 
-		pos.emplace_back(p4);
-		normals.emplace_back(normal4);
+            if (aCapped) {
+                emit({ 0.f, 0.f, 0.f }, { -1.f, 0.f, 0.f });
+                emit({ 0.f, y, z }, { -1.f, 0.f, 0.f });
+                emit({ 0.f, prevY, prevZ }, { -1.f, 0.f, 0.f });
 
-		pos.emplace_back(p5);
-		normals.emplace_back(normal5);
+                emit({ 1.f, 0.f, 0.f }, { 1.f, 0.f, 0.f });
+                emit({ 1.f, prevY, prevZ }, { 1.f, 0.f, 0.f });
+                emit({ 1.f, y, z }, { 1.f, 0.f, 0.f });
+            }
+        }
 
-		pos.emplace_back(p6);
-		normals.emplace_back(normal6);
+        return ret;
+    }
 
-        pos.emplace_back(p7);
-		normals.emplace_back(normal7);
+    UnitPrimitiveCache gUnitCylinders_(&make_unit_cylinder_);
+}
 
-        pos.emplace_back(p8);
-		normals.emplace_back(normal8);
+std::size_t cylinder_vertex_count(bool aCapped, std::size_t aSubdivs)
+{
+    return (aCapped ? 12 : 6) * aSubdivs;
+}
 
-        pos.emplace_back(p9);
-		normals.emplace_back(normal9);
+UnitPrimitive const& unit_cylinder(bool aCapped, std::size_t aSubdivs)
+{
+    return gUnitCylinders_.get(aCapped, aSubdivs);
+}
 
-		prevY = y;
-		prevZ = z;
+void make_cylinder(MeshBuilder& aBuilder, bool aCapped, std::size_t aSubdivs, Vec3f aColor, Mat44f aPreTransform)
+{
+    instantiate_primitive(aBuilder, unit_cylinder(aCapped, aSubdivs), aColor, aPreTransform);
+}
 
-    }
-    for (auto& p : pos) {
-        Vec4f p4{ p.x, p.y, p.z, 1.f };
-        Vec4f t = aPreTransform * p4;
-        t /= t.w;
-        p = Vec3f{ t.x, t.y, t.z };
-    }
-    std::vector col(pos.size(), aColor);
-    return SimpleMeshDataWithoutTexture{ std::move(pos), std::move(col), std::move(normals) };
-}
\ No newline at end of file
+SimpleMeshDataWithoutTexture make_cylinder(bool aCapped, std::size_t aSubdivs, Vec3f aColor, Mat44f aPreTransform)
+{
+    MeshBuilder builder(cylinder_vertex_count(aCapped, aSubdivs), 1);
+    make_cylinder(builder, aCapped, aSubdivs, aColor, aPreTransform);
+    return builder.release();
+}
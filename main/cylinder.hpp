@@ -6,6 +6,8 @@
 #include <cstdlib>
 
 #include "simple_mesh.hpp"
+#include "mesh_builder.hpp"
+#include "unit_primitive.hpp"
 
 #include "../vmlib/vec3.hpp"
 #include "../vmlib/mat44.hpp"
@@ -18,4 +20,19 @@ SimpleMeshDataWithoutTexture make_cylinder(
     Mat44f aPreTransform = kIdentity44f
 );
 
+// Writes the cylinder into aBuilder as a new sub-mesh of
+// cylinder_vertex_count() vertices, by instantiating unit_cylinder().
+std::size_t cylinder_vertex_count(bool aCapped, std::size_t aSubdivs);
+
+// Memoised unit cylinder (see unit_primitive.hpp).
+UnitPrimitive const& unit_cylinder(bool aCapped, std::size_t aSubdivs);
+
+void make_cylinder(
+    MeshBuilder& aBuilder,
+    bool aCapped = true,
+    std::size_t aSubdivs = 16,
+    Vec3f aColor = { 1.f, 1.f, 1.f },
+    Mat44f aPreTransform = kIdentity44f
+);
+
 #endif // CYLINDER_HPP_E4D1E8EC_6CDA_4800_ABDD_264F643AF5DB
\ No newline at end of file
@@ -0,0 +1,135 @@
+#include "layout_benchmark.hpp"
+
+#include <vector>
+#include <algorithm>
+#include <type_traits>
+
+#include <cstdio>
+#include <cstdint>
+
+#include "../support/checkpoint.hpp"
+
+#include "../vmlib/mat33.hpp"
+#include "../vmlib/mat44.hpp"
+
+namespace
+{
+    // Same index buffer as create_indexed_vao(), so that only the vertex
+    // layout differs between the two VAOs.
+    void attach_indices_(IndexedMeshData const& aMesh, IndexedMesh& aOut, std::vector<GLuint>& aBuffers)
+    {
+        GLuint ebo = 0;
+        glGenBuffers(1, &ebo);
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, ebo);
+        aBuffers.emplace_back(ebo);
+
+        if (aMesh.positions.size() <= 65536)
+        {
+            std::vector<std::uint16_t> const indices(aMesh.indices.begin(), aMesh.indices.end());
+            glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(std::uint16_t), indices.data(), GL_STATIC_DRAW);
+            aOut.indexType = GL_UNSIGNED_SHORT;
+        }
+        else
+        {
+            glBufferData(GL_ELEMENT_ARRAY_BUFFER, aMesh.indices.size() * sizeof(std::uint32_t), aMesh.indices.data(), GL_STATIC_DRAW);
+            aOut.indexType = GL_UNSIGNED_INT;
+        }
+        aOut.indexCount = GLsizei(aMesh.indices.size());
+    }
+
+    template< typename tAttrib >
+    void attach_separate_attribute_(GLuint aIndex, GLint aSize, std::vector<tAttrib> const& aData, std::vector<GLuint>& aBuffers)
+    {
+        GLuint vbo = 0;
+        glGenBuffers(1, &vbo);
+        glBindBuffer(GL_ARRAY_BUFFER, vbo);
+        glBufferData(GL_ARRAY_BUFFER, aData.size() * sizeof(tAttrib), aData.data(), GL_STATIC_DRAW);
+        if constexpr (std::is_integral_v<tAttrib>)
+            glVertexAttribIPointer(aIndex, aSize, GL_UNSIGNED_INT, 0, 0);
+        else
+            glVertexAttribPointer(aIndex, aSize, GL_FLOAT, GL_FALSE, 0, 0);
+        glEnableVertexAttribArray(aIndex);
+        aBuffers.emplace_back(vbo);
+    }
+
+    // One buffer per attribute, as create_vao() used to do.
+    IndexedMesh create_separate_vao_(IndexedMeshData const& aMesh, std::vector<GLuint>& aBuffers)
+    {
+        IndexedMesh ret{};
+        glGenVertexArrays(1, &ret.vao);
+        glBindVertexArray(ret.vao);
+
+        attach_separate_attribute_(0, 3, aMesh.positions, aBuffers);
+        attach_separate_attribute_(1, 1, aMesh.materialIds, aBuffers);
+        attach_separate_attribute_(2, 3, aMesh.normals, aBuffers);
+        attach_separate_attribute_(3, 2, aMesh.textcoords, aBuffers);
+        if (!aMesh.tangents.empty())
+            attach_separate_attribute_(4, 4, aMesh.tangents, aBuffers);
+        attach_indices_(aMesh, ret, aBuffers);
+
+        glBindVertexArray(0);
+        glBindBuffer(GL_ARRAY_BUFFER, 0);
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+        return ret;
+    }
+
+    // GPU time in milliseconds for aDraws draws of aMesh.
+    double time_draws_(IndexedMesh const& aMesh, std::size_t aDraws, GLuint aQuery)
+    {
+        glBindVertexArray(aMesh.vao);
+
+        glBeginQuery(GL_TIME_ELAPSED, aQuery);
+        for (std::size_t i = 0; i < aDraws; ++i)
+            glDrawElements(GL_TRIANGLES, aMesh.indexCount, aMesh.indexType, nullptr);
+        glEndQuery(GL_TIME_ELAPSED);
+
+        GLuint64 ns = 0;
+        glGetQueryObjectui64v(aQuery, GL_QUERY_RESULT, &ns);
+
+        glBindVertexArray(0);
+        return ns / 1e6;
+    }
+}
+
+void benchmark_vertex_layouts(IndexedMeshData const& aMesh, GLuint aProgram, std::size_t aDraws)
+{
+    std::vector<GLuint> buffers;
+    IndexedMesh const separate = create_separate_vao_(aMesh, buffers);
+    IndexedMesh const interleaved = create_indexed_vao(aMesh);
+
+    GLuint query = 0;
+    glGenQueries(1, &query);
+
+    glUseProgram(aProgram);
+    glUniformMatrix4fv(0, 1, GL_FALSE, kIdentity44f.v);
+    glUniformMatrix3fv(1, 1, GL_FALSE, kIdentity33f.v);
+    glEnable(GL_RASTERIZER_DISCARD);
+
+    // Warm up (driver-side validation, caches), then alternate between the
+    // two layouts and keep the best time of each.
+    time_draws_(separate, 10, query);
+    time_draws_(interleaved, 10, query);
+
+    constexpr int kRounds = 5;
+    double bestSeparate = 1e30, bestInterleaved = 1e30;
+    for (int round = 0; round < kRounds; ++round)
+    {
+        bestSeparate = std::min(bestSeparate, time_draws_(separate, aDraws, query));
+        bestInterleaved = std::min(bestInterleaved, time_draws_(interleaved, aDraws, query));
+    }
+
+    glDisable(GL_RASTERIZER_DISCARD);
+    glUseProgram(0);
+    OGL_CHECKPOINT_ALWAYS();
+
+    std::printf("Vertex layout benchmark: %zu vertices, %zu triangles, %zu draws, best of %d\n",
+        aMesh.positions.size(), aMesh.indices.size() / 3, aDraws, kRounds);
+    std::printf("  separate buffers : %8.4f ms/draw\n", bestSeparate / aDraws);
+    std::printf("  interleaved      : %8.4f ms/draw (%.2fx)\n", bestInterleaved / aDraws, bestSeparate / bestInterleaved);
+
+    glDeleteQueries(1, &query);
+    glDeleteVertexArrays(1, &separate.vao);
+    glDeleteVertexArrays(1, &interleaved.vao);
+    glDeleteBuffers(1, &interleaved.materials);
+    glDeleteBuffers(GLsizei(buffers.size()), buffers.data());
+}
@@ -0,0 +1,21 @@
+#ifndef LAYOUT_BENCHMARK_HPP_110F7D5A_8953_437C_B62D_D3FAC909017C
+#define LAYOUT_BENCHMARK_HPP_110F7D5A_8953_437C_B62D_D3FAC909017C
+
+#include <glad.h>
+
+#include <cstddef>
+
+#include "simple_mesh.hpp"
+
+// Compares the GPU time for drawing aMesh from one buffer per attribute (the
+// old create_vao() layout) and from the interleaved buffer that create_vao()
+// now uses. Each layout is drawn aDraws times with aProgram; the times are
+// measured with GL_TIME_ELAPSED queries and printed to stdout.
+//
+// Rasterization is disabled (GL_RASTERIZER_DISCARD) while measuring, so that
+// the times are dominated by vertex fetch and vertex shading.
+//
+// Run main with --benchmark-layouts to benchmark the terrain mesh.
+void benchmark_vertex_layouts(IndexedMeshData const& aMesh, GLuint aProgram, std::size_t aDraws = 200);
+
+#endif // LAYOUT_BENCHMARK_HPP_110F7D5A_8953_437C_B62D_D3FAC909017C
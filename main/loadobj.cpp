@@ -2,8 +2,129 @@
 
 #include <rapidobj/rapidobj.hpp>
 
+#include <atomic>
+#include <vector>
+#include <algorithm>
+
+#include <cstdint>
+#include <cstddef>
+
 #include "../support/error.hpp"
 
+#include "../vmlib/parallel.hpp"
+#include "../vmlib/vertex_normals.hpp"
+
+namespace
+{
+	// Face corners per thread. Converting a corner is a handful of loads and
+	// stores, so smaller chunks are not worth a thread.
+	constexpr std::size_t kMinCornersPerThread_ = 64 * 1024;
+
+	// Calls aCorner(out, mesh, i) for the face corners out in [aBegin,
+	// aEnd), numbered across all shapes; corner out is corner i of mesh.
+	// aShapeOffsets[s] is the number of corners before shape s (a prefix
+	// sum, with the total at the end), so corner i of shape s goes to output
+	// vertex aShapeOffsets[s] + i, and chunks write disjoint ranges.
+	template <typename tCorner>
+	void for_each_corner_(rapidobj::Result const& aResult, std::vector<std::size_t> const& aShapeOffsets, std::size_t aBegin, std::size_t aEnd, tCorner&& aCorner)
+	{
+		// First shape that has corners in the chunk
+		std::size_t shape = std::size_t(std::upper_bound(aShapeOffsets.begin(), aShapeOffsets.end(), aBegin) - aShapeOffsets.begin()) - 1;
+
+		for (std::size_t out = aBegin; out < aEnd; ++shape)
+		{
+			auto const& mesh = aResult.shapes[shape].mesh;
+			std::size_t const first = aShapeOffsets[shape];
+			std::size_t const last = std::min(aShapeOffsets[shape + 1], aEnd);
+
+			for (; out < last; ++out)
+				aCorner(out, mesh, out - first);
+		}
+	}
+
+	// Converts the face corners [aBegin, aEnd). Corners without a normal or
+	// texture coordinate get zeros; returns false if there are any corners
+	// without a normal.
+	bool convert_corners_(rapidobj::Result const& aResult, std::vector<std::size_t> const& aShapeOffsets, std::uint32_t aDefaultMaterial, std::size_t aBegin, std::size_t aEnd, SimpleMeshData& aOut)
+	{
+		auto const& attribs = aResult.attributes;
+		std::size_t const materialCount = aResult.materials.size();
+
+		bool ret = true;
+		for_each_corner_(aResult, aShapeOffsets, aBegin, aEnd, [&] (std::size_t aOutIndex, rapidobj::Mesh const& aMesh, std::size_t aI) {
+			auto const& idx = aMesh.indices[aI];
+
+			aOut.positions[aOutIndex] = Vec3f{
+				attribs.positions[idx.position_index * 3 + 0],
+				attribs.positions[idx.position_index * 3 + 1],
+				attribs.positions[idx.position_index * 3 + 2]
+			};
+
+			int const materialId = aMesh.material_ids.empty() ? -1 : aMesh.material_ids[aI / 3];
+			aOut.materialIds[aOutIndex] = materialId < 0 || std::size_t(materialId) >= materialCount ? aDefaultMaterial : std::uint32_t(materialId);
+
+			if (idx.normal_index >= 0)
+			{
+				aOut.normals[aOutIndex] = Vec3f{
+					attribs.normals[idx.normal_index * 3 + 0],
+					attribs.normals[idx.normal_index * 3 + 1],
+					attribs.normals[idx.normal_index * 3 + 2]
+				};
+			}
+			else
+			{
+				aOut.normals[aOutIndex] = Vec3f{ 0.f, 0.f, 0.f };
+				ret = false;
+			}
+
+			if (idx.texcoord_index >= 0)
+			{
+				aOut.textcoords[aOutIndex] = Vec2f{
+					attribs.texcoords[idx.texcoord_index * 2 + 0],
+					attribs.texcoords[idx.texcoord_index * 2 + 1]
+				};
+			}
+			else
+				aOut.textcoords[aOutIndex] = Vec2f{ 0.f, 0.f };
+		});
+
+		return ret;
+	}
+
+	// Smooth normals for the corners without one (see
+	// vmlib/vertex_normals.hpp). The triangles are indexed by the OBJ's
+	// positions, so faces that share a position share its normal even
+	// across shapes, texture seams and materials.
+	void generate_missing_normals_(rapidobj::Result const& aResult, std::vector<std::size_t> const& aShapeOffsets, SimpleMeshData& aOut)
+	{
+		auto const& attribs = aResult.attributes;
+		std::size_t const count = aShapeOffsets.back();
+
+		std::vector<std::uint32_t> indices(count);
+		parallel_for(count, kMinCornersPerThread_, [&] (std::size_t aBegin, std::size_t aEnd) {
+			for_each_corner_(aResult, aShapeOffsets, aBegin, aEnd, [&] (std::size_t aOutIndex, rapidobj::Mesh const& aMesh, std::size_t aI) {
+				indices[aOutIndex] = std::uint32_t(aMesh.indices[aI].position_index);
+			});
+		});
+
+		std::size_t const positionCount = attribs.positions.size() / 3;
+		std::vector<Vec3f> positions(positionCount);
+		for (std::size_t i = 0; i < positionCount; ++i)
+			positions[i] = Vec3f{ attribs.positions[3 * i + 0], attribs.positions[3 * i + 1], attribs.positions[3 * i + 2] };
+
+		std::vector<Vec3f> normals(positionCount);
+		compute_vertex_normals(count, indices.data(), positionCount, positions.data(), normals.data());
+
+		parallel_for(count, kMinCornersPerThread_, [&] (std::size_t aBegin, std::size_t aEnd) {
+			for (std::size_t i = aBegin; i < aEnd; ++i)
+			{
+				if (0.f == dot(aOut.normals[i], aOut.normals[i]))
+					aOut.normals[i] = normals[indices[i]];
+			}
+		});
+	}
+}
+
 SimpleMeshData load_wavefront_obj(char const* aPath)
 {
 	auto result = rapidobj::ParseFile(aPath);
@@ -11,34 +132,53 @@ SimpleMeshData load_wavefront_obj(char const* aPath)
 		throw Error("Unable to load OBJ file �%s�: %s", aPath, result.error.code.message().c_str());
 	rapidobj::Triangulate(result);
 	SimpleMeshData ret;
-	for (auto const& shape : result.shapes){
-		for (std::size_t i = 0; i < shape.mesh.indices.size(); ++i) {
-			auto const& idx = shape.mesh.indices[i];
-			ret.positions.emplace_back(Vec3f{
-				result.attributes.positions[idx.position_index * 3 + 0],
-				result.attributes.positions[idx.position_index * 3 + 1],
-				result.attributes.positions[idx.position_index * 3 + 2] 
-				}
-			);
-			auto const& mat = result.materials[shape.mesh.material_ids[i / 3]];
-			ret.colors.emplace_back(Vec3f{
-				mat.ambient[0],
-				mat.ambient[1],
-				mat.ambient[2]
-				}
-			);
-			ret.normals.emplace_back(Vec3f{
-				result.attributes.normals[idx.normal_index * 3 + 0],
-				result.attributes.normals[idx.normal_index * 3 + 1],
-				result.attributes.normals[idx.normal_index * 3 + 2],
-				}
-			);
-			ret.textcoords.emplace_back(Vec2f{
-				result.attributes.texcoords[idx.texcoord_index * 2 + 0],
-				result.attributes.texcoords[idx.texcoord_index * 2 + 1]
-				}
-			);
-		}
+
+	// One material per MTL entry, in the same order, so that the material
+	// ids of the faces can be used as they are. Faces without a material
+	// (id -1, or an OBJ without MTL) use an extra white material at the end.
+	for (auto const& mat : result.materials)
+		ret.materials.emplace_back(Material{ Vec3f{ mat.ambient[0], mat.ambient[1], mat.ambient[2] } });
+
+	std::uint32_t const defaultMaterial = std::uint32_t(ret.materials.size());
+	bool usesDefault = false;
+
+	// Output size: one vertex per face corner. The prefix sum over the shapes
+	// tells each chunk where its corners go.
+	std::vector<std::size_t> shapeOffsets(result.shapes.size() + 1, 0);
+	for (std::size_t s = 0; s < result.shapes.size(); ++s)
+	{
+		auto const& mesh = result.shapes[s].mesh;
+		shapeOffsets[s + 1] = shapeOffsets[s] + mesh.indices.size();
+
+		// Per face, so this is cheap next to the conversion itself
+		usesDefault = usesDefault || mesh.material_ids.empty() || std::any_of(mesh.material_ids.begin(), mesh.material_ids.end(), [&result] (std::int32_t aId) {
+			return aId < 0 || std::size_t(aId) >= result.materials.size();
+		});
 	}
+
+	std::size_t const count = shapeOffsets.back();
+	ret.positions.resize(count);
+	ret.materialIds.resize(count);
+	ret.normals.resize(count);
+	ret.textcoords.resize(count);
+
+	std::atomic<bool> hasNormals{ true };
+	parallel_for(count, kMinCornersPerThread_, [&] (std::size_t aBegin, std::size_t aEnd) {
+		if (!convert_corners_(result, shapeOffsets, defaultMaterial, aBegin, aEnd, ret))
+			hasNormals = false;
+	});
+
+	if (!hasNormals)
+		generate_missing_normals_(result, shapeOffsets, ret);
+
+	if (usesDefault)
+		ret.materials.emplace_back(Material{ Vec3f{ 1.f, 1.f, 1.f } });
+	return ret;
+}
+
+IndexedMeshData load_wavefront_obj_indexed(char const* aPath)
+{
+	IndexedMeshData ret = weld_vertices(load_wavefront_obj(aPath));
+	generate_tangents(ret);
 	return ret;
 }
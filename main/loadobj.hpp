@@ -5,4 +5,8 @@
 
 SimpleMeshData load_wavefront_obj(char const* aPath);
 
+// As load_wavefront_obj(), but with identical vertices merged (see
+// weld_vertices()), and with tangents (see generate_tangents()).
+IndexedMeshData load_wavefront_obj_indexed(char const* aPath);
+
 #endif // LOADOBJ_HPP_2CF735BE_6624_413E_B6DC_B5BBA337F96F
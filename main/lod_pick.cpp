@@ -0,0 +1,148 @@
+#include "lod_pick.hpp"
+
+#include <utility>
+#include <algorithm>
+#include <unordered_map>
+
+#include <cstring>
+
+namespace
+{
+    // The mapped cache holds the buffers as they are uploaded (see
+    // interleave_vertices() and pack_indices()).
+    std::uint32_t mapped_index_(MappedLodMesh const& aMesh, std::size_t aI)
+    {
+        auto const* packed = static_cast<std::uint8_t const*>(aMesh.indices);
+        if (GL_UNSIGNED_SHORT == aMesh.indexType)
+        {
+            std::uint16_t index;
+            std::memcpy(&index, packed + aI * sizeof(std::uint16_t), sizeof(std::uint16_t));
+            return index;
+        }
+
+        std::uint32_t index;
+        std::memcpy(&index, packed + aI * sizeof(std::uint32_t), sizeof(std::uint32_t));
+        return index;
+    }
+
+    Vec3f mapped_position_(MappedLodMesh const& aMesh, std::uint32_t aVertex)
+    {
+        std::size_t const stride = interleaved_vertex_size(aMesh.hasTextcoords);
+        auto const* vertices = static_cast<std::uint8_t const*>(aMesh.vertices);
+
+        Vec3f ret;
+        std::memcpy(&ret, vertices + aVertex * stride, sizeof(Vec3f));
+        return ret;
+    }
+
+    std::uint64_t memory_(Bvh const& aBvh)
+    {
+        return aBvh.nodes.size() * sizeof(BvhNode) + aBvh.packets.size() * sizeof(BvhPacket);
+    }
+}
+
+LodPicker::LodPicker(MappedLodMesh aMesh, std::uint64_t aMemoryBudget)
+    : mMapped(std::move(aMesh))
+    , mMemoryBudget(aMemoryBudget)
+    , mBvhs(mMapped->parts.size())
+    , mLastUse(mMapped->parts.size(), 0)
+{}
+
+LodPicker::LodPicker(LodMeshData aData, std::uint64_t aMemoryBudget)
+    : mPositions(std::move(aData.mesh.positions))
+    , mIndices(std::move(aData.mesh.indices))
+    , mParts(std::move(aData.parts))
+    , mMemoryBudget(aMemoryBudget)
+    , mBvhs(mParts.size())
+    , mLastUse(mParts.size(), 0)
+{}
+
+std::optional<RayHit> LodPicker::intersect(Rayf const& aRay, float aMaxT)
+{
+    auto const& parts = parts_();
+
+    // Parts that the ray reaches, nearest first
+    std::vector<std::pair<float, std::size_t>> candidates;
+    for (std::size_t i = 0; i < parts.size(); ++i)
+    {
+        if (auto const t = ::intersect(parts[i].bounds, aRay, aMaxT))
+            candidates.emplace_back(*t, i);
+    }
+    std::sort(candidates.begin(), candidates.end());
+
+    ++mQueryCount;
+
+    std::optional<RayHit> ret;
+    float closest = aMaxT;
+    for (auto const& [entry, i] : candidates)
+    {
+        if (entry >= closest)
+            break;
+
+        if (!mBvhs[i])
+        {
+            mBvhs[i] = build_part_bvh_(parts[i]);
+            mMemoryUsed += memory_(*mBvhs[i]);
+            trim_(i);
+        }
+        mLastUse[i] = mQueryCount;
+
+        if (auto hit = ::intersect(*mBvhs[i], aRay, closest))
+        {
+            hit->triangle += parts[i].levels.front().firstIndex / 3;
+            closest = hit->t;
+            ret = hit;
+        }
+    }
+
+    return ret;
+}
+
+std::vector<LodPart> const& LodPicker::parts_() const noexcept
+{
+    return mMapped ? mMapped->parts : mParts;
+}
+
+Bvh LodPicker::build_part_bvh_(LodPart const& aPart) const
+{
+    // The part's vertices are numbered anew, so that only those are copied.
+    LodLevel const& level = aPart.levels.front();
+
+    std::vector<std::uint32_t> indices(level.indexCount);
+    std::vector<Vec3f> positions;
+    std::unordered_map<std::uint32_t, std::uint32_t> local;
+    for (std::uint32_t i = 0; i < level.indexCount; ++i)
+    {
+        std::size_t const at = std::size_t(level.firstIndex) + i;
+        std::uint32_t const vertex = mMapped ? mapped_index_(*mMapped, at) : mIndices[at];
+
+        auto const [it, fresh] = local.emplace(vertex, std::uint32_t(positions.size()));
+        if (fresh)
+            positions.emplace_back(mMapped ? mapped_position_(*mMapped, vertex) : mPositions[vertex]);
+        indices[i] = it->second;
+    }
+
+    return build_bvh(indices.size(), indices.data(), positions.data());
+}
+
+void LodPicker::trim_(std::size_t aKeep)
+{
+    while (mMemoryBudget && mMemoryUsed > mMemoryBudget)
+    {
+        // Least recently used, but not by the current query
+        std::size_t oldest = mBvhs.size();
+        for (std::size_t i = 0; i < mBvhs.size(); ++i)
+        {
+            if (i == aKeep || !mBvhs[i] || mQueryCount == mLastUse[i])
+                continue;
+            if (mBvhs.size() == oldest || mLastUse[i] < mLastUse[oldest])
+                oldest = i;
+        }
+
+        if (mBvhs.size() == oldest)
+            return;
+
+        mMemoryUsed -= memory_(*mBvhs[oldest]);
+        mBvhs[oldest].reset();
+    }
+}
@@ -0,0 +1,67 @@
+#ifndef LOD_PICK_HPP_4E8B2D17_C05A_4F39_9B6E_1A73D2F8E540
+#define LOD_PICK_HPP_4E8B2D17_C05A_4F39_9B6E_1A73D2F8E540
+
+#include <limits>
+#include <vector>
+#include <optional>
+
+#include <cstddef>
+#include <cstdint>
+
+#include "../vmlib/bvh.hpp"
+
+#include "mesh_lod.hpp"
+#include "mesh_cache.hpp"
+
+// Ray queries against the full detail (level 0) of a LOD mesh, e.g. for
+// picking.
+//
+// A BVH over the whole mesh would cost about as much to build as the mesh
+// takes to load from its cache. Instead, each part gets its own BVH (see
+// vmlib/bvh.hpp) when a ray first reaches the part's bounds, built from that
+// part's triangles only. Parts are visited nearest first, and those that a
+// ray only reaches behind its closest hit are skipped, so a query builds few
+// BVHs, and parts that are never queried never get one.
+//
+// A mapped cache is read in place: a BVH build only touches the part's
+// vertices and indices, and the OS can drop those pages again. With a memory
+// budget, the BVHs together are kept below it (as far as the BVHs that one
+// query needs allow) by dropping those that were used least recently; they
+// are rebuilt when needed again. So picking on a streamed mesh (see
+// obj_stream.hpp) stays within the import's budget.
+class LodPicker
+{
+public:
+    LodPicker() = default;
+
+    // Keeps the mapped cache, e.g., after create_lod_vao() has uploaded it.
+    // aMemoryBudget is in bytes; zero means no limit.
+    explicit LodPicker(MappedLodMesh aMesh, std::uint64_t aMemoryBudget = 0);
+
+    // Keeps the positions, indices and parts of aData.
+    explicit LodPicker(LodMeshData aData, std::uint64_t aMemoryBudget = 0);
+
+    // Closest hit with 0 < t < aMaxT, if any. The hit's triangle is the
+    // triangle's position in the mesh's indices (index / 3).
+    std::optional<RayHit> intersect(Rayf const& aRay, float aMaxT = std::numeric_limits<float>::infinity());
+
+private:
+    std::vector<LodPart> const& parts_() const noexcept;
+    Bvh build_part_bvh_(LodPart const&) const;
+    void trim_(std::size_t aKeep);
+
+    std::optional<MappedLodMesh> mMapped;
+    std::vector<Vec3f> mPositions;
+    std::vector<std::uint32_t> mIndices;
+    std::vector<LodPart> mParts;
+
+    std::uint64_t mMemoryBudget = 0;
+    std::uint64_t mMemoryUsed = 0;
+    std::uint64_t mQueryCount = 0;
+
+    // Per part
+    std::vector<std::optional<Bvh>> mBvhs;
+    std::vector<std::uint64_t> mLastUse; // query count
+};
+
+#endif // LOD_PICK_HPP_4E8B2D17_C05A_4F39_9B6E_1A73D2F8E540
@@ -4,11 +4,20 @@
 #include <GLFW/glfw3.h>
 #include <GL/gl.h>
 
+#include <future>
+#include <array>
+#include <vector>
+#include <utility>
+#include <optional>
+#include <filesystem>
 #include <typeinfo>
+#include <algorithm>
 #include <stdexcept>
 
 #include <cstdio>
+#include <cstdint>
 #include <cstdlib>
+#include <cstring>
 
 #include "../support/error.hpp"
 #include "../support/program.hpp"
@@ -18,15 +27,29 @@
 #include "../vmlib/vec4.hpp"
 #include "../vmlib/mat44.hpp"
 #include "../vmlib/mat33.hpp"
-#include "../vmlib/mat44.cpp"
+#include "../vmlib/mat44_expr.hpp"
+#include "../vmlib/mat44_simd.hpp"
+#include "../vmlib/model_transform.hpp"
+#include "../vmlib/quat.hpp"
+#include "../vmlib/bounds.hpp"
+#include "../vmlib/frustum.hpp"
+#include "../vmlib/fast_math.hpp"
+#include "../vmlib/bvh.hpp"
 #include "defaults.hpp"
 #include "loadobj.hpp"
 #include "texture.hpp"
+#include "texture_cache.hpp"
 #include "simple_mesh.hpp"
+#include "mesh_builder.hpp"
 #include "cylinder.hpp"
 #include "cone.hpp"
 #include "cube.hpp"
 #include "button.hpp"
+#include "layout_benchmark.hpp"
+#include "mesh_lod.hpp"
+#include "mesh_cache.hpp"
+#include "lod_pick.hpp"
+#include "obj_stream.hpp"
 namespace
 {
 	constexpr char const* kWindowTitle = "COMP3811 - CW2";
@@ -34,10 +57,54 @@ namespace
 
 	constexpr float kMovementPerSecond_ = 5.f; // units per second
 	constexpr float kMouseSensitivity_ = 0.01f; // radians per
+
+	// Matrices need to be transposed on upload unless vmlib stores them in
+	// column-major order (see kMatrixLayout).
+	constexpr GLboolean kMatrixTranspose_ = MatrixLayout::columnMajor == kMatrixLayout ? GL_FALSE : GL_TRUE;
+
+	// Objects that never move. Their world space bounds are computed once
+	// and culled against the view frustum in a single batch each frame. The
+	// terrain is split into patches; patch i is object kTerrainObject_ + i.
+	enum StaticObject_
+	{
+		kPadObject_,
+		kPad2Object_,
+		kTerrainObject_
+	};
+
+	// Level of detail: the terrain is split into kTerrainPatches_ x
+	// kTerrainPatches_ patches, and each static object is drawn at the
+	// coarsest level whose error covers at most kLodPixelError_ pixels.
+	constexpr unsigned kTerrainPatches_ = 4;
+	constexpr float kLodPixelError_ = 1.f;
+
+	// OBJ files larger than kStreamedImportSize_ bytes are imported out of
+	// core (see obj_stream.hpp), in tiles that need about
+	// kImportMemoryBudget_ bytes each.
+	constexpr std::uintmax_t kStreamedImportSize_ = 256u * 1024 * 1024;
+	constexpr std::uint64_t kImportMemoryBudget_ = 512u * 1024 * 1024;
+
+	constexpr float kFovY_ = 60.f * 3.1415926f / 180.f;
 	bool isAnimate = false;
 	bool resetAnimation = false;
 	bool splitScreen = false;
 
+	// An object that can be clicked on, through either a BVH or, for LOD
+	// meshes, a LodPicker. Both are in the object's model space; world2model
+	// moves pick rays there (see pick_()). triangleParts, if set, names the
+	// part that each of the BVH's triangles belongs to.
+	struct PickTarget_
+	{
+		char const* name;
+		Bvh const* bvh;
+		LodPicker* lod;
+		Mat44f world2model;
+		bool enabled;
+
+		std::uint8_t const* triangleParts;
+		char const* const* partNames;
+	};
+
 	struct State_
 	{
 		ShaderProgram* prog;
@@ -67,13 +134,87 @@ namespace
 			Vec3f StartingPosition;
 
 		} camControl;
+
+		// Clicks are resolved against the last frame that was drawn.
+		struct Picking_
+		{
+			Mat44f world2clip;
+			std::vector<PickTarget_> targets;
+		} picking;
 	};
 	void lightDirection(Vec3f& lightDir);
-	void drawAssets(GLuint, GLuint, std::size_t , GLuint , const Mat44f& , const Mat33f& ,GLuint , GLuint , std::size_t , const Mat44f& , const Mat44f& );
+	void drawAssets(GLuint, const LodMesh& , const LodDrawList& , GLuint , const Mat44f& , const Mat33f& ,GLuint , const LodMesh& , const ModelTransform& , const ModelTransform& , const std::uint8_t* , const std::uint8_t* );
 	void glfw_callback_error_( int, char const* );
 	void glfw_callback_motion_(GLFWwindow*, double, double);
 	void glfw_callback_key_( GLFWwindow*, int, int, int, int );
 	void glfw_callback_mouse_button_(GLFWwindow* , int , int , int);
+	void pick_(State_ const&, float aNdcX, float aNdcY);
+	void print_mesh_optimization_(char const*, MeshOptimizationReport const&);
+	void print_lod_levels_(char const*, std::vector<LodPart> const&);
+
+	// CPU side of loading a LOD mesh: the mapped cache or, if there was no
+	// usable cache, the mesh built from the OBJ.
+	struct LoadedLodMesh_
+	{
+		std::optional<MappedLodMesh> cached;
+		LodMeshData data;
+
+		// Streamed meshes are also picked within the import's memory budget
+		std::uint64_t pickMemoryBudget = 0;
+	};
+
+	LoadedLodMesh_ load_lod_mesh_(char const*, MeshCacheParams const&);
+
+	// Uploads the mesh, and then hands it to aPicker, which builds its BVHs
+	// only once they are needed (see lod_pick.hpp).
+	LodMesh create_lod_vao_(LoadedLodMesh_, LodPicker& aPicker);
+
+	// The spaceship. Its round parts are built at every circle subdivision
+	// level (see unit_primitive.hpp), and each is drawn at the level that
+	// suits its size on screen. The engines (cubes) only have one level.
+	constexpr std::size_t kSpaceshipPartCount_ = 10;
+
+	struct SpaceshipPart_
+	{
+		float radius; // model units; 0 for parts with a single level
+		std::vector<SubMesh> levels;
+	};
+
+	constexpr char const* kSpaceshipPartNames_[kSpaceshipPartCount_] = {
+		"body", "nose cone",
+		"booster 1", "booster 1 cone",
+		"booster 2", "booster 2 cone",
+		"booster 3", "booster 3 cone",
+		"engine", "engine"
+	};
+
+	struct Spaceship_
+	{
+		SimpleMeshDataWithoutTexture mesh;
+		std::array<SpaceshipPart_, kSpaceshipPartCount_> parts;
+
+		// BVH of the finest level of each part, and the part of each of its
+		// triangles.
+		Bvh pickBvh;
+		std::vector<std::uint8_t> triangleParts;
+	};
+
+	Spaceship_ make_spaceship_();
+
+	// Draws every part at its level. The spaceship's VAO must be bound.
+	void draw_spaceship_(Spaceship_ const&, float aPixelsPerUnit);
+
+	// Assets that are loaded on worker threads. None of the jobs use OpenGL;
+	// the results are uploaded on the main thread once they are needed.
+	struct AssetJobs_
+	{
+		std::future<LoadedLodMesh_> parlahti;
+		std::future<LoadedLodMesh_> landingpad;
+		std::future<CompressedImage> terrainTexture;
+		std::future<Spaceship_> spaceship;
+	};
+
+	AssetJobs_ start_loading_assets_();
 
 	struct GLFWCleanupHelper
 	{
@@ -90,8 +231,27 @@ namespace
 	}	
 }
 
-int main() try
+int main(int aArgc, char* aArgv[]) try
 {
+	// --benchmark-layouts: compare the vertex buffer layouts on the terrain
+	// and exit.
+	bool benchmarkLayouts = false;
+	for (int i = 1; i < aArgc; ++i)
+	{
+		if (0 == std::strcmp(aArgv[i], "--benchmark-layouts"))
+			benchmarkLayouts = true;
+	}
+
+	// Start loading the assets right away. The OBJ meshes, the terrain
+	// texture and the spaceship are prepared on worker threads while this
+	// thread creates the window and compiles the shaders, so startup takes
+	// about as long as the slowest job instead of the sum of all of them.
+	auto const loadStart = Clock::now();
+
+	AssetJobs_ assets;
+	if (!benchmarkLayouts)
+		assets = start_loading_assets_();
+
 	// Initialize GLFW
 	if( GLFW_TRUE != glfwInit() )
 	{
@@ -214,46 +374,32 @@ int main() try
 
 	//Create VBO and VAO
 	//Loading in map and texture
-	auto parlahtiMesh = load_wavefront_obj("assets/parlahti.obj");
-	GLuint parlahtiVAO = create_vao(parlahtiMesh);
-	std::size_t parlahtiVertex = parlahtiMesh.positions.size();
+	// The layout benchmark uses the terrain as loaded from the OBJ, without
+	// levels of detail or the mesh cache.
+	if (benchmarkLayouts)
+	{
+		auto parlahtiMesh = load_wavefront_obj_indexed("assets/parlahti.obj");
+		print_mesh_optimization_("assets/parlahti.obj", optimize_mesh(parlahtiMesh));
+		benchmark_vertex_layouts(parlahtiMesh, prog.programId());
+		return 0;
+	}
+
+	// Upload the assets as their jobs finish. get() rethrows any exception
+	// from the job.
+	LodPicker parlahtiPicker, landingpadPicker;
+	LodMesh const parlahti = create_lod_vao_(assets.parlahti.get(), parlahtiPicker);
 
-	GLuint textureID = load_texture_2d("assets/L4343A-4k.jpeg");
+	GLuint textureID = create_compressed_texture_2d(assets.terrainTexture.get());
 
 	//Load landing pad model
-	auto landingpad = load_wavefront_obj("assets/landingpad.obj");
-	GLuint landingpadVAO = create_vao(landingpad);
-	std::size_t landingpadVertex = landingpad.positions.size();
+	LodMesh const landingpadMesh = create_lod_vao_(assets.landingpad.get(), landingpadPicker);
 
 	//Create the custom model
-	auto maincylinder = make_cylinder(true, 16, {2.f, 2.f, 2.f}, make_rotation_z(3.141592f  / 2.0f) * make_scaling(2.2f, 0.2f, 0.2f)* make_translation({0.f, 0.f, 0.f}));
-	auto maincone = make_cone(true, 16, {1.f, 0.f, 0.f}, make_rotation_z(3.141592f  / 2.0f) * make_scaling(1.5f, 0.2f, 0.2f) * make_translation({1.45f, 0.f, 0.f}));
+	Spaceship_ const spaceship = assets.spaceship.get();
+	GLuint spaceshipVao = create_vao_without_texture(spaceship.mesh);
+	GLuint spaceshipMaterials = create_material_buffer(spaceship.mesh.materials);
 
-	auto cylinderbehind = make_cylinder(true, 16, {1.f, 1.f, 1.f}, make_rotation_z(3.141592f  / 2.0f) * make_scaling(0.8f, 0.1f, 0.1f)* make_translation({0.f, 2.8f, 0.f}));
-	auto conebehind = make_cone(true, 16, {1.f, 0.f, 0.f}, make_rotation_z(3.141592f  / 2.0f) * make_scaling(1.f, 0.1f, 0.1f) * make_translation({0.8f, 2.8f, 0.f}));;
-	
-	auto cylinderright = make_cylinder(true, 16, {1.f, 1.f, 1.f}, make_rotation_z(3.141592f  / 2.0f) * make_scaling(0.8f, 0.1f, 0.1f)* make_translation({0.f, 0.f, 2.f}));
-	auto coneright = make_cone(true, 16, {1.f, 0.f, 0.f}, make_rotation_z(3.141592f  / 2.0f) * make_scaling(1.f, 0.1f, 0.1f) * make_translation({0.8f, 0.f, 2.f}));
-	
-	auto cylinderleft = make_cylinder(true, 16, {1.f, 1.f, 1.f}, make_rotation_z(3.141592f  / 2.0f) * make_scaling(0.8f, 0.1f, 0.1f)* make_translation({0.f, 0.f, -2.f}));
-	auto coneleft = make_cone(true, 16, {1.f, 0.f, 0.f}, make_rotation_z(3.141592f  / 2.0f) * make_scaling(1.f, 0.1f, 0.1f) * make_translation({0.8f, 0.f, -2.f}));
-	
-	auto engine = make_cube({1.f, 0.098f, 0.2f}, make_rotation_z(3.141592f  / 2.0f) * make_scaling(0.2f, 0.1f, 0.1f)* make_translation({1.f, -2.8f, 0.f}));
-	auto engine2 = make_cube({1.f, 0.098f, 0.2f}, make_rotation_z(3.141592f  / 2.0f) * make_scaling(0.2f, 0.1f, 0.1f)* make_translation({3.2f, -2.8f, 0.f}));
-
-	SimpleMeshDataWithoutTexture spaceship = maincylinder;
-	spaceship = concatenate(std::move(spaceship), maincone);
-	spaceship = concatenate(std::move(spaceship), cylinderbehind);
-	spaceship = concatenate(std::move(spaceship), conebehind);
-	spaceship = concatenate(std::move(spaceship), cylinderright);
-	spaceship = concatenate(std::move(spaceship), coneright);
-	spaceship = concatenate(std::move(spaceship), cylinderleft);
-	spaceship = concatenate(std::move(spaceship), coneleft);
-	spaceship = concatenate(std::move(spaceship), engine);
-	spaceship = concatenate(std::move(spaceship), engine2);
-
-	GLuint spaceshipVao = create_vao_without_texture(spaceship);
-	std::size_t spaceshipVertex = spaceship.positions.size();
+	std::printf("Assets loaded in %.1f ms\n", 1000.f * std::chrono::duration_cast<Secondsf>(Clock::now() - loadStart).count());
 
 	//Create the launch and reset button
 	GLuint buttonVAO1 = create_launch_button_vao();
@@ -266,6 +412,49 @@ int main() try
     Vec3f p0 = {-20.f, -0.9f, -30.f};  
 	Vec3f p1 = p0 + Vec3f({5.f, 25.f, -20.f});  
 	Vec3f p2 = p0 + Vec3f({25.f, 20.f, -20.f});
+
+	// Model transforms. The terrain and the landing pads never move, so their
+	// normal matrices are computed once and then reused every frame.
+	ModelTransform const terrainTransform( kIdentity44f, ModelTransform::kRigid );
+	ModelTransform const padTransform( make_translation({10.f, -0.9f, 40.f}), ModelTransform::kRigid );
+	ModelTransform const padTransform2( make_translation({-20.f, -0.9f, -30.f}), ModelTransform::kRigid );
+	ModelTransform vehicleTransform( make_translation(p0), ModelTransform::kRigid );
+
+	// Bounds for view frustum culling, and the LOD chain of each static
+	// object. (All static transforms are rigid, so the LOD errors are the
+	// same in model and in world space.)
+	Aabb3f const spaceshipBounds = make_aabb(spaceship.mesh.positions);
+
+	std::size_t const staticCount = kTerrainObject_ + parlahti.parts.size();
+	std::vector<Aabb3f> staticBounds(staticCount);
+	std::vector<LodPart const*> staticLodParts(staticCount);
+
+	staticBounds[kPadObject_] = transform_aabb(padTransform.model2world(), landingpadMesh.parts[0].bounds);
+	staticBounds[kPad2Object_] = transform_aabb(padTransform2.model2world(), landingpadMesh.parts[0].bounds);
+	staticLodParts[kPadObject_] = staticLodParts[kPad2Object_] = &landingpadMesh.parts[0];
+	for (std::size_t i = 0; i < parlahti.parts.size(); ++i)
+	{
+		staticBounds[kTerrainObject_ + i] = transform_aabb(terrainTransform.model2world(), parlahti.parts[i].bounds);
+		staticLodParts[kTerrainObject_ + i] = &parlahti.parts[i];
+	}
+
+	std::vector<std::uint8_t> staticVisible(staticCount), staticLod(staticCount);
+
+	// Meshlets of the visible terrain patches, see mesh_lod.hpp
+	LodDrawList terrainDraws;
+
+	// Clickable objects, see pick_(). The pads share the landing pad's
+	// picker.
+	// Where the vehicle is, and whether it is there at all, is updated each
+	// frame.
+	state.picking.world2clip = kIdentity44f;
+	state.picking.targets = {
+		{ "terrain", nullptr, &parlahtiPicker, terrainTransform.inverse(), true, nullptr, nullptr },
+		{ "landing pad", nullptr, &landingpadPicker, padTransform.inverse(), true, nullptr, nullptr },
+		{ "landing pad 2", nullptr, &landingpadPicker, padTransform2.inverse(), true, nullptr, nullptr },
+		{ "spaceship", &spaceship.pickBvh, nullptr, padTransform2.inverse(), true, spaceship.triangleParts.data(), kSpaceshipPartNames_ }
+	};
+	PickTarget_& vehiclePick = state.picking.targets.back();
 	
 	// // Other initialization & loading
 	// OGL_CHECKPOINT_ALWAYS();
@@ -326,8 +515,8 @@ int main() try
 		// Phi affects x and z components of the camera's movement, so it is used to maipulate the coordinates of firstPOVmovement.
 		// Coordinate of y when moving up and down is adjusted using the movementSpeed, which defaul value is 1 and increase or decrease based on the speed of the user.
 		float movementSpeed = calculateMovementSpeed(kMovementPerSecond_ * dt, 10.0f, state.camControl.actionSpeedUp, state.camControl.actionSlowDown);
-		float phiSin = sin(state.camControl.phi);
-		float phiCos = cos(state.camControl.phi);
+		float phiSin, phiCos;
+		fast_sincos(state.camControl.phi, phiSin, phiCos);
 
 		if (state.camControl.moveForward) {
 			state.camControl.FirstPOVMovement.x -= movementSpeed * phiSin;
@@ -372,9 +561,9 @@ int main() try
 		
 		// Update: compute matrices
 		// Define and compute projCameraWorld matrix
-		Mat33f normalMatrix = mat44_to_mat33(transpose(invert(kIdentity44f)));
-		//rotate around the y-axis
-		Mat44f model2world = make_rotation_y(0);
+		Mat33f normalMatrix = terrainTransform.normalMatrix();
+		//the terrain is not transformed, so this folds away in the products below
+		Mat44Identity const model2world{};
 		//rotate around x-axis with angle specified
 		Mat44f Rx = make_rotation_x(state.camControl.theta);
 		//rotate around y-axis with angle specified
@@ -382,17 +571,47 @@ int main() try
 		//translate to move objects along the x and z axis
 		//change here to for cam to move along x and z axis
 		// Mat44f T = make_translation({ 0.f, 0.f, -state.camControl.radius });
-		Mat44f T = make_translation({state.camControl.FirstPOVMovement.x, state.camControl.FirstPOVMovement.y, state.camControl.FirstPOVMovement.z});
+		Mat44Translation T{ {state.camControl.FirstPOVMovement.x, state.camControl.FirstPOVMovement.y, state.camControl.FirstPOVMovement.z} };
 		//rotations and translation to transform world to camera space which defines how the scene appears on the camera
-		Mat44f world2camera = Rx * Ry * T;
+		Mat44Affine const world2camera( Mat44Affine(Rx) * Mat44Affine(Ry) * T );
 		// displaying on 2D space
-		Mat44f projection = make_perspective_projection(
-			60.f * 3.1415926f / 180.f,
+		//typed factors (see mat44_expr.hpp), so that the products below only do the necessary multiplies
+		Mat44Perspective const projection = make_perspective_projection_expr(
+			kFovY_,
 			fbwidth / float(fbheight),
 			0.1f, 100.f
 		);
 		// rendering
 		Mat44f projCameraWorld = projection * world2camera * model2world;
+		// The other objects' matrices are projCameraWorld * their model2world,
+		// one product each with the dispatched SIMD kernel (see mat44_simd.hpp).
+
+		// View frustum culling. Both halves of the split screen use the same
+		// camera, so this is done once per frame.
+		Frustumf const frustum = make_frustum(projCameraWorld);
+		frustum_cull(frustum, staticCount, staticBounds.data(), staticVisible.data());
+
+		// Level of detail, from the distance between the camera and each
+		// visible object's bounds.
+		Vec3f const cameraPosition = -state.camControl.FirstPOVMovement;
+		for (std::size_t i = 0; i < staticCount; ++i)
+		{
+			if (!staticVisible[i])
+				continue;
+
+			float const pixelsPerUnit = pixels_per_unit(distance(staticBounds[i], cameraPosition), kFovY_, fbheight);
+			staticLod[i] = std::uint8_t(select_lod(*staticLodParts[i], pixelsPerUnit, kLodPixelError_));
+		}
+
+		// Meshlet culling of the visible terrain patches. The terrain's model
+		// space is world space, so the frustum and camera position are used
+		// as they are.
+		terrainDraws.clear();
+		for (std::size_t i = 0; i < parlahti.parts.size(); ++i)
+		{
+			if (staticVisible[kTerrainObject_ + i])
+				add_visible_meshlets(terrainDraws, parlahti, i, staticLod[kTerrainObject_ + i], frustum, cameraPosition);
+		}
 
 
 		// Draw scene
@@ -416,47 +635,54 @@ int main() try
 
 		 //Load shader program for pahlati model
 		glUseProgram(prog.programId());
-		glBindVertexArray(parlahtiVAO);
+		glBindVertexArray(parlahti.mesh.vao);
+		glBindBufferBase(GL_UNIFORM_BUFFER, kMaterialBinding, parlahti.mesh.materials);
 
 		// auto endSubmitCodeTimeforTask1_2 = std::chrono::high_resolution_clock::now();
 
 		//Bind Texture
 		glActiveTexture(GL_TEXTURE0);
 		glBindTexture(GL_TEXTURE_2D, textureID);
-		glDrawArrays(GL_TRIANGLES, 0, parlahtiVertex);
 		Vec3f lightDir = normalize({ 0.f, 1.f, -1.f });
-		glUniformMatrix4fv(0, 1, GL_TRUE, projCameraWorld.v);
-		glUniformMatrix3fv(1,1, GL_TRUE, normalMatrix.v);
+		glUniformMatrix4fv(0, 1, kMatrixTranspose_, projCameraWorld.v);
+		glUniformMatrix3fv(1,1, kMatrixTranspose_, normalMatrix.v);
 		lightDirection(lightDir);
+
+		// Back facing meshlets were dropped, so back faces must be culled
+		glEnable(GL_CULL_FACE);
+		draw_lod(parlahti, terrainDraws);
+		glDisable(GL_CULL_FACE);
 		glBindVertexArray(0);
 		glUseProgram(0);
 
 		// Program for the landing pad
 		//Different shader program for lading pad
 		glUseProgram(pad.programId());
-		//Landing pad 1
-		Mat44f model2worldPad = make_translation({10.f, -0.9f, 40.f});
-		Mat44f projCameraWorldPad = projection * world2camera * model2worldPad;
-		normalMatrix = mat44_to_mat33(transpose(invert(model2worldPad)));
-		glUniformMatrix4fv(0,1, GL_TRUE, projCameraWorldPad.v);
-		glUniformMatrix3fv(1,1, GL_TRUE, normalMatrix.v);
-		lightDirection(lightDir);
-
-		//Landing pad 2
-		Mat44f model2worldPad2 = make_translation({-20.f, -0.9f, -30.f});
-		Mat44f projCameraWorldPad2 = projection * world2camera * model2worldPad2;
-		normalMatrix = mat44_to_mat33(transpose(invert(model2worldPad2)));
-		glUniformMatrix4fv(0,1, GL_TRUE, projCameraWorldPad2.v);
-		glUniformMatrix3fv(1,1, GL_TRUE, normalMatrix.v);
-		lightDirection(lightDir);
-
 		// Measuring Peformance for Task 1.4
 		// auto startSubmitCodeTimeforTask1_4 = std::chrono::high_resolution_clock::now();
 		//Bind VAO and Draw array
-		glBindVertexArray(landingpadVAO);
-		glDrawArrays(GL_TRIANGLES, 0, landingpadVertex);
-		glBindVertexArray(landingpadVAO);
-		glDrawArrays(GL_TRIANGLES, 0, landingpadVertex);
+		glBindVertexArray(landingpadMesh.mesh.vao);
+		glBindBufferBase(GL_UNIFORM_BUFFER, kMaterialBinding, landingpadMesh.mesh.materials);
+
+		//Landing pad 1
+		if (staticVisible[kPadObject_]) {
+			Mat44f projCameraWorldPad = mat44_mul(projCameraWorld, padTransform.model2world());
+			normalMatrix = padTransform.normalMatrix();
+			glUniformMatrix4fv(0,1, kMatrixTranspose_, projCameraWorldPad.v);
+			glUniformMatrix3fv(1,1, kMatrixTranspose_, normalMatrix.v);
+			lightDirection(lightDir);
+			draw_lod(landingpadMesh, 0, staticLod[kPadObject_]);
+		}
+
+		//Landing pad 2
+		if (staticVisible[kPad2Object_]) {
+			Mat44f projCameraWorldPad2 = mat44_mul(projCameraWorld, padTransform2.model2world());
+			normalMatrix = padTransform2.normalMatrix();
+			glUniformMatrix4fv(0,1, kMatrixTranspose_, projCameraWorldPad2.v);
+			glUniformMatrix3fv(1,1, kMatrixTranspose_, normalMatrix.v);
+			lightDirection(lightDir);
+			draw_lod(landingpadMesh, 0, staticLod[kPad2Object_]);
+		}
 		glBindVertexArray(0);
 		// auto endSubmitCodeTimeforTask1_4 = std::chrono::high_resolution_clock::now();
 		//Vehicle
@@ -483,27 +709,34 @@ int main() try
         	}
 			float animationSpeed = 0.05f;
 			Vec3f tangent = normalize(quadraticBezierTangent(p0, p1, p2, t));
-			float angleRadians = atan2(-tangent.x, -tangent.z);
+			float angleRadians = fast_atan2(-tangent.x, -tangent.z);
 			if (t < 1.0f) { 
-				Mat44f model2worldVehicle = make_translation(result) * make_rotation_z(angleRadians) ;
-				Mat44f projCameraWorldVehicle = projection * world2camera * model2worldVehicle;
-				normalMatrix = mat44_to_mat33(transpose(invert(model2worldVehicle)));
-				glUniformMatrix4fv(0,1, GL_TRUE, projCameraWorldVehicle.v);
-				glUniformMatrix3fv(1,1, GL_TRUE, normalMatrix.v);
+				vehicleTransform.set(to_mat44(make_dual_quat(make_quat_rotation({0.f, 0.f, 1.f}, angleRadians), result)), ModelTransform::kRigid);
+				Mat44f projCameraWorldVehicle = mat44_mul(projCameraWorld, vehicleTransform.model2world());
+				normalMatrix = vehicleTransform.normalMatrix();
+				glUniformMatrix4fv(0,1, kMatrixTranspose_, projCameraWorldVehicle.v);
+				glUniformMatrix3fv(1,1, kMatrixTranspose_, normalMatrix.v);
 				lightDirection(lightDir);
-				glBindVertexArray(spaceshipVao);
-				glDrawArrays(GL_TRIANGLES, 0, spaceshipVertex);
+				Aabb3f const vehicleBounds = transform_aabb(vehicleTransform.model2world(), spaceshipBounds);
+				if (intersects(frustum, vehicleBounds)) {
+					glBindVertexArray(spaceshipVao);
+					glBindBufferBase(GL_UNIFORM_BUFFER, kMaterialBinding, spaceshipMaterials);
+					draw_spaceship_(spaceship, pixels_per_unit(distance(vehicleBounds, cameraPosition), kFovY_, fbheight));
+				}
 				t += dt * animationSpeed; 
 			}
 		}else{
-			Mat44f model2worldVehicle = make_translation({-20.f, -0.9f, -30.f});
-			Mat44f projCameraWorldVehicle = projection * world2camera * model2worldVehicle;
-			normalMatrix = mat44_to_mat33(transpose(invert(model2worldVehicle)));
-			glUniformMatrix4fv(0,1, GL_TRUE, projCameraWorldVehicle.v);
-			glUniformMatrix3fv(1,1, GL_TRUE, normalMatrix.v);
+			Mat44f projCameraWorldVehicle = mat44_mul(projCameraWorld, padTransform2.model2world());
+			normalMatrix = padTransform2.normalMatrix();
+			glUniformMatrix4fv(0,1, kMatrixTranspose_, projCameraWorldVehicle.v);
+			glUniformMatrix3fv(1,1, kMatrixTranspose_, normalMatrix.v);
 			lightDirection(lightDir);
-			glBindVertexArray(spaceshipVao);
-			glDrawArrays(GL_TRIANGLES, 0, spaceshipVertex);
+			Aabb3f const vehicleBounds = transform_aabb(padTransform2.model2world(), spaceshipBounds);
+			if (intersects(frustum, vehicleBounds)) {
+				glBindVertexArray(spaceshipVao);
+				glBindBufferBase(GL_UNIFORM_BUFFER, kMaterialBinding, spaceshipMaterials);
+				draw_spaceship_(spaceship, pixels_per_unit(distance(vehicleBounds, cameraPosition), kFovY_, fbheight));
+			}
 		}
 		// auto endSubmitCodeTimeforTask1_5 = std::chrono::high_resolution_clock::now();
 		glBindVertexArray(0);
@@ -583,8 +816,8 @@ int main() try
 		//Split Screen View
 		glViewport(0, 0, fbwidth / 2, fbheight);
 		glScissor(0, 0, fbwidth / 2, fbheight);
-		drawAssets(prog.programId(), parlahtiVAO, parlahtiVertex, textureID, projCameraWorld, normalMatrix, pad.programId(), landingpadVAO, landingpadVertex, 
-		projection,  world2camera);
+		drawAssets(prog.programId(), parlahti, terrainDraws, textureID, projCameraWorld, normalMatrix, pad.programId(), landingpadMesh, 
+		padTransform, padTransform2, staticVisible.data(), staticLod.data());
 		// vehicle normals
 		glUseProgram(blinn.programId());
 		Vec3f lightDir = normalize({ 0.f, 1.f, -1.f });
@@ -600,34 +833,41 @@ int main() try
         	}
 			float animationSpeed = 0.05f;
 			Vec3f tangent = normalize(quadraticBezierTangent(p0, p1, p2, t));
-			float angleRadians = atan2(-tangent.x, -tangent.z);
+			float angleRadians = fast_atan2(-tangent.x, -tangent.z);
 			if (t < 1.0f) { 
-				Mat44f model2worldVehicle = make_translation(result) * make_rotation_z(angleRadians) ;
-				Mat44f projCameraWorldVehicle = projection * world2camera * model2worldVehicle;
-				normalMatrix = mat44_to_mat33(transpose(invert(model2worldVehicle)));
-				glUniformMatrix4fv(0,1, GL_TRUE, projCameraWorldVehicle.v);
-				glUniformMatrix3fv(1,1, GL_TRUE, normalMatrix.v);
+				vehicleTransform.set(to_mat44(make_dual_quat(make_quat_rotation({0.f, 0.f, 1.f}, angleRadians), result)), ModelTransform::kRigid);
+				Mat44f projCameraWorldVehicle = mat44_mul(projCameraWorld, vehicleTransform.model2world());
+				normalMatrix = vehicleTransform.normalMatrix();
+				glUniformMatrix4fv(0,1, kMatrixTranspose_, projCameraWorldVehicle.v);
+				glUniformMatrix3fv(1,1, kMatrixTranspose_, normalMatrix.v);
 				lightDirection(lightDir);
-				glBindVertexArray(spaceshipVao);
-				glDrawArrays(GL_TRIANGLES, 0, spaceshipVertex);
+				Aabb3f const vehicleBounds = transform_aabb(vehicleTransform.model2world(), spaceshipBounds);
+				if (intersects(frustum, vehicleBounds)) {
+					glBindVertexArray(spaceshipVao);
+					glBindBufferBase(GL_UNIFORM_BUFFER, kMaterialBinding, spaceshipMaterials);
+					draw_spaceship_(spaceship, pixels_per_unit(distance(vehicleBounds, cameraPosition), kFovY_, fbheight));
+				}
 				t += dt * animationSpeed; 
 			}
 		}else{
-			Mat44f model2worldVehicle = make_translation({-20.f, -0.9f, -30.f});
-			Mat44f projCameraWorldVehicle = projection * world2camera * model2worldVehicle;
-			normalMatrix = mat44_to_mat33(transpose(invert(model2worldVehicle)));
-			glUniformMatrix4fv(0,1, GL_TRUE, projCameraWorldVehicle.v);
-			glUniformMatrix3fv(1,1, GL_TRUE, normalMatrix.v);
+			Mat44f projCameraWorldVehicle = mat44_mul(projCameraWorld, padTransform2.model2world());
+			normalMatrix = padTransform2.normalMatrix();
+			glUniformMatrix4fv(0,1, kMatrixTranspose_, projCameraWorldVehicle.v);
+			glUniformMatrix3fv(1,1, kMatrixTranspose_, normalMatrix.v);
 			lightDirection(lightDir);
-			glBindVertexArray(spaceshipVao);
-			glDrawArrays(GL_TRIANGLES, 0, spaceshipVertex);
+			Aabb3f const vehicleBounds = transform_aabb(padTransform2.model2world(), spaceshipBounds);
+			if (intersects(frustum, vehicleBounds)) {
+				glBindVertexArray(spaceshipVao);
+				glBindBufferBase(GL_UNIFORM_BUFFER, kMaterialBinding, spaceshipMaterials);
+				draw_spaceship_(spaceship, pixels_per_unit(distance(vehicleBounds, cameraPosition), kFovY_, fbheight));
+			}
 		}
 
 
 		glViewport(fbwidth / 2, 0, fbwidth / 2, fbheight);
 		glScissor(fbwidth / 2, 0, fbwidth / 2, fbheight);
-		drawAssets(prog.programId(), parlahtiVAO, parlahtiVertex, textureID, projCameraWorld, normalMatrix, pad.programId(), landingpadVAO, landingpadVertex, 
-		projection,  world2camera);
+		drawAssets(prog.programId(), parlahti, terrainDraws, textureID, projCameraWorld, normalMatrix, pad.programId(), landingpadMesh, 
+		padTransform, padTransform2, staticVisible.data(), staticLod.data());
 		// vehicle normals
 		glUseProgram(blinn.programId());
 		glUniform3f(3, 0.2f, 1.f, -1.f); 
@@ -643,30 +883,43 @@ int main() try
         	}
 			float animationSpeed = 0.05f;
 			Vec3f tangent = normalize(quadraticBezierTangent(p0, p1, p2, t));
-			float angleRadians = atan2(-tangent.x, -tangent.z);
+			float angleRadians = fast_atan2(-tangent.x, -tangent.z);
 			if (t < 1.0f) { 
-				Mat44f model2worldVehicle = make_translation(result) * make_rotation_z(angleRadians) ;
-				Mat44f projCameraWorldVehicle = projection * world2camera * model2worldVehicle;
-				normalMatrix = mat44_to_mat33(transpose(invert(model2worldVehicle)));
-				glUniformMatrix4fv(0,1, GL_TRUE, projCameraWorldVehicle.v);
-				glUniformMatrix3fv(1,1, GL_TRUE, normalMatrix.v);
+				vehicleTransform.set(to_mat44(make_dual_quat(make_quat_rotation({0.f, 0.f, 1.f}, angleRadians), result)), ModelTransform::kRigid);
+				Mat44f projCameraWorldVehicle = mat44_mul(projCameraWorld, vehicleTransform.model2world());
+				normalMatrix = vehicleTransform.normalMatrix();
+				glUniformMatrix4fv(0,1, kMatrixTranspose_, projCameraWorldVehicle.v);
+				glUniformMatrix3fv(1,1, kMatrixTranspose_, normalMatrix.v);
 				lightDirection(lightDir);
-				glBindVertexArray(spaceshipVao);
-				glDrawArrays(GL_TRIANGLES, 0, spaceshipVertex);
+				Aabb3f const vehicleBounds = transform_aabb(vehicleTransform.model2world(), spaceshipBounds);
+				if (intersects(frustum, vehicleBounds)) {
+					glBindVertexArray(spaceshipVao);
+					glBindBufferBase(GL_UNIFORM_BUFFER, kMaterialBinding, spaceshipMaterials);
+					draw_spaceship_(spaceship, pixels_per_unit(distance(vehicleBounds, cameraPosition), kFovY_, fbheight));
+				}
 				t += dt * animationSpeed; 
 			}
 		}else{
-			Mat44f model2worldVehicle = make_translation({-20.f, -0.9f, -30.f});
-			Mat44f projCameraWorldVehicle = projection * world2camera * model2worldVehicle;
-			normalMatrix = mat44_to_mat33(transpose(invert(model2worldVehicle)));
-			glUniformMatrix4fv(0,1, GL_TRUE, projCameraWorldVehicle.v);
-			glUniformMatrix3fv(1,1, GL_TRUE, normalMatrix.v);
+			Mat44f projCameraWorldVehicle = mat44_mul(projCameraWorld, padTransform2.model2world());
+			normalMatrix = padTransform2.normalMatrix();
+			glUniformMatrix4fv(0,1, kMatrixTranspose_, projCameraWorldVehicle.v);
+			glUniformMatrix3fv(1,1, kMatrixTranspose_, normalMatrix.v);
 			lightDirection(lightDir);
-			glBindVertexArray(spaceshipVao);
-			glDrawArrays(GL_TRIANGLES, 0, spaceshipVertex);
+			Aabb3f const vehicleBounds = transform_aabb(padTransform2.model2world(), spaceshipBounds);
+			if (intersects(frustum, vehicleBounds)) {
+				glBindVertexArray(spaceshipVao);
+				glBindBufferBase(GL_UNIFORM_BUFFER, kMaterialBinding, spaceshipMaterials);
+				draw_spaceship_(spaceship, pixels_per_unit(distance(vehicleBounds, cameraPosition), kFovY_, fbheight));
+			}
 		}
 	}
 		OGL_CHECKPOINT_DEBUG();	
+
+		// Clicks until the next frame pick what was just drawn.
+		state.picking.world2clip = projCameraWorld;
+		vehiclePick.world2model = isAnimate ? vehicleTransform.inverse() : padTransform2.inverse();
+		vehiclePick.enabled = !isAnimate || t < 1.f;
+
 		glfwSwapBuffers( window );
 	}
 
@@ -675,6 +928,7 @@ int main() try
 	state.prog = nullptr;
 	state.pad = nullptr;
 	state.blinn = nullptr;
+	state.picking.targets.clear();
 	return 0;
 }
 catch( std::exception const& eErr )
@@ -692,21 +946,317 @@ namespace
 		std::fprintf(stderr, "GLFW error: %s (%d)\n", aErrDesc, aErrNum);
 	}
 
-	void glfw_callback_mouse_button_(GLFWwindow* aWindow, int aButton, int aAction, int)
+	void print_mesh_optimization_(char const* aName, MeshOptimizationReport const& aReport)
 	{
-		if (GLFW_MOUSE_BUTTON_LEFT == aButton && GLFW_PRESS == aAction)
+		// Both are measured with a 16 entry FIFO cache.
+		std::printf("%s: ACMR %.3f -> %.3f, ATVR %.3f -> %.3f\n", aName,
+			aReport.before.acmr, aReport.after.acmr,
+			aReport.before.atvr, aReport.after.atvr
+		);
+	}
+
+	void print_lod_levels_(char const* aName, std::vector<LodPart> const& aParts)
+	{
+		// Triangles when all parts use level i (or their coarsest level)
+		std::size_t levels = 0;
+		for (auto const& part : aParts)
+			levels = std::max(levels, part.levels.size());
+
+		std::vector<std::size_t> triangles(levels, 0);
+		for (auto const& part : aParts)
+		{
+			for (std::size_t i = 0; i < levels; ++i)
+				triangles[i] += part.levels[std::min(i, part.levels.size()-1)].indexCount / 3;
+		}
+
+		std::printf("%s: %zu part(s), triangles per level:", aName, aParts.size());
+		for (auto const count : triangles)
+			std::printf(" %zu", count);
+		std::printf("\n");
+	}
+
+	LoadedLodMesh_ load_lod_mesh_(char const* aPath, MeshCacheParams const& aParams)
+	{
+		auto const start = Clock::now();
+		auto const elapsed_ms = [&start] {
+			return 1000.f * std::chrono::duration_cast<Secondsf>(Clock::now() - start).count();
+		};
+
+		// Large files never go through memory as a whole, so their cache is
+		// built by the streaming importer, and then loaded as any other.
+		MeshCacheParams params = aParams;
+		std::error_code ec;
+		if (std::filesystem::file_size(aPath, ec) > kStreamedImportSize_ && !ec)
+			params.memoryBudget = kImportMemoryBudget_;
+
+		LoadedLodMesh_ ret;
+		ret.pickMemoryBudget = params.memoryBudget;
+
+		// The mapped cache is uploaded as it is
+		if ((ret.cached = open_mesh_cache(aPath, params)))
+		{
+			print_lod_levels_(aPath, ret.cached->parts);
+			std::printf("%s: loaded from %s in %.1f ms\n", aPath, mesh_cache_path(aPath).c_str(), elapsed_ms());
+			return ret;
+		}
+
+		if (params.memoryBudget)
 		{
-			double xpos, ypos;
-			glfwGetCursorPos(aWindow, &xpos, &ypos);
+			auto const report = import_wavefront_obj_streamed(aPath, params);
+			std::printf("%s: streamed %llu positions, %llu triangles into %zu of %u x %u tiles\n", aPath, static_cast<unsigned long long>(report.positions), static_cast<unsigned long long>(report.triangles), report.parts, report.tilesX, report.tilesZ);
+
+			if (!(ret.cached = open_mesh_cache(aPath, params)))
+				throw Error("Unable to open '%s' after importing '%s'", mesh_cache_path(aPath).c_str(), aPath);
 
-			if (xpos >= 450.0 && xpos <= 580.0 && ypos >= 615.0 && ypos <= 690.0)
+			print_lod_levels_(aPath, ret.cached->parts);
+			std::printf("%s: loaded in %.1f ms\n", aPath, elapsed_ms());
+			return ret;
+		}
+
+		// Full processing. Welding removes the duplicate vertices of the
+		// expanded face corners; the mesh is then reordered for the vertex
+		// cache, overdraw and vertex fetch (see optimize_mesh()), and
+		// simplified into levels of detail (see mesh_lod.hpp).
+		auto mesh = load_wavefront_obj_indexed(aPath);
+		print_mesh_optimization_(aPath, optimize_mesh(mesh));
+
+		ret.data = build_lod_mesh(std::move(mesh), params.partsX, params.partsZ, params.levelCount, params.reduction);
+		print_lod_levels_(aPath, ret.data.parts);
+
+		// A missing cache only costs time, so failing to write one is not
+		// an error.
+		try
+		{
+			write_mesh_cache(aPath, params, ret.data);
+		}
+		catch (std::exception const& eErr)
+		{
+			std::fprintf(stderr, "Warning: %s\n", eErr.what());
+		}
+
+		std::printf("%s: loaded in %.1f ms\n", aPath, elapsed_ms());
+		return ret;
+	}
+
+	LodMesh create_lod_vao_(LoadedLodMesh_ aLoaded, LodPicker& aPicker)
+	{
+		if (aLoaded.cached)
+		{
+			LodMesh ret = create_lod_vao(*aLoaded.cached);
+			aPicker = LodPicker(std::move(*aLoaded.cached), aLoaded.pickMemoryBudget);
+			return ret;
+		}
+
+		LodMesh ret = create_lod_vao(aLoaded.data);
+		aPicker = LodPicker(std::move(aLoaded.data), aLoaded.pickMemoryBudget);
+		return ret;
+	}
+
+	Spaceship_ make_spaceship_()
+	{
+		enum class Shape { cylinder, cone, cube };
+		struct Part
+		{
+			Shape shape;
+			Vec3f color;
+			Mat44f transform;
+		};
+
+		Mat44f const rotation = make_rotation_z(3.141592f  / 2.0f);
+		Part const parts[kSpaceshipPartCount_] = {
+			{ Shape::cylinder, {2.f, 2.f, 2.f}, rotation * make_scaling(2.2f, 0.2f, 0.2f)* make_translation({0.f, 0.f, 0.f}) },
+			{ Shape::cone, {1.f, 0.f, 0.f}, rotation * make_scaling(1.5f, 0.2f, 0.2f) * make_translation({1.45f, 0.f, 0.f}) },
+
+			{ Shape::cylinder, {1.f, 1.f, 1.f}, rotation * make_scaling(0.8f, 0.1f, 0.1f)* make_translation({0.f, 2.8f, 0.f}) },
+			{ Shape::cone, {1.f, 0.f, 0.f}, rotation * make_scaling(1.f, 0.1f, 0.1f) * make_translation({0.8f, 2.8f, 0.f}) },
+
+			{ Shape::cylinder, {1.f, 1.f, 1.f}, rotation * make_scaling(0.8f, 0.1f, 0.1f)* make_translation({0.f, 0.f, 2.f}) },
+			{ Shape::cone, {1.f, 0.f, 0.f}, rotation * make_scaling(1.f, 0.1f, 0.1f) * make_translation({0.8f, 0.f, 2.f}) },
+
+			{ Shape::cylinder, {1.f, 1.f, 1.f}, rotation * make_scaling(0.8f, 0.1f, 0.1f)* make_translation({0.f, 0.f, -2.f}) },
+			{ Shape::cone, {1.f, 0.f, 0.f}, rotation * make_scaling(1.f, 0.1f, 0.1f) * make_translation({0.8f, 0.f, -2.f}) },
+
+			{ Shape::cube, {1.f, 0.098f, 0.2f}, rotation * make_scaling(0.2f, 0.1f, 0.1f)* make_translation({1.f, -2.8f, 0.f}) },
+			{ Shape::cube, {1.f, 0.098f, 0.2f}, rotation * make_scaling(0.2f, 0.1f, 0.1f)* make_translation({3.2f, -2.8f, 0.f}) },
+		};
+
+		// Size everything up front
+		std::size_t vertexCount = 0, subMeshCount = 0;
+		for (auto const& part : parts)
+		{
+			if (Shape::cube == part.shape)
+			{
+				vertexCount += cube_vertex_count();
+				++subMeshCount;
+				continue;
+			}
+
+			for (auto const subdivs : kCircleSubdivisionLevels)
+				vertexCount += Shape::cylinder == part.shape ? cylinder_vertex_count(true, subdivs) : cone_vertex_count(true, subdivs);
+			subMeshCount += kCircleSubdivisionLevelCount;
+		}
+
+		MeshBuilder builder(vertexCount, subMeshCount);
+
+		Spaceship_ ret;
+		for (std::size_t i = 0; i < kSpaceshipPartCount_; ++i)
+		{
+			Part const& part = parts[i];
+			SpaceshipPart_& out = ret.parts[i];
+
+			if (Shape::cube == part.shape)
+			{
+				out.radius = 0.f;
+				make_cube(builder, part.color, part.transform);
+				out.levels.emplace_back(builder.submeshes().back());
+				continue;
+			}
+
+			out.radius = transformed_unit_radius(part.transform);
+			for (auto const subdivs : kCircleSubdivisionLevels)
+			{
+				if (Shape::cylinder == part.shape)
+					make_cylinder(builder, true, subdivs, part.color, part.transform);
+				else
+					make_cone(builder, true, subdivs, part.color, part.transform);
+
+				out.levels.emplace_back(builder.submeshes().back());
+			}
+		}
+
+		ret.mesh = builder.release();
+
+		// The mesh is drawn with glDrawArrays(), so the triangles of each
+		// level are consecutive vertices.
+		std::vector<std::uint32_t> indices;
+		for (std::size_t i = 0; i < kSpaceshipPartCount_; ++i)
+		{
+			SubMesh const& finest = ret.parts[i].levels.back();
+			for (std::size_t v = 0; v < finest.vertexCount; ++v)
+				indices.emplace_back(std::uint32_t(finest.firstVertex + v));
+
+			ret.triangleParts.insert(ret.triangleParts.end(), finest.vertexCount / 3, std::uint8_t(i));
+		}
+
+		ret.pickBvh = build_bvh(indices.size(), indices.data(), ret.mesh.positions.data());
+		return ret;
+	}
+
+	void draw_spaceship_(Spaceship_ const& aShip, float aPixelsPerUnit)
+	{
+		// All parts in one call
+		std::array<GLint, kSpaceshipPartCount_> firsts;
+		std::array<GLsizei, kSpaceshipPartCount_> counts;
+		for (std::size_t i = 0; i < kSpaceshipPartCount_; ++i)
+		{
+			SpaceshipPart_ const& part = aShip.parts[i];
+
+			std::size_t const level = std::min(circle_subdivision_level(part.radius * aPixelsPerUnit, kLodPixelError_), part.levels.size() - 1);
+			firsts[i] = GLint(part.levels[level].firstVertex);
+			counts[i] = GLsizei(part.levels[level].vertexCount);
+		}
+
+		glMultiDrawArrays(GL_TRIANGLES, firsts.data(), counts.data(), GLsizei(kSpaceshipPartCount_));
+	}
+
+	AssetJobs_ start_loading_assets_()
+	{
+		MeshCacheParams terrainParams;
+		terrainParams.partsX = terrainParams.partsZ = kTerrainPatches_;
+
+		// std::launch::async: each job gets its own thread, rather than
+		// being deferred until get().
+		AssetJobs_ ret;
+		ret.parlahti = std::async(std::launch::async, load_lod_mesh_, "assets/parlahti.obj", terrainParams);
+		ret.landingpad = std::async(std::launch::async, load_lod_mesh_, "assets/landingpad.obj", MeshCacheParams{});
+		ret.terrainTexture = std::async(std::launch::async, load_compressed_image, "assets/L4343A-4k.jpeg");
+		ret.spaceship = std::async(std::launch::async, make_spaceship_);
+		return ret;
+	}
+
+	void glfw_callback_mouse_button_(GLFWwindow* aWindow, int aButton, int aAction, int)
+	{
+		if (GLFW_MOUSE_BUTTON_LEFT != aButton || GLFW_PRESS != aAction)
+			return;
+
+		// The cursor position is in window coordinates, which need not be
+		// pixels (e.g. on high DPI displays). Relative to the window's size,
+		// it maps onto the framebuffer whatever its resolution.
+		double xpos, ypos;
+		glfwGetCursorPos(aWindow, &xpos, &ypos);
+
+		int width, height;
+		glfwGetWindowSize(aWindow, &width, &height);
+		if (0 == width || 0 == height)
+			return;
+
+		float x = float(xpos / width);
+		float const y = float(ypos / height);
+
+		// In split screen, each half shows the whole view.
+		if (splitScreen)
+			x = x < 0.5f ? 2.f * x : 2.f * x - 1.f;
+
+		float const ndcX = 2.f * x - 1.f;
+		float const ndcY = 1.f - 2.f * y;
+
+		// The buttons are on top of the scene, and only drawn outside of
+		// split screen.
+		if (!splitScreen)
+		{
+			if (button_contains(launchButPos, ndcX, ndcY))
 			{
 				isAnimate = true;
-			} else if (xpos >= 705.0 && xpos <= 835.0 && ypos >= 615.0 && ypos <= 690.0){
+				return;
+			}
+			if (button_contains(resetButPos, ndcX, ndcY))
+			{
 				isAnimate = false;
 				resetAnimation = true;
+				return;
+			}
+		}
+
+		if (auto* state = static_cast<State_*>(glfwGetWindowUserPointer(aWindow)))
+			pick_(*state, ndcX, ndcY);
+	}
+
+	void pick_(State_ const& aState, float aNdcX, float aNdcY)
+	{
+		// World space ray from the near to the far plane. Moving it into
+		// each object's model space keeps its parametrisation, so the hits'
+		// distances can be compared directly.
+		Rayf const ray = make_pick_ray(mat44_invert(aState.picking.world2clip), aNdcX, aNdcY);
+
+		PickTarget_ const* closest = nullptr;
+		RayHit closestHit{ 1.f, 0, 0.f, 0.f };
+		for (auto const& target : aState.picking.targets)
+		{
+			if (!target.enabled)
+				continue;
+
+			Vec4f const o = target.world2model * Vec4f{ ray.origin.x, ray.origin.y, ray.origin.z, 1.f };
+			Vec4f const d = target.world2model * Vec4f{ ray.direction.x, ray.direction.y, ray.direction.z, 0.f };
+
+			Rayf const local{ { o.x, o.y, o.z }, { d.x, d.y, d.z } };
+			if (auto const hit = target.lod ? target.lod->intersect(local, closestHit.t) : intersect(*target.bvh, local, closestHit.t))
+			{
+				closest = &target;
+				closestHit = *hit;
 			}
 		}
+
+		if (!closest)
+		{
+			std::printf("Picked: nothing\n");
+			return;
+		}
+
+		Vec3f const p = ray.origin + closestHit.t * ray.direction;
+		if (closest->triangleParts)
+			std::printf("Picked: %s (%s) at (%.2f, %.2f, %.2f)\n", closest->name, closest->partNames[closest->triangleParts[closestHit.triangle]], p.x, p.y, p.z);
+		else
+			std::printf("Picked: %s at (%.2f, %.2f, %.2f)\n", closest->name, p.x, p.y, p.z);
 	}
 	void glfw_callback_key_(GLFWwindow* aWindow, int aKey, int, int aAction, int)
 	{
@@ -877,45 +1427,51 @@ namespace
 		glUniform3f(3, 0.9f, 0.9f, 0.6f);
 		glUniform3f(4, 0.05f, 0.05, 0.05f);
 	}
-	void drawAssets(GLuint programId, GLuint parlahtiVAO, std::size_t parlahtiVertex, GLuint textureID, const Mat44f& projCameraWorld, const Mat33f& normalMatrix,
-	GLuint padID, GLuint landingpadVAO, std::size_t landingpadVertex, const Mat44f& projection, const Mat44f& world2camera){
+	void drawAssets(GLuint programId, const LodMesh& parlahti, const LodDrawList& terrainDraws, GLuint textureID, const Mat44f& projCameraWorld, const Mat33f& normalMatrix,
+	GLuint padID, const LodMesh& landingpadMesh,
+	const ModelTransform& padTransform, const ModelTransform& padTransform2, const std::uint8_t* staticVisible, const std::uint8_t* staticLod){
 		glUseProgram(programId);
-		glBindVertexArray(parlahtiVAO);
+		glBindVertexArray(parlahti.mesh.vao);
+		glBindBufferBase(GL_UNIFORM_BUFFER, kMaterialBinding, parlahti.mesh.materials);
 
 		//Bind Texture
 		glActiveTexture(GL_TEXTURE0);
 		glBindTexture(GL_TEXTURE_2D, textureID);
-		glDrawArrays(GL_TRIANGLES, 0, parlahtiVertex);
 
 		Vec3f lightDir = normalize({ 0.f, 1.f, -1.f });
-		glUniformMatrix4fv(0, 1, GL_TRUE, projCameraWorld.v);
-		glUniformMatrix3fv(1,1, GL_TRUE, normalMatrix.v);
+		glUniformMatrix4fv(0, 1, kMatrixTranspose_, projCameraWorld.v);
+		glUniformMatrix3fv(1,1, kMatrixTranspose_, normalMatrix.v);
 		lightDirection(lightDir);
+
+		// Back facing meshlets were dropped, so back faces must be culled
+		glEnable(GL_CULL_FACE);
+		draw_lod(parlahti, terrainDraws);
+		glDisable(GL_CULL_FACE);
 		glBindVertexArray(0);
 		glUseProgram(0);
 
 		glUseProgram(padID);
 
-		Mat44f model2worldPad = make_translation({10.f, -0.9f, 40.f});
-		Mat44f projCameraWorldPad = projection * world2camera * model2worldPad;
-		Mat33f padMatrix = mat44_to_mat33(transpose(invert(model2worldPad)));
-		glUniformMatrix4fv(0,1, GL_TRUE, projCameraWorldPad.v);
-		glUniformMatrix3fv(1,1, GL_TRUE, padMatrix.v);
-		lightDirection(lightDir);
+		// //Bind VAO and Draw array
+		glBindVertexArray(landingpadMesh.mesh.vao);
+		glBindBufferBase(GL_UNIFORM_BUFFER, kMaterialBinding, landingpadMesh.mesh.materials);
 
-		//Landing pad 2
-		Mat44f model2worldPad2 = make_translation({-20.f, -0.9f, -30.f});
-		Mat44f projCameraWorldPad2 = projection * world2camera * model2worldPad2;
-		Mat33f padMatrix2  = mat44_to_mat33(transpose(invert(model2worldPad2)));
-		glUniformMatrix4fv(0,1, GL_TRUE, projCameraWorldPad2.v);
-		glUniformMatrix3fv(1,1, GL_TRUE, padMatrix2.v);
-		lightDirection(lightDir);
+		if (staticVisible[kPadObject_]) {
+			Mat44f projCameraWorldPad = mat44_mul(projCameraWorld, padTransform.model2world());
+			glUniformMatrix4fv(0,1, kMatrixTranspose_, projCameraWorldPad.v);
+			glUniformMatrix3fv(1,1, kMatrixTranspose_, padTransform.normalMatrix().v);
+			lightDirection(lightDir);
+			draw_lod(landingpadMesh, 0, staticLod[kPadObject_]);
+		}
 
-		// //Bind VAO and Draw array
-		glBindVertexArray(landingpadVAO);
-		glDrawArrays(GL_TRIANGLES, 0, landingpadVertex);
-		glBindVertexArray(landingpadVAO);
-		glDrawArrays(GL_TRIANGLES, 0, landingpadVertex);
+		//Landing pad 2
+		if (staticVisible[kPad2Object_]) {
+			Mat44f projCameraWorldPad2 = mat44_mul(projCameraWorld, padTransform2.model2world());
+			glUniformMatrix4fv(0,1, kMatrixTranspose_, projCameraWorldPad2.v);
+			glUniformMatrix3fv(1,1, kMatrixTranspose_, padTransform2.normalMatrix().v);
+			lightDirection(lightDir);
+			draw_lod(landingpadMesh, 0, staticLod[kPad2Object_]);
+		}
 		glBindVertexArray(0);
 
 		glBindVertexArray(0);
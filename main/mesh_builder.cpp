@@ -0,0 +1,57 @@
+#include "mesh_builder.hpp"
+
+#include <utility>
+#include <algorithm>
+
+MeshBuilder::MeshBuilder(std::size_t aVertexCount, std::size_t aSubMeshCount)
+{
+    reserve(aVertexCount, aSubMeshCount);
+}
+
+void MeshBuilder::reserve(std::size_t aVertexCount, std::size_t aSubMeshCount)
+{
+    mMesh.positions.reserve(aVertexCount);
+    mMesh.materialIds.reserve(aVertexCount);
+    mMesh.normals.reserve(aVertexCount);
+    mSubMeshes.reserve(aSubMeshCount);
+}
+
+MeshBuilder::Vertices MeshBuilder::add_submesh(std::size_t aVertexCount, Material const& aMaterial)
+{
+    // Few parts have distinct materials, so a linear search is enough
+    auto& materials = mMesh.materials;
+    auto const same = [&aMaterial] (Material const& aOther) {
+        return aOther.color.x == aMaterial.color.x && aOther.color.y == aMaterial.color.y && aOther.color.z == aMaterial.color.z;
+    };
+
+    std::uint32_t const material = std::uint32_t(std::find_if(materials.begin(), materials.end(), same) - materials.begin());
+    if (materials.size() == material)
+        materials.emplace_back(aMaterial);
+
+    std::size_t const first = mMesh.positions.size();
+    mSubMeshes.emplace_back(SubMesh{ first, aVertexCount, material });
+
+    mMesh.positions.resize(first + aVertexCount);
+    mMesh.materialIds.resize(first + aVertexCount, material);
+    mMesh.normals.resize(first + aVertexCount);
+
+    return Vertices{ mMesh.positions.data() + first, mMesh.normals.data() + first, aVertexCount };
+}
+
+std::size_t MeshBuilder::vertex_count() const noexcept
+{
+    return mMesh.positions.size();
+}
+
+std::vector<SubMesh> const& MeshBuilder::submeshes() const noexcept
+{
+    return mSubMeshes;
+}
+
+SimpleMeshDataWithoutTexture MeshBuilder::release()
+{
+    SimpleMeshDataWithoutTexture ret = std::move(mMesh);
+    mMesh = {};
+    mSubMeshes.clear();
+    return ret;
+}
@@ -0,0 +1,65 @@
+#ifndef MESH_BUILDER_HPP_39C436F3_FAE5_428C_BC5C_79495FBF7E26
+#define MESH_BUILDER_HPP_39C436F3_FAE5_428C_BC5C_79495FBF7E26
+
+#include <vector>
+
+#include <cstddef>
+#include <cstdint>
+
+#include "simple_mesh.hpp"
+
+#include "../vmlib/vec3.hpp"
+
+// Assembles a mesh from several parts in place.
+//
+// Chaining concatenate() copies the mesh built so far once per part, which
+// is quadratic in the number of parts and reallocates the arrays each time.
+// A MeshBuilder reserves the total up front instead (the primitives report
+// their sizes, e.g. cylinder_vertex_count()), and the make_*() overloads
+// that take a MeshBuilder write their vertices directly into its arrays.
+// Assembling a mesh is then linear in its size, and apart from the small
+// material table, does not allocate after reserve().
+//
+// Each part is recorded as a sub-mesh: the range of vertices that it
+// occupies in the result, and its material. Parts with equal materials share
+// one entry of the mesh's material table.
+struct SubMesh
+{
+    std::size_t firstVertex;
+    std::size_t vertexCount;
+    std::uint32_t material;
+};
+
+class MeshBuilder final
+{
+public:
+    MeshBuilder() = default;
+    MeshBuilder(std::size_t aVertexCount, std::size_t aSubMeshCount);
+
+    void reserve(std::size_t aVertexCount, std::size_t aSubMeshCount);
+
+    // The vertices of a new sub-mesh, for the caller to fill in. Their
+    // material ids are already set. The pointers stay valid until the next
+    // add_submesh() or release().
+    struct Vertices
+    {
+        Vec3f* positions;
+        Vec3f* normals;
+        std::size_t count;
+    };
+
+    Vertices add_submesh(std::size_t aVertexCount, Material const& aMaterial);
+
+    std::size_t vertex_count() const noexcept;
+    std::vector<SubMesh> const& submeshes() const noexcept;
+
+    // Moves the mesh out, and leaves the builder empty (read submeshes()
+    // first).
+    SimpleMeshDataWithoutTexture release();
+
+private:
+    SimpleMeshDataWithoutTexture mMesh;
+    std::vector<SubMesh> mSubMeshes;
+};
+
+#endif // MESH_BUILDER_HPP_39C436F3_FAE5_428C_BC5C_79495FBF7E26
@@ -0,0 +1,536 @@
+#include "mesh_cache.hpp"
+
+#include <limits>
+#include <utility>
+#include <algorithm>
+#include <filesystem>
+#include <type_traits>
+#include <system_error>
+
+#include <cstdio>
+#include <cassert>
+#include <cstdint>
+#include <cstring>
+
+#include "../support/error.hpp"
+
+#include "cache_file.hpp"
+#include "source_stamp.hpp"
+
+namespace
+{
+    // File layout (see cache_file.hpp).
+    //
+    //    Header_
+    //    vertices  (vertexCount x vertexStride bytes, see interleave_vertices())
+    //    indices   (indexCount x 2 or 4 bytes, see pack_indices())
+    //    parts     (partCount x PartRecord_)
+    //    levels    (levelTotal x LevelRecord_; the levels of each part are
+    //               contiguous, in part order)
+    //    materials (materialCount x MaterialRecord_)
+    //    meshlets  (meshletCount x MeshletRecord_)
+    //
+    // Increment kVersion_ whenever the layout changes, or the processing that
+    // produces the cached data (welding, optimize_mesh(), build_lod_mesh(),
+    // build_meshlets(), the streamed import of obj_stream.hpp) changes its
+    // results, so that old caches are rebuilt.
+    constexpr std::uint32_t kMagic_ = 0x48534d56; // "VMSH" in little endian
+    constexpr std::uint32_t kVersion_ = 6;
+
+    struct Header_
+    {
+        std::uint32_t magic;
+        std::uint32_t version;
+        std::uint64_t fileSize;
+
+        SourceStamp source; // OBJ
+
+        // MeshCacheParams
+        std::uint32_t partsX, partsZ;
+        std::uint32_t levelCount;
+        float reduction;
+        std::uint64_t memoryBudget;
+
+        std::uint32_t vertexCount;
+        std::uint32_t vertexStride; // bytes
+        std::uint32_t indexCount;
+        std::uint32_t indexType;
+        std::uint32_t partCount;
+        std::uint32_t levelTotal;
+        std::uint32_t materialCount;
+        std::uint32_t meshletCount;
+
+        std::uint64_t vertexOffset;
+        std::uint64_t indexOffset;
+        std::uint64_t partOffset;
+        std::uint64_t levelOffset;
+        std::uint64_t materialOffset;
+        std::uint64_t meshletOffset;
+    };
+
+    struct PartRecord_
+    {
+        float min[3];
+        float max[3];
+        std::uint32_t firstLevel;
+        std::uint32_t levelCount;
+    };
+
+    struct LevelRecord_
+    {
+        std::uint32_t firstIndex;
+        std::uint32_t indexCount;
+        float error;
+        std::uint32_t firstMeshlet;
+        std::uint32_t meshletCount;
+    };
+
+    struct MaterialRecord_
+    {
+        float color[3];
+    };
+
+    struct MeshletRecord_
+    {
+        std::uint32_t firstIndex;
+        std::uint32_t indexCount;
+        float center[3];
+        float radius;
+        float coneApex[3];
+        float coneAxis[3];
+        float coneCutoff;
+    };
+
+    static_assert(std::is_trivially_copyable_v<Header_> && 144 == sizeof(Header_), "unexpected header layout");
+    static_assert(std::is_trivially_copyable_v<PartRecord_> && 32 == sizeof(PartRecord_), "unexpected part layout");
+    static_assert(std::is_trivially_copyable_v<LevelRecord_> && 20 == sizeof(LevelRecord_), "unexpected level layout");
+    static_assert(std::is_trivially_copyable_v<MaterialRecord_> && 12 == sizeof(MaterialRecord_), "unexpected material layout");
+    static_assert(std::is_trivially_copyable_v<MeshletRecord_> && 52 == sizeof(MeshletRecord_), "unexpected meshlet layout");
+
+    // Whether all aCount indices at aIndices (which may be unaligned) are
+    // below aVertexCount. A damaged index would make the renderer and the
+    // picking read past the vertices.
+    template <typename tIndex>
+    bool indices_in_range_(unsigned char const* aIndices, std::size_t aCount, std::uint32_t aVertexCount)
+    {
+        tIndex max = 0;
+        for (std::size_t i = 0; i < aCount; ++i)
+        {
+            tIndex index;
+            std::memcpy(&index, aIndices + i * sizeof(tIndex), sizeof(tIndex));
+            max = std::max(max, index);
+        }
+        return 0 == aCount || max < aVertexCount;
+    }
+
+    // Header with everything but the section offsets and the file size, see
+    // layout_().
+    Header_ make_header_(char const* aSourcePath, MeshCacheParams const& aParams)
+    {
+        Header_ ret{};
+        ret.magic = kMagic_;
+        ret.version = kVersion_;
+
+        ret.source = make_source_stamp(aSourcePath);
+
+        ret.partsX = aParams.partsX;
+        ret.partsZ = aParams.partsZ;
+        ret.levelCount = std::uint32_t(aParams.levelCount);
+        ret.reduction = aParams.reduction;
+        ret.memoryBudget = aParams.memoryBudget;
+        return ret;
+    }
+
+    void layout_(Header_& aHeader)
+    {
+        std::uint64_t const indexSize = GL_UNSIGNED_SHORT == aHeader.indexType ? sizeof(std::uint16_t) : sizeof(std::uint32_t);
+
+        aHeader.vertexOffset = cache_align(sizeof(Header_));
+        aHeader.indexOffset = cache_align(aHeader.vertexOffset + std::uint64_t(aHeader.vertexCount) * aHeader.vertexStride);
+        aHeader.partOffset = cache_align(aHeader.indexOffset + aHeader.indexCount * indexSize);
+        aHeader.levelOffset = cache_align(aHeader.partOffset + aHeader.partCount * sizeof(PartRecord_));
+        aHeader.materialOffset = cache_align(aHeader.levelOffset + aHeader.levelTotal * sizeof(LevelRecord_));
+        aHeader.meshletOffset = cache_align(aHeader.materialOffset + aHeader.materialCount * sizeof(MaterialRecord_));
+        aHeader.fileSize = aHeader.meshletOffset + aHeader.meshletCount * sizeof(MeshletRecord_);
+    }
+
+    // Appends the records of aParts, with aIndexOffset and aMeshletOffset
+    // added to the levels' ranges.
+    void add_part_records_(std::vector<LodPart> const& aParts, std::uint32_t aIndexOffset, std::uint32_t aMeshletOffset, std::vector<PartRecord_>& aPartRecords, std::vector<LevelRecord_>& aLevelRecords)
+    {
+        for (auto const& part : aParts)
+        {
+            Aabb3f const& b = part.bounds;
+            aPartRecords.emplace_back(PartRecord_{ { b.min.x, b.min.y, b.min.z }, { b.max.x, b.max.y, b.max.z }, std::uint32_t(aLevelRecords.size()), std::uint32_t(part.levels.size()) });
+
+            for (auto const& level : part.levels)
+                aLevelRecords.emplace_back(LevelRecord_{ aIndexOffset + level.firstIndex, level.indexCount, level.error, aMeshletOffset + level.firstMeshlet, level.meshletCount });
+        }
+    }
+
+    std::vector<MaterialRecord_> make_material_records_(std::vector<Material> const& aMaterials)
+    {
+        std::vector<MaterialRecord_> ret;
+        for (auto const& material : aMaterials)
+            ret.emplace_back(MaterialRecord_{ { material.color.x, material.color.y, material.color.z } });
+        return ret;
+    }
+
+    void add_meshlet_records_(std::vector<Meshlet> const& aMeshlets, std::uint32_t aIndexOffset, std::vector<MeshletRecord_>& aRecords)
+    {
+        for (auto const& m : aMeshlets)
+        {
+            aRecords.emplace_back(MeshletRecord_{
+                aIndexOffset + m.firstIndex, m.indexCount,
+                { m.bounds.center.x, m.bounds.center.y, m.bounds.center.z }, m.bounds.radius,
+                { m.coneApex.x, m.coneApex.y, m.coneApex.z },
+                { m.coneAxis.x, m.coneAxis.y, m.coneAxis.z },
+                m.coneCutoff
+            });
+        }
+    }
+
+    // Copies aSize bytes from the start of aFrom to aTo, as one section. If
+    // aNarrow is set, aFrom holds 32-bit indices that are written as 16 bit.
+    void copy_section_(CacheFileWriter& aTo, std::FILE* aFrom, std::uint64_t aSize, bool aNarrow, char const* aPath)
+    {
+        aTo.section("", 0); // alignment
+
+        constexpr std::size_t kBlock = 1024 * 1024;
+        std::vector<std::uint8_t> block(kBlock);
+        std::vector<std::uint16_t> narrow;
+
+        std::rewind(aFrom);
+        for (std::uint64_t done = 0; done < aSize; )
+        {
+            std::size_t const size = std::size_t(std::min<std::uint64_t>(kBlock, aSize - done));
+            if (size != std::fread(block.data(), 1, size, aFrom))
+                throw Error("Unable to read temporary data of mesh cache '%s'", aPath);
+            done += size;
+
+            if (!aNarrow)
+            {
+                aTo.append(block.data(), size);
+                continue;
+            }
+
+            narrow.resize(size / sizeof(std::uint32_t));
+            for (std::size_t i = 0; i < narrow.size(); ++i)
+            {
+                std::uint32_t index;
+                std::memcpy(&index, block.data() + i * sizeof(std::uint32_t), sizeof(std::uint32_t));
+                narrow[i] = std::uint16_t(index);
+            }
+
+            aTo.append(narrow.data(), narrow.size() * sizeof(std::uint16_t));
+        }
+    }
+}
+
+std::string mesh_cache_path(char const* aSourcePath)
+{
+    return std::string(aSourcePath) + ".vmesh";
+}
+
+std::optional<MappedLodMesh> open_mesh_cache(char const* aSourcePath, MeshCacheParams const& aParams)
+{
+    std::string const path = mesh_cache_path(aSourcePath);
+
+    std::error_code ec;
+    if (!std::filesystem::exists(path, ec))
+        return {};
+
+    MappedLodMesh ret{};
+    try
+    {
+        ret.file = MappedFile(path.c_str());
+    }
+    catch (Error const&)
+    {
+        return {};
+    }
+
+    auto const* base = static_cast<unsigned char const*>(ret.file.data());
+    std::uint64_t const fileSize = ret.file.size();
+
+    // Format and parameters
+    Header_ header;
+    if (fileSize < sizeof(Header_))
+        return {};
+    std::memcpy(&header, base, sizeof(Header_));
+
+    if (kMagic_ != header.magic || kVersion_ != header.version || fileSize != header.fileSize)
+        return {};
+    if (aParams.partsX != header.partsX || aParams.partsZ != header.partsZ || aParams.levelCount != header.levelCount || aParams.reduction != header.reduction)
+        return {};
+    if (aParams.memoryBudget != header.memoryBudget)
+        return {};
+
+    if (!matches_source_stamp(aSourcePath, header.source))
+        return {};
+
+    // Sections
+    std::uint64_t const indexSize = GL_UNSIGNED_SHORT == header.indexType ? sizeof(std::uint16_t) : sizeof(std::uint32_t);
+    if (GL_UNSIGNED_SHORT != header.indexType && GL_UNSIGNED_INT != header.indexType)
+        return {};
+    if (interleaved_vertex_size(false) != header.vertexStride && interleaved_vertex_size(true) != header.vertexStride)
+        return {};
+
+    if (!cache_section_in_file(header.vertexOffset, std::uint64_t(header.vertexCount) * header.vertexStride, fileSize)
+        || !cache_section_in_file(header.indexOffset, std::uint64_t(header.indexCount) * indexSize, fileSize)
+        || !cache_section_in_file(header.partOffset, std::uint64_t(header.partCount) * sizeof(PartRecord_), fileSize)
+        || !cache_section_in_file(header.levelOffset, std::uint64_t(header.levelTotal) * sizeof(LevelRecord_), fileSize)
+        || !cache_section_in_file(header.materialOffset, std::uint64_t(header.materialCount) * sizeof(MaterialRecord_), fileSize)
+        || !cache_section_in_file(header.meshletOffset, std::uint64_t(header.meshletCount) * sizeof(MeshletRecord_), fileSize))
+    {
+        return {};
+    }
+
+    // The indices are read in full once. Their pages are needed for the
+    // upload right after anyway.
+    bool const indicesInRange = GL_UNSIGNED_SHORT == header.indexType
+        ? indices_in_range_<std::uint16_t>(base + header.indexOffset, header.indexCount, header.vertexCount)
+        : indices_in_range_<std::uint32_t>(base + header.indexOffset, header.indexCount, header.vertexCount);
+    if (!indicesInRange)
+        return {};
+
+    ret.vertices = base + header.vertexOffset;
+    ret.vertexCount = header.vertexCount;
+    ret.hasTextcoords = interleaved_vertex_size(true) == header.vertexStride;
+    ret.indices = base + header.indexOffset;
+    ret.indexCount = header.indexCount;
+    ret.indexType = GLenum(header.indexType);
+
+    // LOD parts
+    ret.parts.resize(header.partCount);
+    for (std::size_t i = 0; i < ret.parts.size(); ++i)
+    {
+        PartRecord_ record;
+        std::memcpy(&record, base + header.partOffset + i * sizeof(PartRecord_), sizeof(PartRecord_));
+        if (0 == record.levelCount || record.firstLevel > header.levelTotal || record.levelCount > header.levelTotal - record.firstLevel)
+            return {};
+
+        LodPart& part = ret.parts[i];
+        part.bounds = Aabb3f{ { record.min[0], record.min[1], record.min[2] }, { record.max[0], record.max[1], record.max[2] } };
+
+        part.levels.resize(record.levelCount);
+        for (std::size_t j = 0; j < part.levels.size(); ++j)
+        {
+            LevelRecord_ level;
+            std::memcpy(&level, base + header.levelOffset + (record.firstLevel + j) * sizeof(LevelRecord_), sizeof(LevelRecord_));
+            if (level.firstIndex > header.indexCount || level.indexCount > header.indexCount - level.firstIndex)
+                return {};
+            if (level.firstMeshlet > header.meshletCount || level.meshletCount > header.meshletCount - level.firstMeshlet)
+                return {};
+
+            part.levels[j] = LodLevel{ level.firstIndex, level.indexCount, level.error, level.firstMeshlet, level.meshletCount };
+        }
+    }
+
+    // Materials
+    if (header.materialCount > kMaxMaterials)
+        return {};
+
+    ret.materials.resize(header.materialCount);
+    for (std::size_t i = 0; i < ret.materials.size(); ++i)
+    {
+        MaterialRecord_ record;
+        std::memcpy(&record, base + header.materialOffset + i * sizeof(MaterialRecord_), sizeof(MaterialRecord_));
+        ret.materials[i] = Material{ Vec3f{ record.color[0], record.color[1], record.color[2] } };
+    }
+
+    // Meshlets
+    ret.meshlets.resize(header.meshletCount);
+    for (std::size_t i = 0; i < ret.meshlets.size(); ++i)
+    {
+        MeshletRecord_ record;
+        std::memcpy(&record, base + header.meshletOffset + i * sizeof(MeshletRecord_), sizeof(MeshletRecord_));
+        if (record.firstIndex > header.indexCount || record.indexCount > header.indexCount - record.firstIndex)
+            return {};
+
+        ret.meshlets[i] = Meshlet{
+            record.firstIndex, record.indexCount,
+            Spheref{ { record.center[0], record.center[1], record.center[2] }, record.radius },
+            Vec3f{ record.coneApex[0], record.coneApex[1], record.coneApex[2] },
+            Vec3f{ record.coneAxis[0], record.coneAxis[1], record.coneAxis[2] },
+            record.coneCutoff
+        };
+    }
+
+    return ret;
+}
+
+void write_mesh_cache(char const* aSourcePath, MeshCacheParams const& aParams, LodMeshData const& aData)
+{
+    std::vector<std::uint8_t> const vertices = interleave_vertices(aData.mesh);
+
+    GLenum indexType;
+    std::vector<std::uint8_t> const indices = pack_indices(aData.mesh, indexType);
+
+    std::vector<PartRecord_> parts;
+    std::vector<LevelRecord_> levels;
+    add_part_records_(aData.parts, 0, 0, parts, levels);
+
+    std::vector<MaterialRecord_> const materials = make_material_records_(aData.mesh.materials);
+
+    std::vector<MeshletRecord_> meshlets;
+    add_meshlet_records_(aData.meshlets, 0, meshlets);
+
+    // Header
+    Header_ header = make_header_(aSourcePath, aParams);
+    header.vertexCount = std::uint32_t(aData.mesh.positions.size());
+    header.vertexStride = std::uint32_t(interleaved_vertex_size(!aData.mesh.textcoords.empty()));
+    header.indexCount = std::uint32_t(aData.mesh.indices.size());
+    header.indexType = indexType;
+    header.partCount = std::uint32_t(parts.size());
+    header.levelTotal = std::uint32_t(levels.size());
+    header.materialCount = std::uint32_t(materials.size());
+    header.meshletCount = std::uint32_t(meshlets.size());
+    layout_(header);
+
+    CacheFileWriter file(mesh_cache_path(aSourcePath));
+    file.section(&header, sizeof(Header_));
+    file.section(vertices.data(), vertices.size());
+    file.section(indices.data(), indices.size());
+    file.section(parts.data(), parts.size() * sizeof(PartRecord_));
+    file.section(levels.data(), levels.size() * sizeof(LevelRecord_));
+    file.section(materials.data(), materials.size() * sizeof(MaterialRecord_));
+    file.section(meshlets.data(), meshlets.size() * sizeof(MeshletRecord_));
+    assert(file.offset() == header.fileSize);
+    file.commit();
+}
+
+MeshCacheWriter::MeshCacheWriter(char const* aSourcePath, MeshCacheParams const& aParams, bool aHasTextcoords)
+    : mSourcePath(aSourcePath)
+    , mParams(aParams)
+    , mHasTextcoords(aHasTextcoords)
+{
+    std::string const path = mesh_cache_path(aSourcePath);
+    char const* const suffixes[kTempCount_] = { ".vertices.tmp", ".indices.tmp", ".meshlets.tmp" };
+
+    for (std::size_t i = 0; i < kTempCount_; ++i)
+    {
+        mTempPaths[i] = path + suffixes[i];
+        mTemps[i] = std::fopen(mTempPaths[i].c_str(), "w+b");
+        if (!mTemps[i])
+        {
+            close_temps_();
+            throw Error("Unable to create '%s'", mTempPaths[i].c_str());
+        }
+    }
+}
+
+MeshCacheWriter::~MeshCacheWriter()
+{
+    close_temps_();
+}
+
+void MeshCacheWriter::add(LodMeshData const& aData)
+{
+    assert(mHasTextcoords == !aData.mesh.textcoords.empty());
+
+    // The cache stores its counts as 32 bits
+    std::uint64_t const vertexCount = mVertexCount + aData.mesh.positions.size();
+    std::uint64_t const indexCount = mIndexCount + aData.mesh.indices.size();
+    if (vertexCount > std::numeric_limits<std::uint32_t>::max() || indexCount > std::numeric_limits<std::uint32_t>::max())
+        throw Error("Mesh too large for mesh cache '%s'", mesh_cache_path(mSourcePath.c_str()).c_str());
+
+    std::vector<std::uint8_t> const vertices = interleave_vertices(aData.mesh);
+
+    std::vector<std::uint32_t> indices(aData.mesh.indices.size());
+    for (std::size_t i = 0; i < indices.size(); ++i)
+        indices[i] = std::uint32_t(mVertexCount) + aData.mesh.indices[i];
+
+    std::vector<MeshletRecord_> meshlets;
+    add_meshlet_records_(aData.meshlets, std::uint32_t(mIndexCount), meshlets);
+
+    std::vector<PartRecord_> parts;
+    std::vector<LevelRecord_> levels;
+    add_part_records_(aData.parts, std::uint32_t(mIndexCount), std::uint32_t(mMeshletCount), parts, levels);
+
+    auto const append = [this] (std::size_t aTemp, void const* aData, std::size_t aSize) {
+        if (aSize != std::fwrite(aData, 1, aSize, mTemps[aTemp]))
+            throw Error("Unable to write '%s'", mTempPaths[aTemp].c_str());
+    };
+    append(kVertexTemp_, vertices.data(), vertices.size());
+    append(kIndexTemp_, indices.data(), indices.size() * sizeof(std::uint32_t));
+    append(kMeshletTemp_, meshlets.data(), meshlets.size() * sizeof(MeshletRecord_));
+
+    // The part table is small, and stays in memory until finish()
+    for (auto const& part : aData.parts)
+    {
+        LodPart rebased = part;
+        for (auto& level : rebased.levels)
+        {
+            level.firstIndex += std::uint32_t(mIndexCount);
+            level.firstMeshlet += std::uint32_t(mMeshletCount);
+        }
+        mParts.emplace_back(std::move(rebased));
+    }
+
+    mVertexCount = vertexCount;
+    mIndexCount = indexCount;
+    mMeshletCount += aData.meshlets.size();
+}
+
+void MeshCacheWriter::finish(std::vector<Material> const& aMaterials)
+{
+    std::vector<PartRecord_> parts;
+    std::vector<LevelRecord_> levels;
+    add_part_records_(mParts, 0, 0, parts, levels);
+
+    std::vector<MaterialRecord_> const materials = make_material_records_(aMaterials);
+
+    // As pack_indices()
+    bool const narrow = mVertexCount <= 65536;
+
+    Header_ header = make_header_(mSourcePath.c_str(), mParams);
+    header.vertexCount = std::uint32_t(mVertexCount);
+    header.vertexStride = std::uint32_t(interleaved_vertex_size(mHasTextcoords));
+    header.indexCount = std::uint32_t(mIndexCount);
+    header.indexType = narrow ? GL_UNSIGNED_SHORT : GL_UNSIGNED_INT;
+    header.partCount = std::uint32_t(parts.size());
+    header.levelTotal = std::uint32_t(levels.size());
+    header.materialCount = std::uint32_t(materials.size());
+    header.meshletCount = std::uint32_t(mMeshletCount);
+    layout_(header);
+
+    for (std::size_t i = 0; i < kTempCount_; ++i)
+    {
+        if (0 != std::fflush(mTemps[i]))
+            throw Error("Unable to write '%s'", mTempPaths[i].c_str());
+    }
+
+    std::string const path = mesh_cache_path(mSourcePath.c_str());
+    CacheFileWriter file(path);
+    file.section(&header, sizeof(Header_));
+    copy_section_(file, mTemps[kVertexTemp_], std::uint64_t(header.vertexCount) * header.vertexStride, false, path.c_str());
+    copy_section_(file, mTemps[kIndexTemp_], std::uint64_t(header.indexCount) * sizeof(std::uint32_t), narrow, path.c_str());
+    file.section(parts.data(), parts.size() * sizeof(PartRecord_));
+    file.section(levels.data(), levels.size() * sizeof(LevelRecord_));
+    file.section(materials.data(), materials.size() * sizeof(MaterialRecord_));
+    copy_section_(file, mTemps[kMeshletTemp_], std::uint64_t(header.meshletCount) * sizeof(MeshletRecord_), false, path.c_str());
+    assert(file.offset() == header.fileSize);
+    file.commit();
+
+    close_temps_();
+}
+
+void MeshCacheWriter::close_temps_() noexcept
+{
+    for (std::size_t i = 0; i < kTempCount_; ++i)
+    {
+        if (!mTemps[i])
+            continue;
+
+        std::fclose(mTemps[i]);
+        std::remove(mTempPaths[i].c_str());
+        mTemps[i] = nullptr;
+    }
+}
+
+LodMesh create_lod_vao(MappedLodMesh const& aMapped)
+{
+    IndexedMesh const mesh = create_indexed_vao(aMapped.vertices, aMapped.vertexCount, aMapped.hasTextcoords, aMapped.indices, aMapped.indexCount, aMapped.indexType, aMapped.materials);
+    return LodMesh{ mesh, aMapped.parts, aMapped.meshlets };
+}
@@ -0,0 +1,131 @@
+#ifndef MESH_CACHE_HPP_9A66101F_B757_47D0_ADB4_F75FB54AD97F
+#define MESH_CACHE_HPP_9A66101F_B757_47D0_ADB4_F75FB54AD97F
+
+#include <glad.h>
+
+#include <string>
+#include <vector>
+#include <optional>
+
+#include <cstdio>
+#include <cstddef>
+#include <cstdint>
+
+#include "../support/mapped_file.hpp"
+
+#include "mesh_lod.hpp"
+
+// Binary cache of processed OBJ meshes.
+//
+// Loading an OBJ means parsing text, welding, optimize_mesh() and
+// build_lod_mesh(), which takes far longer than drawing the first frame. The
+// result of all that is written next to the OBJ (see mesh_cache_path()) in
+// the form that create_indexed_vao() uploads: interleaved vertices and
+// 16- or 32-bit indices, followed by the LOD parts and levels, the
+// material table and the meshlets. Later runs map the file into memory and pass the mapped
+// vertices and indices directly to glBufferData(), without converting
+// anything.
+//
+// A cache is only used if it has the current format version, was built with
+// the same MeshCacheParams, and matches the OBJ: same size and modification
+// time or, if only the time differs (e.g. after a fresh checkout), the same
+// contents hash. The file is in native byte order; caches written on a
+// machine with the other byte order are rejected.
+struct MeshCacheParams
+{
+    unsigned partsX = 1;
+    unsigned partsZ = 1;
+    std::size_t levelCount = 5;
+    float reduction = 0.5f;
+
+    // Zero if the OBJ is processed in memory as a whole. Otherwise, the OBJ
+    // is imported in tiles of about this many bytes of working memory each
+    // (see obj_stream.hpp); the tiles are the parts.
+    std::uint64_t memoryBudget = 0;
+};
+
+// Path of the cache for the OBJ aSourcePath: the same path with ".vmesh"
+// appended.
+std::string mesh_cache_path(char const* aSourcePath);
+
+// Cache file mapped into memory. vertices and indices point into the
+// mapping, and stay valid as long as the MappedLodMesh exists.
+struct MappedLodMesh
+{
+    MappedFile file;
+
+    void const* vertices;
+    std::size_t vertexCount;
+    bool hasTextcoords;
+
+    void const* indices;
+    std::size_t indexCount;
+    GLenum indexType;
+
+    std::vector<LodPart> parts;
+    std::vector<Material> materials;
+    std::vector<Meshlet> meshlets;
+};
+
+// Maps the cache of aSourcePath. Returns an empty optional if there is no
+// cache, or if it is out of date, was built with other parameters or is
+// damaged: sections, ranges or indices out of bounds. The index section is
+// read once to check the indices.
+std::optional<MappedLodMesh> open_mesh_cache(char const* aSourcePath, MeshCacheParams const&);
+
+// Writes the cache of aSourcePath for aData, which must have been built from
+// it with aParams. The file is written under a temporary name and then
+// renamed, so an interrupted write never leaves a partial cache. Throws
+// Error on failure.
+void write_mesh_cache(char const* aSourcePath, MeshCacheParams const& aParams, LodMeshData const& aData);
+
+// Writes a cache part by part, for meshes that are too large to be processed
+// as a whole (see obj_stream.hpp). Only the part table is kept in memory; the
+// vertices, indices and meshlets are appended to temporary files next to the
+// cache, from which finish() assembles it. The temporary files are removed
+// when the writer is destroyed, also if finish() was never reached (e.g.
+// after an exception). All members throw Error on failure.
+class MeshCacheWriter final
+{
+public:
+    MeshCacheWriter(char const* aSourcePath, MeshCacheParams const&, bool aHasTextcoords);
+    ~MeshCacheWriter();
+
+    MeshCacheWriter(MeshCacheWriter const&) = delete;
+    MeshCacheWriter& operator=(MeshCacheWriter const&) = delete;
+
+    // Appends the parts of aData. Parts of different calls do not share
+    // vertices. aData has texture coordinates if and only if the writer was
+    // created with aHasTextcoords.
+    void add(LodMeshData const& aData);
+
+    // Writes the cache. The material ids of all parts refer to aMaterials.
+    void finish(std::vector<Material> const& aMaterials);
+
+private:
+    void close_temps_() noexcept;
+
+    enum Temp_
+    {
+        kVertexTemp_,
+        kIndexTemp_,
+        kMeshletTemp_,
+        kTempCount_
+    };
+
+    std::string mSourcePath;
+    MeshCacheParams mParams;
+    bool mHasTextcoords;
+
+    std::string mTempPaths[kTempCount_];
+    std::FILE* mTemps[kTempCount_] = {};
+
+    std::uint64_t mVertexCount = 0;
+    std::uint64_t mIndexCount = 0;
+    std::uint64_t mMeshletCount = 0;
+    std::vector<LodPart> mParts;
+};
+
+LodMesh create_lod_vao(MappedLodMesh const&);
+
+#endif // MESH_CACHE_HPP_9A66101F_B757_47D0_ADB4_F75FB54AD97F
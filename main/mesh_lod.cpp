@@ -0,0 +1,186 @@
+#include "mesh_lod.hpp"
+
+#include <utility>
+#include <algorithm>
+
+#include <cmath>
+#include <cassert>
+
+#include "../vmlib/mesh_optimize.hpp"
+#include "../vmlib/mesh_simplify.hpp"
+
+namespace
+{
+    // Parts are not simplified below this many triangles.
+    constexpr std::size_t kMinTriangles_ = 16;
+
+    // A level must have at most this fraction of the previous level's
+    // triangles; otherwise the chain ends there.
+    constexpr float kMinProgress_ = 0.85f;
+
+    // Distance below which pixels_per_unit() stops growing.
+    constexpr float kMinDistance_ = 1e-4f;
+
+    // Appends the level's triangles, in meshlet order.
+    void add_level_(LodMeshData& aData, LodPart& aPart, std::vector<std::uint32_t> const& aIndices, float aError)
+    {
+        auto& indices = aData.mesh.indices;
+        auto const& positions = aData.mesh.positions;
+
+        std::uint32_t const firstIndex = std::uint32_t(indices.size());
+        std::uint32_t const firstMeshlet = std::uint32_t(aData.meshlets.size());
+
+        indices.resize(firstIndex + aIndices.size());
+        std::size_t const meshletCount = build_meshlets(aIndices.size(), aIndices.data(), positions.size(), positions.data(), indices.data() + firstIndex, aData.meshlets, firstIndex);
+
+        aPart.levels.emplace_back(LodLevel{ firstIndex, std::uint32_t(aIndices.size()), aError, firstMeshlet, std::uint32_t(meshletCount) });
+    }
+
+    std::size_t index_size_(LodMesh const& aMesh)
+    {
+        return GL_UNSIGNED_SHORT == aMesh.mesh.indexType ? sizeof(std::uint16_t) : sizeof(std::uint32_t);
+    }
+}
+
+LodMeshData build_lod_mesh(IndexedMeshData aMesh, unsigned aPartsX, unsigned aPartsZ, std::size_t aLevelCount, float aReduction, bool aLockBorder)
+{
+    assert(aPartsX > 0 && aPartsZ > 0);
+    assert(aLevelCount > 0);
+    assert(aReduction > 0.f && aReduction < 1.f);
+
+    // Distribute the triangles to the parts
+    std::vector<std::uint32_t> const indices = std::move(aMesh.indices);
+    std::vector<Vec3f> const& positions = aMesh.positions;
+
+    Aabb3f const bounds = make_aabb(positions);
+    float const cellX = (bounds.max.x - bounds.min.x) / aPartsX;
+    float const cellZ = (bounds.max.z - bounds.min.z) / aPartsZ;
+
+    auto const cell_of = [] (float aOffset, float aCellSize, unsigned aCount) {
+        if (aCellSize <= 0.f)
+            return 0u;
+        return std::min(unsigned(std::max(aOffset / aCellSize, 0.f)), aCount - 1);
+    };
+
+    std::vector<std::vector<std::uint32_t>> partIndices(std::size_t(aPartsX) * aPartsZ);
+    for (std::size_t i = 0; i < indices.size(); i += 3)
+    {
+        Vec3f const centroid = (positions[indices[i]] + positions[indices[i+1]] + positions[indices[i+2]]) / 3.f;
+        unsigned const x = cell_of(centroid.x - bounds.min.x, cellX, aPartsX);
+        unsigned const z = cell_of(centroid.z - bounds.min.z, cellZ, aPartsZ);
+
+        auto& part = partIndices[std::size_t(z) * aPartsX + x];
+        part.insert(part.end(), indices.begin() + i, indices.begin() + i+3);
+    }
+
+    // Build each part's chain
+    LodMeshData ret;
+    ret.mesh = std::move(aMesh);
+    ret.mesh.indices.clear();
+    ret.mesh.indices.reserve(2 * indices.size());
+
+    SimplifyOptions options;
+    options.lockBorder = aLockBorder || partIndices.size() > 1;
+    options.normals = ret.mesh.normals.size() == ret.mesh.positions.size() ? ret.mesh.normals.data() : nullptr;
+
+    for (auto& level : partIndices)
+    {
+        if (level.empty())
+            continue;
+
+        LodPart part;
+        part.bounds = kEmptyAabb3f;
+        for (auto const i : level)
+            part.bounds = merge(part.bounds, ret.mesh.positions[i]);
+
+        add_level_(ret, part, level, 0.f);
+
+        float error = 0.f;
+        std::vector<std::uint32_t> next;
+        while (part.levels.size() < aLevelCount)
+        {
+            std::size_t const triangles = level.size() / 3;
+            options.targetIndexCount = 3 * std::size_t(triangles * aReduction);
+            if (options.targetIndexCount < 3 * kMinTriangles_)
+                break;
+
+            next.resize(level.size());
+            auto const res = simplify_mesh(level.size(), level.data(), ret.mesh.positions.size(), ret.mesh.positions.data(), options, next.data());
+            if (res.indexCount > kMinProgress_ * level.size())
+                break;
+
+            next.resize(res.indexCount);
+            optimize_vertex_cache(next.size(), next.data(), ret.mesh.positions.size(), next.data());
+
+            // Each level is simplified from the previous one, so the errors
+            // add up.
+            error += res.error;
+            add_level_(ret, part, next, error);
+            level.swap(next);
+        }
+
+        ret.parts.emplace_back(std::move(part));
+    }
+
+    return ret;
+}
+
+LodMeshData build_lod_mesh(SimpleMeshData const& aMesh, unsigned aPartsX, unsigned aPartsZ, std::size_t aLevelCount, float aReduction)
+{
+    IndexedMeshData mesh = weld_vertices(aMesh);
+    generate_tangents(mesh);
+    return build_lod_mesh(std::move(mesh), aPartsX, aPartsZ, aLevelCount, aReduction);
+}
+
+LodMesh create_lod_vao(LodMeshData const& aData)
+{
+    return LodMesh{ create_indexed_vao(aData.mesh), aData.parts, aData.meshlets };
+}
+
+float pixels_per_unit(float aDistance, float aFovY, float aViewportHeight)
+{
+    return aViewportHeight / (2.f * std::tan(0.5f * aFovY) * std::max(aDistance, kMinDistance_));
+}
+
+std::size_t select_lod(LodPart const& aPart, float aPixelsPerUnit, float aMaxPixelError)
+{
+    for (std::size_t i = aPart.levels.size(); i > 1; --i)
+    {
+        if (aPart.levels[i-1].error * aPixelsPerUnit <= aMaxPixelError)
+            return i-1;
+    }
+    return 0;
+}
+
+void draw_lod(LodMesh const& aMesh, std::size_t aPart, std::size_t aLevel)
+{
+    LodLevel const& level = aMesh.parts[aPart].levels[aLevel];
+
+    glDrawElements(GL_TRIANGLES, GLsizei(level.indexCount), aMesh.mesh.indexType,
+        reinterpret_cast<void const*>(level.firstIndex * index_size_(aMesh)));
+}
+
+std::size_t add_visible_meshlets(LodDrawList& aList, LodMesh const& aMesh, std::size_t aPart, std::size_t aLevel, Frustumf const& aFrustum, Vec3f aCameraPosition)
+{
+    LodLevel const& level = aMesh.parts[aPart].levels[aLevel];
+
+    aList.ranges.clear();
+    std::size_t const visible = cull_meshlets(aFrustum, aCameraPosition, level.meshletCount, aMesh.meshlets.data() + level.firstMeshlet, aList.ranges);
+
+    std::size_t const indexSize = index_size_(aMesh);
+    for (auto const& range : aList.ranges)
+    {
+        aList.counts.emplace_back(GLsizei(range.indexCount));
+        aList.offsets.emplace_back(reinterpret_cast<void const*>(range.firstIndex * indexSize));
+    }
+
+    return visible;
+}
+
+void draw_lod(LodMesh const& aMesh, LodDrawList const& aList)
+{
+    if (aList.counts.empty())
+        return;
+
+    glMultiDrawElements(GL_TRIANGLES, aList.counts.data(), aMesh.mesh.indexType, aList.offsets.data(), GLsizei(aList.counts.size()));
+}
@@ -0,0 +1,119 @@
+#ifndef MESH_LOD_HPP_BF7346BF_1149_4B80_AC47_94690DB1F466
+#define MESH_LOD_HPP_BF7346BF_1149_4B80_AC47_94690DB1F466
+
+#include <glad.h>
+
+#include <vector>
+
+#include <cstddef>
+#include <cstdint>
+
+#include "../vmlib/bounds.hpp"
+#include "../vmlib/frustum.hpp"
+#include "../vmlib/meshlet.hpp"
+
+#include "simple_mesh.hpp"
+
+// Level of detail (LOD) chains, built with simplify_mesh() (see
+// vmlib/mesh_simplify.hpp).
+//
+// A LOD mesh consists of one or more parts, each with its own chain of
+// levels; level 0 is the full detail mesh. Splitting a mesh into parts (e.g.
+// terrain patches) lets each part pick its level and be culled on its own.
+// The borders between parts are never simplified, so neighbouring parts at
+// different levels do not show cracks.
+//
+// All parts and levels share one vertex buffer. Their index ranges are
+// stored back to back in a single index buffer.
+//
+// The triangles of each level are ordered into meshlets (see
+// vmlib/meshlet.hpp), which are stored with the mesh. Large parts can then
+// be drawn with only the meshlets that are in view and facing the camera
+// (see add_visible_meshlets()), so that their cost depends on the visible
+// area rather than on their size.
+struct LodLevel
+{
+    std::uint32_t firstIndex;
+    std::uint32_t indexCount;
+
+    // Simplification error, in model units, relative to level 0.
+    float error;
+
+    // Meshlets of this level, in the mesh's meshlets. Together they cover
+    // the level's index range.
+    std::uint32_t firstMeshlet;
+    std::uint32_t meshletCount;
+};
+
+struct LodPart
+{
+    Aabb3f bounds; // model space
+    std::vector<LodLevel> levels;
+};
+
+struct LodMeshData
+{
+    IndexedMeshData mesh; // indices of all parts and levels
+    std::vector<LodPart> parts;
+    std::vector<Meshlet> meshlets; // of all parts and levels
+};
+
+// Splits the mesh into aPartsX x aPartsZ parts along a regular grid in the XZ
+// plane (by triangle centroid; empty parts are dropped), and builds up to
+// aLevelCount levels per part. Each level has about aReduction times as many
+// triangles as the previous one. The chain ends early when simplification
+// stops making progress.
+//
+// The borders between the parts stay in place in all levels, so that parts
+// at different levels still meet. Set aLockBorder to do the same for the
+// border of the whole mesh, e.g. if it is one tile of a larger mesh.
+LodMeshData build_lod_mesh(IndexedMeshData aMesh, unsigned aPartsX = 1, unsigned aPartsZ = 1, std::size_t aLevelCount = 5, float aReduction = 0.5f, bool aLockBorder = false);
+LodMeshData build_lod_mesh(SimpleMeshData const& aMesh, unsigned aPartsX = 1, unsigned aPartsZ = 1, std::size_t aLevelCount = 5, float aReduction = 0.5f);
+
+struct LodMesh
+{
+    IndexedMesh mesh;
+    std::vector<LodPart> parts;
+    std::vector<Meshlet> meshlets;
+};
+
+LodMesh create_lod_vao(LodMeshData const&);
+
+// Number of pixels that one unit covers at a distance aDistance from the
+// camera, for a perspective projection with the vertical field of view
+// aFovY (radians) and a viewport that is aViewportHeight pixels high.
+float pixels_per_unit(float aDistance, float aFovY, float aViewportHeight);
+
+// Coarsest level of aPart whose error covers at most aMaxPixelError pixels.
+std::size_t select_lod(LodPart const& aPart, float aPixelsPerUnit, float aMaxPixelError = 1.f);
+
+// Draws level aLevel of part aPart. The mesh's VAO must be bound.
+void draw_lod(LodMesh const& aMesh, std::size_t aPart, std::size_t aLevel);
+
+// Index ranges of a LodMesh, collected by add_visible_meshlets() and drawn
+// with a single glMultiDrawElements() call by draw_lod().
+struct LodDrawList
+{
+    std::vector<GLsizei> counts;
+    std::vector<void const*> offsets;
+
+    std::vector<MeshletRange> ranges; // scratch space
+
+    void clear() noexcept
+    {
+        counts.clear();
+        offsets.clear();
+    }
+};
+
+// Adds the meshlets of level aLevel of part aPart that intersect aFrustum and
+// are not back facing as seen from aCameraPosition. The frustum and the
+// camera position must be in the mesh's model space. Skipping back facing
+// meshlets is only correct if back faces are culled while drawing the list
+// (GL_CULL_FACE). Returns the number of visible meshlets.
+std::size_t add_visible_meshlets(LodDrawList& aList, LodMesh const& aMesh, std::size_t aPart, std::size_t aLevel, Frustumf const& aFrustum, Vec3f aCameraPosition);
+
+// Draws the ranges in aList. The mesh's VAO must be bound.
+void draw_lod(LodMesh const& aMesh, LodDrawList const& aList);
+
+#endif // MESH_LOD_HPP_BF7346BF_1149_4B80_AC47_94690DB1F466
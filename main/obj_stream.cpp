@@ -0,0 +1,646 @@
+#include "obj_stream.hpp"
+
+#include <cmath>
+#include <limits>
+#include <string>
+#include <vector>
+#include <memory>
+#include <fstream>
+#include <utility>
+#include <algorithm>
+#include <filesystem>
+#include <string_view>
+#include <type_traits>
+#include <unordered_map>
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+#include "../support/error.hpp"
+#include "../support/mapped_file.hpp"
+
+#include "simple_mesh.hpp"
+
+namespace
+{
+    // The OBJ is read through a window of this size. Lines must be shorter.
+    constexpr std::size_t kWindow_ = 64 * 1024 * 1024;
+
+    // Working memory per triangle of a tile: the expanded corners, welding,
+    // optimize_mesh() and build_lod_mesh(). Measured with a terrain grid,
+    // with some headroom.
+    constexpr std::uint64_t kTileBytesPerTriangle_ = 512;
+
+    // Upper limit of the tiles; their files are open at the same time.
+    constexpr unsigned kMaxTiles_ = 256;
+
+    // Buffer of each tile file while the faces are distributed
+    constexpr std::size_t kTileBuffer_ = 256 * 1024;
+
+    // Face corner as stored in the tile files
+    struct Corner_
+    {
+        Vec3f position;
+        Vec3f normal;
+        Vec2f textcoord;
+        std::uint32_t material;
+    };
+
+    static_assert(std::is_trivially_copyable_v<Corner_> && 36 == sizeof(Corner_), "Corner_ is written to files as is");
+
+    // Temporary file, removed when the object goes away. The file is open
+    // for writing until close().
+    class TempFile_ final
+    {
+    public:
+        explicit TempFile_(std::string aPath, std::size_t aBuffer = 0)
+            : mPath(std::move(aPath))
+            , mFile(std::fopen(mPath.c_str(), "wb"))
+        {
+            if (!mFile)
+                throw Error("Unable to create '%s'", mPath.c_str());
+            if (aBuffer)
+                std::setvbuf(mFile, nullptr, _IOFBF, aBuffer);
+        }
+
+        ~TempFile_()
+        {
+            if (mFile)
+                std::fclose(mFile);
+            std::remove(mPath.c_str());
+        }
+
+        TempFile_(TempFile_ const&) = delete;
+        TempFile_& operator=(TempFile_ const&) = delete;
+
+        void write(void const* aData, std::size_t aSize)
+        {
+            if (aSize != std::fwrite(aData, 1, aSize, mFile))
+                throw Error("Unable to write '%s'", mPath.c_str());
+            mSize += aSize;
+        }
+
+        void close()
+        {
+            int const res = std::fclose(mFile);
+            mFile = nullptr;
+            if (0 != res)
+                throw Error("Unable to write '%s'", mPath.c_str());
+        }
+
+        std::string const& path() const noexcept { return mPath; }
+        std::uint64_t size() const noexcept { return mSize; }
+
+    private:
+        std::string mPath;
+        std::FILE* mFile;
+        std::uint64_t mSize = 0;
+    };
+
+    // Calls aLine(begin, end) for each line of aPath, without the line break.
+    template <typename tLine>
+    void for_each_line_(char const* aPath, std::uint64_t aFileSize, tLine&& aLine)
+    {
+        for (std::uint64_t offset = 0; offset < aFileSize; )
+        {
+            MappedFile const window(aPath, offset, kWindow_);
+            char const* const begin = static_cast<char const*>(window.data());
+            char const* const end = begin + window.size();
+            bool const last = offset + window.size() >= aFileSize;
+
+            // Complete lines only; the rest is the start of the next window.
+            char const* line = begin;
+            while (line != end)
+            {
+                char const* eol = static_cast<char const*>(std::memchr(line, '\n', std::size_t(end - line)));
+                if (!eol)
+                {
+                    if (!last)
+                        break;
+                    eol = end;
+                }
+
+                char const* lineEnd = eol;
+                if (lineEnd != line && '\r' == lineEnd[-1])
+                    --lineEnd;
+                aLine(line, lineEnd);
+
+                line = eol == end ? end : eol + 1;
+            }
+
+            if (line == begin)
+                throw Error("'%s': line longer than %zu bytes", aPath, kWindow_);
+            offset += std::uint64_t(line - begin);
+        }
+    }
+
+    bool is_space_(char aC) noexcept
+    {
+        return ' ' == aC || '\t' == aC;
+    }
+
+    void skip_spaces_(char const*& aIt, char const* aEnd) noexcept
+    {
+        while (aIt != aEnd && is_space_(*aIt))
+            ++aIt;
+    }
+
+    // Keyword at the start of the line, e.g. "v" or "usemtl"; advances aIt
+    // past it.
+    std::string_view keyword_(char const*& aIt, char const* aEnd) noexcept
+    {
+        skip_spaces_(aIt, aEnd);
+        char const* const begin = aIt;
+        while (aIt != aEnd && !is_space_(*aIt))
+            ++aIt;
+        return std::string_view(begin, std::size_t(aIt - begin));
+    }
+
+    // Decimal numbers with up to 18 significant digits and no exponent
+    // (which is what OBJ exporters write) are converted directly; anything
+    // else goes through strtof().
+    bool parse_float_(char const*& aIt, char const* aEnd, float& aOut)
+    {
+        static constexpr double kPow10[] = {
+            1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+            1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+        };
+
+        skip_spaces_(aIt, aEnd);
+        char const* const begin = aIt;
+        char const* end = begin;
+        while (end != aEnd && !is_space_(*end))
+            ++end;
+        if (begin == end)
+            return false;
+
+        char const* p = begin;
+        bool const negative = '-' == *p;
+        if ('-' == *p || '+' == *p)
+            ++p;
+
+        std::uint64_t mantissa = 0;
+        int digits = 0, exponent = 0;
+        bool any = false;
+        for (; p != end && *p >= '0' && *p <= '9'; ++p, any = true)
+        {
+            if (digits < 18)
+            {
+                mantissa = mantissa * 10 + std::uint64_t(*p - '0');
+                digits += 0 != mantissa;
+            }
+            else
+                ++exponent;
+        }
+        if (p != end && '.' == *p)
+        {
+            for (++p; p != end && *p >= '0' && *p <= '9'; ++p, any = true)
+            {
+                if (digits < 18)
+                {
+                    mantissa = mantissa * 10 + std::uint64_t(*p - '0');
+                    digits += 0 != mantissa;
+                    --exponent;
+                }
+            }
+        }
+
+        if (any && p == end && exponent >= -22 && exponent <= 22)
+        {
+            double const value = exponent < 0 ? double(mantissa) / kPow10[-exponent] : double(mantissa) * kPow10[exponent];
+            aOut = float(negative ? -value : value);
+            aIt = end;
+            return true;
+        }
+
+        char buffer[64];
+        std::size_t const length = std::size_t(end - begin);
+        if (length >= sizeof(buffer))
+            return false;
+
+        std::memcpy(buffer, begin, length);
+        buffer[length] = '\0';
+
+        char* stop = nullptr;
+        aOut = std::strtof(buffer, &stop);
+        if (stop != buffer + length)
+            return false;
+
+        aIt = end;
+        return true;
+    }
+
+    bool parse_int_(char const*& aIt, char const* aEnd, std::int64_t& aOut) noexcept
+    {
+        char const* p = aIt;
+        bool const negative = p != aEnd && '-' == *p;
+        if (negative)
+            ++p;
+
+        if (p == aEnd || *p < '0' || *p > '9')
+            return false;
+
+        std::int64_t value = 0;
+        for (; p != aEnd && *p >= '0' && *p <= '9'; ++p)
+            value = value * 10 + (*p - '0');
+
+        aOut = negative ? -value : value;
+        aIt = p;
+        return true;
+    }
+
+    // OBJ index (1-based, or negative relative to the end) into an array of
+    // aCount entries; false if it is out of range.
+    bool resolve_index_(std::int64_t aIndex, std::uint64_t aCount, std::uint64_t& aOut) noexcept
+    {
+        if (aIndex > 0 && std::uint64_t(aIndex) <= aCount)
+        {
+            aOut = std::uint64_t(aIndex - 1);
+            return true;
+        }
+        if (aIndex < 0 && std::uint64_t(-aIndex) <= aCount)
+        {
+            aOut = aCount - std::uint64_t(-aIndex);
+            return true;
+        }
+        return false;
+    }
+
+    struct Materials_
+    {
+        std::vector<Material> table;
+        std::unordered_map<std::string, std::uint32_t> ids;
+    };
+
+    // Materials of an MTL file: one per newmtl, with its ambient color.
+    void load_mtl_(std::filesystem::path const& aPath, Materials_& aMaterials)
+    {
+        std::ifstream file(aPath);
+        if (!file)
+        {
+            std::fprintf(stderr, "Warning: unable to open '%s'; its materials are replaced by the default\n", aPath.string().c_str());
+            return;
+        }
+
+        Material* current = nullptr;
+        for (std::string line; std::getline(file, line); )
+        {
+            char const* it = line.data();
+            char const* const end = it + line.size();
+            std::string_view const key = keyword_(it, end);
+
+            if ("newmtl" == key)
+            {
+                skip_spaces_(it, end);
+                std::string name(it, end);
+                while (!name.empty() && (is_space_(name.back()) || '\r' == name.back()))
+                    name.pop_back();
+
+                aMaterials.ids.emplace(std::move(name), std::uint32_t(aMaterials.table.size()));
+                aMaterials.table.emplace_back(Material{ Vec3f{ 0.f, 0.f, 0.f } });
+                current = &aMaterials.table.back();
+            }
+            else if ("Ka" == key && current)
+            {
+                Vec3f color;
+                if (parse_float_(it, end, color.x) && parse_float_(it, end, color.y) && parse_float_(it, end, color.z))
+                    current->color = color;
+            }
+        }
+    }
+
+    // The rest of the line, without trailing spaces.
+    std::string rest_(char const* aIt, char const* aEnd)
+    {
+        skip_spaces_(aIt, aEnd);
+        while (aEnd != aIt && is_space_(aEnd[-1]))
+            --aEnd;
+        return std::string(aIt, aEnd);
+    }
+
+    [[noreturn]] void throw_line_error_(char const* aPath, std::uint64_t aLine, char const* aWhat)
+    {
+        throw Error("'%s' line %llu: %s", aPath, static_cast<unsigned long long>(aLine), aWhat);
+    }
+
+    // Pass 1
+    struct Scan_
+    {
+        std::uint64_t positions = 0, normals = 0, textcoords = 0;
+        std::uint64_t triangles = 0;
+        Aabb3f bounds = kEmptyAabb3f;
+        Materials_ materials;
+    };
+
+    Scan_ scan_(char const* aPath, std::uint64_t aFileSize, TempFile_& aPositions, TempFile_& aNormals, TempFile_& aTextcoords)
+    {
+        std::filesystem::path const directory = std::filesystem::path(aPath).parent_path();
+
+        Scan_ ret;
+        std::uint64_t lineNumber = 0;
+        for_each_line_(aPath, aFileSize, [&] (char const* aIt, char const* aEnd) {
+            ++lineNumber;
+            std::string_view const key = keyword_(aIt, aEnd);
+
+            if ("v" == key)
+            {
+                Vec3f p;
+                if (!parse_float_(aIt, aEnd, p.x) || !parse_float_(aIt, aEnd, p.y) || !parse_float_(aIt, aEnd, p.z))
+                    throw_line_error_(aPath, lineNumber, "invalid vertex position");
+
+                aPositions.write(&p, sizeof(Vec3f));
+                ret.bounds = merge(ret.bounds, p);
+                ++ret.positions;
+            }
+            else if ("vn" == key)
+            {
+                Vec3f n;
+                if (!parse_float_(aIt, aEnd, n.x) || !parse_float_(aIt, aEnd, n.y) || !parse_float_(aIt, aEnd, n.z))
+                    throw_line_error_(aPath, lineNumber, "invalid vertex normal");
+
+                aNormals.write(&n, sizeof(Vec3f));
+                ++ret.normals;
+            }
+            else if ("vt" == key)
+            {
+                // The third coordinate is optional, and ignored
+                Vec2f t;
+                if (!parse_float_(aIt, aEnd, t.x))
+                    throw_line_error_(aPath, lineNumber, "invalid texture coordinate");
+                if (!parse_float_(aIt, aEnd, t.y))
+                    t.y = 0.f;
+
+                aTextcoords.write(&t, sizeof(Vec2f));
+                ++ret.textcoords;
+            }
+            else if ("f" == key)
+            {
+                std::uint64_t corners = 0;
+                while (!keyword_(aIt, aEnd).empty())
+                    ++corners;
+
+                if (corners < 3)
+                    throw_line_error_(aPath, lineNumber, "face with fewer than three corners");
+                ret.triangles += corners - 2;
+            }
+            else if ("mtllib" == key)
+            {
+                for (std::string_view name = keyword_(aIt, aEnd); !name.empty(); name = keyword_(aIt, aEnd))
+                    load_mtl_(directory / std::string(name), ret.materials);
+            }
+        });
+
+        return ret;
+    }
+
+    // Tile grid: aParams.partsX x aParams.partsZ cells, each split into k x k
+    // tiles.
+    void choose_tiles_(MeshCacheParams const& aParams, std::uint64_t aTriangles, unsigned& aTilesX, unsigned& aTilesZ)
+    {
+        std::uint64_t const cells = std::uint64_t(aParams.partsX) * aParams.partsZ;
+        std::uint64_t const perTile = std::max<std::uint64_t>(aParams.memoryBudget / kTileBytesPerTriangle_, 1);
+
+        unsigned k = 1;
+        while (aTriangles > perTile * cells * k * k && cells * (k+1) * (k+1) <= kMaxTiles_)
+            ++k;
+
+        if (aTriangles > perTile * cells * k * k)
+            std::fprintf(stderr, "Warning: %u tiles are too few to stay within the memory budget\n", unsigned(cells * k * k));
+
+        aTilesX = aParams.partsX * k;
+        aTilesZ = aParams.partsZ * k;
+    }
+
+    // Pass 2
+    struct Attributes_
+    {
+        Vec3f const* positions;
+        Vec3f const* normals;
+        Vec2f const* textcoords;
+    };
+
+    void distribute_(char const* aPath, std::uint64_t aFileSize, Scan_ const& aScan, Attributes_ const& aAttributes, unsigned aTilesX, unsigned aTilesZ, std::vector<std::unique_ptr<TempFile_>>& aTiles, bool& aUsesDefault, bool& aMissingNormals, bool& aHasTextcoords)
+    {
+        Aabb3f const& bounds = aScan.bounds;
+        float const cellX = (bounds.max.x - bounds.min.x) / aTilesX;
+        float const cellZ = (bounds.max.z - bounds.min.z) / aTilesZ;
+
+        // As build_lod_mesh()
+        auto const cell_of = [] (float aOffset, float aCellSize, unsigned aCount) {
+            if (aCellSize <= 0.f)
+                return 0u;
+            return std::min(unsigned(std::max(aOffset / aCellSize, 0.f)), aCount - 1);
+        };
+
+        std::uint32_t const defaultMaterial = std::uint32_t(aScan.materials.table.size());
+        std::uint32_t material = defaultMaterial;
+
+        // Counts so far, for relative indices
+        std::uint64_t positions = 0, normals = 0, textcoords = 0;
+        std::uint64_t lineNumber = 0;
+
+        std::vector<Corner_> corners;
+        for_each_line_(aPath, aFileSize, [&] (char const* aIt, char const* aEnd) {
+            ++lineNumber;
+            std::string_view const key = keyword_(aIt, aEnd);
+
+            if ("v" == key)
+                ++positions;
+            else if ("vn" == key)
+                ++normals;
+            else if ("vt" == key)
+                ++textcoords;
+            else if ("usemtl" == key)
+            {
+                auto const it = aScan.materials.ids.find(rest_(aIt, aEnd));
+                material = aScan.materials.ids.end() == it ? defaultMaterial : it->second;
+            }
+            else if ("f" == key)
+            {
+                // v, v/t, v//n or v/t/n
+                corners.clear();
+                for (skip_spaces_(aIt, aEnd); aIt != aEnd; skip_spaces_(aIt, aEnd))
+                {
+                    Corner_ corner{ {}, { 0.f, 0.f, 0.f }, { 0.f, 0.f }, material };
+
+                    std::int64_t index;
+                    std::uint64_t resolved;
+                    if (!parse_int_(aIt, aEnd, index) || !resolve_index_(index, positions, resolved))
+                        throw_line_error_(aPath, lineNumber, "invalid position index");
+                    corner.position = aAttributes.positions[resolved];
+
+                    if (aIt != aEnd && '/' == *aIt)
+                    {
+                        ++aIt;
+                        if (aIt != aEnd && '/' != *aIt)
+                        {
+                            if (!parse_int_(aIt, aEnd, index) || !resolve_index_(index, textcoords, resolved))
+                                throw_line_error_(aPath, lineNumber, "invalid texture coordinate index");
+                            corner.textcoord = aAttributes.textcoords[resolved];
+                            aHasTextcoords = true;
+                        }
+                        if (aIt != aEnd && '/' == *aIt)
+                        {
+                            ++aIt;
+                            if (!parse_int_(aIt, aEnd, index) || !resolve_index_(index, normals, resolved))
+                                throw_line_error_(aPath, lineNumber, "invalid normal index");
+                            corner.normal = aAttributes.normals[resolved];
+                        }
+                    }
+
+                    aMissingNormals = aMissingNormals || 0.f == dot(corner.normal, corner.normal);
+
+                    if (aIt != aEnd && !is_space_(*aIt))
+                        throw_line_error_(aPath, lineNumber, "invalid face corner");
+
+                    corners.emplace_back(corner);
+                }
+
+                aUsesDefault = aUsesDefault || defaultMaterial == material;
+
+                // Fan, as the faces are expected to be convex
+                for (std::size_t i = 2; i < corners.size(); ++i)
+                {
+                    Corner_ const triangle[3] = { corners[0], corners[i-1], corners[i] };
+
+                    Vec3f const centroid = (triangle[0].position + triangle[1].position + triangle[2].position) / 3.f;
+                    unsigned const x = cell_of(centroid.x - bounds.min.x, cellX, aTilesX);
+                    unsigned const z = cell_of(centroid.z - bounds.min.z, cellZ, aTilesZ);
+
+                    aTiles[std::size_t(z) * aTilesX + x]->write(triangle, sizeof(triangle));
+                }
+            }
+        });
+    }
+
+    // Pass 3. The texture coordinates are dropped unless aTextcoords is set.
+    SimpleMeshData load_tile_(std::string const& aPath, std::uint64_t aSize, std::vector<Material> const& aMaterials, bool aTextcoords)
+    {
+        std::size_t const count = std::size_t(aSize / sizeof(Corner_));
+
+        SimpleMeshData ret;
+        ret.positions.resize(count);
+        ret.materialIds.resize(count);
+        ret.normals.resize(count);
+        if (aTextcoords)
+            ret.textcoords.resize(count);
+        ret.materials = aMaterials;
+
+        // The whole tile is needed at once anyway, so it is read in large
+        // windows too.
+        constexpr std::size_t kCornersPerWindow = kWindow_ / sizeof(Corner_);
+        for (std::size_t first = 0; first < count; first += kCornersPerWindow)
+        {
+            std::size_t const n = std::min(kCornersPerWindow, count - first);
+
+            MappedFile const window(aPath.c_str(), std::uint64_t(first) * sizeof(Corner_), n * sizeof(Corner_));
+            auto const* bytes = static_cast<std::uint8_t const*>(window.data());
+
+            for (std::size_t i = 0; i < n; ++i)
+            {
+                Corner_ corner;
+                std::memcpy(&corner, bytes + i * sizeof(Corner_), sizeof(Corner_));
+
+                ret.positions[first + i] = corner.position;
+                ret.materialIds[first + i] = corner.material;
+                ret.normals[first + i] = corner.normal;
+                if (aTextcoords)
+                    ret.textcoords[first + i] = corner.textcoord;
+            }
+        }
+
+        return ret;
+    }
+}
+
+ObjStreamReport import_wavefront_obj_streamed(char const* aPath, MeshCacheParams const& aParams)
+{
+    if (0 == aParams.memoryBudget)
+        throw Error("Streamed import of '%s' without a memory budget", aPath);
+
+    std::error_code ec;
+    std::uint64_t const fileSize = std::filesystem::file_size(aPath, ec);
+    if (ec)
+        throw Error("Unable to open OBJ file '%s': %s", aPath, ec.message().c_str());
+
+    std::string const temp = mesh_cache_path(aPath);
+
+    // Pass 1: attributes
+    TempFile_ positionFile(temp + ".positions.tmp");
+    TempFile_ normalFile(temp + ".normals.tmp");
+    TempFile_ textcoordFile(temp + ".textcoords.tmp");
+
+    Scan_ const scan = scan_(aPath, fileSize, positionFile, normalFile, textcoordFile);
+    positionFile.close();
+    normalFile.close();
+    textcoordFile.close();
+
+    ObjStreamReport ret{};
+    ret.positions = scan.positions;
+    ret.triangles = scan.triangles;
+    choose_tiles_(aParams, scan.triangles, ret.tilesX, ret.tilesZ);
+
+    // Pass 2: faces to tiles
+    std::vector<std::unique_ptr<TempFile_>> tiles;
+    bool usesDefault = false, missingNormals = false, hasTextcoords = false;
+    {
+        MappedFile const positions(positionFile.path().c_str());
+        MappedFile const normals(normalFile.path().c_str());
+        MappedFile const textcoords(textcoordFile.path().c_str());
+
+        Attributes_ const attributes{
+            static_cast<Vec3f const*>(positions.data()),
+            static_cast<Vec3f const*>(normals.data()),
+            static_cast<Vec2f const*>(textcoords.data())
+        };
+
+        for (std::size_t i = 0; i < std::size_t(ret.tilesX) * ret.tilesZ; ++i)
+            tiles.emplace_back(std::make_unique<TempFile_>(temp + ".tile" + std::to_string(i) + ".tmp", kTileBuffer_));
+
+        distribute_(aPath, fileSize, scan, attributes, ret.tilesX, ret.tilesZ, tiles, usesDefault, missingNormals, hasTextcoords);
+
+        for (auto& tile : tiles)
+            tile->close();
+    }
+
+    // As load_wavefront_obj()
+    std::vector<Material> materials = scan.materials.table;
+    if (usesDefault)
+        materials.emplace_back(Material{ Vec3f{ 1.f, 1.f, 1.f } });
+
+    // Normals generated per tile would differ along the tile borders, where
+    // each tile sees only its own triangles. Sum them over all tiles there
+    // first.
+    bool const lockBorder = tiles.size() > 1;
+
+    SharedNormalSums borderNormals;
+    if (missingNormals && lockBorder)
+    {
+        for (auto const& tile : tiles)
+        {
+            if (0 != tile->size())
+                add_shared_normal_sums(load_tile_(tile->path(), tile->size(), materials, false), borderNormals);
+        }
+    }
+
+    // Pass 3: one part per tile
+    MeshCacheWriter writer(aPath, aParams, hasTextcoords);
+    for (auto& tile : tiles)
+    {
+        if (0 == tile->size())
+            continue;
+
+        IndexedMeshData mesh = weld_vertices(load_tile_(tile->path(), tile->size(), materials, hasTextcoords));
+        tile.reset();
+
+        generate_missing_normals(mesh, &borderNormals);
+        generate_tangents(mesh);
+        optimize_mesh(mesh);
+        writer.add(build_lod_mesh(std::move(mesh), 1, 1, aParams.levelCount, aParams.reduction, lockBorder));
+        ++ret.parts;
+    }
+
+    writer.finish(materials);
+    return ret;
+}
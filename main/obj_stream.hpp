@@ -0,0 +1,58 @@
+#ifndef OBJ_STREAM_HPP_0AF7F76A_D547_4A16_BD67_87D1BAE15589
+#define OBJ_STREAM_HPP_0AF7F76A_D547_4A16_BD67_87D1BAE15589
+
+#include <cstddef>
+#include <cstdint>
+
+#include "mesh_cache.hpp"
+
+// Out-of-core import of OBJ files that do not fit into memory.
+//
+// load_wavefront_obj() holds the whole parse result and then the whole
+// expanded mesh in memory, which peaks at several times the size of the
+// OBJ. import_wavefront_obj_streamed() converts an OBJ straight into its mesh
+// cache (see mesh_cache.hpp) instead, with the working memory bounded by
+// aParams.memoryBudget (which must not be zero):
+//
+//  1. The OBJ is read through a window of fixed size. The positions, normals
+//     and texture coordinates go to temporary files as binary floats, and
+//     the MTL files are loaded.
+//  2. The OBJ is read again, and each face (fan-triangulated) goes to the
+//     temporary file of the tile that holds its centroid, with its corners
+//     resolved from the (mapped) attribute files. The tiles are a grid over
+//     the XZ bounds of the positions: aParams.partsX x aParams.partsZ, each
+//     cell split further until the triangles of a tile would fit into the
+//     budget if they were spread evenly.
+//  3. Each tile is loaded, welded (weld_vertices()), optimized
+//     (optimize_mesh()) and split into levels of detail (build_lod_mesh(),
+//     with its border locked so that the tiles still meet), and is appended
+//     to the cache as one part (see MeshCacheWriter).
+//
+// The temporary files are written next to the cache and removed when done.
+// The attribute files are mapped, not read, so the OS may keep pages of them
+// in memory, but can always drop them again.
+//
+// The importer understands the common subset of OBJ: v, vn, vt, f (with
+// relative indices), mtllib and usemtl. Corners without a texture coordinate
+// get zeros, and if no face uses one, the cached vertices have no texture
+// coordinates at all. Corners without a normal get a smooth one (see
+// generate_missing_normals()). Before pass 3, the tiles are then read once
+// more to sum the normals of the positions on the tile borders over all
+// tiles (see add_shared_normal_sums()), so that the normals agree where the
+// tiles meet. The tangents (see generate_tangents()) are computed per tile,
+// and may differ slightly along the borders. The materials are taken from
+// the ambient colors of the MTL files, as in load_wavefront_obj().
+// Everything else is ignored.
+// Throws Error on failure.
+struct ObjStreamReport
+{
+    std::uint64_t positions;
+    std::uint64_t triangles;
+
+    unsigned tilesX, tilesZ;
+    std::size_t parts; // non-empty tiles
+};
+
+ObjStreamReport import_wavefront_obj_streamed(char const* aPath, MeshCacheParams const& aParams);
+
+#endif // OBJ_STREAM_HPP_0AF7F76A_D547_4A16_BD67_87D1BAE15589
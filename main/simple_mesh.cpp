@@ -1,112 +1,532 @@
 #include "simple_mesh.hpp"
 
+#include <algorithm>
+
+#include <cmath>
+#include <cassert>
+#include <cstring>
+
+#include "../support/error.hpp"
+
+#include "../vmlib/vertex_normals.hpp"
+
+namespace
+{
+    // Key for welding: the bit patterns of all vertex attributes.
+    constexpr std::size_t kWeldKeySize_ = 3 + 1 + 3 + 2;
+    using WeldKey_ = std::uint32_t[kWeldKeySize_];
+
+    std::uint32_t weld_bits_(float aX)
+    {
+        std::uint32_t bits;
+        std::memcpy(&bits, &aX, sizeof(float));
+        return bits == 0x80000000u ? 0u : bits; // -0 -> +0
+    }
+
+    void make_weld_key_(SimpleMeshData const& aMesh, std::size_t aIndex, WeldKey_& aKey)
+    {
+        Vec3f const& p = aMesh.positions[aIndex];
+        Vec3f const& n = aMesh.normals[aIndex];
+        Vec2f const t = aMesh.textcoords.empty() ? Vec2f{ 0.f, 0.f } : aMesh.textcoords[aIndex];
+
+        float const values[kWeldKeySize_ - 1] = { p.x, p.y, p.z, n.x, n.y, n.z, t.x, t.y };
+        for (std::size_t i = 0; i < kWeldKeySize_ - 1; ++i)
+            aKey[i] = weld_bits_(values[i]);
+        aKey[kWeldKeySize_ - 1] = aMesh.materialIds[aIndex];
+    }
+
+    // FNV-1a over 32-bit words, with a final mix so that the low bits (used
+    // to pick the slot) depend on all of the key.
+    template <typename tKey>
+    std::uint64_t hash_weld_key_(tKey const& aKey)
+    {
+        std::uint64_t h = 14695981039346656037ull;
+        for (std::uint32_t const word : aKey)
+            h = (h ^ word) * 1099511628211ull;
+        h ^= h >> 32;
+        h *= 0xd6e8feb86659fd93ull;
+        h ^= h >> 32;
+        return h;
+    }
+
+    using PositionKey_ = std::array<std::uint32_t, 3>;
+
+    PositionKey_ position_key_(Vec3f const& aP)
+    {
+        return PositionKey_{ weld_bits_(aP.x), weld_bits_(aP.y), weld_bits_(aP.z) };
+    }
+
+    // Merges bitwise equal positions (as weld_vertices()). aIds[i] is the
+    // index of aPositions[i] in aUnique.
+    void weld_positions_(std::vector<Vec3f> const& aPositions, std::vector<Vec3f>& aUnique, std::vector<std::uint32_t>& aIds)
+    {
+        std::size_t const count = aPositions.size();
+
+        std::size_t tableSize = 1;
+        while (tableSize < 2 * count)
+            tableSize *= 2;
+
+        std::uint32_t const kEmpty = ~std::uint32_t(0);
+        std::vector<std::uint32_t> table(tableSize, kEmpty);
+        aUnique.clear();
+        aIds.resize(count);
+
+        for (std::size_t i = 0; i < count; ++i)
+        {
+            PositionKey_ const key = position_key_(aPositions[i]);
+
+            std::size_t slot = hash_weld_key_(key) & (tableSize - 1);
+            for (;; slot = (slot + 1) & (tableSize - 1))
+            {
+                if (table[slot] == kEmpty)
+                {
+                    table[slot] = std::uint32_t(aUnique.size());
+                    aUnique.emplace_back(aPositions[i]);
+                    break;
+                }
+
+                if (key == position_key_(aUnique[table[slot]]))
+                    break;
+            }
+
+            aIds[i] = table[slot];
+        }
+    }
+
+    // Interleaved vertex layout: the attributes of each vertex are adjacent
+    // in a single buffer, so fetching a vertex touches one cache line or two
+    // instead of one per attribute. The texture coordinate and the tangent
+    // are left out if aTextcoords is null.
+    //
+    //    offset  0: position (3 floats, attribute 0)
+    //    offset 12: normal   (3 floats, attribute 2)
+    //    offset 24: material (uint32, attribute 1)
+    //    offset 28: texcoord (2 floats, attribute 3)
+    //    offset 36: tangent  (GL_INT_2_10_10_10_REV, normalized, attribute 4)
+    //
+    // The material index replaces the per-vertex color (12 bytes), so a
+    // vertex is 28 bytes, or 40 with the texture coordinate and tangent. The
+    // tangent is a unit vector and a sign, so 10 bits per component are
+    // plenty; it takes 4 bytes instead of 16.
+    constexpr GLuint kVertexBinding_ = 0;
+
+    // Signed normalized 10:10:10:2, x in the lowest bits
+    std::uint32_t pack_tangent_(Vec4f const& aTangent)
+    {
+        auto const snorm = [] (float aValue, float aMax, std::uint32_t aMask) {
+            return std::uint32_t(std::lround(std::clamp(aValue, -1.f, 1.f) * aMax)) & aMask;
+        };
+
+        return snorm(aTangent.x, 511.f, 0x3ff)
+            | snorm(aTangent.y, 511.f, 0x3ff) << 10
+            | snorm(aTangent.z, 511.f, 0x3ff) << 20
+            | snorm(aTangent.w, 1.f, 0x3) << 30;
+    }
+
+    // aTangents may be null if aTextcoords is; otherwise, the tangents are
+    // zero if it is.
+    std::vector<std::uint8_t> interleave_(std::size_t aCount, Vec3f const* aPositions, std::uint32_t const* aMaterialIds, Vec3f const* aNormals, Vec2f const* aTextcoords, Vec4f const* aTangents)
+    {
+        std::size_t const stride = interleaved_vertex_size(aTextcoords != nullptr);
+
+        std::vector<std::uint8_t> vertices(aCount * stride);
+        for (std::size_t i = 0; i < aCount; ++i)
+        {
+            std::uint8_t* v = vertices.data() + i * stride;
+            std::memcpy(v, &aPositions[i], sizeof(Vec3f));
+            std::memcpy(v + 12, &aNormals[i], sizeof(Vec3f));
+            std::memcpy(v + 24, &aMaterialIds[i], sizeof(std::uint32_t));
+            if (aTextcoords)
+            {
+                std::memcpy(v + 28, &aTextcoords[i], sizeof(Vec2f));
+
+                std::uint32_t const tangent = aTangents ? pack_tangent_(aTangents[i]) : 0u;
+                std::memcpy(v + 36, &tangent, sizeof(std::uint32_t));
+            }
+        }
+
+        return vertices;
+    }
+
+    GLuint create_interleaved_vao_(void const* aVertices, std::size_t aCount, bool aHasTextcoords)
+    {
+        std::size_t const stride = interleaved_vertex_size(aHasTextcoords);
+
+        GLuint vbo = 0;
+        glGenBuffers(1, &vbo);
+        glBindBuffer(GL_ARRAY_BUFFER, vbo);
+        glBufferData(GL_ARRAY_BUFFER, aCount * stride, aVertices, GL_STATIC_DRAW);
+        glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+        GLuint vao = 0;
+        glGenVertexArrays(1, &vao);
+        glBindVertexArray(vao);
+
+        glBindVertexBuffer(kVertexBinding_, vbo, 0, GLsizei(stride));
+
+        glVertexAttribFormat(0, 3, GL_FLOAT, GL_FALSE, 0);
+        glVertexAttribBinding(0, kVertexBinding_);
+        glEnableVertexAttribArray(0);
+
+        glVertexAttribIFormat(1, 1, GL_UNSIGNED_INT, 24);
+        glVertexAttribBinding(1, kVertexBinding_);
+        glEnableVertexAttribArray(1);
+
+        glVertexAttribFormat(2, 3, GL_FLOAT, GL_FALSE, 12);
+        glVertexAttribBinding(2, kVertexBinding_);
+        glEnableVertexAttribArray(2);
+
+        if (aHasTextcoords)
+        {
+            glVertexAttribFormat(3, 2, GL_FLOAT, GL_FALSE, 28);
+            glVertexAttribBinding(3, kVertexBinding_);
+            glEnableVertexAttribArray(3);
+
+            glVertexAttribFormat(4, 4, GL_INT_2_10_10_10_REV, GL_TRUE, 36);
+            glVertexAttribBinding(4, kVertexBinding_);
+            glEnableVertexAttribArray(4);
+        }
+
+        glBindVertexArray(0);
+
+        // The VAO keeps the buffer alive.
+        glDeleteBuffers(1, &vbo);
+
+        return vao;
+    }
+
+    GLuint create_vao_(std::size_t aCount, Vec3f const* aPositions, std::uint32_t const* aMaterialIds, Vec3f const* aNormals, Vec2f const* aTextcoords)
+    {
+        // Unindexed: each vertex has a single triangle, so there are no
+        // mirrored vertices to split.
+        std::vector<Vec4f> tangents;
+        if (aTextcoords)
+        {
+            tangents.resize(aCount);
+            compute_vertex_tangents(aCount, nullptr, aCount, aPositions, aNormals, aTextcoords, tangents.data());
+        }
+
+        std::vector<std::uint8_t> const vertices = interleave_(aCount, aPositions, aMaterialIds, aNormals, aTextcoords, tangents.data());
+        return create_interleaved_vao_(vertices.data(), aCount, aTextcoords);
+    }
+}
+
 SimpleMeshDataWithoutTexture concatenate(SimpleMeshDataWithoutTexture aM, SimpleMeshDataWithoutTexture const& aN)
 {
+    std::uint32_t const materialBase = std::uint32_t(aM.materials.size());
+
     aM.positions.insert(aM.positions.end(), aN.positions.begin(), aN.positions.end());
-    aM.colors.insert(aM.colors.end(), aN.colors.begin(), aN.colors.end());
+    for (std::uint32_t const id : aN.materialIds)
+        aM.materialIds.emplace_back(materialBase + id);
     aM.normals.insert(aM.normals.end(), aN.normals.begin(), aN.normals.end());
+    aM.materials.insert(aM.materials.end(), aN.materials.begin(), aN.materials.end());
     return aM;
 }
 
+std::size_t SharedNormalSums::KeyHash::operator()(std::array<std::uint32_t, 3> const& aKey) const noexcept
+{
+    return std::size_t(hash_weld_key_(aKey));
+}
 
-GLuint create_vao(SimpleMeshData const& aMeshData)
+IndexedMeshData weld_vertices(SimpleMeshData const& aMesh)
 {
-    // Generate and bind VBO for positions
-    GLuint vboPositions = 0;
-    glGenBuffers(1, &vboPositions);
-    glBindBuffer(GL_ARRAY_BUFFER, vboPositions);
-    glBufferData(GL_ARRAY_BUFFER, aMeshData.positions.size() * sizeof(Vec3f), aMeshData.positions.data(), GL_STATIC_DRAW);
+    std::size_t const count = aMesh.positions.size();
+    assert(aMesh.materialIds.size() == count && aMesh.normals.size() == count);
+    assert(aMesh.textcoords.empty() || aMesh.textcoords.size() == count);
 
-    GLuint vboColors = 0;
-    glGenBuffers(1, &vboColors);
-    glBindBuffer(GL_ARRAY_BUFFER, vboColors);
-    glBufferData(GL_ARRAY_BUFFER, aMeshData.colors.size() * sizeof(Vec3f), aMeshData.colors.data(), GL_STATIC_DRAW);
+    // Open addressing with linear probing. The table holds output vertex
+    // indices and is kept at most half full.
+    std::size_t tableSize = 1;
+    while (tableSize < 2 * count)
+        tableSize *= 2;
 
-    GLuint vboNormals = 0;
-    glGenBuffers(1, &vboNormals);
-    glBindBuffer(GL_ARRAY_BUFFER, vboNormals);
-    glBufferData(GL_ARRAY_BUFFER, aMeshData.normals.size() * sizeof(Vec3f), aMeshData.normals.data(), GL_STATIC_DRAW);
+    std::uint32_t const kEmpty = ~std::uint32_t(0);
+    std::vector<std::uint32_t> table(tableSize, kEmpty);
+    std::vector<std::uint32_t> firstUse; // output vertex -> input vertex
 
-    GLuint vboTextures = 0;
-    glGenBuffers(1, &vboTextures);
-    glBindBuffer(GL_ARRAY_BUFFER, vboTextures);
-    glBufferData(GL_ARRAY_BUFFER, aMeshData.textcoords.size() * sizeof(Vec2f), aMeshData.textcoords.data(), GL_STATIC_DRAW);
+    IndexedMeshData ret;
+    ret.indices.reserve(count);
 
-    GLuint vao = 0;
-    glGenVertexArrays(1, &vao);
-    glBindVertexArray(vao);
+    WeldKey_ key, other;
+    for (std::size_t i = 0; i < count; ++i)
+    {
+        make_weld_key_(aMesh, i, key);
 
-    glBindBuffer(GL_ARRAY_BUFFER, vboPositions);
-    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 0, 0);
-    glEnableVertexAttribArray(0);
+        std::size_t slot = hash_weld_key_(key) & (tableSize - 1);
+        for (;; slot = (slot + 1) & (tableSize - 1))
+        {
+            if (table[slot] == kEmpty)
+            {
+                table[slot] = std::uint32_t(firstUse.size());
+                firstUse.emplace_back(std::uint32_t(i));
+                break;
+            }
 
-    glBindBuffer(GL_ARRAY_BUFFER, vboColors);
-    glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 0, 0);
-    glEnableVertexAttribArray(1);
+            make_weld_key_(aMesh, firstUse[table[slot]], other);
+            if (0 == std::memcmp(key, other, sizeof(WeldKey_)))
+                break;
+        }
 
-    glBindBuffer(GL_ARRAY_BUFFER, vboNormals);
-    glVertexAttribPointer(2, 3, GL_FLOAT, GL_FALSE, 0, 0);
-    glEnableVertexAttribArray(2);
+        ret.indices.emplace_back(table[slot]);
+    }
 
-    glBindBuffer(GL_ARRAY_BUFFER, vboTextures);
-    glVertexAttribPointer(3, 2, GL_FLOAT, GL_FALSE, 0, 0);
-    glEnableVertexAttribArray(3);
+    std::size_t const unique = firstUse.size();
+    ret.positions.reserve(unique);
+    ret.materialIds.reserve(unique);
+    ret.normals.reserve(unique);
+    if (!aMesh.textcoords.empty())
+        ret.textcoords.reserve(unique);
 
-    glBindVertexArray(0);
-    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    for (std::uint32_t const i : firstUse)
+    {
+        ret.positions.emplace_back(aMesh.positions[i]);
+        ret.materialIds.emplace_back(aMesh.materialIds[i]);
+        ret.normals.emplace_back(aMesh.normals[i]);
+        if (!aMesh.textcoords.empty())
+            ret.textcoords.emplace_back(aMesh.textcoords[i]);
+    }
+
+    ret.materials = aMesh.materials;
+    return ret;
+}
+
+void add_shared_normal_sums(SimpleMeshData const& aMesh, SharedNormalSums& aShared)
+{
+    std::vector<Vec3f> positions;
+    std::vector<std::uint32_t> positionIds;
+    weld_positions_(aMesh.positions, positions, positionIds);
+
+    std::size_t const triangles = positionIds.size() / 3;
+    std::vector<Vec3f> sums(positions.size());
+    compute_vertex_normal_sums(3 * triangles, positionIds.data(), positions.size(), positions.data(), sums.data());
 
-    glDeleteBuffers(1, &vboColors);
-    glDeleteBuffers(1, &vboPositions);
-    glDeleteBuffers(1, &vboNormals);
-    glDeleteBuffers(1, &vboTextures);
+    // Edges with a single triangle, as (smaller id, larger id) pairs
+    std::vector<std::uint64_t> edges;
+    edges.reserve(3 * triangles);
+    for (std::size_t i = 0; i < 3 * triangles; ++i)
+    {
+        std::uint64_t const a = positionIds[i];
+        std::uint64_t const b = positionIds[i - i % 3 + (i + 1) % 3];
+        if (a != b)
+            edges.emplace_back(std::min(a, b) << 32 | std::max(a, b));
+    }
+    std::sort(edges.begin(), edges.end());
 
-    return vao;
+    std::vector<bool> boundary(positions.size());
+    for (std::size_t i = 0; i < edges.size(); )
+    {
+        std::size_t j = i + 1;
+        while (j < edges.size() && edges[j] == edges[i])
+            ++j;
 
+        if (j - i == 1)
+        {
+            boundary[std::size_t(edges[i] >> 32)] = true;
+            boundary[std::size_t(edges[i] & 0xffffffffu)] = true;
+        }
+        i = j;
+    }
 
+    for (std::size_t i = 0; i < positions.size(); ++i)
+    {
+        if (boundary[i])
+            aShared.sums[position_key_(positions[i])] += sums[i];
+    }
+}
+
+std::size_t generate_missing_normals(IndexedMeshData& aMesh, SharedNormalSums const* aShared)
+{
+    std::size_t const missing = std::size_t(std::count_if(aMesh.normals.begin(), aMesh.normals.end(), [] (Vec3f const& aN) {
+        return 0.f == dot(aN, aN);
+    }));
+    if (0 == missing)
+        return 0;
+
+    // Vertices with equal positions (bitwise, as in weld_vertices()) count
+    // as one, so that the normals are smooth across texture seams and
+    // material boundaries.
+    std::vector<Vec3f> positions;
+    std::vector<std::uint32_t> positionIds;
+    weld_positions_(aMesh.positions, positions, positionIds);
+
+    std::vector<std::uint32_t> indices(aMesh.indices.size());
+    for (std::size_t i = 0; i < indices.size(); ++i)
+        indices[i] = positionIds[aMesh.indices[i]];
+
+    std::vector<Vec3f> normals(positions.size());
+    compute_vertex_normal_sums(indices.size(), indices.data(), positions.size(), positions.data(), normals.data());
+
+    for (std::size_t i = 0; i < normals.size(); ++i)
+    {
+        if (aShared)
+        {
+            auto const it = aShared->sums.find(position_key_(positions[i]));
+            if (aShared->sums.end() != it)
+                normals[i] = it->second;
+        }
+
+        float const len = length(normals[i]);
+        normals[i] = len > 0.f ? normals[i] / len : Vec3f{ 0.f, 0.f, 0.f };
+    }
+
+    std::size_t const count = aMesh.positions.size();
+    for (std::size_t i = 0; i < count; ++i)
+    {
+        if (0.f == dot(aMesh.normals[i], aMesh.normals[i]))
+            aMesh.normals[i] = normals[positionIds[i]];
+    }
+
+    return missing;
+}
+
+std::size_t generate_tangents(IndexedMeshData& aMesh)
+{
+    aMesh.tangents.clear();
+    if (aMesh.textcoords.empty())
+        return 0;
+
+    std::vector<std::uint32_t> sources;
+    std::size_t const split = split_mirrored_vertices(aMesh.indices.size(), aMesh.indices.data(), aMesh.positions.size(), aMesh.textcoords.data(), sources);
+
+    append_vertex_copies(aMesh.positions, sources);
+    append_vertex_copies(aMesh.materialIds, sources);
+    append_vertex_copies(aMesh.normals, sources);
+    append_vertex_copies(aMesh.textcoords, sources);
+
+    std::size_t const count = aMesh.positions.size();
+    aMesh.tangents.resize(count);
+    compute_vertex_tangents(aMesh.indices.size(), aMesh.indices.data(), count, aMesh.positions.data(), aMesh.normals.data(), aMesh.textcoords.data(), aMesh.tangents.data());
+
+    return split;
+}
+
+MeshOptimizationReport optimize_mesh(IndexedMeshData& aMesh)
+{
+    std::size_t const vertexCount = aMesh.positions.size();
+    auto& indices = aMesh.indices;
+
+    MeshOptimizationReport ret{};
+    ret.before = analyze_vertex_cache(indices.size(), indices.data(), vertexCount);
+
+    std::vector<std::uint32_t> reordered(indices.size());
+    optimize_vertex_cache(indices.size(), indices.data(), vertexCount, reordered.data());
+    optimize_overdraw(reordered.size(), reordered.data(), vertexCount, aMesh.positions.data(), indices.data());
+
+    std::vector<std::uint32_t> remap(vertexCount);
+    std::size_t const unique = optimize_vertex_fetch_remap(indices.size(), indices.data(), vertexCount, remap.data());
+    remap_indices(indices.size(), indices.data(), remap.data(), indices.data());
+    remap_vertices(aMesh.positions, remap.data(), unique);
+    remap_vertices(aMesh.materialIds, remap.data(), unique);
+    remap_vertices(aMesh.normals, remap.data(), unique);
+    remap_vertices(aMesh.textcoords, remap.data(), unique);
+    remap_vertices(aMesh.tangents, remap.data(), unique);
+
+    ret.after = analyze_vertex_cache(indices.size(), indices.data(), unique);
+    return ret;
+}
+
+GLuint create_vao(SimpleMeshData const& aMeshData)
+{
+    return create_vao_(aMeshData.positions.size(), aMeshData.positions.data(), aMeshData.materialIds.data(), aMeshData.normals.data(), aMeshData.textcoords.data());
 }
 
 GLuint create_vao_without_texture(SimpleMeshDataWithoutTexture const& aMeshData)
 {
-    // Generate and bind VBO for positions
-    GLuint vboPositions = 0;
-    glGenBuffers(1, &vboPositions);
-    glBindBuffer(GL_ARRAY_BUFFER, vboPositions);
-    glBufferData(GL_ARRAY_BUFFER, aMeshData.positions.size() * sizeof(Vec3f), aMeshData.positions.data(), GL_STATIC_DRAW);
+    return create_vao_(aMeshData.positions.size(), aMeshData.positions.data(), aMeshData.materialIds.data(), aMeshData.normals.data(), nullptr);
+}
+
+GLuint create_material_buffer(std::vector<Material> const& aMaterials)
+{
+    if (aMaterials.size() > kMaxMaterials)
+        throw Error("Too many materials (%zu, at most %zu)", aMaterials.size(), kMaxMaterials);
+
+    // std140: one vec4 per entry. Unused entries are zero.
+    std::vector<float> colors(4 * kMaxMaterials, 0.f);
+    for (std::size_t i = 0; i < aMaterials.size(); ++i)
+    {
+        colors[4*i+0] = aMaterials[i].color.x;
+        colors[4*i+1] = aMaterials[i].color.y;
+        colors[4*i+2] = aMaterials[i].color.z;
+    }
+
+    GLuint ubo = 0;
+    glGenBuffers(1, &ubo);
+    glBindBuffer(GL_UNIFORM_BUFFER, ubo);
+    glBufferData(GL_UNIFORM_BUFFER, colors.size() * sizeof(float), colors.data(), GL_STATIC_DRAW);
+    glBindBuffer(GL_UNIFORM_BUFFER, 0);
+    return ubo;
+}
+
+std::size_t interleaved_vertex_size(bool aHasTextcoords) noexcept
+{
+    return aHasTextcoords ? 40 : 28;
+}
+
+std::vector<std::uint8_t> interleave_vertices(IndexedMeshData const& aMeshData)
+{
+    assert(aMeshData.tangents.empty() || aMeshData.tangents.size() == aMeshData.positions.size());
+    return interleave_(aMeshData.positions.size(), aMeshData.positions.data(), aMeshData.materialIds.data(), aMeshData.normals.data(),
+        aMeshData.textcoords.empty() ? nullptr : aMeshData.textcoords.data(),
+        aMeshData.tangents.empty() ? nullptr : aMeshData.tangents.data());
+}
 
-    GLuint vboColors = 0;
-    glGenBuffers(1, &vboColors);
-    glBindBuffer(GL_ARRAY_BUFFER, vboColors);
-    glBufferData(GL_ARRAY_BUFFER, aMeshData.colors.size() * sizeof(Vec3f), aMeshData.colors.data(), GL_STATIC_DRAW);
+std::vector<std::uint8_t> pack_indices(IndexedMeshData const& aMeshData, GLenum& aIndexType)
+{
+    std::vector<std::uint8_t> ret;
+    if (aMeshData.positions.size() <= 65536)
+    {
+        aIndexType = GL_UNSIGNED_SHORT;
+        ret.resize(aMeshData.indices.size() * sizeof(std::uint16_t));
+        for (std::size_t i = 0; i < aMeshData.indices.size(); ++i)
+        {
+            std::uint16_t const index = std::uint16_t(aMeshData.indices[i]);
+            std::memcpy(ret.data() + i * sizeof(std::uint16_t), &index, sizeof(std::uint16_t));
+        }
+    }
+    else
+    {
+        aIndexType = GL_UNSIGNED_INT;
+        ret.resize(aMeshData.indices.size() * sizeof(std::uint32_t));
+        if (!ret.empty())
+            std::memcpy(ret.data(), aMeshData.indices.data(), ret.size());
+    }
+    return ret;
+}
 
-    GLuint vboNormals = 0;
-    glGenBuffers(1, &vboNormals);
-    glBindBuffer(GL_ARRAY_BUFFER, vboNormals);
-    glBufferData(GL_ARRAY_BUFFER, aMeshData.normals.size() * sizeof(Vec3f), aMeshData.normals.data(), GL_STATIC_DRAW);
+IndexedMesh create_indexed_vao(IndexedMeshData const& aMeshData)
+{
+    std::vector<std::uint8_t> const vertices = interleave_vertices(aMeshData);
 
+    GLenum indexType;
+    std::vector<std::uint8_t> const indices = pack_indices(aMeshData, indexType);
 
-    GLuint vao = 0;
-    glGenVertexArrays(1, &vao);
-    glBindVertexArray(vao);
+    return create_indexed_vao(vertices.data(), aMeshData.positions.size(), !aMeshData.textcoords.empty(), indices.data(), aMeshData.indices.size(), indexType, aMeshData.materials);
+}
 
-    glBindBuffer(GL_ARRAY_BUFFER, vboPositions);
-    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 0, 0);
-    glEnableVertexAttribArray(0);
+IndexedMesh create_indexed_vao(void const* aVertices, std::size_t aVertexCount, bool aHasTextcoords, void const* aIndices, std::size_t aIndexCount, GLenum aIndexType, std::vector<Material> const& aMaterials)
+{
+    assert(GL_UNSIGNED_SHORT == aIndexType || GL_UNSIGNED_INT == aIndexType);
 
-    glBindBuffer(GL_ARRAY_BUFFER, vboColors);
-    glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 0, 0);
-    glEnableVertexAttribArray(1);
+    IndexedMesh ret{};
+    ret.vao = create_interleaved_vao_(aVertices, aVertexCount, aHasTextcoords);
+    ret.indexCount = GLsizei(aIndexCount);
+    ret.indexType = aIndexType;
+    ret.materials = create_material_buffer(aMaterials);
 
-    glBindBuffer(GL_ARRAY_BUFFER, vboNormals);
-    glVertexAttribPointer(2, 3, GL_FLOAT, GL_FALSE, 0, 0);
-    glEnableVertexAttribArray(2);
+    // The element array binding is stored in the VAO, so the VAO must be
+    // bound when the index buffer is bound.
+    glBindVertexArray(ret.vao);
 
-    glBindVertexArray(0);
-    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    GLuint ebo = 0;
+    glGenBuffers(1, &ebo);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, ebo);
 
-    glDeleteBuffers(1, &vboColors);
-    glDeleteBuffers(1, &vboPositions);
-    glDeleteBuffers(1, &vboNormals);
+    std::size_t const indexSize = GL_UNSIGNED_SHORT == aIndexType ? sizeof(std::uint16_t) : sizeof(std::uint32_t);
+    glBufferData(GL_ELEMENT_ARRAY_BUFFER, aIndexCount * indexSize, aIndices, GL_STATIC_DRAW);
 
+    glBindVertexArray(0);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+    glDeleteBuffers(1, &ebo);
 
-    return vao;
+    return ret;
 }
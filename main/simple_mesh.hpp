@@ -3,28 +3,170 @@
 
 #include <glad.h>
 
+#include <array>
 #include <vector>
+#include <unordered_map>
+
+#include <cstddef>
+#include <cstdint>
 
 #include "../vmlib/vec3.hpp"
 #include "../vmlib/vec2.hpp"
+#include "../vmlib/vec4.hpp"
+#include "../vmlib/mesh_optimize.hpp"
+
+// Surface properties that are constant over a part of a mesh (an OBJ
+// material, or a sub-mesh of a MeshBuilder). Meshes store a table of
+// materials, and each vertex refers to its entry by index, instead of
+// repeating the color in every vertex. Shaders read the table from a uniform
+// buffer (see create_material_buffer()).
+struct Material
+{
+	Vec3f color;
+};
+
+// Number of entries of the uniform buffer, and its binding point. Shaders
+// declare it as
+//    layout(std140, binding = 0) uniform Materials { vec4 uMaterialColor[256]; };
+constexpr std::size_t kMaxMaterials = 256;
+constexpr GLuint kMaterialBinding = 0;
+
 struct SimpleMeshData
 {
 	std::vector<Vec3f> positions;
-	std::vector<Vec3f> colors;
+	std::vector<std::uint32_t> materialIds;
 	std::vector<Vec3f> normals;
 	std::vector<Vec2f> textcoords;
+
+	std::vector<Material> materials;
 };
 
 struct SimpleMeshDataWithoutTexture
 {
 	std::vector<Vec3f> positions;
-	std::vector<Vec3f> colors;
+	std::vector<std::uint32_t> materialIds;
 	std::vector<Vec3f> normals;
+
+	std::vector<Material> materials;
 };
 
+// Indexed variant of SimpleMeshData. Each distinct vertex is stored once;
+// triangles refer to vertices by index, three indices per triangle. The
+// tangents (handedness in w) are empty until generate_tangents() computes
+// them.
+struct IndexedMeshData
+{
+	std::vector<Vec3f> positions;
+	std::vector<std::uint32_t> materialIds;
+	std::vector<Vec3f> normals;
+	std::vector<Vec2f> textcoords;
+	std::vector<Vec4f> tangents;
+
+	std::vector<std::uint32_t> indices;
+
+	std::vector<Material> materials;
+};
+
+// Appends aN to aM; the materials of aN are appended to those of aM. Use a
+// MeshBuilder (see mesh_builder.hpp) to assemble a mesh from more than two
+// parts.
 SimpleMeshDataWithoutTexture concatenate(SimpleMeshDataWithoutTexture, SimpleMeshDataWithoutTexture const&);
 
+// Merges identical vertices of an unindexed mesh, such as the one returned by
+// load_wavefront_obj(). Two vertices are identical if their position,
+// material, normal and texture coordinate are bitwise equal (+0 and -0 count
+// as equal). Vertices are kept in order of first use.
+IndexedMeshData weld_vertices(SimpleMeshData const&);
+
+// Normal sums of the positions where the parts of a mesh meet, e.g. the
+// tiles of the streamed import (see obj_stream.hpp). Positions are keyed by
+// their bit patterns, as in weld_vertices().
+struct SharedNormalSums
+{
+	struct KeyHash
+	{
+		std::size_t operator()(std::array<std::uint32_t, 3> const&) const noexcept;
+	};
 
+	std::unordered_map<std::array<std::uint32_t, 3>, Vec3f, KeyHash> sums;
+};
+
+// Adds the angle-weighted normal sums (see compute_vertex_normal_sums()) of
+// the positions on the open boundary of an unindexed part, i.e. on edges
+// that belong to a single triangle of the part.
+void add_shared_normal_sums(SimpleMeshData const&, SharedNormalSums&);
+
+// Replaces the zero normals of a welded mesh (e.g., of OBJ faces without
+// normals) with smooth ones (see vmlib/vertex_normals.hpp), computed over
+// all triangles that share the position. With the sums of all parts of a
+// mesh, positions on a part's boundary use the totals instead, so the
+// normals agree across the parts. Returns the number of normals replaced.
+std::size_t generate_missing_normals(IndexedMeshData&, SharedNormalSums const* = nullptr);
+
+// Computes the tangents of a welded mesh with texture coordinates, for
+// normal mapping (see vmlib/vertex_normals.hpp). Vertices on mirrored UV
+// seams are split first, so the mesh can gain vertices; the normals must be
+// complete (see generate_missing_normals()). Meshes without texture
+// coordinates get no tangents. Returns the number of vertices added.
+std::size_t generate_tangents(IndexedMeshData&);
+
+// Reorders the triangles and vertices of a welded mesh for faster rendering:
+// triangles for post-transform vertex cache locality, then clusters of
+// triangles to reduce overdraw, and finally the vertices in the order in
+// which they are first used (see vmlib/mesh_optimize.hpp). Vertices that are
+// not referenced by any triangle are removed. Returns the vertex cache
+// statistics before and after.
+struct MeshOptimizationReport
+{
+	VertexCacheStatistics before;
+	VertexCacheStatistics after;
+};
+
+MeshOptimizationReport optimize_mesh(IndexedMeshData&);
+
+
+// The create_*vao() functions interleave the vertex attributes into a single
+// buffer (bound with glBindVertexBuffer()), using the attribute locations
+// 0 = position, 1 = material index (an unsigned integer attribute), 2 =
+// normal, 3 = texture coordinate and 4 = tangent (a normalized vec4, with
+// the handedness in w; see generate_tangents()). Meshes without texture
+// coordinates have neither of the last two. The materials themselves go
+// into a separate uniform buffer.
 GLuint create_vao(SimpleMeshData const&);
 GLuint create_vao_without_texture(SimpleMeshDataWithoutTexture const&);
+
+// Uniform buffer with the colors of aMaterials, in the layout of the
+// Materials block (kMaxMaterials vec4s). Bind it to kMaterialBinding with
+// glBindBufferBase(GL_UNIFORM_BUFFER, ...) before drawing. Throws Error if
+// there are more than kMaxMaterials materials.
+GLuint create_material_buffer(std::vector<Material> const& aMaterials);
+
+// VAO for an IndexedMeshData. The index buffer is part of the VAO's state,
+// so drawing only requires
+//    glBindVertexArray(mesh.vao);
+//    glDrawElements(GL_TRIANGLES, mesh.indexCount, mesh.indexType, nullptr);
+// 16-bit indices are used when the mesh has few enough vertices.
+struct IndexedMesh
+{
+	GLuint vao;
+	GLsizei indexCount;
+	GLenum indexType;
+
+	GLuint materials; // see create_material_buffer()
+};
+
+IndexedMesh create_indexed_vao(IndexedMeshData const&);
+
+// The buffers that create_indexed_vao() uploads, in their final form: the
+// interleaved vertices (interleaved_vertex_size() bytes per vertex), and the
+// indices as 16-bit (GL_UNSIGNED_SHORT) or 32-bit (GL_UNSIGNED_INT) values,
+// whichever the mesh needs. They can be stored, e.g. in a mesh cache (see
+// mesh_cache.hpp), and later be uploaded as they are with the second
+// create_indexed_vao().
+std::size_t interleaved_vertex_size(bool aHasTextcoords) noexcept;
+
+std::vector<std::uint8_t> interleave_vertices(IndexedMeshData const&);
+std::vector<std::uint8_t> pack_indices(IndexedMeshData const&, GLenum& aIndexType);
+
+IndexedMesh create_indexed_vao(void const* aVertices, std::size_t aVertexCount, bool aHasTextcoords, void const* aIndices, std::size_t aIndexCount, GLenum aIndexType, std::vector<Material> const& aMaterials);
 #endif // SIMPLE_MESH_HPP_C6B749D6_C83B_434C_9E58_F05FC27FEFC9
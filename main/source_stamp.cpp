@@ -0,0 +1,78 @@
+#include "source_stamp.hpp"
+
+#include <filesystem>
+#include <system_error>
+
+#include <cstddef>
+
+#include "../support/error.hpp"
+#include "../support/mapped_file.hpp"
+
+namespace
+{
+    // Size and modification time of the file; false if it does not exist.
+    bool stat_(char const* aPath, std::uint64_t& aSize, std::int64_t& aTime)
+    {
+        std::error_code ec;
+        auto const size = std::filesystem::file_size(aPath, ec);
+        if (ec)
+            return false;
+        auto const time = std::filesystem::last_write_time(aPath, ec);
+        if (ec)
+            return false;
+
+        aSize = size;
+        aTime = std::int64_t(time.time_since_epoch().count());
+        return true;
+    }
+
+    // Files are hashed through a window of this size, so that even files
+    // larger than the address space can be hashed.
+    constexpr std::size_t kHashWindow_ = 64 * 1024 * 1024;
+
+    std::uint64_t hash_file_(char const* aPath)
+    {
+        std::uint64_t h = 14695981039346656037ull;
+        for (std::uint64_t offset = 0;; offset += kHashWindow_)
+        {
+            MappedFile const window(aPath, offset, kHashWindow_);
+            auto const* bytes = static_cast<unsigned char const*>(window.data());
+
+            for (std::size_t i = 0; i < window.size(); ++i)
+                h = (h ^ bytes[i]) * 1099511628211ull;
+
+            if (window.size() < kHashWindow_)
+                return h;
+        }
+    }
+}
+
+SourceStamp make_source_stamp(char const* aPath)
+{
+    SourceStamp ret{};
+    if (!stat_(aPath, ret.size, ret.time))
+        throw Error("Unable to query '%s'", aPath);
+
+    ret.hash = hash_file_(aPath);
+    return ret;
+}
+
+bool matches_source_stamp(char const* aPath, SourceStamp const& aStamp)
+{
+    std::uint64_t size;
+    std::int64_t time;
+    if (!stat_(aPath, size, time) || size != aStamp.size)
+        return false;
+
+    if (time == aStamp.time)
+        return true;
+
+    try
+    {
+        return hash_file_(aPath) == aStamp.hash;
+    }
+    catch (Error const&)
+    {
+        return false;
+    }
+}
@@ -0,0 +1,28 @@
+#ifndef SOURCE_STAMP_HPP_D0AE422D_5810_4885_8C01_A68E7F9E75ED
+#define SOURCE_STAMP_HPP_D0AE422D_5810_4885_8C01_A68E7F9E75ED
+
+#include <type_traits>
+
+#include <cstdint>
+
+// Identifies the version of a source file (OBJ, image) that a cache was
+// built from. Caches store the stamp in their header, and are rebuilt when
+// the source no longer matches it.
+struct SourceStamp
+{
+    std::uint64_t size;
+    std::int64_t time;  // last write time, in file clock ticks
+    std::uint64_t hash; // 64-bit FNV-1a of the contents
+};
+
+static_assert(std::is_trivially_copyable_v<SourceStamp> && 24 == sizeof(SourceStamp), "SourceStamp is written to files as is");
+
+// Stamp of the file aPath. Throws Error if it cannot be read.
+SourceStamp make_source_stamp(char const* aPath);
+
+// Whether the file aPath matches aStamp. Comparing size and time is enough in
+// the common case; the contents are only hashed when the time differs (e.g.
+// after a fresh checkout). False if the file does not exist.
+bool matches_source_stamp(char const* aPath, SourceStamp const& aStamp);
+
+#endif // SOURCE_STAMP_HPP_D0AE422D_5810_4885_8C01_A68E7F9E75ED
@@ -1,23 +1,44 @@
 #include "texture.hpp"
 
+#include <utility>
+#include <algorithm>
+
 #include <cassert>
+#include <cstddef>
 
 #include <stb_image.h>
 
 #include "../support/error.hpp"
 
-GLuint load_texture_2d(char const* aPath) {
+DecodedImage decode_image_rgba(char const* aPath) {
 	assert(aPath);
-	stbi_set_flip_vertically_on_load(true);
+	// Not stbi_set_flip_vertically_on_load(): that setting is global, and
+	// images may be decoded on several threads at once. The rows are flipped
+	// below instead.
 	int w, h, channels;
 	stbi_uc* ptr = stbi_load(aPath, &w, &h, &channels, 4);
 	if (!ptr)
 		throw Error("Unable to load image �%s�\n", aPath);
+
+	DecodedImage ret{ w, h, { ptr, &stbi_image_free } };
+
+	std::size_t const rowSize = std::size_t(w) * 4;
+	for (int y = 0; y < h / 2; ++y)
+	{
+		stbi_uc* top = ptr + y * rowSize;
+		stbi_uc* bottom = ptr + (h - 1 - y) * rowSize;
+		std::swap_ranges(top, top + rowSize, bottom);
+	}
+
+	return ret;
+}
+
+GLuint create_texture_2d(DecodedImage const& aImage) {
+	assert(aImage.pixels);
 	GLuint tex = 0;
 	glGenTextures(1, &tex);
 	glBindTexture(GL_TEXTURE_2D, tex);
-	glTexImage2D(GL_TEXTURE_2D, 0, GL_SRGB8_ALPHA8, w, h, 0, GL_RGBA, GL_UNSIGNED_BYTE, ptr);
-	stbi_image_free(ptr);
+	glTexImage2D(GL_TEXTURE_2D, 0, GL_SRGB8_ALPHA8, aImage.width, aImage.height, 0, GL_RGBA, GL_UNSIGNED_BYTE, aImage.pixels.get());
 	glGenerateMipmap(GL_TEXTURE_2D);
 	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
 	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
@@ -26,4 +47,8 @@ GLuint load_texture_2d(char const* aPath) {
 	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
 	glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_MAX_ANISOTROPY, 6.f);
 	return tex;
-}
\ No newline at end of file
+}
+
+GLuint load_texture_2d(char const* aPath) {
+	return create_texture_2d(decode_image_rgba(aPath));
+}
@@ -3,6 +3,22 @@
 
 #include <glad.h>
 
+#include <memory>
+
+// Decoded RGBA8 image, bottom row first (as OpenGL expects).
+struct DecodedImage
+{
+	int width;
+	int height;
+	std::unique_ptr<unsigned char, void (*)(void*)> pixels{ nullptr, nullptr };
+};
+
+// Decoding does not touch OpenGL, so it can run on any thread (e.g. while
+// the main thread sets up the window). create_texture_2d() then uploads the
+// image on the thread that owns the GL context.
+DecodedImage decode_image_rgba(char const* aPath);
+GLuint create_texture_2d(DecodedImage const&);
+
 GLuint load_texture_2d(char const* aPath);
 
 #endif // TEXTURE_HPP_D0746DED_C9C6_40CD_B6E0_C6FEF665DD31
@@ -0,0 +1,224 @@
+#include "texture_cache.hpp"
+
+#include <utility>
+#include <filesystem>
+#include <type_traits>
+#include <system_error>
+
+#include <cstring>
+
+#include "../support/error.hpp"
+
+#include "../vmlib/texture_compress.hpp"
+
+#include "texture.hpp"
+#include "cache_file.hpp"
+#include "source_stamp.hpp"
+
+namespace
+{
+    // File layout (see cache_file.hpp).
+    //
+    //    Header_
+    //    levels    (levelCount x LevelRecord_)
+    //    data      (the BC7 blocks of each level, in level order)
+    //
+    // Increment kVersion_ whenever the layout changes, or the mips or the
+    // compression (downsample_srgb8(), compress_bc7()) change their results.
+    constexpr std::uint32_t kMagic_ = 0x58455456; // "VTEX" in little endian
+    constexpr std::uint32_t kVersion_ = 1;
+
+    constexpr GLenum kFormat_ = GL_COMPRESSED_SRGB_ALPHA_BPTC_UNORM;
+
+    struct Header_
+    {
+        std::uint32_t magic;
+        std::uint32_t version;
+        std::uint64_t fileSize;
+
+        SourceStamp source; // image
+
+        std::uint32_t format;
+        std::uint32_t levelCount;
+        std::uint64_t levelOffset;
+    };
+
+    struct LevelRecord_
+    {
+        std::uint32_t width, height;
+        std::uint64_t offset;
+        std::uint64_t size;
+    };
+
+    static_assert(std::is_trivially_copyable_v<Header_> && 56 == sizeof(Header_), "unexpected header layout");
+    static_assert(std::is_trivially_copyable_v<LevelRecord_> && 24 == sizeof(LevelRecord_), "unexpected level layout");
+
+    // Maps the cache; false if there is none, or it is out of date or
+    // damaged.
+    bool open_cache_(char const* aSourcePath, CompressedImage& aImage)
+    {
+        std::string const path = texture_cache_path(aSourcePath);
+
+        std::error_code ec;
+        if (!std::filesystem::exists(path, ec))
+            return false;
+
+        MappedFile file;
+        try
+        {
+            file = MappedFile(path.c_str());
+        }
+        catch (Error const&)
+        {
+            return false;
+        }
+
+        auto const* base = static_cast<unsigned char const*>(file.data());
+        std::uint64_t const fileSize = file.size();
+
+        Header_ header;
+        if (fileSize < sizeof(Header_))
+            return false;
+        std::memcpy(&header, base, sizeof(Header_));
+
+        if (kMagic_ != header.magic || kVersion_ != header.version || fileSize != header.fileSize || kFormat_ != header.format)
+            return false;
+        if (0 == header.levelCount || !cache_section_in_file(header.levelOffset, std::uint64_t(header.levelCount) * sizeof(LevelRecord_), fileSize))
+            return false;
+        if (!matches_source_stamp(aSourcePath, header.source))
+            return false;
+
+        std::vector<CompressedImage::Level> levels(header.levelCount);
+        for (std::size_t i = 0; i < levels.size(); ++i)
+        {
+            LevelRecord_ record;
+            std::memcpy(&record, base + header.levelOffset + i * sizeof(LevelRecord_), sizeof(LevelRecord_));
+            if (0 == record.width || 0 == record.height || bc7_size(record.width, record.height) != record.size || !cache_section_in_file(record.offset, record.size, fileSize))
+                return false;
+
+            levels[i] = CompressedImage::Level{ int(record.width), int(record.height), base + record.offset, std::size_t(record.size) };
+        }
+
+        aImage.format = kFormat_;
+        aImage.levels = std::move(levels);
+        aImage.file = std::move(file);
+        return true;
+    }
+
+    void write_cache_(char const* aSourcePath, CompressedImage const& aImage)
+    {
+        Header_ header{};
+        header.magic = kMagic_;
+        header.version = kVersion_;
+        header.source = make_source_stamp(aSourcePath);
+        header.format = aImage.format;
+        header.levelCount = std::uint32_t(aImage.levels.size());
+        header.levelOffset = cache_align(sizeof(Header_));
+
+        std::vector<LevelRecord_> records;
+        std::uint64_t offset = header.levelOffset + aImage.levels.size() * sizeof(LevelRecord_);
+        for (auto const& level : aImage.levels)
+        {
+            offset = cache_align(offset);
+            records.emplace_back(LevelRecord_{ std::uint32_t(level.width), std::uint32_t(level.height), offset, level.size });
+            offset += level.size;
+        }
+        header.fileSize = offset;
+
+        CacheFileWriter file(texture_cache_path(aSourcePath));
+        file.section(&header, sizeof(Header_));
+        file.section(records.data(), records.size() * sizeof(LevelRecord_));
+        for (auto const& level : aImage.levels)
+            file.section(level.data, level.size);
+        file.commit();
+    }
+
+    // Builds the mip chain and compresses each level into aImage.memory.
+    void compress_image_(DecodedImage const& aDecoded, CompressedImage& aImage)
+    {
+        std::size_t const width = std::size_t(aDecoded.width);
+        std::size_t const height = std::size_t(aDecoded.height);
+        std::size_t const levelCount = mip_level_count(width, height);
+
+        std::vector<std::size_t> offsets(levelCount);
+        std::size_t total = 0;
+        for (std::size_t i = 0; i < levelCount; ++i)
+        {
+            offsets[i] = total;
+            total += bc7_size(mip_size(width, i), mip_size(height, i));
+        }
+        aImage.memory.resize(total);
+
+        // Two RGBA8 buffers: the current level, and the next one
+        std::vector<std::uint8_t> mip(4 * mip_size(width, 1) * mip_size(height, 1));
+        std::vector<std::uint8_t> next(mip.size());
+
+        std::uint8_t const* level = aDecoded.pixels.get();
+        for (std::size_t i = 0; i < levelCount; ++i)
+        {
+            std::size_t const w = mip_size(width, i);
+            std::size_t const h = mip_size(height, i);
+
+            compress_bc7(w, h, level, aImage.memory.data() + offsets[i]);
+            aImage.levels.emplace_back(CompressedImage::Level{ int(w), int(h), aImage.memory.data() + offsets[i], bc7_size(w, h) });
+
+            if (i + 1 < levelCount)
+            {
+                downsample_srgb8(w, h, level, next.data());
+                std::swap(mip, next);
+                level = mip.data();
+            }
+        }
+    }
+}
+
+std::string texture_cache_path(char const* aSourcePath)
+{
+    return std::string(aSourcePath) + ".vtex";
+}
+
+CompressedImage load_compressed_image(char const* aSourcePath)
+{
+    CompressedImage ret{};
+    if (open_cache_(aSourcePath, ret))
+        return ret;
+
+    ret.format = kFormat_;
+    compress_image_(decode_image_rgba(aSourcePath), ret);
+
+    // The compressed levels stay in memory either way; the cache only saves
+    // time on the next run.
+    try
+    {
+        write_cache_(aSourcePath, ret);
+    }
+    catch (std::exception const& eErr)
+    {
+        std::fprintf(stderr, "Warning: %s\n", eErr.what());
+    }
+
+    return ret;
+}
+
+GLuint create_compressed_texture_2d(CompressedImage const& aImage)
+{
+    GLuint tex = 0;
+    glGenTextures(1, &tex);
+    glBindTexture(GL_TEXTURE_2D, tex);
+
+    for (std::size_t i = 0; i < aImage.levels.size(); ++i)
+    {
+        auto const& level = aImage.levels[i];
+        glCompressedTexImage2D(GL_TEXTURE_2D, GLint(i), aImage.format, level.width, level.height, 0, GLsizei(level.size), level.data);
+    }
+
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_BASE_LEVEL, 0);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, GLint(aImage.levels.size()) - 1);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_MAX_ANISOTROPY, 6.f);
+    return tex;
+}
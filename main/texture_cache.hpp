@@ -0,0 +1,58 @@
+#ifndef TEXTURE_CACHE_HPP_4A1FB1A9_08B5_441D_9CAA_6F3F6BBDEB4B
+#define TEXTURE_CACHE_HPP_4A1FB1A9_08B5_441D_9CAA_6F3F6BBDEB4B
+
+#include <glad.h>
+
+#include <string>
+#include <vector>
+
+#include <cstddef>
+#include <cstdint>
+
+#include "../support/mapped_file.hpp"
+
+// Block compressed textures, cached on disk.
+//
+// A decoded 4k RGBA8 image with its mips takes about 85 MB of video memory,
+// and glGenerateMipmap() has to build the mips on every run (averaging the
+// sRGB values directly on some drivers, which darkens the smaller levels).
+// Instead, the mip chain is built once with downsample_srgb8() and every
+// level is compressed to BC7 with compress_bc7() (see texture_compress.hpp),
+// which needs a quarter of the memory and bandwidth. The result is written
+// next to the image (see texture_cache_path()), and later runs map the file
+// and pass the levels directly to glCompressedTexImage2D().
+//
+// A cache is only used if it has the current format version and matches the
+// image (see source_stamp.hpp).
+struct CompressedImage
+{
+    struct Level
+    {
+        int width;
+        int height;
+        void const* data;
+        std::size_t size; // bytes
+    };
+
+    GLenum format;
+    std::vector<Level> levels; // level 0 = full size, bottom row first
+
+    // Storage of the levels: the mapped cache or, if the cache could not be
+    // written, memory.
+    MappedFile file;
+    std::vector<std::uint8_t> memory;
+};
+
+// Path of the cache for the image aSourcePath: the same path with ".vtex"
+// appended.
+std::string texture_cache_path(char const* aSourcePath);
+
+// Maps the cache of aSourcePath, or builds it from the image if there is no
+// usable cache. A cache that cannot be written is only reported; the image
+// is then kept in memory. Does not use OpenGL, so it can run on any thread.
+// Throws Error if the image cannot be loaded.
+CompressedImage load_compressed_image(char const* aSourcePath);
+
+GLuint create_compressed_texture_2d(CompressedImage const&);
+
+#endif // TEXTURE_CACHE_HPP_4A1FB1A9_08B5_441D_9CAA_6F3F6BBDEB4B
@@ -0,0 +1,58 @@
+#include "unit_primitive.hpp"
+
+#include <algorithm>
+
+#include <cmath>
+
+#include "../vmlib/vec4.hpp"
+#include "../vmlib/mat33.hpp"
+#include "../vmlib/transform_batch.hpp"
+
+UnitPrimitiveCache::UnitPrimitiveCache(Generator aGenerate) noexcept
+    : mGenerate(aGenerate)
+{}
+
+UnitPrimitive const& UnitPrimitiveCache::get(bool aCapped, std::size_t aSubdivs)
+{
+    std::lock_guard<std::mutex> const lock(mMutex);
+
+    auto const key = std::make_pair(aCapped, aSubdivs);
+    auto it = mEntries.find(key);
+    if (mEntries.end() == it)
+        it = mEntries.emplace(key, mGenerate(aCapped, aSubdivs)).first;
+
+    return it->second;
+}
+
+void instantiate_primitive(MeshBuilder& aBuilder, UnitPrimitive const& aUnit, Vec3f aColor, Mat44f const& aPreTransform)
+{
+    auto const out = aBuilder.add_submesh(aUnit.positions.size(), Material{ aColor });
+
+    transform_points(aPreTransform, out.count, aUnit.positions.data(), out.positions);
+    transform_vectors(normal_matrix(aPreTransform), out.count, aUnit.normals.data(), out.normals, true);
+}
+
+std::size_t circle_subdivision_level(float aRadiusPixels, float aMaxPixelError)
+{
+    constexpr float kPi = 3.1415926f;
+
+    std::size_t level = 0;
+    while (level + 1 < kCircleSubdivisionLevelCount)
+    {
+        float const segments = float(kCircleSubdivisionLevels[level]);
+        if (aRadiusPixels * (1.f - std::cos(kPi / segments)) <= aMaxPixelError)
+            break;
+
+        ++level;
+    }
+
+    return level;
+}
+
+float transformed_unit_radius(Mat44f const& aTransform)
+{
+    Vec4f const y = aTransform * Vec4f{ 0.f, 1.f, 0.f, 0.f };
+    Vec4f const z = aTransform * Vec4f{ 0.f, 0.f, 1.f, 0.f };
+
+    return std::sqrt(std::max(y.x*y.x + y.y*y.y + y.z*y.z, z.x*z.x + z.y*z.y + z.z*z.z));
+}
@@ -0,0 +1,71 @@
+#ifndef UNIT_PRIMITIVE_HPP_20A2C3BB_3437_4CFB_B525_13C4BAA28D0E
+#define UNIT_PRIMITIVE_HPP_20A2C3BB_3437_4CFB_B525_13C4BAA28D0E
+
+#include <map>
+#include <mutex>
+#include <vector>
+#include <utility>
+#include <iterator>
+
+#include <cstddef>
+
+#include "mesh_builder.hpp"
+
+#include "../vmlib/vec3.hpp"
+#include "../vmlib/mat44.hpp"
+
+// Parametric primitives (see cylinder.hpp, cone.hpp) in their unit frame:
+// the axis runs along x from 0 to 1, and the radius is 1. A unit primitive
+// only depends on whether it is capped and on its subdivision count, so it
+// is generated once per combination and then instantiated as often as
+// needed by transforming it (see instantiate_primitive()), which skips the
+// trigonometry and normal computations.
+struct UnitPrimitive
+{
+    std::vector<Vec3f> positions;
+    std::vector<Vec3f> normals;
+};
+
+// Memo of the unit primitives of one kind, keyed by (capped, subdivisions).
+// Safe to use from several threads. Entries are never removed, so the
+// returned references stay valid.
+class UnitPrimitiveCache final
+{
+public:
+    using Generator = UnitPrimitive (*)(bool aCapped, std::size_t aSubdivs);
+
+    explicit UnitPrimitiveCache(Generator) noexcept;
+
+    UnitPrimitive const& get(bool aCapped, std::size_t aSubdivs);
+
+private:
+    Generator mGenerate;
+
+    std::mutex mMutex;
+    std::map<std::pair<bool, std::size_t>, UnitPrimitive> mEntries;
+};
+
+// Adds aUnit to aBuilder as a new sub-mesh, transformed by aPreTransform.
+void instantiate_primitive(MeshBuilder& aBuilder, UnitPrimitive const& aUnit, Vec3f aColor, Mat44f const& aPreTransform);
+
+// Subdivision levels for round primitives. A circle with n segments deviates
+// from the true circle by r (1 - cos(pi/n)), so the number of segments needed
+// for a given error in pixels grows with the square root of the circle's
+// projected radius. circle_subdivisions() returns the smallest level that
+// keeps the deviation within aMaxPixelError pixels for a circle with a
+// radius of aRadiusPixels pixels (the largest level if none does).
+constexpr std::size_t kCircleSubdivisionLevels[] = { 4, 8, 16, 32, 64 };
+constexpr std::size_t kCircleSubdivisionLevelCount = std::size(kCircleSubdivisionLevels);
+
+std::size_t circle_subdivision_level(float aRadiusPixels, float aMaxPixelError = 0.5f);
+
+inline std::size_t circle_subdivisions(float aRadiusPixels, float aMaxPixelError = 0.5f)
+{
+    return kCircleSubdivisionLevels[circle_subdivision_level(aRadiusPixels, aMaxPixelError)];
+}
+
+// Radius of the circle with unit radius in the y-z plane, after aTransform
+// (the larger of the two semi-axes if the scaling is not uniform).
+float transformed_unit_radius(Mat44f const& aTransform);
+
+#endif // UNIT_PRIMITIVE_HPP_20A2C3BB_3437_4CFB_B525_13C4BAA28D0E
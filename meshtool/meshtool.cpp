@@ -0,0 +1,466 @@
+// meshtool: inspect what an OBJ mesh costs before it reaches the renderer.
+//
+// The mesh goes through the same pipeline as in main (see loadobj.hpp,
+// simple_mesh.hpp, mesh_lod.hpp and mesh_cache.hpp), with each step timed,
+// and the result is summarized: vertex and triangle counts, how many corners
+// share a vertex, the size of each vertex attribute and of the buffers that
+// are uploaded, the vertex cache efficiency and the overdraw (see
+// vmlib/mesh_optimize.hpp) before and after optimize_mesh(), the bounds, and
+// the levels of detail. Optionally, the processed mesh is written as an OBJ
+// and/or as the mesh cache that main loads instead of the OBJ.
+//
+// Run without arguments for the usage.
+#include <vector>
+#include <string>
+#include <optional>
+#include <algorithm>
+#include <exception>
+#include <typeinfo>
+
+#include <cstdio>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+
+#include "../support/error.hpp"
+
+#include "../vmlib/bounds.hpp"
+#include "../vmlib/mesh_optimize.hpp"
+
+#include "../main/defaults.hpp"
+#include "../main/loadobj.hpp"
+#include "../main/simple_mesh.hpp"
+#include "../main/mesh_lod.hpp"
+#include "../main/mesh_cache.hpp"
+#include "../main/obj_stream.hpp"
+
+namespace
+{
+	constexpr char const* kUsage_ =
+		"Usage: meshtool [options] <file.obj>\n"
+		"\n"
+		"Loads the OBJ as main does and prints what it costs.\n"
+		"\n"
+		"Options:\n"
+		"  --parts X Z     split into X x Z parts for the levels of detail (1 1)\n"
+		"  --levels N      levels of detail per part (5)\n"
+		"  --reduction R   triangles of each level relative to the previous one (0.5)\n"
+		"  --streamed MB   import out of core, with MB megabytes of working memory\n"
+		"                  (see obj_stream.hpp); always writes the mesh cache\n"
+		"  --cache         write the mesh cache (<file.obj>.vmesh)\n"
+		"  --obj PATH      write the welded and optimized mesh to PATH, with its\n"
+		"                  materials in PATH.mtl\n"
+		"\n"
+		"main only uses a cache that was written with the parameters it loads\n"
+		"the mesh with.\n";
+
+	struct Options_
+	{
+		char const* input = nullptr;
+		MeshCacheParams params;
+
+		bool writeCache = false;
+		char const* objOutput = nullptr;
+	};
+
+	Options_ parse_options_(int aArgc, char* aArgv[]);
+
+	// Milliseconds since aStart
+	float ms_since_(Clock::time_point aStart);
+
+	// Vertex cache and overdraw statistics of a triangle list
+	struct DrawStatistics_
+	{
+		VertexCacheStatistics cache;
+		OverdrawStatistics overdraw;
+	};
+
+	DrawStatistics_ analyze_draw_(std::vector<std::uint32_t> const& aIndices, std::vector<Vec3f> const& aPositions);
+
+	void print_timing_(char const* aStep, float aMs);
+	void print_bounds_(Aabb3f const&);
+	void print_buffers_(std::size_t aVertexCount, bool aHasTextcoords, std::size_t aIndexCount, GLenum aIndexType, std::size_t aTriangleCount);
+	void print_draw_(char const* aName, DrawStatistics_ const&);
+	void print_draw_(char const* aName, DrawStatistics_ const& aBefore, DrawStatistics_ const& aAfter);
+	void print_levels_(std::vector<LodPart> const&, std::size_t aMeshletCount);
+
+	void inspect_in_memory_(Options_ const&);
+	void inspect_streamed_(Options_ const&);
+
+	// Writes aMesh as an OBJ with one vertex (v, vn and, if present, vt) per
+	// welded vertex, and its materials as the ambient and diffuse colors of
+	// aPath.mtl. Throws Error on failure.
+	void write_wavefront_obj_(char const* aPath, IndexedMeshData const& aMesh);
+}
+
+int main(int aArgc, char* aArgv[]) try
+{
+	if (aArgc < 2)
+	{
+		std::fprintf(stderr, "%s", kUsage_);
+		return 2;
+	}
+
+	Options_ const options = parse_options_(aArgc, aArgv);
+
+	if (options.params.memoryBudget)
+		inspect_streamed_(options);
+	else
+		inspect_in_memory_(options);
+
+	return 0;
+}
+catch( std::exception const& eErr )
+{
+	std::fprintf( stderr, "Top-level Exception (%s):\n", typeid(eErr).name() );
+	std::fprintf( stderr, "%s\n", eErr.what() );
+	std::fprintf( stderr, "Bye.\n" );
+	return 1;
+}
+
+namespace
+{
+	Options_ parse_options_(int aArgc, char* aArgv[])
+	{
+		Options_ ret;
+
+		auto const value_ = [&] (int& aI) -> char const* {
+			if (aI+1 >= aArgc)
+				throw Error("%s: missing value\n\n%s", aArgv[aI], kUsage_);
+			return aArgv[++aI];
+		};
+		auto const unsigned_ = [&] (int& aI) {
+			char const* option = aArgv[aI];
+			char const* value = value_(aI);
+
+			char* end = nullptr;
+			unsigned long const ret = std::strtoul(value, &end, 10);
+			if (end == value || *end || 0 == ret || '-' == value[0])
+				throw Error("%s: expected a positive integer, got '%s'", option, value);
+			return ret;
+		};
+
+		for (int i = 1; i < aArgc; ++i)
+		{
+			char const* arg = aArgv[i];
+			if (0 == std::strcmp(arg, "--parts"))
+			{
+				ret.params.partsX = unsigned(unsigned_(i));
+				ret.params.partsZ = unsigned(unsigned_(i));
+			}
+			else if (0 == std::strcmp(arg, "--levels"))
+				ret.params.levelCount = unsigned_(i);
+			else if (0 == std::strcmp(arg, "--reduction"))
+			{
+				char const* value = value_(i);
+
+				char* end = nullptr;
+				ret.params.reduction = std::strtof(value, &end);
+				if (end == value || *end || !(ret.params.reduction > 0.f && ret.params.reduction < 1.f))
+					throw Error("--reduction: expected a number between 0 and 1, got '%s'", value);
+			}
+			else if (0 == std::strcmp(arg, "--streamed"))
+				ret.params.memoryBudget = std::uint64_t(unsigned_(i)) << 20;
+			else if (0 == std::strcmp(arg, "--cache"))
+				ret.writeCache = true;
+			else if (0 == std::strcmp(arg, "--obj"))
+				ret.objOutput = value_(i);
+			else if ('-' == arg[0])
+				throw Error("Unknown option '%s'\n\n%s", arg, kUsage_);
+			else if (ret.input)
+				throw Error("More than one input ('%s' and '%s')", ret.input, arg);
+			else
+				ret.input = arg;
+		}
+
+		if (!ret.input)
+			throw Error("No input\n\n%s", kUsage_);
+		if (ret.params.memoryBudget && ret.objOutput)
+			throw Error("--obj needs the whole mesh in memory, and cannot be combined with --streamed");
+
+		return ret;
+	}
+
+	float ms_since_(Clock::time_point aStart)
+	{
+		return 1000.f * std::chrono::duration_cast<Secondsf>(Clock::now() - aStart).count();
+	}
+
+	DrawStatistics_ analyze_draw_(std::vector<std::uint32_t> const& aIndices, std::vector<Vec3f> const& aPositions)
+	{
+		DrawStatistics_ ret;
+		ret.cache = analyze_vertex_cache(aIndices.size(), aIndices.data(), aPositions.size());
+		ret.overdraw = analyze_overdraw(aIndices.size(), aIndices.data(), aPositions.size(), aPositions.data());
+		return ret;
+	}
+
+	void print_timing_(char const* aStep, float aMs)
+	{
+		std::printf("  %-14s %10.1f ms\n", aStep, aMs);
+	}
+
+	void print_bounds_(Aabb3f const& aBounds)
+	{
+		Vec3f const size = aBounds.max - aBounds.min;
+		std::printf("  bounds         (%g, %g, %g) - (%g, %g, %g)\n",
+			aBounds.min.x, aBounds.min.y, aBounds.min.z,
+			aBounds.max.x, aBounds.max.y, aBounds.max.z
+		);
+		std::printf("  size           %g x %g x %g\n", size.x, size.y, size.z);
+	}
+
+	// The buffers of a LOD mesh, as uploaded by create_lod_vao(): the
+	// vertices in the layout of interleave_vertices(), and the indices of all
+	// parts and levels. For comparison, the size of an unindexed level 0 with
+	// aTriangleCount triangles.
+	void print_buffers_(std::size_t aVertexCount, bool aHasTextcoords, std::size_t aIndexCount, GLenum aIndexType, std::size_t aTriangleCount)
+	{
+		std::size_t const stride = interleaved_vertex_size(aHasTextcoords);
+		std::size_t const indexSize = GL_UNSIGNED_SHORT == aIndexType ? sizeof(std::uint16_t) : sizeof(std::uint32_t);
+
+		std::printf("Bytes per vertex:\n");
+		std::printf("  position       %10zu\n", sizeof(Vec3f));
+		std::printf("  normal         %10zu\n", sizeof(Vec3f));
+		std::printf("  material       %10zu\n", sizeof(std::uint32_t));
+		std::printf("  textcoord      %10zu\n", aHasTextcoords ? sizeof(Vec2f) : std::size_t(0));
+		std::printf("  tangent        %10zu (packed 10:10:10:2)\n", aHasTextcoords ? sizeof(std::uint32_t) : std::size_t(0));
+		std::printf("  interleaved    %10zu\n", stride);
+
+		std::printf("Buffers:\n");
+		std::printf("  vertices       %10.2f MiB\n", double(aVertexCount * stride) / (1 << 20));
+		std::printf("  indices        %10.2f MiB (%zu-bit, all levels)\n", double(aIndexCount * indexSize) / (1 << 20), 8 * indexSize);
+		std::printf("  unindexed      %10.2f MiB (level 0, one vertex per corner)\n", double(3 * aTriangleCount * stride) / (1 << 20));
+	}
+
+	void print_draw_(char const* aName, DrawStatistics_ const& aStats)
+	{
+		// ACMR and ATVR with a 16 entry FIFO cache, as in main
+		std::printf("  %-14s ACMR %.3f, ATVR %.3f, overdraw %.3f\n", aName, aStats.cache.acmr, aStats.cache.atvr, aStats.overdraw.overdraw);
+	}
+
+	void print_draw_(char const* aName, DrawStatistics_ const& aBefore, DrawStatistics_ const& aAfter)
+	{
+		std::printf("  %-14s ACMR %.3f -> %.3f, ATVR %.3f -> %.3f, overdraw %.3f -> %.3f\n", aName,
+			aBefore.cache.acmr, aAfter.cache.acmr,
+			aBefore.cache.atvr, aAfter.cache.atvr,
+			aBefore.overdraw.overdraw, aAfter.overdraw.overdraw
+		);
+	}
+
+	void print_levels_(std::vector<LodPart> const& aParts, std::size_t aMeshletCount)
+	{
+		// Triangles when all parts use level i (or their coarsest level), as
+		// in main, and the largest error of any part at that level.
+		std::size_t levels = 0;
+		for (auto const& part : aParts)
+			levels = std::max(levels, part.levels.size());
+
+		std::printf("Levels of detail: %zu part(s), %zu meshlet(s)\n", aParts.size(), aMeshletCount);
+		for (std::size_t i = 0; i < levels; ++i)
+		{
+			std::size_t triangles = 0;
+			float error = 0.f;
+			for (auto const& part : aParts)
+			{
+				auto const& level = part.levels[std::min(i, part.levels.size()-1)];
+				triangles += level.indexCount / 3;
+				error = std::max(error, level.error);
+			}
+
+			std::printf("  level %-8zu %10zu triangles, error %g\n", i, triangles, error);
+		}
+	}
+
+	void inspect_in_memory_(Options_ const& aOptions)
+	{
+		char const* path = aOptions.input;
+		std::printf("%s\n", path);
+
+		std::printf("Timings:\n");
+
+		// Corners without a normal already get a smooth one while loading.
+		auto start = Clock::now();
+		SimpleMeshData const loaded = load_wavefront_obj(path);
+		print_timing_("load", ms_since_(start));
+
+		start = Clock::now();
+		IndexedMeshData mesh = weld_vertices(loaded);
+		print_timing_("weld", ms_since_(start));
+
+		start = Clock::now();
+		std::size_t const splitVertices = generate_tangents(mesh);
+		print_timing_("tangents", ms_since_(start));
+
+		DrawStatistics_ const before = analyze_draw_(mesh.indices, mesh.positions);
+
+		start = Clock::now();
+		optimize_mesh(mesh);
+		print_timing_("optimize", ms_since_(start));
+
+		DrawStatistics_ const after = analyze_draw_(mesh.indices, mesh.positions);
+
+		start = Clock::now();
+		LodMeshData const lod = build_lod_mesh(mesh, aOptions.params.partsX, aOptions.params.partsZ, aOptions.params.levelCount, aOptions.params.reduction);
+		print_timing_("levels", ms_since_(start));
+
+		if (aOptions.writeCache)
+		{
+			start = Clock::now();
+			write_mesh_cache(path, aOptions.params, lod);
+			print_timing_("write cache", ms_since_(start));
+		}
+		if (aOptions.objOutput)
+		{
+			start = Clock::now();
+			write_wavefront_obj_(aOptions.objOutput, mesh);
+			print_timing_("write OBJ", ms_since_(start));
+		}
+
+		// The duplicates are the corners that weld_vertices() merged into
+		// an earlier one.
+		std::size_t const corners = loaded.positions.size();
+
+		std::printf("Mesh:\n");
+		std::printf("  triangles      %10zu\n", corners / 3);
+		std::printf("  corners        %10zu\n", corners);
+		std::printf("  vertices       %10zu (%.2f corners per vertex)\n", mesh.positions.size(), mesh.positions.empty() ? 0.0 : double(corners) / mesh.positions.size());
+		std::printf("  duplicates     %10.1f %% of corners\n", corners ? 100.0 * double(corners - mesh.positions.size()) / corners : 0.0);
+		std::printf("  tangents       %10zu vertices split at mirrored UV seams\n", splitVertices);
+		std::printf("  materials      %10zu\n", mesh.materials.size());
+		print_bounds_(make_aabb(mesh.positions));
+
+		// As pack_indices()
+		GLenum const indexType = lod.mesh.positions.size() <= 65536 ? GL_UNSIGNED_SHORT : GL_UNSIGNED_INT;
+		print_buffers_(lod.mesh.positions.size(), !lod.mesh.textcoords.empty(), lod.mesh.indices.size(), indexType, corners / 3);
+
+		std::printf("Drawing (level 0):\n");
+		print_draw_("optimize_mesh", before, after);
+
+		print_levels_(lod.parts, lod.meshlets.size());
+	}
+
+	void inspect_streamed_(Options_ const& aOptions)
+	{
+		char const* path = aOptions.input;
+		std::printf("%s\n", path);
+
+		std::printf("Timings:\n");
+
+		auto start = Clock::now();
+		ObjStreamReport const report = import_wavefront_obj_streamed(path, aOptions.params);
+		print_timing_("import", ms_since_(start));
+
+		start = Clock::now();
+		std::optional<MappedLodMesh> const cache = open_mesh_cache(path, aOptions.params);
+		if (!cache)
+			throw Error("'%s': the mesh cache that was just written cannot be opened", mesh_cache_path(path).c_str());
+		print_timing_("open cache", ms_since_(start));
+
+		// Level 0 of all parts, from the cache: the positions are at the start
+		// of each interleaved vertex.
+		std::size_t const stride = interleaved_vertex_size(cache->hasTextcoords);
+		auto const* vertices = static_cast<std::uint8_t const*>(cache->vertices);
+
+		std::vector<Vec3f> positions(cache->vertexCount);
+		for (std::size_t i = 0; i < positions.size(); ++i)
+			std::memcpy(&positions[i], vertices + i * stride, sizeof(Vec3f));
+
+		std::vector<std::uint32_t> indices;
+		for (auto const& part : cache->parts)
+		{
+			LodLevel const& level = part.levels.front();
+			for (std::size_t i = level.firstIndex; i < level.firstIndex + level.indexCount; ++i)
+			{
+				if (GL_UNSIGNED_SHORT == cache->indexType)
+					indices.emplace_back(static_cast<std::uint16_t const*>(cache->indices)[i]);
+				else
+					indices.emplace_back(static_cast<std::uint32_t const*>(cache->indices)[i]);
+			}
+		}
+
+		Aabb3f bounds = kEmptyAabb3f;
+		for (auto const& part : cache->parts)
+			bounds = merge(bounds, part.bounds);
+
+		std::printf("Mesh:\n");
+		std::printf("  triangles      %10llu\n", (unsigned long long)report.triangles);
+		std::printf("  corners        %10llu\n", 3 * (unsigned long long)report.triangles);
+		std::printf("  positions      %10llu\n", (unsigned long long)report.positions);
+		std::printf("  vertices       %10zu (%.2f corners per vertex)\n", cache->vertexCount, cache->vertexCount ? 3.0 * double(report.triangles) / cache->vertexCount : 0.0);
+		std::printf("  materials      %10zu\n", cache->materials.size());
+		std::printf("  tiles          %10zu of %u x %u\n", report.parts, report.tilesX, report.tilesZ);
+		print_bounds_(bounds);
+
+		print_buffers_(cache->vertexCount, cache->hasTextcoords, cache->indexCount, cache->indexType, std::size_t(report.triangles));
+
+		// Vertices are not shared between tiles, so the "duplicates" are not
+		// comparable to those of the in-memory import, and are not shown.
+		std::printf("Drawing (level 0):\n");
+		print_draw_("cache", analyze_draw_(indices, positions));
+
+		print_levels_(cache->parts, cache->meshlets.size());
+	}
+
+	void write_wavefront_obj_(char const* aPath, IndexedMeshData const& aMesh)
+	{
+		std::string const mtlPath = std::string(aPath) + ".mtl";
+		std::string const mtlName = mtlPath.substr(mtlPath.find_last_of("/\\") + 1);
+
+		auto const open_ = [] (std::string const& aFile) {
+			std::FILE* ret = std::fopen(aFile.c_str(), "wb");
+			if (!ret)
+				throw Error("Unable to open '%s' for writing", aFile.c_str());
+			return ret;
+		};
+		auto const close_ = [] (std::FILE* aFile, std::string const& aName) {
+			bool const failed = std::ferror(aFile);
+			if (0 != std::fclose(aFile) || failed)
+				throw Error("Unable to write '%s'", aName.c_str());
+		};
+
+		std::FILE* mtl = open_(mtlPath);
+		for (std::size_t i = 0; i < aMesh.materials.size(); ++i)
+		{
+			Vec3f const c = aMesh.materials[i].color;
+			std::fprintf(mtl, "newmtl material%zu\nKa %.9g %.9g %.9g\nKd %.9g %.9g %.9g\n\n", i, c.x, c.y, c.z, c.x, c.y, c.z);
+		}
+		close_(mtl, mtlPath);
+
+		std::FILE* obj = open_(aPath);
+		std::fprintf(obj, "# %zu vertices, %zu triangles\nmtllib %s\n", aMesh.positions.size(), aMesh.indices.size() / 3, mtlName.c_str());
+
+		for (auto const& p : aMesh.positions)
+			std::fprintf(obj, "v %.9g %.9g %.9g\n", p.x, p.y, p.z);
+		for (auto const& n : aMesh.normals)
+			std::fprintf(obj, "vn %.9g %.9g %.9g\n", n.x, n.y, n.z);
+		for (auto const& t : aMesh.textcoords)
+			std::fprintf(obj, "vt %.9g %.9g\n", t.x, t.y);
+
+		// Materials are per vertex in the mesh, but per face in OBJ. The
+		// triangles are in their optimized order, so the material only
+		// changes between clusters.
+		bool const hasTextcoords = !aMesh.textcoords.empty();
+		std::uint32_t material = ~std::uint32_t(0);
+		for (std::size_t i = 0; i+2 < aMesh.indices.size(); i += 3)
+		{
+			std::uint32_t const m = aMesh.materialIds[aMesh.indices[i]];
+			if (m != material && m < aMesh.materials.size())
+			{
+				std::fprintf(obj, "usemtl material%u\n", m);
+				material = m;
+			}
+
+			std::fprintf(obj, "f");
+			for (std::size_t k = 0; k < 3; ++k)
+			{
+				std::uint32_t const v = aMesh.indices[i+k] + 1;
+				if (hasTextcoords)
+					std::fprintf(obj, " %u/%u/%u", v, v, v);
+				else
+					std::fprintf(obj, " %u//%u", v, v);
+			}
+			std::fprintf(obj, "\n");
+		}
+		close_(obj, aPath);
+	}
+}
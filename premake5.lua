@@ -1,3 +1,8 @@
+newoption {
+	trigger = "generic-arch",
+	description = "Do not build with -march=native (GCC/clang)"
+}
+
 workspace "COMP3811-cw2"
 	language "C++"
 	cppdialect "C++17"
@@ -19,13 +24,19 @@ workspace "COMP3811-cw2"
 	-- Default toolset options
 	filter "toolset:gcc or toolset:clang"
 		linkoptions { "-pthread" }
-		buildoptions { "-march=native", "-Wall", "-pthread" }
+		buildoptions { "-Wall", "-pthread" }
 
 		-- Varriable-length arrays (VLAs) are an extension that GCC and clang
 		-- have long supported. However, they are not part of the C++ standard.
 		-- (MSVC will not compile code with VLAs.)
 		buildoptions { "-Werror=vla" }
 
+	-- Generic builds (--generic-arch) leave out -march=native, e.g., to
+	-- compare benchmark results. The SIMD code in vmlib still selects the
+	-- instruction set at runtime.
+	filter { "toolset:gcc or toolset:clang", "not options:generic-arch" }
+		buildoptions { "-march=native" }
+
 	filter "toolset:msc-*"
 		warnings "extra" -- this enables /W4; default is /W3
 		--buildoptions { "/W4" }
@@ -36,6 +47,10 @@ workspace "COMP3811-cw2"
 	
 	filter "*"
 
+	-- Store vmlib matrices in column-major order, as OpenGL expects them
+	-- (see vmlib/mat44.hpp). This must be the same for all projects.
+	defines { "VMLIB_MATRIX_COLUMN_MAJOR=1" }
+
 	-- default libraries
 	filter "system:linux"
 		links "dl"
@@ -93,6 +108,34 @@ project "main"
 
 	files( sources )
 
+project "meshtool"
+	-- Command line tool that runs OBJ meshes through the same pipeline as
+	-- main (loading, welding, optimization, LOD, mesh cache), and prints
+	-- what they cost. It needs no window, but links the GL loader for the
+	-- VAO helpers in the shared sources.
+	local sources = { 
+		"meshtool/**.cpp",
+		"meshtool/**.hpp",
+		"main/defaults.hpp",
+		"main/loadobj.*",
+		"main/cache_file.*",
+		"main/simple_mesh.*",
+		"main/mesh_lod.*",
+		"main/mesh_cache.*",
+		"main/obj_stream.*",
+		"main/source_stamp.*"
+	}
+
+	kind "ConsoleApp"
+	location "meshtool"
+
+	files( sources )
+
+	links "vmlib"
+	links "support"
+
+	links "x-glad"
+
 project "main-shaders"
 	local shaders = { 
 		"assets/*.vert",
@@ -152,4 +195,22 @@ project "vmlib-test"
 
 	files( sources )
 
+project "vmlib-bench"
+	local sources = { 
+		"vmlib-bench/**.cpp",
+		"vmlib-bench/**.hpp",
+		"vmlib-bench/**.hxx",
+		"vmlib-bench/**.inl"
+	}
+
+	kind "ConsoleApp"
+	location "vmlib-bench"
+
+	files( sources )
+
+	links "vmlib"
+	links "x-catch2"
+
+	files( sources )
+
 --EOF
@@ -0,0 +1,194 @@
+#include "mapped_file.hpp"
+
+#include <limits>
+#include <utility>
+#include <algorithm>
+
+#include <cerrno>
+#include <cstring>
+
+#if defined(_WIN32)
+#	if !defined(WIN32_LEAN_AND_MEAN)
+#		define WIN32_LEAN_AND_MEAN
+#	endif
+#	if !defined(NOMINMAX)
+#		define NOMINMAX
+#	endif
+#	include <windows.h>
+#else
+#	include <fcntl.h>
+#	include <unistd.h>
+#	include <sys/mman.h>
+#	include <sys/stat.h>
+#endif
+
+#include "error.hpp"
+
+MappedFile::MappedFile() noexcept
+	: mData( nullptr )
+	, mSize( 0 )
+	, mView( nullptr )
+	, mViewSize( 0 )
+#	if defined(_WIN32)
+	, mFile( INVALID_HANDLE_VALUE )
+	, mMapping( nullptr )
+#	endif
+{}
+
+MappedFile::MappedFile( char const* aPath )
+	: MappedFile()
+{
+	map_( aPath, 0, std::numeric_limits<std::uint64_t>::max() );
+}
+
+MappedFile::MappedFile( char const* aPath, std::uint64_t aOffset, std::size_t aSize )
+	: MappedFile()
+{
+	map_( aPath, aOffset, aSize );
+}
+
+#if defined(_WIN32)
+void MappedFile::map_( char const* aPath, std::uint64_t aOffset, std::uint64_t aSize )
+{
+	mFile = CreateFileA( aPath, GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr );
+	if( INVALID_HANDLE_VALUE == mFile )
+		throw Error( "Unable to open '%s': error %lu", aPath, GetLastError() );
+
+	LARGE_INTEGER size;
+	if( !GetFileSizeEx( mFile, &size ) )
+	{
+		auto const err = GetLastError();
+		reset_();
+		throw Error( "Unable to query size of '%s': error %lu", aPath, err );
+	}
+
+	std::uint64_t const fileSize = std::uint64_t(size.QuadPart);
+	if( aOffset >= fileSize )
+		return;
+
+	// Views must start at a multiple of the allocation granularity
+	SYSTEM_INFO info;
+	GetSystemInfo( &info );
+
+	std::uint64_t const start = aOffset - aOffset % info.dwAllocationGranularity;
+	std::uint64_t const length = std::min( aSize, fileSize - aOffset );
+	if( length + (aOffset - start) > std::numeric_limits<SIZE_T>::max() )
+	{
+		reset_();
+		throw Error( "Unable to map '%s': too large for the address space", aPath );
+	}
+
+	mMapping = CreateFileMappingA( mFile, nullptr, PAGE_READONLY, 0, 0, nullptr );
+	if( !mMapping || !(mView = MapViewOfFile( mMapping, FILE_MAP_READ, DWORD(start >> 32), DWORD(start & 0xffffffffu), SIZE_T(length + (aOffset - start)) )) )
+	{
+		auto const err = GetLastError();
+		reset_();
+		throw Error( "Unable to map '%s': error %lu", aPath, err );
+	}
+
+	mViewSize = std::size_t(length + (aOffset - start));
+	mData = static_cast<char*>(mView) + (aOffset - start);
+	mSize = std::size_t(length);
+}
+#else // !_WIN32
+void MappedFile::map_( char const* aPath, std::uint64_t aOffset, std::uint64_t aSize )
+{
+	int const fd = ::open( aPath, O_RDONLY );
+	if( -1 == fd )
+		throw Error( "Unable to open '%s': %s", aPath, std::strerror( errno ) );
+
+	struct stat st;
+	if( 0 != ::fstat( fd, &st ) )
+	{
+		int const err = errno;
+		::close( fd );
+		throw Error( "Unable to stat '%s': %s", aPath, std::strerror( err ) );
+	}
+
+	std::uint64_t const fileSize = std::uint64_t(st.st_size);
+	if( aOffset < fileSize )
+	{
+		// Mappings must start at a multiple of the page size
+		std::uint64_t const page = std::uint64_t(::sysconf( _SC_PAGESIZE ));
+		std::uint64_t const start = aOffset - aOffset % page;
+		std::uint64_t const length = std::min( aSize, fileSize - aOffset );
+		if( length + (aOffset - start) > std::numeric_limits<std::size_t>::max() )
+		{
+			::close( fd );
+			throw Error( "Unable to map '%s': too large for the address space", aPath );
+		}
+
+		std::size_t const viewSize = std::size_t(length + (aOffset - start));
+		void* const view = ::mmap( nullptr, viewSize, PROT_READ, MAP_PRIVATE, fd, off_t(start) );
+		if( MAP_FAILED == view )
+		{
+			int const err = errno;
+			::close( fd );
+			throw Error( "Unable to map '%s': %s", aPath, std::strerror( err ) );
+		}
+
+		mView = view;
+		mViewSize = viewSize;
+		mData = static_cast<char*>(view) + (aOffset - start);
+		mSize = std::size_t(length);
+	}
+
+	// The mapping stays valid after the descriptor is closed.
+	::close( fd );
+}
+#endif // ~ _WIN32
+
+MappedFile::~MappedFile()
+{
+	reset_();
+}
+
+MappedFile::MappedFile( MappedFile&& aOther ) noexcept
+	: MappedFile()
+{
+	*this = std::move(aOther);
+}
+MappedFile& MappedFile::operator= (MappedFile&& aOther) noexcept
+{
+	std::swap( mData, aOther.mData );
+	std::swap( mSize, aOther.mSize );
+	std::swap( mView, aOther.mView );
+	std::swap( mViewSize, aOther.mViewSize );
+#	if defined(_WIN32)
+	std::swap( mFile, aOther.mFile );
+	std::swap( mMapping, aOther.mMapping );
+#	endif
+	return *this;
+}
+
+void const* MappedFile::data() const noexcept
+{
+	return mData;
+}
+std::size_t MappedFile::size() const noexcept
+{
+	return mSize;
+}
+
+void MappedFile::reset_() noexcept
+{
+#	if defined(_WIN32)
+	if( mView )
+		UnmapViewOfFile( mView );
+	if( mMapping )
+		CloseHandle( mMapping );
+	if( INVALID_HANDLE_VALUE != mFile )
+		CloseHandle( mFile );
+
+	mFile = INVALID_HANDLE_VALUE;
+	mMapping = nullptr;
+#	else
+	if( mView )
+		::munmap( mView, mViewSize );
+#	endif
+
+	mData = nullptr;
+	mSize = 0;
+	mView = nullptr;
+	mViewSize = 0;
+}
@@ -0,0 +1,54 @@
+#ifndef MAPPED_FILE_HPP_C5AF6F99_BECA_48E8_AD3B_2B2FD63CEF74
+#define MAPPED_FILE_HPP_C5AF6F99_BECA_48E8_AD3B_2B2FD63CEF74
+
+#include <cstddef>
+#include <cstdint>
+
+// Read-only memory mapping of a whole file. The pages are loaded on demand
+// by the OS, so opening even a large file is cheap, and data that is only
+// passed on (e.g. to glBufferData()) is never copied into a separate buffer.
+//
+// The second constructor maps only the aSize bytes at aOffset (fewer at the
+// end of the file), e.g. to walk through a file that is too large for the
+// address space in fixed-size windows. aOffset need not be aligned.
+//
+// The constructors throw Error if the file cannot be opened or mapped. An
+// empty file (or window) is valid; data() is then null.
+class MappedFile final
+{
+	public:
+		MappedFile() noexcept;
+		explicit MappedFile( char const* aPath );
+		MappedFile( char const* aPath, std::uint64_t aOffset, std::size_t aSize );
+
+		~MappedFile();
+
+		MappedFile( MappedFile const& ) = delete;
+		MappedFile& operator= (MappedFile const&) = delete;
+
+		MappedFile( MappedFile&& ) noexcept;
+		MappedFile& operator= (MappedFile&&) noexcept;
+
+	public:
+		void const* data() const noexcept;
+		std::size_t size() const noexcept;
+
+	private:
+		void map_( char const* aPath, std::uint64_t aOffset, std::uint64_t aSize );
+		void reset_() noexcept;
+
+	private:
+		void* mData;
+		std::size_t mSize;
+
+		// Mapped range, which starts at an aligned offset at or before mData
+		void* mView;
+		std::size_t mViewSize;
+
+#		if defined(_WIN32)
+		void* mFile;
+		void* mMapping;
+#		endif
+};
+
+#endif // MAPPED_FILE_HPP_C5AF6F99_BECA_48E8_AD3B_2B2FD63CEF74
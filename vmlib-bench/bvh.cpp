@@ -0,0 +1,63 @@
+#include <catch2/catch_amalgamated.hpp>
+
+#include <string>
+#include <vector>
+
+#include <cmath>
+#include <cstdint>
+
+#include "common.hpp"
+
+#include "../vmlib/bvh.hpp"
+
+TEST_CASE( "BVH", "[bvh]" VMLIB_BENCH_TAGS )
+{
+	// 256x256 quad height field, hit by a 64x64 grid of rays from above.
+	constexpr std::uint32_t kSize = 256;
+
+	std::vector<Vec3f> positions;
+	for( std::uint32_t z = 0; z <= kSize; ++z )
+	{
+		for( std::uint32_t x = 0; x <= kSize; ++x )
+			positions.emplace_back( Vec3f{ float(x), 4.f * std::sin( 0.1f * x ) * std::cos( 0.07f * z ), float(z) } );
+	}
+
+	std::vector<std::uint32_t> indices;
+	for( std::uint32_t z = 0; z < kSize; ++z )
+	{
+		for( std::uint32_t x = 0; x < kSize; ++x )
+		{
+			std::uint32_t const i = z * (kSize+1) + x;
+			indices.insert( indices.end(), { i, i + kSize+1, i+1 } );
+			indices.insert( indices.end(), { i+1, i + kSize+1, i + kSize+2 } );
+		}
+	}
+
+	std::vector<Rayf> rays;
+	for( std::uint32_t y = 0; y < 64; ++y )
+	{
+		for( std::uint32_t x = 0; x < 64; ++x )
+		{
+			Vec3f const target{ 4.f * x + 0.5f, 0.f, 4.f * y + 0.5f };
+			Vec3f const origin{ -20.f, 60.f, -20.f };
+			rays.emplace_back( Rayf{ origin, target - origin } );
+		}
+	}
+
+	BENCHMARK( "build_bvh (" + std::to_string( indices.size() / 3 ) + " triangles)" )
+	{
+		return build_bvh( indices.size(), indices.data(), positions.data() ).nodes.size();
+	};
+
+	Bvh const bvh = build_bvh( indices.size(), indices.data(), positions.data() );
+
+	bench::for_each_isa( "intersect x" + std::to_string( rays.size() ), [&] (std::string aName) {
+		BENCHMARK( std::move(aName) )
+		{
+			std::size_t hits = 0;
+			for( auto const& ray : rays )
+				hits += bool(intersect( bvh, ray, 2.f ));
+			return hits;
+		};
+	} );
+}
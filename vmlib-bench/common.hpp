@@ -0,0 +1,108 @@
+#ifndef COMMON_HPP_AE68C9B3_6C3B_42E7_912E_DD9A5EB987A8
+#define COMMON_HPP_AE68C9B3_6C3B_42E7_912E_DD9A5EB987A8
+
+#include <random>
+#include <string>
+#include <vector>
+
+#include "../vmlib/vec3.hpp"
+#include "../vmlib/mat44.hpp"
+#include "../vmlib/simd.hpp"
+
+// Shared helpers for the vmlib benchmarks.
+//
+// Run e.g.
+//    bin/vmlib-bench-release-x64-gcc.exe --reporter JSON::out=bench.json
+// to get machine readable results (Catch2 3.5 or newer; use the XML reporter
+// with older versions).
+//
+// Every test case is tagged with the compiler and with the instruction set the
+// build targets (kBuildTags), so that results from different toolchains and
+// from -march=native vs. generic builds can be told apart. Benchmarks of the
+// dispatched SIMD kernels are run once per supported instruction set, with the
+// instruction set appended to the benchmark name.
+
+#if defined(__clang__)
+#	define VMLIB_BENCH_COMPILER_ "[clang]"
+#elif defined(__GNUC__)
+#	define VMLIB_BENCH_COMPILER_ "[gcc]"
+#elif defined(_MSC_VER)
+#	define VMLIB_BENCH_COMPILER_ "[msvc]"
+#else
+#	define VMLIB_BENCH_COMPILER_ "[unknown-compiler]"
+#endif
+
+#if defined(__AVX2__)
+#	define VMLIB_BENCH_TARGET_ "[build-avx2]"
+#elif defined(__AVX__)
+#	define VMLIB_BENCH_TARGET_ "[build-avx]"
+#elif defined(__ARM_NEON) || defined(_M_ARM64)
+#	define VMLIB_BENCH_TARGET_ "[build-neon]"
+#else
+#	define VMLIB_BENCH_TARGET_ "[build-generic]"
+#endif
+
+#if defined(NDEBUG)
+#	define VMLIB_BENCH_CONFIG_ "[release]"
+#else
+#	define VMLIB_BENCH_CONFIG_ "[debug]"
+#endif
+
+#define VMLIB_BENCH_TAGS VMLIB_BENCH_COMPILER_ VMLIB_BENCH_TARGET_ VMLIB_BENCH_CONFIG_
+
+namespace bench
+{
+	inline
+	std::vector<Vec3f> random_points( std::size_t aCount, unsigned aSeed = 42 )
+	{
+		std::mt19937 rng( aSeed );
+		std::uniform_real_distribution<float> dist( -10.f, 10.f );
+
+		std::vector<Vec3f> ret( aCount );
+		for( auto& p : ret )
+			p = Vec3f{ dist(rng), dist(rng), dist(rng) };
+		return ret;
+	}
+
+	inline
+	Mat44f random_affine( std::mt19937& aRng )
+	{
+		std::uniform_real_distribution<float> angle( -3.f, 3.f );
+		std::uniform_real_distribution<float> offset( -10.f, 10.f );
+		std::uniform_real_distribution<float> scale( 0.5f, 2.f );
+		return make_translation( { offset(aRng), offset(aRng), offset(aRng) } )
+			* make_rotation_y( angle(aRng) )
+			* make_rotation_x( angle(aRng) )
+			* make_scaling( scale(aRng), scale(aRng), scale(aRng) );
+	}
+
+	inline
+	std::vector<Mat44f> random_affines( std::size_t aCount, unsigned aSeed = 42 )
+	{
+		std::mt19937 rng( aSeed );
+		std::vector<Mat44f> ret( aCount );
+		for( auto& m : ret )
+			m = random_affine( rng );
+		return ret;
+	}
+
+	// Calls aFunc( name ) once for each instruction set that the CPU
+	// supports, with that instruction set active. The name is aName with the
+	// instruction set appended, e.g., "mat44_mul_n [avx2]". The name is passed
+	// by value, since Catch's BENCHMARK() wants to take ownership of it.
+	template< typename tFunc >
+	void for_each_isa( std::string const& aName, tFunc&& aFunc )
+	{
+		auto const previous = simd_active_isa();
+		for( auto const isa : { SimdIsa::scalar, SimdIsa::sse2, SimdIsa::avx2, SimdIsa::neon } )
+		{
+			if( !simd_set_isa( isa ) )
+				continue;
+
+			aFunc( aName + " [" + simd_isa_name( isa ) + "]" );
+		}
+		simd_set_isa( previous );
+	}
+}
+
+#endif // COMMON_HPP_AE68C9B3_6C3B_42E7_912E_DD9A5EB987A8
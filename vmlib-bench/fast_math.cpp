@@ -0,0 +1,108 @@
+#include <catch2/catch_amalgamated.hpp>
+
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <cmath>
+
+#include "common.hpp"
+
+#include "../vmlib/fast_math.hpp"
+
+TEST_CASE( "Fast math", "[fastmath]" VMLIB_BENCH_TAGS )
+{
+	constexpr std::size_t kCount = 64*1024;
+
+	std::mt19937 rng( 42 );
+	std::uniform_real_distribution<float> angle( -10.f, 10.f );
+	std::uniform_real_distribution<float> coord( -100.f, 100.f );
+
+	std::vector<float> x( kCount ), y( kCount ), s( kCount ), c( kCount );
+	for( std::size_t i = 0; i < kCount; ++i )
+	{
+		x[i] = angle( rng );
+		y[i] = coord( rng );
+	}
+	std::vector<float> positive( kCount );
+	for( std::size_t i = 0; i < kCount; ++i )
+		positive[i] = std::abs( y[i] ) + 1e-3f;
+
+	auto vectors = bench::random_points( kCount );
+	std::vector<Vec3f> out( kCount );
+
+	std::string const suffix = " x" + std::to_string( kCount );
+
+	// libm references
+	BENCHMARK( "std::sin + std::cos" + suffix )
+	{
+		for( std::size_t i = 0; i < kCount; ++i )
+		{
+			s[i] = std::sin( x[i] );
+			c[i] = std::cos( x[i] );
+		}
+		return s[0] + c[0];
+	};
+	BENCHMARK( "std::atan2" + suffix )
+	{
+		for( std::size_t i = 0; i < kCount; ++i )
+			s[i] = std::atan2( y[i], x[i] );
+		return s[0];
+	};
+	BENCHMARK( "1/std::sqrt" + suffix )
+	{
+		for( std::size_t i = 0; i < kCount; ++i )
+			s[i] = 1.f / std::sqrt( positive[i] );
+		return s[0];
+	};
+	BENCHMARK( "normalize()" + suffix )
+	{
+		for( std::size_t i = 0; i < kCount; ++i )
+			out[i] = normalize( vectors[i] );
+		return out[0];
+	};
+
+	// Scalar fast versions (inline, no dispatch)
+	BENCHMARK( "fast_sincos" + suffix )
+	{
+		for( std::size_t i = 0; i < kCount; ++i )
+			fast_sincos( x[i], s[i], c[i] );
+		return s[0] + c[0];
+	};
+	BENCHMARK( "fast_atan2" + suffix )
+	{
+		for( std::size_t i = 0; i < kCount; ++i )
+			s[i] = fast_atan2( y[i], x[i] );
+		return s[0];
+	};
+
+	// Batched versions
+	bench::for_each_isa( "fast_sincos_n" + suffix, [&] (std::string aName) {
+		BENCHMARK( std::move( aName ) )
+		{
+			fast_sincos_n( kCount, x.data(), s.data(), c.data() );
+			return s[0] + c[0];
+		};
+	} );
+	bench::for_each_isa( "fast_atan2_n" + suffix, [&] (std::string aName) {
+		BENCHMARK( std::move( aName ) )
+		{
+			fast_atan2_n( kCount, y.data(), x.data(), s.data() );
+			return s[0];
+		};
+	} );
+	bench::for_each_isa( "fast_rsqrt_n" + suffix, [&] (std::string aName) {
+		BENCHMARK( std::move( aName ) )
+		{
+			fast_rsqrt_n( kCount, positive.data(), s.data() );
+			return s[0];
+		};
+	} );
+	bench::for_each_isa( "fast_normalize_n" + suffix, [&] (std::string aName) {
+		BENCHMARK( std::move( aName ) )
+		{
+			fast_normalize_n( kCount, vectors.data(), out.data() );
+			return out[0];
+		};
+	} );
+}
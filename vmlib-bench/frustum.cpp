@@ -0,0 +1,52 @@
+#include <catch2/catch_amalgamated.hpp>
+
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <cstdint>
+
+#include "common.hpp"
+
+#include "../vmlib/bounds.hpp"
+#include "../vmlib/frustum.hpp"
+
+TEST_CASE( "Frustum culling", "[frustum]" VMLIB_BENCH_TAGS )
+{
+	constexpr std::size_t kCount = 100000;
+
+	std::mt19937 rng( 42 );
+	std::uniform_real_distribution<float> pos( -150.f, 150.f );
+	std::uniform_real_distribution<float> size( 0.f, 10.f );
+
+	std::vector<Aabb3f> boxes( kCount );
+	for( auto& box : boxes )
+	{
+		Vec3f const p{ pos(rng), pos(rng), pos(rng) };
+		box = Aabb3f{ p, p + Vec3f{ size(rng), size(rng), size(rng) } };
+	}
+
+	Frustumf const frustum = make_frustum(
+		make_perspective_projection( 1.f, 1.5f, 0.1f, 100.f ) * make_rotation_y( 0.3f )
+	);
+
+	std::vector<std::uint8_t> visible( kCount );
+
+	BENCHMARK( "intersects() loop x100k" )
+	{
+		std::size_t count = 0;
+		for( std::size_t i = 0; i < kCount; ++i )
+		{
+			visible[i] = intersects( frustum, boxes[i] ) ? 1 : 0;
+			count += visible[i];
+		}
+		return count;
+	};
+
+	bench::for_each_isa( "frustum_cull x100k", [&] (std::string aName) {
+		BENCHMARK( std::move( aName ) )
+		{
+			return frustum_cull( frustum, kCount, boxes.data(), visible.data() );
+		};
+	} );
+}
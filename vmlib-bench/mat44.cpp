@@ -0,0 +1,122 @@
+#include <catch2/catch_amalgamated.hpp>
+
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "common.hpp"
+
+#include "../vmlib/mat44.hpp"
+#include "../vmlib/mat44_simd.hpp"
+#include "../vmlib/mat44_expr.hpp"
+
+TEST_CASE( "Mat44f single operations", "[mat44]" VMLIB_BENCH_TAGS )
+{
+	auto const ms = bench::random_affines( 2 );
+	Mat44f const a = ms[0];
+	Mat44f const b = ms[1];
+	Vec4f const v{ 1.f, 2.f, 3.f, 1.f };
+
+	BENCHMARK( "operator*(Mat44f,Mat44f)" )
+	{
+		return a * b;
+	};
+	BENCHMARK( "operator*(Mat44f,Vec4f)" )
+	{
+		return a * v;
+	};
+	BENCHMARK( "transpose" )
+	{
+		return transpose( a );
+	};
+	BENCHMARK( "invert" )
+	{
+		return invert( a );
+	};
+	BENCHMARK( "invert_affine" )
+	{
+		return invert_affine( a );
+	};
+	BENCHMARK( "invert_rigid" )
+	{
+		return invert_rigid( a );
+	};
+	BENCHMARK( "make_perspective_projection" )
+	{
+		return make_perspective_projection( 1.0472f, 1.7778f, 0.1f, 100.f );
+	};
+
+	bench::for_each_isa( "mat44_mul", [&] (std::string aName) {
+		BENCHMARK( std::move( aName ) )
+		{
+			return mat44_mul( a, b );
+		};
+	} );
+	bench::for_each_isa( "mat44_invert", [&] (std::string aName) {
+		BENCHMARK( std::move( aName ) )
+		{
+			return mat44_invert( a );
+		};
+	} );
+}
+
+TEST_CASE( "Mat44f product chains", "[mat44][expr]" VMLIB_BENCH_TAGS )
+{
+	auto const ms = bench::random_affines( 2 );
+	Mat44f const proj = make_perspective_projection( 1.0472f, 1.7778f, 0.1f, 100.f );
+	Mat44Perspective const projExpr = make_perspective_projection_expr( 1.0472f, 1.7778f, 0.1f, 100.f );
+
+	BENCHMARK( "projection * view * model (Mat44f)" )
+	{
+		return proj * ms[0] * ms[1];
+	};
+	BENCHMARK( "projection * view * model (mat44_expr)" )
+	{
+		return Mat44f( projExpr * Mat44Affine( ms[0] ) * Mat44Affine( ms[1] ) );
+	};
+}
+
+TEST_CASE( "Mat44f batches", "[mat44][batch]" VMLIB_BENCH_TAGS )
+{
+	constexpr std::size_t kCount = 4096;
+
+	auto const left = bench::random_affines( kCount, 1 );
+	auto const right = bench::random_affines( kCount, 2 );
+	auto const points = bench::random_points( kCount );
+
+	std::vector<Vec4f> vecs( kCount );
+	for( std::size_t i = 0; i < kCount; ++i )
+		vecs[i] = Vec4f{ points[i].x, points[i].y, points[i].z, 1.f };
+
+	std::vector<Mat44f> out( kCount );
+	std::vector<Vec4f> vout( kCount );
+
+	bench::for_each_isa( "mat44_mul_n x4096", [&] (std::string aName) {
+		BENCHMARK( std::move( aName ) )
+		{
+			mat44_mul_n( kCount, left.data(), right.data(), out.data() );
+			return out[0];
+		};
+	} );
+	bench::for_each_isa( "mat44_transpose_n x4096", [&] (std::string aName) {
+		BENCHMARK( std::move( aName ) )
+		{
+			mat44_transpose_n( kCount, left.data(), out.data() );
+			return out[0];
+		};
+	} );
+	bench::for_each_isa( "mat44_invert_n x4096", [&] (std::string aName) {
+		BENCHMARK( std::move( aName ) )
+		{
+			mat44_invert_n( kCount, left.data(), out.data() );
+			return out[0];
+		};
+	} );
+	bench::for_each_isa( "mat44_transform_n x4096", [&] (std::string aName) {
+		BENCHMARK( std::move( aName ) )
+		{
+			mat44_transform_n( left[0], kCount, vecs.data(), vout.data() );
+			return vout[0];
+		};
+	} );
+}
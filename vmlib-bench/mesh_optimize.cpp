@@ -0,0 +1,67 @@
+#include <catch2/catch_amalgamated.hpp>
+
+#include <random>
+#include <string>
+#include <vector>
+#include <algorithm>
+
+#include <cstdint>
+
+#include "common.hpp"
+
+#include "../vmlib/mesh_optimize.hpp"
+
+TEST_CASE( "Mesh optimization", "[meshopt]" VMLIB_BENCH_TAGS )
+{
+	// 256x256 quad grid with the triangles in random order.
+	constexpr std::uint32_t kSize = 256;
+
+	std::vector<Vec3f> positions;
+	for( std::uint32_t z = 0; z <= kSize; ++z )
+	{
+		for( std::uint32_t x = 0; x <= kSize; ++x )
+			positions.emplace_back( Vec3f{ float(x), 0.f, float(z) } );
+	}
+
+	std::vector<std::uint32_t> quads( kSize*kSize );
+	for( std::uint32_t i = 0; i < quads.size(); ++i )
+		quads[i] = (i / kSize) * (kSize+1) + i % kSize;
+
+	std::mt19937 rng( 42 );
+	std::shuffle( quads.begin(), quads.end(), rng );
+
+	std::vector<std::uint32_t> indices;
+	for( auto const i : quads )
+	{
+		indices.insert( indices.end(), { i, i + kSize+1, i+1 } );
+		indices.insert( indices.end(), { i+1, i + kSize+1, i + kSize+2 } );
+	}
+
+	std::vector<std::uint32_t> cached( indices.size() ), out( indices.size() ), remap( positions.size() );
+	optimize_vertex_cache( indices.size(), indices.data(), positions.size(), cached.data() );
+
+	std::string const suffix = " (" + std::to_string( indices.size() / 3 ) + " triangles)";
+
+	BENCHMARK( "analyze_vertex_cache" + suffix )
+	{
+		return analyze_vertex_cache( indices.size(), indices.data(), positions.size() ).transformedVertices;
+	};
+	BENCHMARK( "optimize_vertex_cache" + suffix )
+	{
+		optimize_vertex_cache( indices.size(), indices.data(), positions.size(), out.data() );
+		return out[0];
+	};
+	BENCHMARK( "optimize_overdraw" + suffix )
+	{
+		optimize_overdraw( cached.size(), cached.data(), positions.size(), positions.data(), out.data() );
+		return out[0];
+	};
+	BENCHMARK( "analyze_overdraw" + suffix )
+	{
+		return analyze_overdraw( cached.size(), cached.data(), positions.size(), positions.data() ).pixelsShaded;
+	};
+	BENCHMARK( "optimize_vertex_fetch_remap" + suffix )
+	{
+		return optimize_vertex_fetch_remap( cached.size(), cached.data(), positions.size(), remap.data() );
+	};
+}
@@ -0,0 +1,53 @@
+#include <catch2/catch_amalgamated.hpp>
+
+#include <string>
+#include <vector>
+
+#include <cmath>
+#include <cstdint>
+
+#include "common.hpp"
+
+#include "../vmlib/mesh_simplify.hpp"
+
+TEST_CASE( "Mesh simplification", "[simplify]" VMLIB_BENCH_TAGS )
+{
+	// Unit sphere, 128 rings x 256 segments
+	constexpr std::uint32_t kRings = 128, kSegments = 256;
+
+	std::vector<Vec3f> positions;
+	for( std::uint32_t r = 0; r <= kRings; ++r )
+	{
+		float const theta = 3.1415926f * r / kRings;
+		for( std::uint32_t s = 0; s < kSegments; ++s )
+		{
+			float const phi = 2.f * 3.1415926f * s / kSegments;
+			positions.emplace_back( Vec3f{ std::sin( theta ) * std::cos( phi ), std::cos( theta ), std::sin( theta ) * std::sin( phi ) } );
+		}
+	}
+
+	std::vector<std::uint32_t> indices;
+	for( std::uint32_t r = 0; r < kRings; ++r )
+	{
+		for( std::uint32_t s = 0; s < kSegments; ++s )
+		{
+			std::uint32_t const a = r * kSegments + s;
+			std::uint32_t const b = r * kSegments + (s+1) % kSegments;
+			indices.insert( indices.end(), { a, b, a + kSegments, b, b + kSegments, a + kSegments } );
+		}
+	}
+
+	std::vector<std::uint32_t> out( indices.size() );
+	std::string const suffix = " (" + std::to_string( indices.size() / 3 ) + " triangles)";
+
+	for( std::size_t const divisor : { 2, 16 } )
+	{
+		SimplifyOptions options;
+		options.targetIndexCount = indices.size() / divisor;
+
+		BENCHMARK( "simplify_mesh to 1/" + std::to_string( divisor ) + suffix )
+		{
+			return simplify_mesh( indices.size(), indices.data(), positions.size(), positions.data(), options, out.data() ).indexCount;
+		};
+	}
+}
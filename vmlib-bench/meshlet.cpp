@@ -0,0 +1,60 @@
+#include <catch2/catch_amalgamated.hpp>
+
+#include <string>
+#include <vector>
+
+#include <cmath>
+#include <cstdint>
+
+#include "common.hpp"
+
+#include "../vmlib/frustum.hpp"
+#include "../vmlib/meshlet.hpp"
+
+TEST_CASE( "Meshlets", "[meshlet]" VMLIB_BENCH_TAGS )
+{
+	// 256x256 quad height field, seen from above one of its corners.
+	constexpr std::uint32_t kSize = 256;
+
+	std::vector<Vec3f> positions;
+	for( std::uint32_t z = 0; z <= kSize; ++z )
+	{
+		for( std::uint32_t x = 0; x <= kSize; ++x )
+			positions.emplace_back( Vec3f{ float(x), 4.f * std::sin( 0.1f * x ) * std::cos( 0.07f * z ), float(z) } );
+	}
+
+	std::vector<std::uint32_t> indices;
+	for( std::uint32_t z = 0; z < kSize; ++z )
+	{
+		for( std::uint32_t x = 0; x < kSize; ++x )
+		{
+			std::uint32_t const i = z * (kSize+1) + x;
+			indices.insert( indices.end(), { i, i + kSize+1, i+1 } );
+			indices.insert( indices.end(), { i+1, i + kSize+1, i + kSize+2 } );
+		}
+	}
+
+	std::vector<std::uint32_t> out( indices.size() );
+	std::vector<Meshlet> meshlets;
+	build_meshlets( indices.size(), indices.data(), positions.size(), positions.data(), out.data(), meshlets );
+
+	Vec3f const camera{ -10.f, 20.f, -10.f };
+	Mat44f const world2camera = make_rotation_x( 0.5f ) * make_rotation_y( 3.1415926f * 0.75f ) * make_translation( -camera );
+	Frustumf const frustum = make_frustum( make_perspective_projection( 1.f, 16.f/9.f, 0.1f, 200.f ) * world2camera );
+
+	std::string const suffix = " (" + std::to_string( indices.size() / 3 ) + " triangles)";
+
+	BENCHMARK( "build_meshlets" + suffix )
+	{
+		std::vector<Meshlet> ret;
+		build_meshlets( indices.size(), indices.data(), positions.size(), positions.data(), out.data(), ret );
+		return ret.size();
+	};
+
+	std::vector<MeshletRange> ranges;
+	BENCHMARK( "cull_meshlets (" + std::to_string( meshlets.size() ) + " meshlets)" )
+	{
+		ranges.clear();
+		return cull_meshlets( frustum, camera, meshlets.size(), meshlets.data(), ranges );
+	};
+}
@@ -0,0 +1,39 @@
+#include <catch2/catch_amalgamated.hpp>
+
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "common.hpp"
+
+#include "../vmlib/quat.hpp"
+
+TEST_CASE( "Quaternions", "[quat]" VMLIB_BENCH_TAGS )
+{
+	constexpr std::size_t kCount = 4096;
+
+	std::mt19937 rng( 42 );
+	std::uniform_real_distribution<float> dist( -1.f, 1.f );
+
+	std::vector<DualQuatf> duals( kCount );
+	for( auto& d : duals )
+	{
+		Quatf const q = normalize_quat( Quatf{ dist(rng), dist(rng), dist(rng), dist(rng) } );
+		d = make_dual_quat( q, Vec3f{ dist(rng), dist(rng), dist(rng) } );
+	}
+
+	std::vector<Mat44f> out( kCount );
+
+	BENCHMARK( "DualQuatf composition" )
+	{
+		return duals[0] * duals[1];
+	};
+
+	bench::for_each_isa( "dual_quat_to_mat44_n x4096", [&] (std::string aName) {
+		BENCHMARK( std::move( aName ) )
+		{
+			dual_quat_to_mat44_n( kCount, duals.data(), out.data() );
+			return out[0];
+		};
+	} );
+}
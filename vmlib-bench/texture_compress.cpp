@@ -0,0 +1,51 @@
+#include <catch2/catch_amalgamated.hpp>
+
+#include <random>
+#include <string>
+#include <vector>
+
+#include <cstdint>
+
+#include "common.hpp"
+
+#include "../vmlib/texture_compress.hpp"
+
+TEST_CASE( "Texture compression", "[texture]" VMLIB_BENCH_TAGS )
+{
+	// 2048x2048 RGBA8, smooth with some noise
+	constexpr std::size_t kSize = 2048;
+
+	std::mt19937 rng( 42 );
+	std::uniform_int_distribution<int> noise( 0, 15 );
+
+	std::vector<std::uint8_t> image( 4 * kSize * kSize );
+	for( std::size_t y = 0; y < kSize; ++y )
+	{
+		for( std::size_t x = 0; x < kSize; ++x )
+		{
+			std::uint8_t* texel = image.data() + 4 * (y * kSize + x);
+			texel[0] = std::uint8_t((x / 8 + noise( rng )) & 0xff);
+			texel[1] = std::uint8_t((y / 8 + noise( rng )) & 0xff);
+			texel[2] = std::uint8_t(((x + y) / 16 + noise( rng )) & 0xff);
+			texel[3] = 255;
+		}
+	}
+
+	std::string const suffix = " " + std::to_string( kSize ) + "x" + std::to_string( kSize );
+
+	std::vector<std::uint8_t> half( 4 * (kSize/2) * (kSize/2) );
+	bench::for_each_isa( "downsample_srgb8" + suffix, [&] (std::string aName) {
+		BENCHMARK( std::move(aName) )
+		{
+			downsample_srgb8( kSize, kSize, image.data(), half.data() );
+			return half[0];
+		};
+	} );
+
+	std::vector<std::uint8_t> blocks( bc7_size( kSize, kSize ) );
+	BENCHMARK( "compress_bc7" + suffix )
+	{
+		compress_bc7( kSize, kSize, image.data(), blocks.data() );
+		return blocks[0];
+	};
+}
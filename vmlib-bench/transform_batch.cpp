@@ -0,0 +1,79 @@
+#include <catch2/catch_amalgamated.hpp>
+
+#include <string>
+#include <utility>
+#include <vector>
+#include <initializer_list>
+
+#include "common.hpp"
+
+#include "../vmlib/mat33.hpp"
+#include "../vmlib/transform_batch.hpp"
+
+TEST_CASE( "Batched vertex transforms", "[batch]" VMLIB_BENCH_TAGS )
+{
+	// A small mesh (fits into the caches, single thread) and a large one
+	// (split across threads).
+	for( std::size_t const count : { std::size_t(4096), std::size_t(1) << 20 } )
+	{
+		auto const points = bench::random_points( count );
+		std::vector<Vec3f> out( count );
+
+		std::vector<float> x( count ), y( count ), z( count );
+		for( std::size_t i = 0; i < count; ++i )
+		{
+			x[i] = points[i].x;
+			y[i] = points[i].y;
+			z[i] = points[i].z;
+		}
+		std::vector<float> ox( count ), oy( count ), oz( count );
+
+		Mat44f const affine = make_translation( { 1.f, 2.f, 3.f } ) * make_rotation_y( 0.5f );
+		Mat44f const projective = make_perspective_projection( 1.0472f, 1.7778f, 0.1f, 100.f ) * affine;
+		Mat33f const normalMatrix = normal_matrix( affine * make_scaling( 2.f, 1.f, 1.f ) );
+
+		std::string const suffix = " x" + std::to_string( count );
+
+		BENCHMARK( "reference loop (Mat44f * Vec4f)" + suffix )
+		{
+			for( std::size_t i = 0; i < count; ++i )
+			{
+				Vec4f const t = affine * Vec4f{ points[i].x, points[i].y, points[i].z, 1.f };
+				out[i] = Vec3f{ t.x, t.y, t.z };
+			}
+			return out[0];
+		};
+
+		bench::for_each_isa( "transform_points affine" + suffix, [&] (std::string aName) {
+			BENCHMARK( std::move( aName ) )
+			{
+				transform_points( affine, count, points.data(), out.data() );
+				return out[0];
+			};
+		} );
+		bench::for_each_isa( "transform_points projective" + suffix, [&] (std::string aName) {
+			BENCHMARK( std::move( aName ) )
+			{
+				transform_points( projective, count, points.data(), out.data() );
+				return out[0];
+			};
+		} );
+		bench::for_each_isa( "transform_vectors renormalize" + suffix, [&] (std::string aName) {
+			BENCHMARK( std::move( aName ) )
+			{
+				transform_vectors( normalMatrix, count, points.data(), out.data(), true );
+				return out[0];
+			};
+		} );
+		bench::for_each_isa( "transform_points_soa affine" + suffix, [&] (std::string aName) {
+			BENCHMARK( std::move( aName ) )
+			{
+				transform_points_soa( affine, count,
+					Vec3fSoaConst{ x.data(), y.data(), z.data() },
+					Vec3fSoa{ ox.data(), oy.data(), oz.data() }
+				);
+				return ox[0];
+			};
+		} );
+	}
+}
@@ -0,0 +1,41 @@
+#include <catch2/catch_amalgamated.hpp>
+
+#include <vector>
+
+#include "common.hpp"
+
+#include "../vmlib/vec3.hpp"
+
+TEST_CASE( "Vec3f operations", "[vec3]" VMLIB_BENCH_TAGS )
+{
+	auto const points = bench::random_points( 1024 );
+	Vec3f const a = points[0];
+	Vec3f const b = points[1];
+
+	BENCHMARK( "normalize" )
+	{
+		return normalize( a );
+	};
+	BENCHMARK( "cross" )
+	{
+		return cross( a, b );
+	};
+	BENCHMARK( "dot" )
+	{
+		return dot( a, b );
+	};
+
+	std::vector<Vec3f> out( points.size() );
+	BENCHMARK( "normalize x1024" )
+	{
+		for( std::size_t i = 0; i < points.size(); ++i )
+			out[i] = normalize( points[i] );
+		return out[0];
+	};
+	BENCHMARK( "cross x1024" )
+	{
+		for( std::size_t i = 0; i+1 < points.size(); ++i )
+			out[i] = cross( points[i], points[i+1] );
+		return out[0];
+	};
+}
@@ -0,0 +1,64 @@
+#include <catch2/catch_amalgamated.hpp>
+
+#include <string>
+#include <vector>
+
+#include <cmath>
+#include <cstdint>
+
+#include "common.hpp"
+
+#include "../vmlib/vec2.hpp"
+#include "../vmlib/vec4.hpp"
+#include "../vmlib/vertex_normals.hpp"
+
+TEST_CASE( "Vertex normals", "[normals]" VMLIB_BENCH_TAGS )
+{
+	// 512x512 quad height field with texture coordinates. The triangle angles
+	// go through fast_atan2_n(), so its instruction set is varied.
+	constexpr std::uint32_t kSize = 512;
+
+	std::vector<Vec3f> positions;
+	std::vector<Vec2f> textcoords;
+	for( std::uint32_t z = 0; z <= kSize; ++z )
+	{
+		for( std::uint32_t x = 0; x <= kSize; ++x )
+		{
+			positions.emplace_back( Vec3f{ float(x), 4.f * std::sin( 0.1f * x ) * std::cos( 0.07f * z ), float(z) } );
+			textcoords.emplace_back( Vec2f{ x / float(kSize), z / float(kSize) } );
+		}
+	}
+
+	std::vector<std::uint32_t> indices;
+	for( std::uint32_t z = 0; z < kSize; ++z )
+	{
+		for( std::uint32_t x = 0; x < kSize; ++x )
+		{
+			std::uint32_t const i = z * (kSize+1) + x;
+			indices.insert( indices.end(), { i, i + kSize+1, i+1 } );
+			indices.insert( indices.end(), { i+1, i + kSize+1, i + kSize+2 } );
+		}
+	}
+
+	std::vector<Vec3f> normals( positions.size() );
+	std::vector<Vec4f> tangents( positions.size() );
+	std::string const suffix = " (" + std::to_string( indices.size() / 3 ) + " triangles)";
+
+	bench::for_each_isa( "compute_vertex_normals" + suffix, [&] (std::string aName) {
+		BENCHMARK( std::move(aName) )
+		{
+			compute_vertex_normals( indices.size(), indices.data(), positions.size(), positions.data(), normals.data() );
+			return normals[positions.size() / 2].y;
+		};
+	} );
+
+	compute_vertex_normals( indices.size(), indices.data(), positions.size(), positions.data(), normals.data() );
+
+	bench::for_each_isa( "compute_vertex_tangents" + suffix, [&] (std::string aName) {
+		BENCHMARK( std::move(aName) )
+		{
+			compute_vertex_tangents( indices.size(), indices.data(), positions.size(), positions.data(), normals.data(), textcoords.data(), tangents.data() );
+			return tangents[positions.size() / 2].x;
+		};
+	} );
+}
@@ -0,0 +1,268 @@
+#include <catch2/catch_amalgamated.hpp>
+
+#include <limits>
+#include <random>
+#include <vector>
+#include <optional>
+
+#include <cmath>
+#include <cstdint>
+
+#include "common.hpp"
+
+#include "../vmlib/vec3.hpp"
+#include "../vmlib/vec4.hpp"
+#include "../vmlib/mat44.hpp"
+#include "../vmlib/simd.hpp"
+#include "../vmlib/bvh.hpp"
+
+namespace
+{
+	// Random "soup" of aCount small triangles, plus a few large ones that
+	// overlap most of the others.
+	struct Soup_
+	{
+		std::vector<Vec3f> positions;
+		std::vector<std::uint32_t> indices;
+	};
+
+	Soup_ make_soup_( std::size_t aCount, unsigned aSeed = 42 )
+	{
+		std::mt19937 rng( aSeed );
+		std::uniform_real_distribution<float> pos( -50.f, 50.f );
+		std::uniform_real_distribution<float> offset( -3.f, 3.f );
+
+		Soup_ ret;
+		for( std::size_t i = 0; i < aCount; ++i )
+		{
+			float const scale = i % 100 == 0 ? 20.f : 1.f;
+
+			Vec3f const p = test::random_vec3( rng, pos );
+			for( std::size_t j = 0; j < 3; ++j )
+			{
+				ret.indices.emplace_back( std::uint32_t(ret.positions.size()) );
+				ret.positions.emplace_back( p + scale * test::random_vec3( rng, offset ) );
+			}
+		}
+		return ret;
+	}
+
+	// Reference: test every triangle.
+	std::optional<RayHit> brute_force_( Soup_ const& aSoup, Rayf const& aRay, float aMaxT = std::numeric_limits<float>::infinity() )
+	{
+		std::optional<RayHit> ret;
+		for( std::size_t i = 0; i < aSoup.indices.size(); i += 3 )
+		{
+			Vec3f const v0 = aSoup.positions[aSoup.indices[i]];
+			Vec3f const e1 = aSoup.positions[aSoup.indices[i+1]] - v0;
+			Vec3f const e2 = aSoup.positions[aSoup.indices[i+2]] - v0;
+
+			Vec3f const p = cross( aRay.direction, e2 );
+			float const det = dot( e1, p );
+			if( 0.f == det )
+				continue;
+
+			Vec3f const s = aRay.origin - v0;
+			float const u = dot( s, p ) / det;
+			Vec3f const q = cross( s, e1 );
+			float const v = dot( aRay.direction, q ) / det;
+			float const t = dot( e2, q ) / det;
+
+			if( u >= 0.f && v >= 0.f && u + v <= 1.f && t > 0.f && t < aMaxT && (!ret || t < ret->t) )
+				ret = RayHit{ t, std::uint32_t(i / 3), u, v };
+		}
+		return ret;
+	}
+}
+
+TEST_CASE( "BVH building", "[bvh]" )
+{
+	auto const soup = make_soup_( 2000 );
+	Bvh const bvh = build_bvh( soup.indices.size(), soup.indices.data(), soup.positions.data() );
+
+	REQUIRE( !bvh.nodes.empty() );
+
+	// Every triangle is in exactly one packet, and the leaves' packets cover
+	// all packets exactly once.
+	std::vector<int> seen( soup.indices.size() / 3, 0 );
+	for( auto const& packet : bvh.packets )
+	{
+		for( auto const tri : packet.triangle )
+		{
+			if( BvhPacket::kNoTriangle != tri )
+				++seen[tri];
+		}
+	}
+	for( auto const s : seen )
+		REQUIRE( 1 == s );
+
+	std::vector<int> packets( bvh.packets.size(), 0 );
+	for( std::size_t n = 0; n < bvh.nodes.size(); ++n )
+	{
+		BvhNode const& node = bvh.nodes[n];
+		if( node.packetCount > 0 )
+		{
+			for( std::uint32_t p = node.first; p < node.first + node.packetCount; ++p )
+				++packets[p];
+			continue;
+		}
+
+		// Children lie within their parent
+		REQUIRE( node.first > n );
+		REQUIRE( node.first + 1 < bvh.nodes.size() );
+		for( std::uint32_t c = node.first; c <= node.first + 1; ++c )
+		{
+			for( std::size_t axis = 0; axis < 3; ++axis )
+			{
+				REQUIRE( bvh.nodes[c].bounds.min[axis] >= node.bounds.min[axis] );
+				REQUIRE( bvh.nodes[c].bounds.max[axis] <= node.bounds.max[axis] );
+			}
+		}
+	}
+	for( auto const p : packets )
+		REQUIRE( 1 == p );
+
+	// Mostly full packets
+	REQUIRE( bvh.packets.size() < soup.indices.size() / 3 / 2 );
+
+	SECTION( "Empty" )
+	{
+		Bvh const none = build_bvh( 0, nullptr, nullptr );
+		REQUIRE( none.nodes.empty() );
+		REQUIRE( !intersect( none, Rayf{ { 0.f, 0.f, 0.f }, { 1.f, 0.f, 0.f } } ) );
+	}
+
+	SECTION( "Coincident triangles" )
+	{
+		// Identical triangles cannot be split by their centroids, but the
+		// tree is still built.
+		std::vector<Vec3f> const positions{ { 0.f, 0.f, 0.f }, { 1.f, 0.f, 0.f }, { 0.f, 1.f, 0.f } };
+		std::vector<std::uint32_t> indices;
+		for( std::size_t i = 0; i < 100; ++i )
+			indices.insert( indices.end(), { 0, 1, 2 } );
+
+		Bvh const same = build_bvh( indices.size(), indices.data(), positions.data() );
+		REQUIRE( 25 == same.packets.size() );
+		REQUIRE( intersect( same, Rayf{ { 0.25f, 0.25f, -1.f }, { 0.f, 0.f, 1.f } } ) );
+	}
+}
+
+TEST_CASE( "BVH ray queries", "[bvh]" )
+{
+	using namespace Catch::Matchers;
+
+	auto const soup = make_soup_( 3000, 7 );
+	Bvh const bvh = build_bvh( soup.indices.size(), soup.indices.data(), soup.positions.data() );
+
+	std::mt19937 rng( 1 );
+	std::uniform_real_distribution<float> pos( -60.f, 60.f );
+	std::uniform_real_distribution<float> dir( -1.f, 1.f );
+
+	std::vector<Rayf> rays;
+	for( std::size_t i = 0; i < 2000; ++i )
+		rays.emplace_back( Rayf{ test::random_vec3( rng, pos ), test::random_vec3( rng, dir ) } );
+
+	// Axis aligned rays, which have infinite components in the inverse
+	// direction.
+	for( std::size_t i = 0; i < 200; ++i )
+	{
+		Vec3f d{ 0.f, 0.f, 0.f };
+		d[i % 3] = i % 2 ? 1.f : -1.f;
+		rays.emplace_back( Rayf{ test::random_vec3( rng, pos ), d } );
+	}
+
+	test::for_each_isa( [&] {
+		std::size_t hits = 0;
+		for( auto const& ray : rays )
+		{
+			auto const expected = brute_force_( soup, ray );
+			auto const actual = intersect( bvh, ray );
+
+			// Near misses of an edge may end up either way due to rounding.
+			REQUIRE( bool(expected) == bool(actual) );
+			if( !expected )
+				continue;
+
+			++hits;
+			REQUIRE_THAT( actual->t, WithinRel( expected->t, 1e-4f ) );
+			if( actual->triangle != expected->triangle )
+				continue; // two triangles at the same distance
+
+			REQUIRE_THAT( actual->u, WithinAbs( expected->u, 1e-4f ) );
+			REQUIRE_THAT( actual->v, WithinAbs( expected->v, 1e-4f ) );
+
+			// Limited range
+			auto const shorter = intersect( bvh, ray, actual->t );
+			auto const shorterExpected = brute_force_( soup, ray, expected->t );
+			REQUIRE( bool(shorter) == bool(shorterExpected) );
+			if( shorter )
+				REQUIRE( shorter->t < actual->t );
+		}
+
+		// ... and the rays should actually hit something.
+		REQUIRE( hits > rays.size() / 10 );
+	} );
+}
+
+TEST_CASE( "Ray box queries", "[bvh]" )
+{
+	using namespace Catch::Matchers;
+
+	Aabb3f const box{ { -1.f, -2.f, -3.f }, { 1.f, 2.f, 3.f } };
+
+	SECTION( "Entry" )
+	{
+		auto const t = intersect( box, Rayf{ { -5.f, 0.f, 0.f }, { 2.f, 0.f, 0.f } } );
+		REQUIRE( t );
+		REQUIRE_THAT( *t, WithinAbs( 2.f, 1e-6f ) );
+
+		// Not reached before aMaxT
+		REQUIRE( !intersect( box, Rayf{ { -5.f, 0.f, 0.f }, { 2.f, 0.f, 0.f } }, 2.f ) );
+	}
+
+	SECTION( "Inside" )
+	{
+		auto const t = intersect( box, Rayf{ { 0.f, 1.f, 2.f }, { 0.3f, -1.f, 0.f } } );
+		REQUIRE( t );
+		REQUIRE( 0.f == *t );
+	}
+
+	SECTION( "Miss" )
+	{
+		REQUIRE( !intersect( box, Rayf{ { -5.f, 3.f, 0.f }, { 1.f, 0.f, 0.f } } ) );
+		REQUIRE( !intersect( box, Rayf{ { -5.f, 0.f, 0.f }, { -1.f, 0.f, 0.f } } ) );
+	}
+}
+
+TEST_CASE( "Pick rays", "[bvh]" )
+{
+	using namespace Catch::Matchers;
+
+	Mat44f const projection = make_perspective_projection( 1.f, 16.f/9.f, 0.5f, 100.f );
+	Mat44f const world2camera = make_rotation_y( 0.3f ) * make_translation( { -1.f, -2.f, -3.f } );
+	Mat44f const clip = projection * world2camera;
+
+	// Center of the screen: along the view direction, from the near to the
+	// far plane.
+	Rayf const center = make_pick_ray( invert( clip ), 0.f, 0.f );
+	Vec3f const forward = normalize( center.direction );
+
+	Vec3f const eye{ 1.f, 2.f, 3.f };
+	REQUIRE_THAT( dot( center.origin - eye, forward ), WithinAbs( 0.5f, 1e-3f ) );
+	REQUIRE_THAT( length( center.direction ), WithinRel( 99.5f, 1e-3f ) );
+	REQUIRE_THAT( length( cross( center.origin - eye, forward ) ), WithinAbs( 0.f, 1e-3f ) );
+
+	// Points along any ray project back onto the same position on screen.
+	for( auto const& ndc : { Vec3f{ 0.5f, -0.25f, 0.f }, Vec3f{ -1.f, 1.f, 0.f }, Vec3f{ 0.9f, 0.9f, 0.f } } )
+	{
+		Rayf const ray = make_pick_ray( invert( clip ), ndc.x, ndc.y );
+		for( float const t : { 0.f, 0.1f, 0.5f, 1.f } )
+		{
+			Vec3f const p = ray.origin + t * ray.direction;
+			Vec4f const c = clip * Vec4f{ p.x, p.y, p.z, 1.f };
+
+			REQUIRE_THAT( c.x / c.w, WithinAbs( ndc.x, 1e-3f ) );
+			REQUIRE_THAT( c.y / c.w, WithinAbs( ndc.y, 1e-3f ) );
+		}
+	}
+}
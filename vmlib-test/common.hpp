@@ -0,0 +1,87 @@
+#ifndef COMMON_HPP_5D0F7C2E_8B41_4A6F_9C13_E27B4D6A0F95
+#define COMMON_HPP_5D0F7C2E_8B41_4A6F_9C13_E27B4D6A0F95
+
+#include <catch2/catch_amalgamated.hpp>
+
+#include <random>
+#include <initializer_list>
+#include <vector>
+
+#include "../vmlib/vec3.hpp"
+#include "../vmlib/simd.hpp"
+
+// Shared helpers for the vmlib tests. See vmlib-bench/common.hpp for the
+// benchmarks' counterparts.
+
+namespace test
+{
+	namespace detail
+	{
+		template< typename tFunc >
+		void for_each_isa( std::initializer_list<SimdIsa> aIsas, tFunc&& aFunc )
+		{
+			auto const previous = simd_active_isa();
+			for( auto const isa : aIsas )
+			{
+				if( !simd_set_isa( isa ) )
+					continue;
+
+				DYNAMIC_SECTION( simd_isa_name( isa ) )
+				{
+					aFunc();
+				}
+			}
+			simd_set_isa( previous );
+		}
+	}
+
+	// Calls aFunc in a section per instruction set that the CPU supports,
+	// with that instruction set active.
+	template< typename tFunc >
+	void for_each_isa( tFunc&& aFunc )
+	{
+		detail::for_each_isa( { SimdIsa::scalar, SimdIsa::sse2, SimdIsa::avx2, SimdIsa::neon }, aFunc );
+	}
+
+	// As for_each_isa(), without the scalar code, e.g., when it computes the
+	// reference.
+	template< typename tFunc >
+	void for_each_simd_isa( tFunc&& aFunc )
+	{
+		detail::for_each_isa( { SimdIsa::sse2, SimdIsa::avx2, SimdIsa::neon }, aFunc );
+	}
+
+	inline
+	Vec3f random_vec3( std::mt19937& aRng, std::uniform_real_distribution<float>& aDist )
+	{
+		return Vec3f{ aDist(aRng), aDist(aRng), aDist(aRng) };
+	}
+
+	// aCount values, uniform in [aMin, aMax)
+	inline
+	std::vector<float> random_floats( std::size_t aCount, float aMin, float aMax, unsigned aSeed = 42 )
+	{
+		std::mt19937 rng( aSeed );
+		std::uniform_real_distribution<float> dist( aMin, aMax );
+
+		std::vector<float> ret( aCount );
+		for( auto& x : ret )
+			x = dist( rng );
+		return ret;
+	}
+
+	// aCount points, uniform in the cube [aMin, aMax)^3
+	inline
+	std::vector<Vec3f> random_points( std::size_t aCount, float aMin, float aMax, unsigned aSeed = 42 )
+	{
+		std::mt19937 rng( aSeed );
+		std::uniform_real_distribution<float> dist( aMin, aMax );
+
+		std::vector<Vec3f> ret( aCount );
+		for( auto& p : ret )
+			p = random_vec3( rng, dist );
+		return ret;
+	}
+}
+
+#endif // COMMON_HPP_5D0F7C2E_8B41_4A6F_9C13_E27B4D6A0F95
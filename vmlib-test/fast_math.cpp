@@ -0,0 +1,168 @@
+#include <catch2/catch_amalgamated.hpp>
+
+#include <random>
+#include <vector>
+#include <iterator>
+#include <algorithm>
+
+#include <cmath>
+
+#include "common.hpp"
+
+#include "../vmlib/vec3.hpp"
+#include "../vmlib/simd.hpp"
+#include "../vmlib/fast_math.hpp"
+
+// The error bounds checked here are the ones documented in fast_math.hpp.
+
+TEST_CASE( "Fast sin and cos", "[fastmath]" )
+{
+	// 70001 values: large enough to be split across threads, and not a
+	// multiple of the SIMD width. Includes the quadrant boundaries.
+	auto x = test::random_floats( 70001, -8192.f, 8192.f );
+	for( int k = -8; k <= 8; ++k )
+		x[k+8] = k * 1.57079632679489662f;
+	x[20] = 0.f;
+	x[21] = -0.f;
+
+	SECTION( "Scalar" )
+	{
+		double maxErr = 0.0;
+		for( float const v : x )
+		{
+			float s, c;
+			fast_sincos( v, s, c );
+			maxErr = std::max( maxErr, std::abs( s - std::sin( double(v) ) ) );
+			maxErr = std::max( maxErr, std::abs( c - std::cos( double(v) ) ) );
+			REQUIRE( fast_sin( v ) == s );
+			REQUIRE( fast_cos( v ) == c );
+		}
+		REQUIRE( maxErr <= 1.5e-7 );
+	}
+
+	SECTION( "Batched" )
+	{
+		test::for_each_isa( [&] {
+			std::vector<float> s( x.size() ), c( x.size() ), s1( x.size() ), c1( x.size() );
+			fast_sincos_n( x.size(), x.data(), s.data(), c.data() );
+			fast_sin_n( x.size(), x.data(), s1.data() );
+			fast_cos_n( x.size(), x.data(), c1.data() );
+
+			double maxErr = 0.0;
+			for( std::size_t i = 0; i < x.size(); ++i )
+			{
+				maxErr = std::max( maxErr, std::abs( s[i] - std::sin( double(x[i]) ) ) );
+				maxErr = std::max( maxErr, std::abs( c[i] - std::cos( double(x[i]) ) ) );
+				REQUIRE( s1[i] == s[i] );
+				REQUIRE( c1[i] == c[i] );
+			}
+			REQUIRE( maxErr <= 1.5e-7 );
+		} );
+	}
+
+	SECTION( "In place" )
+	{
+		test::for_each_isa( [&] {
+			auto y = x;
+			fast_sin_n( y.size(), y.data(), y.data() );
+			for( std::size_t i = 0; i < x.size(); ++i )
+				REQUIRE( std::abs( y[i] - std::sin( double(x[i]) ) ) <= 1.5e-7 );
+		} );
+	}
+}
+
+TEST_CASE( "Fast atan2", "[fastmath]" )
+{
+	auto y = test::random_floats( 70001, -100.f, 100.f, 1 );
+	auto x = test::random_floats( 70001, -100.f, 100.f, 2 );
+
+	// Axes, diagonals and tiny/huge ratios.
+	float const special[][2] = {
+		{ 0.f, 1.f }, { 1.f, 0.f }, { 0.f, -1.f }, { -1.f, 0.f },
+		{ 1.f, 1.f }, { -1.f, 1.f }, { 1.f, -1.f }, { -1.f, -1.f },
+		{ 1e-20f, 1.f }, { 1.f, 1e-20f }, { -1e-20f, -1.f }, { 1e20f, -3.f },
+		{ -0.f, -1.f }, { 0.41421356f, 1.f }, { 0.41421357f, 1.f }
+	};
+	for( std::size_t i = 0; i < std::size( special ); ++i )
+	{
+		y[i] = special[i][0];
+		x[i] = special[i][1];
+	}
+
+	SECTION( "Scalar" )
+	{
+		double maxErr = 0.0;
+		for( std::size_t i = 0; i < x.size(); ++i )
+			maxErr = std::max( maxErr, std::abs( fast_atan2( y[i], x[i] ) - std::atan2( double(y[i]), double(x[i]) ) ) );
+		REQUIRE( maxErr <= 3e-7 );
+
+		REQUIRE( std::isfinite( fast_atan2( 0.f, 0.f ) ) );
+	}
+
+	SECTION( "Batched" )
+	{
+		test::for_each_isa( [&] {
+			std::vector<float> r( x.size() );
+			fast_atan2_n( x.size(), y.data(), x.data(), r.data() );
+
+			double maxErr = 0.0;
+			for( std::size_t i = 0; i < x.size(); ++i )
+				maxErr = std::max( maxErr, std::abs( r[i] - std::atan2( double(y[i]), double(x[i]) ) ) );
+			REQUIRE( maxErr <= 3e-7 );
+
+			float const zero = 0.f;
+			float r0;
+			fast_atan2_n( 1, &zero, &zero, &r0 );
+			REQUIRE( std::isfinite( r0 ) );
+		} );
+	}
+}
+
+TEST_CASE( "Fast rsqrt and normalize", "[fastmath]" )
+{
+	SECTION( "rsqrt" )
+	{
+		auto x = test::random_floats( 70001, 0.f, 1.f );
+		for( std::size_t i = 0; i < x.size(); ++i )
+			x[i] = std::ldexp( x[i] + 0.5f, int(i % 200) - 100 );
+
+		test::for_each_isa( [&] {
+			std::vector<float> r( x.size() );
+			fast_rsqrt_n( x.size(), x.data(), r.data() );
+
+			double maxErr = 0.0;
+			for( std::size_t i = 0; i < x.size(); ++i )
+			{
+				double const ref = 1.0 / std::sqrt( double(x[i]) );
+				maxErr = std::max( maxErr, std::abs( r[i] - ref ) / ref );
+			}
+			REQUIRE( maxErr <= 3e-7 );
+		} );
+	}
+
+	SECTION( "normalize" )
+	{
+		auto const c = test::random_floats( 3*70001, -10.f, 10.f );
+		std::vector<Vec3f> v( 70001 );
+		for( std::size_t i = 0; i < v.size(); ++i )
+			v[i] = Vec3f{ c[3*i+0], c[3*i+1], c[3*i+2] };
+		v[0] = Vec3f{ 1e-10f, 0.f, 0.f };
+		v[1] = Vec3f{ 0.f, 1e10f, 0.f };
+
+		test::for_each_isa( [&] {
+			auto n = v;
+			fast_normalize_n( n );
+
+			double maxErr = 0.0;
+			for( std::size_t i = 0; i < v.size(); ++i )
+			{
+				double const l = std::sqrt( double(n[i].x)*n[i].x + double(n[i].y)*n[i].y + double(n[i].z)*n[i].z );
+				maxErr = std::max( maxErr, std::abs( l - 1.0 ) );
+
+				// Same direction
+				REQUIRE( dot( n[i], v[i] ) > 0.f );
+			}
+			REQUIRE( maxErr <= 4e-7 );
+		} );
+	}
+}
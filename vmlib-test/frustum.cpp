@@ -0,0 +1,184 @@
+#include <catch2/catch_amalgamated.hpp>
+
+#include <limits>
+#include <random>
+#include <vector>
+#include <algorithm>
+
+#include <cmath>
+#include <cstdint>
+
+#include "common.hpp"
+
+#include "../vmlib/mat44.hpp"
+#include "../vmlib/simd.hpp"
+#include "../vmlib/bounds.hpp"
+#include "../vmlib/frustum.hpp"
+
+namespace
+{
+	std::vector<Aabb3f> make_boxes_( std::size_t aCount )
+	{
+		std::mt19937 rng( 42 );
+		std::uniform_real_distribution<float> pos( -150.f, 150.f );
+		std::uniform_real_distribution<float> size( 0.f, 10.f );
+
+		std::vector<Aabb3f> ret( aCount );
+		for( auto& box : ret )
+		{
+			Vec3f const p = test::random_vec3( rng, pos );
+			box = Aabb3f{ p, p + test::random_vec3( rng, size ) };
+		}
+		return ret;
+	}
+
+	// Smallest distance by which the box is in front of any of the planes.
+	// Boxes where this is close to zero may end up on either side due to
+	// rounding.
+	float margin_( Frustumf const& aFrustum, Aabb3f const& aBox )
+	{
+		Vec3f const c = center( aBox );
+		Vec3f const e = half_extent( aBox );
+
+		float ret = std::numeric_limits<float>::infinity();
+		for( auto const& plane : aFrustum.planes )
+		{
+			float const r = std::abs(plane.n.x)*e.x + std::abs(plane.n.y)*e.y + std::abs(plane.n.z)*e.z;
+			ret = std::min( ret, std::abs( signed_distance( plane, c ) + r ) );
+		}
+		return ret;
+	}
+}
+
+TEST_CASE( "Bounding volumes", "[bounds]" )
+{
+	using namespace Catch::Matchers;
+
+	std::vector<Vec3f> const points{ { 1.f, 2.f, 3.f }, { -1.f, 0.f, 5.f }, { 0.f, 4.f, -3.f } };
+
+	SECTION( "Aabb3f" )
+	{
+		Aabb3f const box = make_aabb( points );
+		REQUIRE( box.min.x == -1.f );
+		REQUIRE( box.min.y == 0.f );
+		REQUIRE( box.min.z == -3.f );
+		REQUIRE( box.max.x == 1.f );
+		REQUIRE( box.max.y == 4.f );
+		REQUIRE( box.max.z == 5.f );
+
+		REQUIRE( is_empty( kEmptyAabb3f ) );
+		REQUIRE( !is_empty( box ) );
+
+		REQUIRE( distance( box, Vec3f{ 0.f, 1.f, 0.f } ) == 0.f );
+		REQUIRE( distance( box, Vec3f{ 4.f, 1.f, 0.f } ) == 3.f );
+		REQUIRE_THAT( distance( box, Vec3f{ 4.f, 8.f, 0.f } ), WithinAbs( 5.f, 1e-6f ) );
+	}
+
+	SECTION( "Transformed Aabb3f contains the transformed points" )
+	{
+		Mat44f const m = make_translation( { 3.f, -1.f, 2.f } ) * make_rotation_y( 0.7f ) * make_scaling( 2.f, 1.f, 0.5f );
+		Aabb3f const box = transform_aabb( m, make_aabb( points ) );
+
+		for( auto const& p : points )
+		{
+			Vec4f const t = m * Vec4f{ p.x, p.y, p.z, 1.f };
+			REQUIRE( t.x >= box.min.x - 1e-5f );
+			REQUIRE( t.y >= box.min.y - 1e-5f );
+			REQUIRE( t.z >= box.min.z - 1e-5f );
+			REQUIRE( t.x <= box.max.x + 1e-5f );
+			REQUIRE( t.y <= box.max.y + 1e-5f );
+			REQUIRE( t.z <= box.max.z + 1e-5f );
+		}
+	}
+
+	SECTION( "Spheref" )
+	{
+		Spheref const sphere = make_bounding_sphere( points );
+		for( auto const& p : points )
+			REQUIRE( length( p - sphere.center ) <= sphere.radius + 1e-5f );
+	}
+
+	SECTION( "Planef" )
+	{
+		Planef const plane = normalize_plane( make_plane( { 0.f, 2.f, 0.f }, { 0.f, 1.f, 0.f } ) );
+		REQUIRE_THAT( signed_distance( plane, { 5.f, 3.f, -2.f } ), WithinAbs( 2.f, 1e-6f ) );
+		REQUIRE_THAT( signed_distance( plane, { 0.f, -1.f, 0.f } ), WithinAbs( -2.f, 1e-6f ) );
+	}
+}
+
+TEST_CASE( "View frustum", "[frustum]" )
+{
+	// Camera at the origin, looking down -z.
+	Frustumf const frustum = make_frustum( make_perspective_projection( 1.f, 1.5f, 0.1f, 100.f ) );
+
+	SECTION( "Points" )
+	{
+		REQUIRE( intersects( frustum, Vec3f{ 0.f, 0.f, -1.f } ) );
+		REQUIRE( intersects( frustum, Vec3f{ 0.f, 0.f, -99.f } ) );
+		REQUIRE( !intersects( frustum, Vec3f{ 0.f, 0.f, 1.f } ) );
+		REQUIRE( !intersects( frustum, Vec3f{ 0.f, 0.f, -0.05f } ) );
+		REQUIRE( !intersects( frustum, Vec3f{ 0.f, 0.f, -101.f } ) );
+		REQUIRE( !intersects( frustum, Vec3f{ 50.f, 0.f, -10.f } ) );
+		REQUIRE( !intersects( frustum, Vec3f{ 0.f, -50.f, -10.f } ) );
+	}
+
+	SECTION( "Spheres and boxes" )
+	{
+		REQUIRE( intersects( frustum, Spheref{ { 0.f, 0.f, 2.f }, 2.5f } ) );
+		REQUIRE( !intersects( frustum, Spheref{ { 0.f, 0.f, 2.f }, 1.5f } ) );
+
+		REQUIRE( intersects( frustum, Aabb3f{ { -1.f, -1.f, 1.f }, { 1.f, 1.f, 2.f } } ) == false );
+		REQUIRE( intersects( frustum, Aabb3f{ { -1.f, -1.f, -2.f }, { 1.f, 1.f, 2.f } } ) );
+		REQUIRE( intersects( frustum, Aabb3f{ { -100.f, -100.f, -50.f }, { 100.f, 100.f, -40.f } } ) );
+		REQUIRE( !intersects( frustum, Aabb3f{ { 40.f, -1.f, -11.f }, { 50.f, 1.f, -10.f } } ) );
+	}
+
+	SECTION( "World space" )
+	{
+		// Same camera moved to (10,0,0): the planes move with it.
+		Mat44f const view = make_translation( { -10.f, 0.f, 0.f } );
+		Frustumf const moved = make_frustum( make_perspective_projection( 1.f, 1.5f, 0.1f, 100.f ) * view );
+		REQUIRE( intersects( moved, Vec3f{ 10.f, 0.f, -5.f } ) );
+		REQUIRE( !intersects( moved, Vec3f{ 0.f, 0.f, -1.f } ) );
+	}
+}
+
+TEST_CASE( "Batched frustum culling", "[frustum][batch]" )
+{
+	Mat44f const proj = make_perspective_projection( 1.f, 1.5f, 0.1f, 100.f )
+		* make_rotation_y( 0.3f )
+		* make_translation( { 5.f, -2.f, 10.f } );
+	Frustumf const frustum = make_frustum( proj );
+
+	// 70001 boxes: large enough to be split across threads, and not a
+	// multiple of the SIMD width.
+	auto const boxes = make_boxes_( 70001 );
+
+	std::size_t expectedCount = 0;
+	for( auto const& box : boxes )
+		expectedCount += intersects( frustum, box ) ? 1 : 0;
+
+	// Some, but not all, boxes should be visible for the test to be useful.
+	REQUIRE( expectedCount > 100 );
+	REQUIRE( expectedCount < boxes.size() - 100 );
+
+	test::for_each_isa( [&] {
+		std::vector<std::uint8_t> visible;
+		std::size_t const count = frustum_cull( frustum, boxes, visible );
+		REQUIRE( visible.size() == boxes.size() );
+
+		std::size_t mismatches = 0, sum = 0;
+		for( std::size_t i = 0; i < boxes.size(); ++i )
+		{
+			sum += visible[i];
+			if( bool(visible[i]) != intersects( frustum, boxes[i] ) )
+			{
+				REQUIRE( margin_( frustum, boxes[i] ) < 1e-3f );
+				++mismatches;
+			}
+		}
+
+		REQUIRE( count == sum );
+		REQUIRE( mismatches < 4 );
+	} );
+}
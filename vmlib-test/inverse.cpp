@@ -0,0 +1,70 @@
+#include <catch2/catch_amalgamated.hpp>
+
+#include "../vmlib/mat33.hpp"
+#include "../vmlib/mat44.hpp"
+#include "../vmlib/model_transform.hpp"
+
+TEST_CASE( "Affine and rigid inverses", "[mat44]" )
+{
+	static constexpr float kEps_ = 1e-5f;
+	using namespace Catch::Matchers;
+
+	SECTION( "Affine inverse matches general inverse" )
+	{
+		Mat44f const m = make_translation( { 3.f, -1.f, 7.f } )
+			* make_rotation_y( 0.8f )
+			* make_rotation_x( -0.3f )
+			* make_scaling( 2.f, 0.5f, 4.f );
+
+		auto const fast = invert_affine( m );
+		auto const ref = invert( m );
+		for( std::size_t i = 0; i < 16; ++i )
+			REQUIRE_THAT( fast.v[i], WithinAbs( ref.v[i], kEps_ ) );
+	}
+
+	SECTION( "Rigid inverse matches general inverse" )
+	{
+		Mat44f const m = make_translation( { -20.f, -0.9f, -30.f } ) * make_rotation_z( 1.1f );
+
+		auto const fast = invert_rigid( m );
+		auto const ref = invert( m );
+		for( std::size_t i = 0; i < 16; ++i )
+			REQUIRE_THAT( fast.v[i], WithinAbs( ref.v[i], kEps_ ) );
+	}
+}
+
+TEST_CASE( "Normal matrix", "[mat33][mat44]" )
+{
+	static constexpr float kEps_ = 1e-5f;
+	using namespace Catch::Matchers;
+
+	Mat44f const m = make_translation( { 1.f, 2.f, 3.f } )
+		* make_rotation_z( 0.5f )
+		* make_scaling( 1.f, 3.f, 0.5f );
+
+	auto const ref = mat44_to_mat33( transpose( invert( m ) ) );
+
+	SECTION( "Matches transposed inverse" )
+	{
+		auto const n = normal_matrix( m );
+		for( std::size_t i = 0; i < 9; ++i )
+			REQUIRE_THAT( n.v[i], WithinAbs( ref.v[i], kEps_ ) );
+	}
+
+	SECTION( "Cached in ModelTransform" )
+	{
+		ModelTransform xform( kIdentity44f );
+		REQUIRE_THAT( xform.normalMatrix()(1,1), WithinAbs( 1.f, kEps_ ) );
+
+		xform.set( m );
+		auto const& n = xform.normalMatrix();
+		for( std::size_t i = 0; i < 9; ++i )
+			REQUIRE_THAT( n.v[i], WithinAbs( ref.v[i], kEps_ ) );
+
+		Mat44f const rigid = make_translation( { 4.f, 0.f, 0.f } ) * make_rotation_x( 0.2f );
+		xform.set( rigid, ModelTransform::kRigid );
+		auto const rigidRef = mat44_to_mat33( transpose( invert( rigid ) ) );
+		for( std::size_t i = 0; i < 9; ++i )
+			REQUIRE_THAT( xform.normalMatrix().v[i], WithinAbs( rigidRef.v[i], kEps_ ) );
+	}
+}
@@ -0,0 +1,60 @@
+#include <catch2/catch_amalgamated.hpp>
+
+#include <cstdint>
+
+#include "../vmlib/mat33.hpp"
+#include "../vmlib/mat44.hpp"
+
+static_assert( alignof(Mat44f) == 32 );
+static_assert( sizeof(Mat44f) == 16*sizeof(float) );
+static_assert( alignof(Mat33f) == alignof(float) );
+static_assert( sizeof(Mat33f) == 9*sizeof(float) );
+
+// Element access is independent of the storage layout.
+static_assert( mat44_from_rows( {
+	0.f, 1.f, 2.f, 3.f,
+	4.f, 5.f, 6.f, 7.f,
+	8.f, 9.f, 10.f, 11.f,
+	12.f, 13.f, 14.f, 15.f
+} )(1,2) == 6.f );
+static_assert( mat33_from_rows( {
+	0.f, 1.f, 2.f,
+	3.f, 4.f, 5.f,
+	6.f, 7.f, 8.f
+} )(2,0) == 6.f );
+
+TEST_CASE( "Matrix storage layout", "[mat44][mat33]" )
+{
+	Mat44f const t = make_translation( { 1.f, 2.f, 3.f } );
+
+	SECTION( "Raw array" )
+	{
+		// With column-major storage the translation is stored in v[12..14],
+		// which is where OpenGL expects it (transpose = GL_FALSE).
+		std::size_t const base = MatrixLayout::columnMajor == kMatrixLayout ? 12 : 3;
+		std::size_t const stride = MatrixLayout::columnMajor == kMatrixLayout ? 1 : 4;
+		REQUIRE( t.v[base + 0*stride] == 1.f );
+		REQUIRE( t.v[base + 1*stride] == 2.f );
+		REQUIRE( t.v[base + 2*stride] == 3.f );
+
+		for( std::size_t i = 0; i < 4; ++i )
+		{
+			for( std::size_t j = 0; j < 4; ++j )
+				REQUIRE( &t(i,j) == t.v + mat44_index( i, j ) );
+		}
+	}
+
+	SECTION( "Alignment" )
+	{
+		Mat44f m44[3];
+		for( std::size_t i = 0; i < 3; ++i )
+			REQUIRE( 0 == reinterpret_cast<std::uintptr_t>( m44[i].v ) % 32 );
+	}
+
+	SECTION( "Packed Mat33f" )
+	{
+		// Arrays upload with a single glUniformMatrix3fv() call
+		Mat33f m33[2];
+		REQUIRE( m33[1].v == m33[0].v + 9 );
+	}
+}
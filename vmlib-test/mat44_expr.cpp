@@ -0,0 +1,74 @@
+#include <catch2/catch_amalgamated.hpp>
+
+#include <type_traits>
+
+#include "../vmlib/mat44.hpp"
+#include "../vmlib/mat44_expr.hpp"
+
+namespace
+{
+	void require_equal_( Mat44f const& aA, Mat44f const& aB, float aEps )
+	{
+		using namespace Catch::Matchers;
+		for( std::size_t i = 0; i < 16; ++i )
+			REQUIRE_THAT( aA.v[i], WithinAbs( aB.v[i], aEps ) );
+	}
+}
+
+// Costs and result types are compile-time properties.
+static_assert( mat44_expr_cost<Mat44Product<Mat44Identity,Mat44Affine>>() == 0 );
+static_assert( mat44_expr_cost<Mat44Product<Mat44Translation,Mat44Translation>>() == 0 );
+static_assert( mat44_expr_cost<Mat44Product<Mat44Affine,Mat44Affine>>() == 36 );
+static_assert( mat44_expr_cost<Mat44Product<Mat44f,Mat44f>>() == 64 );
+
+// (P * V) * M is evaluated as P * (V * M): 36 + 12 instead of 12 + 64.
+static_assert( mat44_expr_cost<Mat44Product<Mat44Product<Mat44Perspective,Mat44Affine>,Mat44Affine>>() == 48 );
+
+// Identity factors fold away entirely.
+static_assert( mat44_expr_cost<Mat44Product<Mat44Product<Mat44Perspective,Mat44Identity>,Mat44Translation>>() == 3 );
+
+// Mat44f * Mat44f is untouched.
+static_assert( std::is_same_v<decltype(kIdentity44f * kIdentity44f), Mat44f> );
+
+TEST_CASE( "Mat44f expression templates", "[mat44]" )
+{
+	static constexpr float kEps_ = 1e-4f;
+
+	Mat44f const proj = make_perspective_projection( 1.1f, 1280/float(720), 0.1f, 100.f );
+	Mat44Perspective const projExpr = make_perspective_projection_expr( 1.1f, 1280/float(720), 0.1f, 100.f );
+
+	Mat44f const view = make_rotation_x( 0.3f ) * make_rotation_y( -0.7f ) * make_translation( { 1.f, -2.f, 5.f } );
+	Mat44f const model = make_translation( { -20.f, -0.9f, -30.f } ) * make_rotation_z( 0.4f ) * make_scaling( 2.f, 1.f, 0.5f );
+	Vec3f const offset{ 3.f, 0.5f, -1.f };
+
+	SECTION( "Leaves" )
+	{
+		require_equal_( to_mat44( projExpr ), proj, 1e-6f );
+		require_equal_( to_mat44( Mat44Translation{ offset } ), make_translation( offset ), 0.f );
+		require_equal_( to_mat44( Mat44Affine( model ) ), model, 0.f );
+	}
+
+	SECTION( "Projection chain" )
+	{
+		Mat44f const ref = proj * view * model;
+		Mat44f const res = projExpr * Mat44Affine( view ) * Mat44Affine( model );
+		require_equal_( res, ref, kEps_ );
+	}
+
+	SECTION( "Translation and identity" )
+	{
+		Mat44Translation const t{ offset };
+
+		require_equal_( evaluate( t * t ), make_translation( offset ) * make_translation( offset ), kEps_ );
+		require_equal_( evaluate( t * Mat44Affine( model ) ), make_translation( offset ) * model, kEps_ );
+		require_equal_( evaluate( Mat44Affine( model ) * t ), model * make_translation( offset ), kEps_ );
+		require_equal_( evaluate( projExpr * t ), proj * make_translation( offset ), kEps_ );
+		require_equal_( evaluate( Mat44Identity{} * Mat44Affine( view ) * Mat44Identity{} ), view, 0.f );
+	}
+
+	SECTION( "Mixed with Mat44f" )
+	{
+		Mat44f const res = view * Mat44Translation{ offset } * model;
+		require_equal_( res, view * make_translation( offset ) * model, kEps_ );
+	}
+}
@@ -0,0 +1,139 @@
+#include <catch2/catch_amalgamated.hpp>
+
+#include <algorithm>
+#include <random>
+#include <vector>
+
+#include <cmath>
+
+#include "common.hpp"
+
+#include "../vmlib/mat44.hpp"
+#include "../vmlib/mat44_simd.hpp"
+
+namespace
+{
+	// Random, reasonably conditioned matrices: a rotation, scaling and
+	// translation, plus some noise so that the bottom row is not (0,0,0,1).
+	std::vector<Mat44f> make_test_matrices_( std::size_t aCount )
+	{
+		std::mt19937 rng( 1234 );
+		std::uniform_real_distribution<float> angle( -3.f, 3.f );
+		std::uniform_real_distribution<float> scale( 0.5f, 2.f );
+		std::uniform_real_distribution<float> offset( -10.f, 10.f );
+		std::uniform_real_distribution<float> noise( -0.1f, 0.1f );
+
+		std::vector<Mat44f> ret;
+		for( std::size_t i = 0; i < aCount; ++i )
+		{
+			Mat44f m = make_translation( { offset(rng), offset(rng), offset(rng) } )
+				* make_rotation_x( angle(rng) )
+				* make_rotation_y( angle(rng) )
+				* make_scaling( scale(rng), scale(rng), scale(rng) );
+
+			for( auto& v : m.v )
+				v += noise(rng);
+
+			ret.emplace_back( m );
+		}
+		return ret;
+	}
+
+	// aEps is relative for elements larger than one.
+	void require_equal_( Mat44f const& aA, Mat44f const& aB, float aEps )
+	{
+		using namespace Catch::Matchers;
+		for( std::size_t i = 0; i < 16; ++i )
+			REQUIRE_THAT( aA.v[i], WithinAbs( aB.v[i], aEps * std::max( 1.f, std::abs( aB.v[i] ) ) ) );
+	}
+}
+
+TEST_CASE( "SIMD 4x4 matrix multiplication matches scalar", "[mat44][simd]" )
+{
+	auto const lhs = make_test_matrices_( 33 );
+	auto rhs = lhs;
+	std::reverse( rhs.begin(), rhs.end() );
+
+	test::for_each_simd_isa( [&] {
+		std::vector<Mat44f> batch( lhs.size() );
+		mat44_mul_n( lhs.size(), lhs.data(), rhs.data(), batch.data() );
+
+		for( std::size_t i = 0; i < lhs.size(); ++i )
+		{
+			require_equal_( mat44_mul( lhs[i], rhs[i] ), lhs[i] * rhs[i], 1e-4f );
+			require_equal_( batch[i], lhs[i] * rhs[i], 1e-4f );
+		}
+	} );
+}
+
+TEST_CASE( "SIMD 4x4 matrix by vector multiplication matches scalar", "[mat44][vec4][simd]" )
+{
+	auto const mats = make_test_matrices_( 4 );
+
+	std::vector<Vec4f> vecs;
+	for( std::size_t i = 0; i < 17; ++i ) // odd count exercises the tails
+		vecs.push_back( { float(i), 1.f - float(i), 0.5f * float(i), 1.f } );
+
+	test::for_each_simd_isa( [&] {
+		using namespace Catch::Matchers;
+		for( auto const& m : mats )
+		{
+			std::vector<Vec4f> out( vecs.size() );
+			mat44_transform_n( m, vecs.size(), vecs.data(), out.data() );
+
+			for( std::size_t i = 0; i < vecs.size(); ++i )
+			{
+				Vec4f const ref = m * vecs[i];
+				Vec4f const single = mat44_transform( m, vecs[i] );
+				for( std::size_t j = 0; j < 4; ++j )
+				{
+					REQUIRE_THAT( out[i][j], WithinAbs( ref[j], 1e-4f ) );
+					REQUIRE_THAT( single[j], WithinAbs( ref[j], 1e-4f ) );
+				}
+			}
+		}
+	} );
+}
+
+TEST_CASE( "SIMD transpose matches scalar", "[mat44][simd]" )
+{
+	auto const mats = make_test_matrices_( 5 );
+
+	test::for_each_simd_isa( [&] {
+		std::vector<Mat44f> out( mats.size() );
+		mat44_transpose_n( mats.size(), mats.data(), out.data() );
+
+		for( std::size_t i = 0; i < mats.size(); ++i )
+		{
+			require_equal_( out[i], transpose( mats[i] ), 0.f );
+			require_equal_( mat44_transpose( mats[i] ), transpose( mats[i] ), 0.f );
+		}
+	} );
+}
+
+TEST_CASE( "SIMD inverse matches scalar", "[mat44][simd]" )
+{
+	auto const mats = make_test_matrices_( 9 );
+
+	test::for_each_simd_isa( [&] {
+		std::vector<Mat44f> out( mats.size() );
+		mat44_invert_n( mats.size(), mats.data(), out.data() );
+
+		for( std::size_t i = 0; i < mats.size(); ++i )
+		{
+			require_equal_( out[i], invert( mats[i] ), 1e-4f );
+			require_equal_( mat44_invert( mats[i] ), invert( mats[i] ), 1e-4f );
+
+			// M * M^-1 = I
+			require_equal_( mats[i] * out[i], kIdentity44f, 1e-4f );
+		}
+	} );
+
+	SECTION( "in-place" )
+	{
+		auto inplace = mats;
+		mat44_invert_n( inplace.size(), inplace.data(), inplace.data() );
+		for( std::size_t i = 0; i < mats.size(); ++i )
+			require_equal_( inplace[i], invert( mats[i] ), 1e-4f );
+	}
+}
@@ -0,0 +1,251 @@
+#include <catch2/catch_amalgamated.hpp>
+
+#include <array>
+#include <random>
+#include <vector>
+#include <numeric>
+#include <algorithm>
+
+#include <cstdint>
+
+#include "../vmlib/vec3.hpp"
+#include "../vmlib/mesh_optimize.hpp"
+
+namespace
+{
+	// Regular grid of aSize x aSize quads in the XZ plane (two triangles
+	// per quad), with the triangles in random order. A shuffled grid is the
+	// worst case for the vertex cache; a well optimized order approaches
+	// 0.5 transformed vertices per triangle.
+	struct Grid_
+	{
+		std::vector<Vec3f> positions;
+		std::vector<std::uint32_t> indices;
+	};
+
+	Grid_ make_shuffled_grid_( std::uint32_t aSize, unsigned aSeed = 42 )
+	{
+		Grid_ ret;
+		for( std::uint32_t z = 0; z <= aSize; ++z )
+		{
+			for( std::uint32_t x = 0; x <= aSize; ++x )
+				ret.positions.emplace_back( Vec3f{ float(x), 0.f, float(z) } );
+		}
+
+		std::vector<std::array<std::uint32_t,3>> tris;
+		for( std::uint32_t z = 0; z < aSize; ++z )
+		{
+			for( std::uint32_t x = 0; x < aSize; ++x )
+			{
+				std::uint32_t const i = z * (aSize+1) + x;
+				tris.push_back( { i, i + aSize+1, i+1 } );
+				tris.push_back( { i+1, i + aSize+1, i + aSize+2 } );
+			}
+		}
+
+		std::mt19937 rng( aSeed );
+		std::shuffle( tris.begin(), tris.end(), rng );
+
+		for( auto const& t : tris )
+			ret.indices.insert( ret.indices.end(), t.begin(), t.end() );
+		return ret;
+	}
+
+	// Triangles with their winding, rotated so that the smallest index is
+	// first, in sorted order. Two index buffers describe the same set of
+	// triangles exactly if these are equal.
+	std::vector<std::array<std::uint32_t,3>> canonical_triangles_( std::vector<std::uint32_t> const& aIndices )
+	{
+		std::vector<std::array<std::uint32_t,3>> ret;
+		for( std::size_t i = 0; i < aIndices.size(); i += 3 )
+		{
+			std::array<std::uint32_t,3> t{ aIndices[i], aIndices[i+1], aIndices[i+2] };
+			std::rotate( t.begin(), std::min_element( t.begin(), t.end() ), t.end() );
+			ret.emplace_back( t );
+		}
+		std::sort( ret.begin(), ret.end() );
+		return ret;
+	}
+}
+
+TEST_CASE( "Vertex cache statistics", "[meshopt]" )
+{
+	SECTION( "Single triangle" )
+	{
+		std::uint32_t const indices[] = { 0, 1, 2 };
+		auto const stats = analyze_vertex_cache( 3, indices, 3 );
+		REQUIRE( stats.transformedVertices == 3 );
+		REQUIRE( stats.acmr == 3.f );
+		REQUIRE( stats.atvr == 1.f );
+	}
+
+	SECTION( "Shared edge" )
+	{
+		std::uint32_t const indices[] = { 0, 1, 2, 2, 1, 3 };
+		auto const stats = analyze_vertex_cache( 6, indices, 4 );
+		REQUIRE( stats.transformedVertices == 4 );
+		REQUIRE( stats.acmr == 2.f );
+		REQUIRE( stats.atvr == 1.f );
+	}
+
+	SECTION( "Eviction" )
+	{
+		// With a cache of three vertices, vertex 0 is evicted by the second
+		// triangle, and must be transformed again.
+		std::uint32_t const indices[] = { 0, 1, 2, 3, 4, 5, 0, 1, 2 };
+		REQUIRE( analyze_vertex_cache( 9, indices, 6, 3 ).transformedVertices == 9 );
+		REQUIRE( analyze_vertex_cache( 9, indices, 6, 6 ).transformedVertices == 6 );
+	}
+
+	SECTION( "Unused vertices" )
+	{
+		std::uint32_t const indices[] = { 0, 2, 4 };
+		REQUIRE( analyze_vertex_cache( 3, indices, 10 ).atvr == 1.f );
+	}
+}
+
+TEST_CASE( "Vertex cache optimization", "[meshopt]" )
+{
+	auto const grid = make_shuffled_grid_( 100 );
+	auto const vertexCount = grid.positions.size();
+
+	std::vector<std::uint32_t> optimized( grid.indices.size() );
+	optimize_vertex_cache( grid.indices.size(), grid.indices.data(), vertexCount, optimized.data() );
+
+	REQUIRE( canonical_triangles_( optimized ) == canonical_triangles_( grid.indices ) );
+
+	auto const before = analyze_vertex_cache( grid.indices.size(), grid.indices.data(), vertexCount );
+	auto const after = analyze_vertex_cache( optimized.size(), optimized.data(), vertexCount );
+	REQUIRE( before.acmr > 2.5f );
+	REQUIRE( after.acmr < 0.8f );
+	REQUIRE( after.atvr < 1.6f );
+
+	SECTION( "In place" )
+	{
+		auto indices = grid.indices;
+		optimize_vertex_cache( indices.size(), indices.data(), vertexCount, indices.data() );
+		REQUIRE( indices == optimized );
+	}
+
+	SECTION( "Degenerate triangles" )
+	{
+		std::uint32_t indices[] = { 0, 0, 1, 1, 2, 3, 2, 2, 2, 3, 1, 0 };
+		std::uint32_t out[12];
+		optimize_vertex_cache( 12, indices, 4, out );
+		REQUIRE( canonical_triangles_( { out, out+12 } ) == canonical_triangles_( { indices, indices+12 } ) );
+	}
+}
+
+TEST_CASE( "Overdraw statistics", "[meshopt]" )
+{
+	// Unit quads in the XY plane, counter-clockwise seen from +z. From any
+	// other direction they are culled or seen edge-on.
+	std::vector<Vec3f> const positions{
+		{ 0.f, 0.f, 0.f }, { 1.f, 0.f, 0.f }, { 1.f, 1.f, 0.f }, { 0.f, 1.f, 0.f },
+		{ 0.f, 0.f, 1.f }, { 1.f, 0.f, 1.f }, { 1.f, 1.f, 1.f }, { 0.f, 1.f, 1.f }
+	};
+	std::vector<std::uint32_t> const back{ 0, 1, 2,  0, 2, 3 };
+	std::vector<std::uint32_t> const front{ 4, 5, 6,  4, 6, 7 };
+
+	auto const concat_ = [] (std::vector<std::uint32_t> aA, std::vector<std::uint32_t> const& aB) {
+		aA.insert( aA.end(), aB.begin(), aB.end() );
+		return aA;
+	};
+
+	SECTION( "Single quad" )
+	{
+		// Every pixel is covered exactly once, including those on the
+		// diagonal shared by the two triangles.
+		auto const stats = analyze_overdraw( front.size(), front.data(), positions.size(), positions.data(), 64 );
+		REQUIRE( 64*64 == stats.pixelsCovered );
+		REQUIRE( 64*64 == stats.pixelsShaded );
+		REQUIRE( 1.f == stats.overdraw );
+	}
+
+	SECTION( "Back to front" )
+	{
+		auto const indices = concat_( back, front );
+		auto const stats = analyze_overdraw( indices.size(), indices.data(), positions.size(), positions.data(), 64 );
+		REQUIRE( 64*64 == stats.pixelsCovered );
+		REQUIRE( 2.f == stats.overdraw );
+	}
+
+	SECTION( "Front to back" )
+	{
+		auto const indices = concat_( front, back );
+		auto const stats = analyze_overdraw( indices.size(), indices.data(), positions.size(), positions.data(), 64 );
+		REQUIRE( 64*64 == stats.pixelsCovered );
+		REQUIRE( 1.f == stats.overdraw );
+	}
+
+	SECTION( "Back faces" )
+	{
+		// Clockwise seen from +z: visible from -z only
+		std::vector<std::uint32_t> const flipped{ 0, 2, 1,  0, 3, 2 };
+		auto const stats = analyze_overdraw( flipped.size(), flipped.data(), positions.size(), positions.data(), 64 );
+		REQUIRE( 64*64 == stats.pixelsCovered );
+		REQUIRE( 1.f == stats.overdraw );
+	}
+}
+
+TEST_CASE( "Overdraw optimization", "[meshopt]" )
+{
+	// Two grids, one above the other, facing up. The upper one occludes the
+	// lower one when seen from above, and should be drawn first.
+	auto const lower = make_shuffled_grid_( 40, 1 );
+	auto const upper = make_shuffled_grid_( 40, 2 );
+
+	std::vector<Vec3f> positions = lower.positions;
+	std::vector<std::uint32_t> indices = lower.indices;
+	std::uint32_t const base = std::uint32_t(positions.size());
+	for( auto const& p : upper.positions )
+		positions.emplace_back( Vec3f{ p.x, 10.f, p.z } );
+	for( auto const i : upper.indices )
+		indices.emplace_back( base + i );
+
+	std::vector<std::uint32_t> cached( indices.size() );
+	optimize_vertex_cache( indices.size(), indices.data(), positions.size(), cached.data() );
+
+	std::vector<std::uint32_t> optimized( indices.size() );
+	optimize_overdraw( cached.size(), cached.data(), positions.size(), positions.data(), optimized.data() );
+
+	REQUIRE( canonical_triangles_( optimized ) == canonical_triangles_( indices ) );
+
+	// Cache efficiency is mostly preserved.
+	auto const acmrCached = analyze_vertex_cache( cached.size(), cached.data(), positions.size() ).acmr;
+	auto const acmrOptimized = analyze_vertex_cache( optimized.size(), optimized.data(), positions.size() ).acmr;
+	REQUIRE( acmrOptimized < 1.2f * acmrCached );
+
+	// Upper grid first: its triangles are, on average, earlier in the output.
+	double upperRank = 0.0, lowerRank = 0.0;
+	for( std::size_t t = 0; t < optimized.size() / 3; ++t )
+	{
+		if( optimized[3*t] >= base )
+			upperRank += double(t);
+		else
+			lowerRank += double(t);
+	}
+	REQUIRE( upperRank < lowerRank );
+}
+
+TEST_CASE( "Vertex fetch optimization", "[meshopt]" )
+{
+	std::vector<std::uint32_t> const indices = { 4, 2, 0, 0, 2, 5, 5, 2, 4 };
+	std::vector<std::uint32_t> remap( 7 );
+
+	auto const unique = optimize_vertex_fetch_remap( indices.size(), indices.data(), remap.size(), remap.data() );
+	REQUIRE( unique == 4 );
+	REQUIRE( remap == std::vector<std::uint32_t>{ 2, kUnusedVertex, 1, kUnusedVertex, 0, 3, kUnusedVertex } );
+
+	std::vector<std::uint32_t> remapped( indices.size() );
+	remap_indices( indices.size(), indices.data(), remap.data(), remapped.data() );
+	REQUIRE( remapped == std::vector<std::uint32_t>{ 0, 1, 2, 2, 1, 3, 3, 1, 0 } );
+
+	std::vector<int> vertices = { 10, 11, 12, 13, 14, 15, 16 };
+	remap_vertices( vertices, remap.data(), unique );
+	REQUIRE( vertices == std::vector<int>{ 14, 12, 10, 15 } );
+
+	// Each vertex is still referenced by the same triangles.
+	for( std::size_t i = 0; i < indices.size(); ++i )
+		REQUIRE( vertices[remapped[i]] == 10 + int(indices[i]) );
+}
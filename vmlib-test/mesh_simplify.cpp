@@ -0,0 +1,214 @@
+#include <catch2/catch_amalgamated.hpp>
+
+#include <vector>
+#include <algorithm>
+
+#include <cmath>
+#include <cstdint>
+
+#include "../vmlib/vec3.hpp"
+#include "../vmlib/mesh_simplify.hpp"
+
+namespace
+{
+	struct Mesh_
+	{
+		std::vector<Vec3f> positions;
+		std::vector<std::uint32_t> indices;
+	};
+
+	// Flat grid of aSize x aSize quads in the XZ plane, facing up.
+	Mesh_ make_grid_( std::uint32_t aSize )
+	{
+		Mesh_ ret;
+		for( std::uint32_t z = 0; z <= aSize; ++z )
+		{
+			for( std::uint32_t x = 0; x <= aSize; ++x )
+				ret.positions.emplace_back( Vec3f{ float(x), 0.f, float(z) } );
+		}
+
+		for( std::uint32_t z = 0; z < aSize; ++z )
+		{
+			for( std::uint32_t x = 0; x < aSize; ++x )
+			{
+				std::uint32_t const i = z * (aSize+1) + x;
+				ret.indices.insert( ret.indices.end(), { i, i + aSize+1, i+1 } );
+				ret.indices.insert( ret.indices.end(), { i+1, i + aSize+1, i + aSize+2 } );
+			}
+		}
+		return ret;
+	}
+
+	// Unit sphere with aRings x aSegments quads, facing outwards.
+	Mesh_ make_sphere_( std::uint32_t aRings, std::uint32_t aSegments )
+	{
+		Mesh_ ret;
+		for( std::uint32_t r = 0; r <= aRings; ++r )
+		{
+			float const theta = 3.1415926f * r / aRings;
+			for( std::uint32_t s = 0; s < aSegments; ++s )
+			{
+				float const phi = 2.f * 3.1415926f * s / aSegments;
+				ret.positions.emplace_back( Vec3f{ std::sin( theta ) * std::cos( phi ), std::cos( theta ), std::sin( theta ) * std::sin( phi ) } );
+			}
+		}
+
+		for( std::uint32_t r = 0; r < aRings; ++r )
+		{
+			for( std::uint32_t s = 0; s < aSegments; ++s )
+			{
+				std::uint32_t const a = r * aSegments + s;
+				std::uint32_t const b = r * aSegments + (s+1) % aSegments;
+				std::uint32_t const c = a + aSegments, d = b + aSegments;
+
+				// The poles are rings of vertices at the same position; the
+				// simplifier treats them as a single vertex.
+				ret.indices.insert( ret.indices.end(), { a, b, c } );
+				ret.indices.insert( ret.indices.end(), { b, d, c } );
+			}
+		}
+		return ret;
+	}
+
+	Vec3f triangle_normal_( Mesh_ const& aMesh, std::uint32_t const* aTri )
+	{
+		Vec3f const p0 = aMesh.positions[aTri[0]];
+		return cross( aMesh.positions[aTri[1]] - p0, aMesh.positions[aTri[2]] - p0 );
+	}
+}
+
+TEST_CASE( "Mesh simplification", "[simplify]" )
+{
+	SECTION( "Flat grid" )
+	{
+		auto const grid = make_grid_( 32 );
+
+		SimplifyOptions options;
+		options.targetIndexCount = grid.indices.size() / 10;
+
+		std::vector<std::uint32_t> out( grid.indices.size() );
+		auto const res = simplify_mesh( grid.indices.size(), grid.indices.data(), grid.positions.size(), grid.positions.data(), options, out.data() );
+
+		REQUIRE( res.indexCount <= options.targetIndexCount );
+		REQUIRE( res.indexCount > 0 );
+		REQUIRE( res.error < 1e-3f );
+
+		// All triangles still face up, and still cover the whole grid.
+		float area = 0.f;
+		for( std::size_t i = 0; i < res.indexCount; i += 3 )
+		{
+			Vec3f const n = triangle_normal_( grid, out.data() + i );
+			REQUIRE( n.y > 0.f );
+			area += 0.5f * n.y;
+		}
+		REQUIRE_THAT( area, Catch::Matchers::WithinAbs( 32.f*32.f, 1e-2f ) );
+	}
+
+	SECTION( "Locked border" )
+	{
+		auto const grid = make_grid_( 16 );
+
+		SimplifyOptions options;
+		options.targetIndexCount = 0;
+		options.lockBorder = true;
+
+		std::vector<std::uint32_t> out( grid.indices.size() );
+		auto const res = simplify_mesh( grid.indices.size(), grid.indices.data(), grid.positions.size(), grid.positions.data(), options, out.data() );
+		REQUIRE( res.indexCount < grid.indices.size() / 4 );
+
+		// Every vertex on the border is still there.
+		for( std::uint32_t v = 0; v < grid.positions.size(); ++v )
+		{
+			Vec3f const p = grid.positions[v];
+			if( p.x != 0.f && p.x != 16.f && p.z != 0.f && p.z != 16.f )
+				continue;
+
+			REQUIRE( std::find( out.begin(), out.begin() + res.indexCount, v ) != out.begin() + res.indexCount );
+		}
+	}
+
+	SECTION( "Sphere" )
+	{
+		auto const sphere = make_sphere_( 32, 64 );
+
+		SimplifyOptions options;
+		options.targetIndexCount = sphere.indices.size() / 4;
+
+		std::vector<std::uint32_t> out( sphere.indices.size() );
+		auto const res = simplify_mesh( sphere.indices.size(), sphere.indices.data(), sphere.positions.size(), sphere.positions.data(), options, out.data() );
+
+		REQUIRE( res.indexCount <= options.targetIndexCount );
+		REQUIRE( res.indexCount > options.targetIndexCount / 2 );
+		REQUIRE( res.error > 0.f );
+		REQUIRE( res.error < 0.05f );
+
+		// No triangle has flipped
+		for( std::size_t i = 0; i < res.indexCount; i += 3 )
+		{
+			Vec3f const* p = sphere.positions.data();
+			Vec3f const centroid = (p[out[i]] + p[out[i+1]] + p[out[i+2]]) / 3.f;
+			REQUIRE( dot( triangle_normal_( sphere, out.data() + i ), centroid ) > 0.f );
+		}
+
+		SECTION( "Error limit" )
+		{
+			options.targetError = res.error / 4.f;
+
+			std::vector<std::uint32_t> limited( sphere.indices.size() );
+			auto const lres = simplify_mesh( sphere.indices.size(), sphere.indices.data(), sphere.positions.size(), sphere.positions.data(), options, limited.data() );
+			REQUIRE( lres.error <= options.targetError );
+			REQUIRE( lres.indexCount > res.indexCount );
+		}
+
+		SECTION( "In place" )
+		{
+			auto indices = sphere.indices;
+			auto const ires = simplify_mesh( indices.size(), indices.data(), sphere.positions.size(), sphere.positions.data(), options, indices.data() );
+			REQUIRE( ires.indexCount == res.indexCount );
+			REQUIRE( std::equal( indices.begin(), indices.begin() + ires.indexCount, out.begin() ) );
+		}
+	}
+
+	SECTION( "Split vertices" )
+	{
+		// Each quad of the grid has its own four vertices, as with hard
+		// edges. The simplifier sees through the duplicates and picks the
+		// duplicate with the matching normal.
+		auto const grid = make_grid_( 16 );
+
+		Mesh_ split;
+		std::vector<Vec3f> normals;
+		for( std::size_t i = 0; i < grid.indices.size(); i += 6 )
+		{
+			std::uint32_t const base = std::uint32_t(split.positions.size());
+			std::uint32_t const quad[4] = { grid.indices[i], grid.indices[i+1], grid.indices[i+2], grid.indices[i+5] };
+			for( auto const v : quad )
+			{
+				split.positions.emplace_back( grid.positions[v] );
+				normals.emplace_back( Vec3f{ 0.f, 1.f, 0.f } );
+			}
+			split.indices.insert( split.indices.end(), { base, base+1, base+2, base+2, base+1, base+3 } );
+		}
+
+		// One quad that is "bent", with different normals.
+		normals[0] = normals[1] = normals[2] = normals[3] = Vec3f{ 1.f, 0.f, 0.f };
+
+		SimplifyOptions options;
+		options.targetIndexCount = split.indices.size() / 8;
+		options.normals = normals.data();
+
+		std::vector<std::uint32_t> out( split.indices.size() );
+		auto const res = simplify_mesh( split.indices.size(), split.indices.data(), split.positions.size(), split.positions.data(), options, out.data() );
+		REQUIRE( res.indexCount <= options.targetIndexCount );
+
+		// Only the bent quad's own triangles use its vertices.
+		std::size_t bent = 0;
+		for( std::size_t i = 0; i < res.indexCount; i += 3 )
+		{
+			REQUIRE( out[i] < split.positions.size() );
+			if( out[i] < 4 || out[i+1] < 4 || out[i+2] < 4 )
+				++bent;
+		}
+		REQUIRE( bent <= 2 );
+	}
+}
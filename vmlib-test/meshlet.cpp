@@ -0,0 +1,274 @@
+#include <catch2/catch_amalgamated.hpp>
+
+#include <array>
+#include <cmath>
+#include <random>
+#include <vector>
+#include <algorithm>
+
+#include <cstdint>
+
+#include "../vmlib/vec3.hpp"
+#include "../vmlib/bounds.hpp"
+#include "../vmlib/frustum.hpp"
+#include "../vmlib/meshlet.hpp"
+
+namespace
+{
+	// Height field of aSize x aSize quads in the XZ plane, facing up, with
+	// the triangles in random order. aHeight gives the surface some hills,
+	// so that the meshlets' normal cones differ.
+	struct Grid_
+	{
+		std::vector<Vec3f> positions;
+		std::vector<std::uint32_t> indices;
+	};
+
+	Grid_ make_grid_( std::uint32_t aSize, float aHeight = 0.f, unsigned aSeed = 42 )
+	{
+		Grid_ ret;
+		for( std::uint32_t z = 0; z <= aSize; ++z )
+		{
+			for( std::uint32_t x = 0; x <= aSize; ++x )
+			{
+				float const y = aHeight * std::sin( 0.3f * x ) * std::cos( 0.2f * z );
+				ret.positions.emplace_back( Vec3f{ float(x), y, float(z) } );
+			}
+		}
+
+		std::vector<std::array<std::uint32_t,3>> tris;
+		for( std::uint32_t z = 0; z < aSize; ++z )
+		{
+			for( std::uint32_t x = 0; x < aSize; ++x )
+			{
+				std::uint32_t const i = z * (aSize+1) + x;
+				tris.push_back( { i, i + aSize+1, i+1 } );
+				tris.push_back( { i+1, i + aSize+1, i + aSize+2 } );
+			}
+		}
+
+		std::mt19937 rng( aSeed );
+		std::shuffle( tris.begin(), tris.end(), rng );
+
+		for( auto const& t : tris )
+			ret.indices.insert( ret.indices.end(), t.begin(), t.end() );
+		return ret;
+	}
+
+	// See mesh_optimize.cpp
+	std::vector<std::array<std::uint32_t,3>> canonical_triangles_( std::vector<std::uint32_t> const& aIndices )
+	{
+		std::vector<std::array<std::uint32_t,3>> ret;
+		for( std::size_t i = 0; i < aIndices.size(); i += 3 )
+		{
+			std::array<std::uint32_t,3> t{ aIndices[i], aIndices[i+1], aIndices[i+2] };
+			std::rotate( t.begin(), std::min_element( t.begin(), t.end() ), t.end() );
+			ret.emplace_back( t );
+		}
+		std::sort( ret.begin(), ret.end() );
+		return ret;
+	}
+
+	// Axis-aligned box as a frustum.
+	Frustumf make_box_frustum_( Aabb3f const& aBox )
+	{
+		Frustumf ret;
+		ret.planes[Frustumf::kLeft] = make_plane( { 1.f, 0.f, 0.f }, aBox.min );
+		ret.planes[Frustumf::kRight] = make_plane( { -1.f, 0.f, 0.f }, aBox.max );
+		ret.planes[Frustumf::kBottom] = make_plane( { 0.f, 1.f, 0.f }, aBox.min );
+		ret.planes[Frustumf::kTop] = make_plane( { 0.f, -1.f, 0.f }, aBox.max );
+		ret.planes[Frustumf::kNear] = make_plane( { 0.f, 0.f, 1.f }, aBox.min );
+		ret.planes[Frustumf::kFar] = make_plane( { 0.f, 0.f, -1.f }, aBox.max );
+		return ret;
+	}
+}
+
+TEST_CASE( "Meshlet building", "[meshlet]" )
+{
+	auto const grid = make_grid_( 100, 3.f );
+
+	std::vector<std::uint32_t> out( grid.indices.size() );
+	std::vector<Meshlet> meshlets;
+	auto const count = build_meshlets( grid.indices.size(), grid.indices.data(), grid.positions.size(), grid.positions.data(), out.data(), meshlets );
+
+	REQUIRE( count == meshlets.size() );
+	REQUIRE( canonical_triangles_( out ) == canonical_triangles_( grid.indices ) );
+
+	// Compact meshlets on a grid are close to full
+	REQUIRE( count < 2 * grid.indices.size() / (3 * kMeshletMaxTriangles) );
+
+	SECTION( "Limits and ranges" )
+	{
+		std::uint32_t next = 0;
+		for( auto const& meshlet : meshlets )
+		{
+			REQUIRE( meshlet.firstIndex == next );
+			REQUIRE( meshlet.indexCount % 3 == 0 );
+			REQUIRE( meshlet.indexCount > 0 );
+			REQUIRE( meshlet.indexCount <= 3 * kMeshletMaxTriangles );
+
+			std::vector<std::uint32_t> vertices( out.begin() + meshlet.firstIndex, out.begin() + meshlet.firstIndex + meshlet.indexCount );
+			std::sort( vertices.begin(), vertices.end() );
+			vertices.erase( std::unique( vertices.begin(), vertices.end() ), vertices.end() );
+			REQUIRE( vertices.size() <= kMeshletMaxVertices );
+
+			next += meshlet.indexCount;
+		}
+		REQUIRE( next == out.size() );
+	}
+
+	SECTION( "Bounding spheres" )
+	{
+		for( auto const& meshlet : meshlets )
+		{
+			for( std::uint32_t i = meshlet.firstIndex; i < meshlet.firstIndex + meshlet.indexCount; ++i )
+				REQUIRE( length( grid.positions[out[i]] - meshlet.bounds.center ) <= meshlet.bounds.radius * 1.0001f );
+		}
+	}
+
+	SECTION( "Index offset" )
+	{
+		std::vector<Meshlet> offset;
+		build_meshlets( grid.indices.size(), grid.indices.data(), grid.positions.size(), grid.positions.data(), out.data(), offset, 1000 );
+
+		REQUIRE( offset.size() == meshlets.size() );
+		for( std::size_t i = 0; i < offset.size(); ++i )
+			REQUIRE( offset[i].firstIndex == meshlets[i].firstIndex + 1000 );
+	}
+
+	SECTION( "Empty" )
+	{
+		std::vector<Meshlet> none;
+		REQUIRE( 0 == build_meshlets( 0, nullptr, 0, nullptr, nullptr, none ) );
+		REQUIRE( none.empty() );
+	}
+}
+
+TEST_CASE( "Meshlet normal cones", "[meshlet]" )
+{
+	SECTION( "Flat grid" )
+	{
+		auto const grid = make_grid_( 30 );
+
+		std::vector<std::uint32_t> out( grid.indices.size() );
+		std::vector<Meshlet> meshlets;
+		build_meshlets( grid.indices.size(), grid.indices.data(), grid.positions.size(), grid.positions.data(), out.data(), meshlets );
+
+		for( auto const& meshlet : meshlets )
+		{
+			REQUIRE_THAT( meshlet.coneCutoff, Catch::Matchers::WithinAbs( 0.f, 1e-3f ) );
+			REQUIRE( is_backfacing( meshlet, { 15.f, -5.f, 15.f } ) );
+			REQUIRE( !is_backfacing( meshlet, { 15.f, 5.f, 15.f } ) );
+		}
+	}
+
+	SECTION( "Conservative" )
+	{
+		// Every meshlet that is reported as back facing must have only
+		// triangles that face away from the camera.
+		auto const grid = make_grid_( 60, 4.f );
+
+		std::vector<std::uint32_t> out( grid.indices.size() );
+		std::vector<Meshlet> meshlets;
+		build_meshlets( grid.indices.size(), grid.indices.data(), grid.positions.size(), grid.positions.data(), out.data(), meshlets );
+
+		std::mt19937 rng( 7 );
+		std::uniform_real_distribution<float> dist( -20.f, 80.f );
+
+		std::size_t culled = 0;
+		for( std::size_t k = 0; k < 200; ++k )
+		{
+			Vec3f const camera{ dist( rng ), 0.3f * dist( rng ), dist( rng ) };
+			for( auto const& meshlet : meshlets )
+			{
+				if( !is_backfacing( meshlet, camera ) )
+					continue;
+
+				++culled;
+				for( std::uint32_t i = meshlet.firstIndex; i < meshlet.firstIndex + meshlet.indexCount; i += 3 )
+				{
+					Vec3f const p0 = grid.positions[out[i]];
+					Vec3f const n = normalize( cross( grid.positions[out[i+1]] - p0, grid.positions[out[i+2]] - p0 ) );
+					REQUIRE( dot( camera - p0, n ) <= 1e-4f );
+				}
+			}
+		}
+
+		// ... and the test should actually cull something.
+		REQUIRE( culled > 0 );
+	}
+
+	SECTION( "Closed mesh" )
+	{
+		// A tetrahedron's normals spread over more than a hemisphere.
+		std::vector<Vec3f> const positions{ { 0.f, 0.f, 0.f }, { 1.f, 0.f, 0.f }, { 0.f, 1.f, 0.f }, { 0.f, 0.f, 1.f } };
+		std::vector<std::uint32_t> const indices{ 0, 2, 1, 0, 1, 3, 0, 3, 2, 1, 2, 3 };
+
+		std::vector<std::uint32_t> out( indices.size() );
+		std::vector<Meshlet> meshlets;
+		REQUIRE( 1 == build_meshlets( indices.size(), indices.data(), positions.size(), positions.data(), out.data(), meshlets ) );
+		REQUIRE( meshlets[0].coneCutoff > 1.f );
+
+		for( Vec3f const camera : { Vec3f{ 5.f, 5.f, 5.f }, Vec3f{ -5.f, 0.f, 0.f }, Vec3f{ 0.1f, 0.1f, 0.1f }, meshlets[0].coneApex } )
+			REQUIRE( !is_backfacing( meshlets[0], camera ) );
+	}
+}
+
+TEST_CASE( "Meshlet culling", "[meshlet]" )
+{
+	auto const grid = make_grid_( 64 );
+
+	std::vector<std::uint32_t> out( grid.indices.size() );
+	std::vector<Meshlet> meshlets;
+	build_meshlets( grid.indices.size(), grid.indices.data(), grid.positions.size(), grid.positions.data(), out.data(), meshlets );
+
+	Vec3f const above{ 32.f, 10.f, 32.f };
+	Vec3f const below{ 32.f, -10.f, 32.f };
+
+	std::vector<MeshletRange> ranges;
+
+	SECTION( "All visible" )
+	{
+		Frustumf const frustum = make_box_frustum_( { { -100.f, -100.f, -100.f }, { 100.f, 100.f, 100.f } } );
+		REQUIRE( meshlets.size() == cull_meshlets( frustum, above, meshlets.size(), meshlets.data(), ranges ) );
+
+		// Adjacent meshlets are merged into one range
+		REQUIRE( 1 == ranges.size() );
+		REQUIRE( 0 == ranges[0].firstIndex );
+		REQUIRE( out.size() == ranges[0].indexCount );
+	}
+
+	SECTION( "Back facing" )
+	{
+		Frustumf const frustum = make_box_frustum_( { { -100.f, -100.f, -100.f }, { 100.f, 100.f, 100.f } } );
+		REQUIRE( 0 == cull_meshlets( frustum, below, meshlets.size(), meshlets.data(), ranges ) );
+		REQUIRE( ranges.empty() );
+
+		REQUIRE( meshlets.size() == cull_meshlets( frustum, below, meshlets.size(), meshlets.data(), ranges, false ) );
+	}
+
+	SECTION( "Frustum" )
+	{
+		// Left half of the grid. Every triangle that is inside must be in one
+		// of the ranges; some outside may be too (the spheres are larger than
+		// the meshlets).
+		Frustumf const frustum = make_box_frustum_( { { -100.f, -100.f, -100.f }, { 20.f, 100.f, 100.f } } );
+		std::size_t const visible = cull_meshlets( frustum, above, meshlets.size(), meshlets.data(), ranges );
+		REQUIRE( visible > 0 );
+		REQUIRE( visible < meshlets.size() );
+
+		std::vector<std::uint8_t> drawn( out.size() / 3, 0 );
+		for( auto const& range : ranges )
+		{
+			for( std::uint32_t i = range.firstIndex; i < range.firstIndex + range.indexCount; i += 3 )
+				drawn[i / 3] = 1;
+		}
+
+		for( std::size_t t = 0; t < drawn.size(); ++t )
+		{
+			bool const inside = grid.positions[out[3*t]].x < 20.f || grid.positions[out[3*t+1]].x < 20.f || grid.positions[out[3*t+2]].x < 20.f;
+			if( inside )
+				REQUIRE( drawn[t] );
+		}
+	}
+}
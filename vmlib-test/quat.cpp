@@ -0,0 +1,148 @@
+#include <catch2/catch_amalgamated.hpp>
+
+#include <random>
+#include <vector>
+
+#include "common.hpp"
+
+#include "../vmlib/quat.hpp"
+#include "../vmlib/simd.hpp"
+
+namespace
+{
+	void require_equal_( Mat44f const& aA, Mat44f const& aB, float aEps )
+	{
+		using namespace Catch::Matchers;
+		for( std::size_t i = 0; i < 16; ++i )
+			REQUIRE_THAT( aA.v[i], WithinAbs( aB.v[i], aEps ) );
+	}
+
+	Quatf random_quat_( std::mt19937& aRng )
+	{
+		std::uniform_real_distribution<float> dist( -1.f, 1.f );
+		return normalize_quat( Quatf{ dist(aRng), dist(aRng), dist(aRng), dist(aRng) } );
+	}
+}
+
+TEST_CASE( "Quaternion rotations", "[quat]" )
+{
+	static constexpr float kEps_ = 1e-5f;
+	using namespace Catch::Matchers;
+
+	SECTION( "Axis rotations match Mat44f" )
+	{
+		require_equal_( to_mat44( make_quat_rotation( { 1.f, 0.f, 0.f }, 0.7f ) ), make_rotation_x( 0.7f ), kEps_ );
+		require_equal_( to_mat44( make_quat_rotation( { 0.f, 1.f, 0.f }, -1.3f ) ), make_rotation_y( -1.3f ), kEps_ );
+		require_equal_( to_mat44( make_quat_rotation( { 0.f, 0.f, 1.f }, 2.1f ) ), make_rotation_z( 2.1f ), kEps_ );
+	}
+
+	SECTION( "Composition matches matrix product" )
+	{
+		Quatf const a = make_quat_rotation( { 0.f, 1.f, 0.f }, 0.4f );
+		Quatf const b = make_quat_rotation( normalize( Vec3f{ 1.f, 1.f, 0.f } ), -0.9f );
+		require_equal_( to_mat44( a * b ), to_mat44( a ) * to_mat44( b ), kEps_ );
+
+		Vec3f const v{ 1.f, -2.f, 0.5f };
+		Vec3f const rv = rotate( a * b, v );
+		Vec4f const mv = to_mat44( a ) * to_mat44( b ) * Vec4f{ v.x, v.y, v.z, 0.f };
+		REQUIRE_THAT( rv.x, WithinAbs( mv.x, kEps_ ) );
+		REQUIRE_THAT( rv.y, WithinAbs( mv.y, kEps_ ) );
+		REQUIRE_THAT( rv.z, WithinAbs( mv.z, kEps_ ) );
+	}
+
+	SECTION( "Slerp" )
+	{
+		Vec3f const axis{ 0.f, 0.f, 1.f };
+		Quatf const a = make_quat_rotation( axis, 0.2f );
+		Quatf const b = make_quat_rotation( axis, 1.4f );
+
+		require_equal_( to_mat44( slerp( a, b, 0.f ) ), to_mat44( a ), kEps_ );
+		require_equal_( to_mat44( slerp( a, b, 1.f ) ), to_mat44( b ), kEps_ );
+		require_equal_( to_mat44( slerp( a, b, 0.25f ) ), make_rotation_z( 0.5f ), kEps_ );
+
+		// Takes the shorter arc even if the signs differ
+		require_equal_( to_mat44( slerp( a, -1.f * b, 0.25f ) ), make_rotation_z( 0.5f ), kEps_ );
+	}
+}
+
+TEST_CASE( "Dual quaternion transforms", "[quat]" )
+{
+	static constexpr float kEps_ = 1e-5f;
+	using namespace Catch::Matchers;
+
+	Quatf const ra = make_quat_rotation( { 0.f, 0.f, 1.f }, 0.6f );
+	Quatf const rb = make_quat_rotation( { 1.f, 0.f, 0.f }, -0.3f );
+	Vec3f const ta{ 1.f, 2.f, 3.f };
+	Vec3f const tb{ -4.f, 0.5f, 2.f };
+
+	DualQuatf const a = make_dual_quat( ra, ta );
+	DualQuatf const b = make_dual_quat( rb, tb );
+
+	Mat44f const ma = make_translation( ta ) * to_mat44( ra );
+	Mat44f const mb = make_translation( tb ) * to_mat44( rb );
+
+	SECTION( "Conversion" )
+	{
+		require_equal_( to_mat44( a ), ma, kEps_ );
+
+		Vec3f const t = translation( a );
+		REQUIRE_THAT( t.x, WithinAbs( ta.x, kEps_ ) );
+		REQUIRE_THAT( t.y, WithinAbs( ta.y, kEps_ ) );
+		REQUIRE_THAT( t.z, WithinAbs( ta.z, kEps_ ) );
+	}
+
+	SECTION( "Composition matches matrix product" )
+	{
+		require_equal_( to_mat44( a * b ), ma * mb, 1e-4f );
+		require_equal_( to_mat44( normalize_dual_quat( a * b ) ), ma * mb, 1e-4f );
+
+		Vec3f const p{ 0.5f, -1.f, 2.f };
+		Vec3f const q = transform_point( a * b, p );
+		Vec4f const r = ma * mb * Vec4f{ p.x, p.y, p.z, 1.f };
+		REQUIRE_THAT( q.x, WithinAbs( r.x, 1e-4f ) );
+		REQUIRE_THAT( q.y, WithinAbs( r.y, 1e-4f ) );
+		REQUIRE_THAT( q.z, WithinAbs( r.z, 1e-4f ) );
+	}
+
+	SECTION( "Interpolation" )
+	{
+		require_equal_( to_mat44( slerp( a, b, 0.f ) ), ma, kEps_ );
+		require_equal_( to_mat44( slerp( a, b, 1.f ) ), mb, 1e-4f );
+		require_equal_( to_mat44( nlerp( a, b, 0.f ) ), ma, kEps_ );
+		require_equal_( to_mat44( nlerp( a, b, 1.f ) ), mb, 1e-4f );
+
+		Vec3f const mid = translation( slerp( a, b, 0.5f ) );
+		REQUIRE_THAT( mid.x, WithinAbs( -1.5f, kEps_ ) );
+		REQUIRE_THAT( mid.y, WithinAbs( 1.25f, kEps_ ) );
+		REQUIRE_THAT( mid.z, WithinAbs( 2.5f, kEps_ ) );
+	}
+}
+
+TEST_CASE( "Batched quaternion conversion", "[quat][batch]" )
+{
+	// Not a multiple of the SIMD width, to exercise the tails.
+	std::size_t const count = 1003;
+
+	std::mt19937 rng( 7 );
+	std::uniform_real_distribution<float> dist( -10.f, 10.f );
+
+	std::vector<Quatf> quats( count );
+	std::vector<DualQuatf> duals( count );
+	for( std::size_t i = 0; i < count; ++i )
+	{
+		quats[i] = random_quat_( rng );
+		duals[i] = make_dual_quat( random_quat_( rng ), test::random_vec3( rng, dist ) );
+	}
+
+	test::for_each_isa( [&] {
+		std::vector<Mat44f> out( count );
+
+		quat_to_mat44_n( count, quats.data(), out.data() );
+		for( std::size_t i = 0; i < count; ++i )
+			require_equal_( out[i], to_mat44( quats[i] ), 1e-5f );
+
+		dual_quat_to_mat44_n( count, duals.data(), out.data() );
+		for( std::size_t i = 0; i < count; ++i )
+			require_equal_( out[i], to_mat44( duals[i] ), 1e-4f );
+	} );
+}
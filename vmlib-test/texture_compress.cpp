@@ -0,0 +1,328 @@
+#include <catch2/catch_amalgamated.hpp>
+
+#include <random>
+#include <vector>
+#include <algorithm>
+
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+
+#include "common.hpp"
+
+#include "../vmlib/simd.hpp"
+#include "../vmlib/texture_compress.hpp"
+
+namespace
+{
+	std::vector<std::uint8_t> make_noise_( std::size_t aWidth, std::size_t aHeight, unsigned aSeed = 42 )
+	{
+		std::mt19937 rng( aSeed );
+		std::uniform_int_distribution<int> dist( 0, 255 );
+
+		std::vector<std::uint8_t> ret( 4 * aWidth * aHeight );
+		for( auto& x : ret )
+			x = std::uint8_t(dist( rng ));
+		return ret;
+	}
+
+	// Smooth color gradients, with a little noise; similar to a photograph.
+	std::vector<std::uint8_t> make_smooth_( std::size_t aWidth, std::size_t aHeight )
+	{
+		std::mt19937 rng( 7 );
+		std::uniform_int_distribution<int> noise( -2, 2 );
+
+		std::vector<std::uint8_t> ret( 4 * aWidth * aHeight );
+		for( std::size_t y = 0; y < aHeight; ++y )
+		{
+			for( std::size_t x = 0; x < aWidth; ++x )
+			{
+				float const u = float(x) / aWidth, v = float(y) / aHeight;
+				float const c[4] = {
+					128.f + 100.f * std::sin( 6.f * u ),
+					128.f + 100.f * std::cos( 5.f * v ),
+					64.f + 128.f * u * v,
+					255.f - 60.f * v
+				};
+				for( int i = 0; i < 4; ++i )
+					ret[4*(y*aWidth + x) + i] = std::uint8_t(std::clamp( int(c[i]) + noise( rng ), 0, 255 ));
+			}
+		}
+		return ret;
+	}
+
+	double to_linear_( int aValue )
+	{
+		double const c = aValue / 255.0;
+		return c <= 0.04045 ? c / 12.92 : std::pow( (c + 0.055) / 1.055, 2.4 );
+	}
+	int to_srgb_( double aLinear )
+	{
+		double const c = aLinear <= 0.0031308 ? 12.92 * aLinear : 1.055 * std::pow( aLinear, 1.0/2.4 ) - 0.055;
+		return int(std::lround( std::clamp( c, 0.0, 1.0 ) * 255.0 ));
+	}
+
+	// Decoder for BC7 mode 6 blocks (the only mode that compress_bc7()
+	// writes). Returns false for other modes.
+	bool decode_bc7_mode6_( std::uint8_t const* aBlock, std::uint8_t (&aTexels)[16][4] )
+	{
+		unsigned bit = 0;
+		auto const get = [&] (unsigned aBits) {
+			unsigned ret = 0;
+			for( unsigned i = 0; i < aBits; ++i, ++bit )
+				ret |= unsigned((aBlock[bit >> 3] >> (bit & 7)) & 1u) << i;
+			return ret;
+		};
+
+		if( (1u << 6) != get( 7 ) )
+			return false;
+
+		int e[2][4];
+		for( int c = 0; c < 4; ++c )
+		{
+			e[0][c] = int(get( 7 )) << 1;
+			e[1][c] = int(get( 7 )) << 1;
+		}
+		int const p0 = int(get( 1 )), p1 = int(get( 1 ));
+		for( int c = 0; c < 4; ++c )
+		{
+			e[0][c] |= p0;
+			e[1][c] |= p1;
+		}
+
+		static constexpr int kWeights[16] = { 0, 4, 9, 13, 17, 21, 26, 30, 34, 38, 43, 47, 51, 55, 60, 64 };
+		for( int t = 0; t < 16; ++t )
+		{
+			int const w = kWeights[get( 0 == t ? 3 : 4 )];
+			for( int c = 0; c < 4; ++c )
+				aTexels[t][c] = std::uint8_t(((64 - w) * e[0][c] + w * e[1][c] + 32) >> 6);
+		}
+		return 128 == bit;
+	}
+
+	std::vector<std::uint8_t> decode_bc7_( std::size_t aWidth, std::size_t aHeight, std::vector<std::uint8_t> const& aBlocks )
+	{
+		std::size_t const blocksX = (aWidth + 3) / 4;
+
+		std::vector<std::uint8_t> ret( 4 * aWidth * aHeight );
+		for( std::size_t by = 0; by < (aHeight + 3) / 4; ++by )
+		{
+			for( std::size_t bx = 0; bx < blocksX; ++bx )
+			{
+				std::uint8_t texels[16][4];
+				REQUIRE( decode_bc7_mode6_( aBlocks.data() + 16 * (by * blocksX + bx), texels ) );
+
+				for( std::size_t t = 0; t < 16; ++t )
+				{
+					std::size_t const x = 4*bx + t % 4, y = 4*by + t / 4;
+					if( x < aWidth && y < aHeight )
+						std::copy( texels[t], texels[t] + 4, ret.data() + 4 * (y * aWidth + x) );
+				}
+			}
+		}
+		return ret;
+	}
+
+	double psnr_( std::vector<std::uint8_t> const& aA, std::vector<std::uint8_t> const& aB )
+	{
+		double mse = 0.0;
+		for( std::size_t i = 0; i < aA.size(); ++i )
+		{
+			double const d = double(aA[i]) - aB[i];
+			mse += d*d;
+		}
+		mse /= aA.size();
+		return 0.0 == mse ? 100.0 : 10.0 * std::log10( 255.0 * 255.0 / mse );
+	}
+}
+
+TEST_CASE( "Mip chain sizes", "[texture]" )
+{
+	REQUIRE( mip_size( 4096, 0 ) == 4096 );
+	REQUIRE( mip_size( 4096, 3 ) == 512 );
+	REQUIRE( mip_size( 5, 1 ) == 2 );
+	REQUIRE( mip_size( 5, 3 ) == 1 );
+	REQUIRE( mip_size( 1, 100 ) == 1 );
+
+	REQUIRE( mip_level_count( 1, 1 ) == 1 );
+	REQUIRE( mip_level_count( 4096, 4096 ) == 13 );
+	REQUIRE( mip_level_count( 4096, 16 ) == 13 );
+	REQUIRE( mip_level_count( 5, 3 ) == 3 );
+}
+
+TEST_CASE( "Gamma correct downsampling", "[texture]" )
+{
+	SECTION( "Black and white" )
+	{
+		// Half black and half white is 50% linear intensity, which is 188
+		// in sRGB (not 128). Alpha is averaged as it is.
+		std::uint8_t const in[16] = {
+			0, 0, 0, 0,     255, 255, 255, 255,
+			255, 255, 255, 255,   0, 0, 0, 0
+		};
+		std::uint8_t out[4];
+
+		test::for_each_isa( [&] {
+			downsample_srgb8( 2, 2, in, out );
+			REQUIRE( int(out[0]) == 188 );
+			REQUIRE( int(out[1]) == 188 );
+			REQUIRE( int(out[2]) == 188 );
+			REQUIRE( int(out[3]) == 128 );
+		} );
+	}
+
+	SECTION( "Constant" )
+	{
+		// Every value survives unchanged.
+		std::vector<std::uint8_t> in( 4 * 256 * 2 );
+		for( std::size_t i = 0; i < in.size(); ++i )
+			in[i] = std::uint8_t((i / 4 % 256) & ~1u);
+
+		std::vector<std::uint8_t> out( 4 * 128 );
+		test::for_each_isa( [&] {
+			downsample_srgb8( 256, 2, in.data(), out.data() );
+			for( std::size_t x = 0; x < 128; ++x )
+			{
+				for( int c = 0; c < 4; ++c )
+					REQUIRE( int(out[4*x + c]) == int(2*x) );
+			}
+		} );
+	}
+
+	SECTION( "Random" )
+	{
+		// Sizes: odd (the last row and column are dropped), one texel wide
+		// or high, and large enough to be split across threads.
+		std::size_t const sizes[][2] = { { 513, 301 }, { 1, 37 }, { 64, 1 }, { 1, 1 }, { 3, 3 } };
+		for( auto const& size : sizes )
+		{
+			std::size_t const w = size[0], h = size[1];
+			std::size_t const ow = mip_size( w, 1 ), oh = mip_size( h, 1 );
+			auto const in = make_noise_( w, h );
+
+			// Reference, in double precision
+			std::vector<std::uint8_t> ref( 4 * ow * oh );
+			for( std::size_t y = 0; y < oh; ++y )
+			{
+				for( std::size_t x = 0; x < ow; ++x )
+				{
+					std::size_t const xs[2] = { 2*x, std::min( 2*x+1, w-1 ) };
+					std::size_t const ys[2] = { 2*y, std::min( 2*y+1, h-1 ) };
+					for( int c = 0; c < 4; ++c )
+					{
+						double sum = 0.0;
+						for( auto const yy : ys )
+						{
+							for( auto const xx : xs )
+							{
+								int const v = in[4*(yy*w + xx) + c];
+								sum += 3 == c ? v : to_linear_( v );
+							}
+						}
+						ref[4*(y*ow + x) + c] = std::uint8_t(3 == c ? int(std::floor( sum / 4.0 + 0.5 )) : to_srgb_( sum / 4.0 ));
+					}
+				}
+			}
+
+			// All instruction sets give the same results. (No sections here;
+			// they would only run for the first size.)
+			auto const previous = simd_active_isa();
+			simd_set_isa( SimdIsa::scalar );
+			std::vector<std::uint8_t> scalar( ref.size() );
+			downsample_srgb8( w, h, in.data(), scalar.data() );
+
+			for( std::size_t i = 0; i < ref.size(); ++i )
+				REQUIRE( std::abs( int(scalar[i]) - int(ref[i]) ) <= 1 );
+
+			std::vector<std::uint8_t> out( ref.size() );
+			for( auto const isa : { SimdIsa::sse2, SimdIsa::avx2, SimdIsa::neon } )
+			{
+				if( !simd_set_isa( isa ) )
+					continue;
+
+				INFO( simd_isa_name( isa ) << ", " << w << "x" << h );
+				downsample_srgb8( w, h, in.data(), out.data() );
+				REQUIRE( out == scalar );
+			}
+			simd_set_isa( previous );
+		}
+	}
+}
+
+TEST_CASE( "BC7 compression", "[texture]" )
+{
+	REQUIRE( bc7_size( 4, 4 ) == 16 );
+	REQUIRE( bc7_size( 5, 3 ) == 32 );
+	REQUIRE( bc7_size( 4096, 4096 ) == 4096 * 4096 );
+
+	SECTION( "Constant blocks" )
+	{
+		// Every constant color is represented to within one unit.
+		std::vector<std::uint8_t> in( 4 * 16 * 16 );
+		for( std::size_t i = 0; i < 256; ++i )
+		{
+			for( int c = 0; c < 4; ++c )
+				in[4*i + c] = std::uint8_t((i * (c+1) * 37) & 0xff);
+		}
+
+		// Make every 4x4 block constant.
+		for( std::size_t y = 0; y < 16; ++y )
+		{
+			for( std::size_t x = 0; x < 16; ++x )
+				std::copy( in.begin() + 4*((y & ~3u)*16 + (x & ~3u)), in.begin() + 4*((y & ~3u)*16 + (x & ~3u)) + 4, in.begin() + 4*(y*16 + x) );
+		}
+
+		std::vector<std::uint8_t> blocks( bc7_size( 16, 16 ) );
+		compress_bc7( 16, 16, in.data(), blocks.data() );
+
+		auto const out = decode_bc7_( 16, 16, blocks );
+		for( std::size_t i = 0; i < in.size(); ++i )
+			REQUIRE( std::abs( int(out[i]) - int(in[i]) ) <= 1 );
+	}
+
+	SECTION( "Two colors" )
+	{
+		// Blocks with two colors are represented almost exactly: both are
+		// endpoints.
+		std::uint8_t const a[4] = { 10, 200, 30, 255 }, b[4] = { 250, 20, 90, 0 };
+
+		std::vector<std::uint8_t> in( 4 * 16 );
+		for( std::size_t t = 0; t < 16; ++t )
+			std::copy( (t * 7) % 3 ? a : b, ((t * 7) % 3 ? a : b) + 4, in.begin() + 4*t );
+
+		std::vector<std::uint8_t> blocks( 16 );
+		compress_bc7( 4, 4, in.data(), blocks.data() );
+
+		auto const out = decode_bc7_( 4, 4, blocks );
+		for( std::size_t i = 0; i < in.size(); ++i )
+			REQUIRE( std::abs( int(out[i]) - int(in[i]) ) <= 1 );
+	}
+
+	SECTION( "Smooth image" )
+	{
+		// Includes partial blocks at the right and bottom edges.
+		std::size_t const w = 257, h = 131;
+		auto const in = make_smooth_( w, h );
+
+		std::vector<std::uint8_t> blocks( bc7_size( w, h ) );
+		compress_bc7( w, h, in.data(), blocks.data() );
+
+		auto const out = decode_bc7_( w, h, blocks );
+		REQUIRE( psnr_( in, out ) > 40.0 );
+	}
+
+	SECTION( "Noise" )
+	{
+		// Noise is the worst case, but the result must still be closer to
+		// the input than a flat gray image is.
+		std::size_t const w = 64, h = 64;
+		auto const in = make_noise_( w, h );
+
+		std::vector<std::uint8_t> blocks( bc7_size( w, h ) );
+		compress_bc7( w, h, in.data(), blocks.data() );
+
+		auto const out = decode_bc7_( w, h, blocks );
+		std::vector<std::uint8_t> const gray( in.size(), 128 );
+		REQUIRE( psnr_( in, out ) > psnr_( in, gray ) + 1.0 );
+	}
+}
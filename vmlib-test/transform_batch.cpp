@@ -0,0 +1,102 @@
+#include <catch2/catch_amalgamated.hpp>
+
+#include <random>
+#include <vector>
+
+#include "common.hpp"
+
+#include "../vmlib/mat33.hpp"
+#include "../vmlib/mat44.hpp"
+#include "../vmlib/simd.hpp"
+#include "../vmlib/transform_batch.hpp"
+
+namespace
+{
+	Vec3f reference_point_( Mat44f const& aM, Vec3f aP )
+	{
+		Vec4f t = aM * Vec4f{ aP.x, aP.y, aP.z, 1.f };
+		t /= t.w;
+		return Vec3f{ t.x, t.y, t.z };
+	}
+
+	void require_close_( Vec3f aA, Vec3f aB, float aEps )
+	{
+		using namespace Catch::Matchers;
+		REQUIRE_THAT( aA.x, WithinAbs( aB.x, aEps ) );
+		REQUIRE_THAT( aA.y, WithinAbs( aB.y, aEps ) );
+		REQUIRE_THAT( aA.z, WithinAbs( aB.z, aEps ) );
+	}
+}
+
+TEST_CASE( "Batched point transformation", "[batch][mat44]" )
+{
+	// 70001 points: large enough to be split across threads, and not a
+	// multiple of the SIMD width.
+	auto const points = test::random_points( 70001, -5.f, 5.f );
+
+	Mat44f const affine = make_translation( { 1.f, -2.f, 3.f } )
+		* make_rotation_y( 0.7f )
+		* make_scaling( 2.f, 0.5f, 1.5f );
+
+	Mat44f const projective = make_perspective_projection( 1.f, 1.5f, 0.1f, 100.f )
+		* make_translation( { 0.f, 0.f, -20.f } );
+
+	test::for_each_isa( [&] {
+		for( auto const& m : { affine, projective } )
+		{
+			auto out = points;
+			transform_points( m, out );
+
+			for( std::size_t i = 0; i < points.size(); i += 97 )
+				require_close_( out[i], reference_point_( m, points[i] ), 1e-4f );
+			require_close_( out.back(), reference_point_( m, points.back() ), 1e-4f );
+		}
+	} );
+}
+
+TEST_CASE( "Batched vector transformation", "[batch][mat33]" )
+{
+	auto const vectors = test::random_points( 1003, -5.f, 5.f );
+	Mat33f const rot = mat44_to_mat33( make_rotation_x( 0.3f ) * make_rotation_z( -1.2f ) );
+	Mat33f const scale = mat44_to_mat33( make_scaling( 3.f, 1.f, 0.25f ) );
+
+	test::for_each_isa( [&] {
+		std::vector<Vec3f> out( vectors.size() );
+		transform_vectors( rot, vectors.size(), vectors.data(), out.data() );
+		for( std::size_t i = 0; i < vectors.size(); ++i )
+			require_close_( out[i], rot * vectors[i], 1e-4f );
+
+		out = vectors;
+		transform_vectors( scale, out, true );
+		for( std::size_t i = 0; i < vectors.size(); ++i )
+			require_close_( out[i], normalize( scale * vectors[i] ), 1e-5f );
+	} );
+}
+
+TEST_CASE( "Batched SoA point transformation", "[batch][mat44]" )
+{
+	auto const points = test::random_points( 1029, -5.f, 5.f );
+
+	std::vector<float> x, y, z;
+	for( auto const& p : points )
+	{
+		x.push_back( p.x );
+		y.push_back( p.y );
+		z.push_back( p.z );
+	}
+
+	Mat44f const m = make_perspective_projection( 1.f, 1.5f, 0.1f, 100.f )
+		* make_translation( { 0.f, 0.f, -20.f } )
+		* make_rotation_z( 0.4f );
+
+	test::for_each_isa( [&] {
+		std::vector<float> ox( x.size() ), oy( y.size() ), oz( z.size() );
+		transform_points_soa( m, points.size(),
+			Vec3fSoaConst{ x.data(), y.data(), z.data() },
+			Vec3fSoa{ ox.data(), oy.data(), oz.data() }
+		);
+
+		for( std::size_t i = 0; i < points.size(); ++i )
+			require_close_( Vec3f{ ox[i], oy[i], oz[i] }, reference_point_( m, points[i] ), 1e-4f );
+	} );
+}
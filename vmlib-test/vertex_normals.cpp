@@ -0,0 +1,304 @@
+#include <catch2/catch_amalgamated.hpp>
+
+#include <array>
+#include <cmath>
+#include <vector>
+#include <algorithm>
+
+#include <cstdint>
+
+#include "common.hpp"
+
+#include "../vmlib/vec2.hpp"
+#include "../vmlib/vec3.hpp"
+#include "../vmlib/vec4.hpp"
+#include "../vmlib/vertex_normals.hpp"
+
+namespace
+{
+	// Height field of aSize x aSize quads in the XZ plane, facing up, with
+	// texture coordinates (aU * x, z). Large enough grids are split across
+	// threads.
+	struct Grid_
+	{
+		std::vector<Vec3f> positions;
+		std::vector<Vec2f> textcoords;
+		std::vector<std::uint32_t> indices;
+	};
+
+	Grid_ make_grid_( std::uint32_t aSize, float aHeight = 0.f, float aU = 1.f )
+	{
+		Grid_ ret;
+		for( std::uint32_t z = 0; z <= aSize; ++z )
+		{
+			for( std::uint32_t x = 0; x <= aSize; ++x )
+			{
+				float const y = aHeight * std::sin( 0.3f * x ) * std::cos( 0.2f * z );
+				ret.positions.emplace_back( Vec3f{ float(x), y, float(z) } );
+				ret.textcoords.emplace_back( Vec2f{ aU * float(x), float(z) } );
+			}
+		}
+
+		for( std::uint32_t z = 0; z < aSize; ++z )
+		{
+			for( std::uint32_t x = 0; x < aSize; ++x )
+			{
+				std::uint32_t const i = z * (aSize+1) + x;
+				ret.indices.insert( ret.indices.end(), { i, i + aSize+1, i+1 } );
+				ret.indices.insert( ret.indices.end(), { i+1, i + aSize+1, i + aSize+2 } );
+			}
+		}
+		return ret;
+	}
+
+	// Reference: serial, in double precision, with std::acos.
+	std::vector<Vec3f> reference_normals_( Grid_ const& aGrid )
+	{
+		std::vector<std::array<double,3>> sums( aGrid.positions.size(), { 0.0, 0.0, 0.0 } );
+		for( std::size_t i = 0; i < aGrid.indices.size(); i += 3 )
+		{
+			Vec3f const n = normalize( cross( aGrid.positions[aGrid.indices[i+1]] - aGrid.positions[aGrid.indices[i]], aGrid.positions[aGrid.indices[i+2]] - aGrid.positions[aGrid.indices[i]] ) );
+			for( std::size_t k = 0; k < 3; ++k )
+			{
+				Vec3f const p = aGrid.positions[aGrid.indices[i+k]];
+				Vec3f const a = normalize( aGrid.positions[aGrid.indices[i+(k+1)%3]] - p );
+				Vec3f const b = normalize( aGrid.positions[aGrid.indices[i+(k+2)%3]] - p );
+				double const angle = std::acos( std::clamp( double(dot( a, b )), -1.0, 1.0 ) );
+
+				auto& sum = sums[aGrid.indices[i+k]];
+				sum[0] += angle * n.x;
+				sum[1] += angle * n.y;
+				sum[2] += angle * n.z;
+			}
+		}
+
+		std::vector<Vec3f> ret;
+		for( auto const& s : sums )
+			ret.emplace_back( normalize( Vec3f{ float(s[0]), float(s[1]), float(s[2]) } ) );
+		return ret;
+	}
+}
+
+TEST_CASE( "Vertex normals", "[normals]" )
+{
+	using namespace Catch::Matchers;
+
+	test::for_each_isa( [&] {
+		SECTION( "Cube" )
+		{
+			// Shared corners. Each face adds 90 degrees to each of its corners,
+			// no matter which of its two triangles touch it, so the normals
+			// point exactly along the diagonals. (Area weights would not.)
+			std::vector<Vec3f> const positions{
+				{ -1.f, -1.f, -1.f }, { 1.f, -1.f, -1.f }, { 1.f, 1.f, -1.f }, { -1.f, 1.f, -1.f },
+				{ -1.f, -1.f, 1.f }, { 1.f, -1.f, 1.f }, { 1.f, 1.f, 1.f }, { -1.f, 1.f, 1.f }
+			};
+			std::vector<std::uint32_t> const indices{
+				0, 2, 1,  0, 3, 2, // -z
+				4, 5, 6,  4, 6, 7, // +z
+				0, 1, 5,  0, 5, 4, // -y
+				3, 7, 6,  3, 6, 2, // +y
+				0, 4, 7,  0, 7, 3, // -x
+				1, 2, 6,  1, 6, 5  // +x
+			};
+
+			std::vector<Vec3f> normals( positions.size() );
+			compute_vertex_normals( indices.size(), indices.data(), positions.size(), positions.data(), normals.data() );
+
+			for( std::size_t v = 0; v < positions.size(); ++v )
+			{
+				Vec3f const expected = normalize( positions[v] );
+				REQUIRE_THAT( normals[v].x, WithinAbs( expected.x, 1e-6f ) );
+				REQUIRE_THAT( normals[v].y, WithinAbs( expected.y, 1e-6f ) );
+				REQUIRE_THAT( normals[v].z, WithinAbs( expected.z, 1e-6f ) );
+			}
+		}
+
+		SECTION( "Unindexed" )
+		{
+			// Each vertex has a single triangle: flat normals.
+			std::vector<Vec3f> const positions{
+				{ 0.f, 0.f, 0.f }, { 1.f, 0.f, 0.f }, { 0.f, 1.f, 0.f },
+				{ 0.f, 0.f, 0.f }, { 0.f, 0.f, 1.f }, { 1.f, 0.f, 0.f }
+			};
+
+			std::vector<Vec3f> normals( positions.size() );
+			compute_vertex_normals( positions.size(), nullptr, positions.size(), positions.data(), normals.data() );
+
+			for( std::size_t v = 0; v < 3; ++v )
+			{
+				REQUIRE_THAT( normals[v].z, WithinAbs( 1.f, 1e-6f ) );
+				REQUIRE_THAT( normals[v+3].y, WithinAbs( 1.f, 1e-6f ) );
+			}
+		}
+
+		SECTION( "Unused and degenerate" )
+		{
+			std::vector<Vec3f> const positions{ { 0.f, 0.f, 0.f }, { 1.f, 0.f, 0.f }, { 2.f, 0.f, 0.f }, { 5.f, 5.f, 5.f } };
+			std::vector<std::uint32_t> const indices{ 0, 1, 2 };
+
+			std::vector<Vec3f> normals( positions.size(), Vec3f{ 1.f, 1.f, 1.f } );
+			compute_vertex_normals( indices.size(), indices.data(), positions.size(), positions.data(), normals.data() );
+
+			for( auto const& n : normals )
+				REQUIRE( 0.f == dot( n, n ) );
+		}
+
+		SECTION( "Height field" )
+		{
+			// Large enough to be split across threads
+			auto const grid = make_grid_( 200, 3.f );
+			auto const expected = reference_normals_( grid );
+
+			std::vector<Vec3f> normals( grid.positions.size() );
+			compute_vertex_normals( grid.indices.size(), grid.indices.data(), grid.positions.size(), grid.positions.data(), normals.data() );
+
+			for( std::size_t v = 0; v < normals.size(); ++v )
+				REQUIRE( length( normals[v] - expected[v] ) < 1e-5f );
+		}
+
+		SECTION( "Sums" )
+		{
+			// As the normals, without normalizing
+			auto const grid = make_grid_( 200, 3.f );
+
+			std::vector<Vec3f> normals( grid.positions.size() ), sums( grid.positions.size() );
+			compute_vertex_normals( grid.indices.size(), grid.indices.data(), grid.positions.size(), grid.positions.data(), normals.data() );
+			compute_vertex_normal_sums( grid.indices.size(), grid.indices.data(), grid.positions.size(), grid.positions.data(), sums.data() );
+
+			for( std::size_t v = 0; v < sums.size(); ++v )
+			{
+				REQUIRE( length( sums[v] ) > 1.f );
+				REQUIRE( length( normalize( sums[v] ) - normals[v] ) < 1e-6f );
+			}
+		}
+	} );
+}
+
+TEST_CASE( "Vertex tangents", "[normals]" )
+{
+	using namespace Catch::Matchers;
+
+	test::for_each_isa( [&] {
+		// Flat grid: u grows along +x (or -x, if mirrored), v along +z. The
+		// tangent follows u, and w * cross( n, t ) follows v.
+		for( float const u : { 1.f, -1.f } )
+		{
+			DYNAMIC_SECTION( "Grid, u = " << u << "x" )
+			{
+				auto const grid = make_grid_( 150, 0.f, u );
+
+				std::vector<Vec3f> normals( grid.positions.size() );
+				compute_vertex_normals( grid.indices.size(), grid.indices.data(), grid.positions.size(), grid.positions.data(), normals.data() );
+
+				std::vector<Vec4f> tangents( grid.positions.size() );
+				compute_vertex_tangents( grid.indices.size(), grid.indices.data(), grid.positions.size(), grid.positions.data(), normals.data(), grid.textcoords.data(), tangents.data() );
+
+				for( std::size_t v = 0; v < tangents.size(); ++v )
+				{
+					Vec3f const t{ tangents[v].x, tangents[v].y, tangents[v].z };
+					REQUIRE_THAT( t.x, WithinAbs( u, 1e-6f ) );
+					REQUIRE_THAT( t.y, WithinAbs( 0.f, 1e-6f ) );
+					REQUIRE_THAT( t.z, WithinAbs( 0.f, 1e-6f ) );
+
+					Vec3f const bitangent = tangents[v].w * cross( normals[v], t );
+					REQUIRE_THAT( bitangent.z, WithinAbs( 1.f, 1e-6f ) );
+				}
+			}
+		}
+
+		SECTION( "Height field" )
+		{
+			// Orthonormal to the normals, and roughly along +x
+			auto const grid = make_grid_( 100, 2.f );
+
+			std::vector<Vec3f> normals( grid.positions.size() );
+			compute_vertex_normals( grid.indices.size(), grid.indices.data(), grid.positions.size(), grid.positions.data(), normals.data() );
+
+			std::vector<Vec4f> tangents( grid.positions.size() );
+			compute_vertex_tangents( grid.indices.size(), grid.indices.data(), grid.positions.size(), grid.positions.data(), normals.data(), grid.textcoords.data(), tangents.data() );
+
+			for( std::size_t v = 0; v < tangents.size(); ++v )
+			{
+				Vec3f const t{ tangents[v].x, tangents[v].y, tangents[v].z };
+				REQUIRE_THAT( length( t ), WithinAbs( 1.f, 1e-5f ) );
+				REQUIRE_THAT( dot( t, normals[v] ), WithinAbs( 0.f, 1e-5f ) );
+				REQUIRE( t.x > 0.5f );
+				REQUIRE( -1.f == tangents[v].w );
+			}
+		}
+
+		SECTION( "No texture coordinates" )
+		{
+			// All zero (e.g., an OBJ without vt): any unit vector perpendicular
+			// to the normal.
+			auto grid = make_grid_( 10, 1.f );
+			std::fill( grid.textcoords.begin(), grid.textcoords.end(), Vec2f{ 0.f, 0.f } );
+
+			std::vector<Vec3f> normals( grid.positions.size() );
+			compute_vertex_normals( grid.indices.size(), grid.indices.data(), grid.positions.size(), grid.positions.data(), normals.data() );
+
+			std::vector<Vec4f> tangents( grid.positions.size() );
+			compute_vertex_tangents( grid.indices.size(), grid.indices.data(), grid.positions.size(), grid.positions.data(), normals.data(), grid.textcoords.data(), tangents.data() );
+
+			for( std::size_t v = 0; v < tangents.size(); ++v )
+			{
+				Vec3f const t{ tangents[v].x, tangents[v].y, tangents[v].z };
+				REQUIRE_THAT( length( t ), WithinAbs( 1.f, 1e-5f ) );
+				REQUIRE_THAT( dot( t, normals[v] ), WithinAbs( 0.f, 1e-5f ) );
+			}
+		}
+	} );
+}
+
+TEST_CASE( "Mirrored UV seams", "[normals]" )
+{
+	using namespace Catch::Matchers;
+
+	test::for_each_isa( [&] {
+		// u = |x - 50|: the left half of the grid is mirrored, and the column
+		// x = 50 is shared by both halves.
+		auto grid = make_grid_( 100 );
+		for( std::size_t v = 0; v < grid.positions.size(); ++v )
+			grid.textcoords[v].x = std::abs( grid.positions[v].x - 50.f );
+
+		std::vector<std::uint32_t> sources;
+		std::size_t const copies = split_mirrored_vertices( grid.indices.size(), grid.indices.data(), grid.positions.size(), grid.textcoords.data(), sources );
+
+		REQUIRE( 101 == copies );
+		REQUIRE( 101 == sources.size() );
+		for( auto const source : sources )
+			REQUIRE( 50.f == grid.positions[source].x );
+
+		append_vertex_copies( grid.positions, sources );
+		append_vertex_copies( grid.textcoords, sources );
+
+		std::vector<Vec3f> normals( grid.positions.size() );
+		compute_vertex_normals( grid.indices.size(), grid.indices.data(), grid.positions.size(), grid.positions.data(), normals.data() );
+
+		std::vector<Vec4f> tangents( grid.positions.size() );
+		compute_vertex_tangents( grid.indices.size(), grid.indices.data(), grid.positions.size(), grid.positions.data(), normals.data(), grid.textcoords.data(), tangents.data() );
+
+		// Each side has its own tangent along the seam, and v still follows +z
+		// everywhere.
+		for( std::size_t v = 0; v < tangents.size(); ++v )
+		{
+			Vec3f const t{ tangents[v].x, tangents[v].y, tangents[v].z };
+			REQUIRE_THAT( std::abs( t.x ), WithinAbs( 1.f, 1e-6f ) );
+
+			Vec3f const bitangent = tangents[v].w * cross( normals[v], t );
+			REQUIRE_THAT( bitangent.z, WithinAbs( 1.f, 1e-6f ) );
+		}
+
+		SECTION( "No seams" )
+		{
+			auto plain = make_grid_( 20 );
+			auto const indices = plain.indices;
+
+			sources.clear();
+			REQUIRE( 0 == split_mirrored_vertices( plain.indices.size(), plain.indices.data(), plain.positions.size(), plain.textcoords.data(), sources ) );
+			REQUIRE( sources.empty() );
+			REQUIRE( indices == plain.indices );
+		}
+	} );
+}
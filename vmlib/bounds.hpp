@@ -0,0 +1,196 @@
+#ifndef BOUNDS_HPP_E2D4D537_2167_4A3D_9260_4505D7BB108E
+#define BOUNDS_HPP_E2D4D537_2167_4A3D_9260_4505D7BB108E
+
+#include <limits>
+#include <vector>
+#include <algorithm>
+
+#include <cmath>
+#include <cstddef>
+
+#include "vec3.hpp"
+#include "mat44.hpp"
+
+/** Bounding volumes: axis-aligned boxes, spheres and planes
+ *
+ * These are plain aggregates, like Vec3f. See frustum.hpp for testing them
+ * against a view frustum.
+ *
+ * Example:
+ *    Aabb3f const local = make_aabb( mesh.positions );
+ *    Aabb3f const world = transform_aabb( model2world, local );
+ */
+
+/** Aabb3f: axis-aligned bounding box
+ *
+ * An empty box has min > max (see kEmptyAabb3f); merging anything into it
+ * yields that thing's bounds.
+ */
+struct Aabb3f
+{
+	Vec3f min;
+	Vec3f max;
+};
+
+constexpr Aabb3f kEmptyAabb3f = {
+	{ std::numeric_limits<float>::infinity(), std::numeric_limits<float>::infinity(), std::numeric_limits<float>::infinity() },
+	{ -std::numeric_limits<float>::infinity(), -std::numeric_limits<float>::infinity(), -std::numeric_limits<float>::infinity() }
+};
+
+constexpr
+bool is_empty( Aabb3f const& aBox ) noexcept
+{
+	return aBox.min.x > aBox.max.x || aBox.min.y > aBox.max.y || aBox.min.z > aBox.max.z;
+}
+
+constexpr
+Vec3f center( Aabb3f const& aBox ) noexcept
+{
+	return 0.5f * (aBox.min + aBox.max);
+}
+constexpr
+Vec3f half_extent( Aabb3f const& aBox ) noexcept
+{
+	return 0.5f * (aBox.max - aBox.min);
+}
+
+constexpr
+Aabb3f merge( Aabb3f const& aBox, Vec3f aPoint ) noexcept
+{
+	return Aabb3f{
+		{ std::min( aBox.min.x, aPoint.x ), std::min( aBox.min.y, aPoint.y ), std::min( aBox.min.z, aPoint.z ) },
+		{ std::max( aBox.max.x, aPoint.x ), std::max( aBox.max.y, aPoint.y ), std::max( aBox.max.z, aPoint.z ) }
+	};
+}
+constexpr
+Aabb3f merge( Aabb3f const& aBox, Aabb3f const& aOther ) noexcept
+{
+	return merge( merge( aBox, aOther.min ), aOther.max );
+}
+
+inline
+Aabb3f make_aabb( std::size_t aCount, Vec3f const* aPoints ) noexcept
+{
+	Aabb3f ret = kEmptyAabb3f;
+	for( std::size_t i = 0; i < aCount; ++i )
+		ret = merge( ret, aPoints[i] );
+	return ret;
+}
+inline
+Aabb3f make_aabb( std::vector<Vec3f> const& aPoints ) noexcept
+{
+	return make_aabb( aPoints.size(), aPoints.data() );
+}
+
+// Bounds of the box aBox after transforming it with the affine matrix aM.
+// The result contains the transformed box, but is generally larger than it
+// (the transformed box is not axis-aligned). Transforms the center and the
+// half extent separately, instead of all eight corners (J. Arvo, Graphics
+// Gems, 1990).
+inline
+Aabb3f transform_aabb( Mat44f const& aM, Aabb3f const& aBox ) noexcept
+{
+	assert( is_affine( aM ) );
+
+	if( is_empty( aBox ) )
+		return aBox;
+
+	Vec3f const c = center( aBox );
+	Vec3f const e = half_extent( aBox );
+
+	Vec3f nc, ne;
+	for( std::size_t i = 0; i < 3; ++i )
+	{
+		nc[i] = aM(i,0)*c.x + aM(i,1)*c.y + aM(i,2)*c.z + aM(i,3);
+		ne[i] = std::abs(aM(i,0))*e.x + std::abs(aM(i,1))*e.y + std::abs(aM(i,2))*e.z;
+	}
+
+	return Aabb3f{ nc - ne, nc + ne };
+}
+
+// Distance from aPoint to the closest point of aBox; zero if aPoint is
+// inside the box.
+inline
+float distance( Aabb3f const& aBox, Vec3f aPoint ) noexcept
+{
+	Vec3f const d{
+		std::max( std::max( aBox.min.x - aPoint.x, aPoint.x - aBox.max.x ), 0.f ),
+		std::max( std::max( aBox.min.y - aPoint.y, aPoint.y - aBox.max.y ), 0.f ),
+		std::max( std::max( aBox.min.z - aPoint.z, aPoint.z - aBox.max.z ), 0.f )
+	};
+	return length( d );
+}
+
+
+/** Spheref: bounding sphere
+ */
+struct Spheref
+{
+	Vec3f center;
+	float radius;
+};
+
+// Sphere through the corners of aBox.
+inline
+Spheref make_bounding_sphere( Aabb3f const& aBox ) noexcept
+{
+	return Spheref{ center( aBox ), length( half_extent( aBox ) ) };
+}
+
+// Sphere around the center of the points' bounding box that contains all
+// points. Usually tighter than the sphere through the box corners.
+inline
+Spheref make_bounding_sphere( std::size_t aCount, Vec3f const* aPoints ) noexcept
+{
+	Vec3f const c = center( make_aabb( aCount, aPoints ) );
+
+	float r2 = 0.f;
+	for( std::size_t i = 0; i < aCount; ++i )
+	{
+		Vec3f const d = aPoints[i] - c;
+		r2 = std::max( r2, dot( d, d ) );
+	}
+
+	return Spheref{ c, std::sqrt( r2 ) };
+}
+inline
+Spheref make_bounding_sphere( std::vector<Vec3f> const& aPoints ) noexcept
+{
+	return make_bounding_sphere( aPoints.size(), aPoints.data() );
+}
+
+
+/** Planef: plane dot(n, p) + d = 0
+ *
+ * Points with dot(n, p) + d > 0 are in front of the plane. n need not be of
+ * unit length, but signed_distance() only returns actual distances if it is.
+ */
+struct Planef
+{
+	Vec3f n;
+	float d;
+};
+
+// Plane through aPoint with normal aNormal.
+constexpr
+Planef make_plane( Vec3f aNormal, Vec3f aPoint ) noexcept
+{
+	return Planef{ aNormal, -dot( aNormal, aPoint ) };
+}
+
+// Not an overload of normalize(), since that would make calls like
+// normalize( { 0.f, 1.f, 0.f } ) ambiguous.
+inline
+Planef normalize_plane( Planef const& aPlane ) noexcept
+{
+	float const il = 1.f / length( aPlane.n );
+	return Planef{ aPlane.n * il, aPlane.d * il };
+}
+
+constexpr
+float signed_distance( Planef const& aPlane, Vec3f aPoint ) noexcept
+{
+	return dot( aPlane.n, aPoint ) + aPlane.d;
+}
+
+#endif // BOUNDS_HPP_E2D4D537_2167_4A3D_9260_4505D7BB108E
@@ -0,0 +1,551 @@
+#include "bvh.hpp"
+
+#include <algorithm>
+
+#include <cmath>
+#include <cassert>
+
+#include "vec4.hpp"
+#include "simd.hpp"
+
+namespace
+{
+	// SAH build
+	//
+	// Costs are relative to testing one packet. Traversing a node (one box
+	// test) is about as expensive as that.
+	constexpr std::size_t kBins_ = 16;
+	constexpr std::size_t kPacketSize_ = 4;
+	constexpr std::size_t kMaxLeafTriangles_ = 4 * kPacketSize_;
+	constexpr float kTraversalCost_ = 1.f;
+	constexpr float kPacketCost_ = 1.f;
+
+	constexpr std::size_t kMaxDepth_ = 64;
+
+	struct BuildTriangle_
+	{
+		Aabb3f bounds;
+		Vec3f centroid;
+	};
+
+	float half_area_( Aabb3f const& aBox ) noexcept
+	{
+		if( is_empty( aBox ) )
+			return 0.f;
+
+		Vec3f const e = aBox.max - aBox.min;
+		return e.x*e.y + e.y*e.z + e.z*e.x;
+	}
+
+	float packet_count_( std::size_t aTriangles ) noexcept
+	{
+		return float((aTriangles + kPacketSize_ - 1) / kPacketSize_);
+	}
+
+	class Builder_
+	{
+		public:
+			Builder_( std::size_t aIndexCount, std::uint32_t const* aIndices, Vec3f const* aPositions, Bvh& aBvh )
+				: mIndices( aIndices )
+				, mPositions( aPositions )
+				, mBvh( aBvh )
+			{
+				std::size_t const count = aIndexCount / 3;
+				mTriangles.resize( count );
+				mOrder.resize( count );
+
+				for( std::size_t i = 0; i < count; ++i )
+				{
+					Vec3f const a = aPositions[aIndices[3*i+0]];
+					Vec3f const b = aPositions[aIndices[3*i+1]];
+					Vec3f const c = aPositions[aIndices[3*i+2]];
+
+					mTriangles[i].bounds = merge( merge( Aabb3f{ a, a }, b ), c );
+					mTriangles[i].centroid = (a + b + c) / 3.f;
+					mOrder[i] = std::uint32_t(i);
+				}
+			}
+
+			void build()
+			{
+				mBvh.nodes.clear();
+				mBvh.packets.clear();
+				mBvh.nodes.reserve( 2 * mOrder.size() / kPacketSize_ + 1 );
+				mBvh.packets.reserve( mOrder.size() / kPacketSize_ + 1 );
+
+				mBvh.nodes.emplace_back();
+				build_( 0, 0, mOrder.size(), 0 );
+			}
+
+		private:
+			void build_( std::size_t aNode, std::size_t aBegin, std::size_t aEnd, std::size_t aDepth )
+			{
+				Aabb3f bounds = kEmptyAabb3f, centroids = kEmptyAabb3f;
+				for( std::size_t i = aBegin; i < aEnd; ++i )
+				{
+					bounds = merge( bounds, mTriangles[mOrder[i]].bounds );
+					centroids = merge( centroids, mTriangles[mOrder[i]].centroid );
+				}
+
+				mBvh.nodes[aNode].bounds = bounds;
+
+				std::size_t const count = aEnd - aBegin;
+				if( count <= kPacketSize_ || aDepth >= kMaxDepth_ )
+				{
+					make_leaf_( aNode, aBegin, aEnd );
+					return;
+				}
+
+				// Best binned split
+				std::size_t bestAxis = 3, bestBin = 0;
+				float bestCost = std::numeric_limits<float>::infinity();
+
+				for( std::size_t axis = 0; axis < 3; ++axis )
+				{
+					float const lo = centroids.min[axis];
+					float const extent = centroids.max[axis] - lo;
+					if( !(extent > 0.f) )
+						continue;
+
+					float const scale = kBins_ / extent;
+
+					Aabb3f binBounds[kBins_];
+					std::size_t binCounts[kBins_] = {};
+					std::fill( binBounds, binBounds + kBins_, kEmptyAabb3f );
+
+					for( std::size_t i = aBegin; i < aEnd; ++i )
+					{
+						auto const& tri = mTriangles[mOrder[i]];
+						std::size_t const bin = bin_( tri.centroid[axis], lo, scale );
+						binBounds[bin] = merge( binBounds[bin], tri.bounds );
+						++binCounts[bin];
+					}
+
+					// Sweep from the right, then from the left
+					float rightArea[kBins_];
+					std::size_t rightCount[kBins_];
+					Aabb3f right = kEmptyAabb3f;
+					std::size_t rc = 0;
+					for( std::size_t b = kBins_-1; b > 0; --b )
+					{
+						right = merge( right, binBounds[b] );
+						rc += binCounts[b];
+						rightArea[b] = half_area_( right );
+						rightCount[b] = rc;
+					}
+
+					Aabb3f left = kEmptyAabb3f;
+					std::size_t lc = 0;
+					for( std::size_t b = 1; b < kBins_; ++b )
+					{
+						left = merge( left, binBounds[b-1] );
+						lc += binCounts[b-1];
+						if( 0 == lc || 0 == rightCount[b] )
+							continue;
+
+						float const cost = half_area_( left ) * packet_count_( lc ) + rightArea[b] * packet_count_( rightCount[b] );
+						if( cost < bestCost )
+						{
+							bestCost = cost;
+							bestAxis = axis;
+							bestBin = b;
+						}
+					}
+				}
+
+				std::size_t mid;
+				if( 3 == bestAxis )
+				{
+					// All centroids coincide. Split by count if the leaf would
+					// be too large, keeping the packets of the left half full.
+					if( count <= kMaxLeafTriangles_ )
+					{
+						make_leaf_( aNode, aBegin, aEnd );
+						return;
+					}
+					mid = aBegin + kPacketSize_ * (std::size_t(packet_count_( count )) / 2);
+				}
+				else
+				{
+					float const area = half_area_( bounds );
+					float const splitCost = kTraversalCost_ + kPacketCost_ * (area > 0.f ? bestCost / area : 0.f);
+					float const leafCost = kPacketCost_ * packet_count_( count );
+					if( count <= kMaxLeafTriangles_ && leafCost <= splitCost )
+					{
+						make_leaf_( aNode, aBegin, aEnd );
+						return;
+					}
+
+					float const lo = centroids.min[bestAxis];
+					float const scale = kBins_ / (centroids.max[bestAxis] - lo);
+					auto const it = std::partition( mOrder.begin() + aBegin, mOrder.begin() + aEnd, [&] (std::uint32_t aTri) {
+						return bin_( mTriangles[aTri].centroid[bestAxis], lo, scale ) < bestBin;
+					} );
+					mid = std::size_t(it - mOrder.begin());
+					assert( mid > aBegin && mid < aEnd );
+				}
+
+				std::uint32_t const children = std::uint32_t(mBvh.nodes.size());
+				mBvh.nodes[aNode].first = children;
+				mBvh.nodes[aNode].packetCount = 0;
+				mBvh.nodes.emplace_back();
+				mBvh.nodes.emplace_back();
+
+				build_( children, aBegin, mid, aDepth+1 );
+				build_( children+1, mid, aEnd, aDepth+1 );
+			}
+
+			static std::size_t bin_( float aValue, float aLo, float aScale ) noexcept
+			{
+				return std::min( std::size_t(std::max( (aValue - aLo) * aScale, 0.f )), kBins_-1 );
+			}
+
+			void make_leaf_( std::size_t aNode, std::size_t aBegin, std::size_t aEnd )
+			{
+				mBvh.nodes[aNode].first = std::uint32_t(mBvh.packets.size());
+				mBvh.nodes[aNode].packetCount = std::uint32_t(packet_count_( aEnd - aBegin ));
+
+				for( std::size_t i = aBegin; i < aEnd; i += kPacketSize_ )
+				{
+					BvhPacket packet{};
+					for( std::size_t k = 0; k < kPacketSize_; ++k )
+					{
+						if( i+k >= aEnd )
+						{
+							packet.triangle[k] = BvhPacket::kNoTriangle;
+							continue;
+						}
+
+						std::uint32_t const tri = mOrder[i+k];
+						Vec3f const a = mPositions[mIndices[3*tri+0]];
+						Vec3f const e1 = mPositions[mIndices[3*tri+1]] - a;
+						Vec3f const e2 = mPositions[mIndices[3*tri+2]] - a;
+
+						for( std::size_t axis = 0; axis < 3; ++axis )
+						{
+							packet.v0[axis][k] = a[axis];
+							packet.e1[axis][k] = e1[axis];
+							packet.e2[axis][k] = e2[axis];
+						}
+						packet.triangle[k] = tri;
+					}
+					mBvh.packets.emplace_back( packet );
+				}
+			}
+
+			std::uint32_t const* mIndices;
+			Vec3f const* mPositions;
+			Bvh& mBvh;
+
+			std::vector<BuildTriangle_> mTriangles;
+			std::vector<std::uint32_t> mOrder;
+	};
+
+
+	// Traversal
+	//
+	// Closest child first, with a fixed size stack. The packet tests update
+	// aHit and its t, which also bounds the box tests.
+	struct Hit_
+	{
+		float t;
+		std::uint32_t triangle;
+		float u, v;
+	};
+
+	struct RayBoxTest_
+	{
+		Vec3f origin;
+		Vec3f invDirection;
+
+		// Entry distance, or infinity if the box is missed or further than
+		// aMaxT.
+		float operator()( Aabb3f const& aBox, float aMaxT ) const noexcept
+		{
+			float tmin = 0.f, tmax = aMaxT;
+			for( std::size_t axis = 0; axis < 3; ++axis )
+			{
+				float const t0 = (aBox.min[axis] - origin[axis]) * invDirection[axis];
+				float const t1 = (aBox.max[axis] - origin[axis]) * invDirection[axis];
+				tmin = std::max( tmin, std::min( t0, t1 ) );
+				tmax = std::min( tmax, std::max( t0, t1 ) );
+			}
+			return tmin <= tmax ? tmin : std::numeric_limits<float>::infinity();
+		}
+	};
+
+	template< typename tPacketTest >
+	std::optional<RayHit> traverse_( Bvh const& aBvh, Rayf const& aRay, float aMaxT, tPacketTest&& aTest ) noexcept
+	{
+		if( aBvh.nodes.empty() || aBvh.packets.empty() )
+			return {};
+
+		RayBoxTest_ const box{ aRay.origin, Vec3f{ 1.f / aRay.direction.x, 1.f / aRay.direction.y, 1.f / aRay.direction.z } };
+
+		Hit_ hit{ aMaxT, BvhPacket::kNoTriangle, 0.f, 0.f };
+
+		std::uint32_t stack[kMaxDepth_ + 1];
+		std::size_t top = 0;
+
+		if( box( aBvh.nodes[0].bounds, hit.t ) == std::numeric_limits<float>::infinity() )
+			return {};
+		stack[top++] = 0;
+
+		while( top > 0 )
+		{
+			BvhNode const& node = aBvh.nodes[stack[--top]];
+			if( node.packetCount > 0 )
+			{
+				for( std::uint32_t p = 0; p < node.packetCount; ++p )
+					aTest( aBvh.packets[node.first + p], aRay, hit );
+				continue;
+			}
+
+			std::uint32_t first = node.first, second = node.first + 1;
+			float tFirst = box( aBvh.nodes[first].bounds, hit.t );
+			float tSecond = box( aBvh.nodes[second].bounds, hit.t );
+			if( tSecond < tFirst )
+			{
+				std::swap( first, second );
+				std::swap( tFirst, tSecond );
+			}
+
+			// Pushed in reverse order, so that the nearer child is popped first
+			if( tSecond != std::numeric_limits<float>::infinity() )
+				stack[top++] = second;
+			if( tFirst != std::numeric_limits<float>::infinity() )
+				stack[top++] = first;
+		}
+
+		if( BvhPacket::kNoTriangle == hit.triangle )
+			return {};
+
+		return RayHit{ hit.t, hit.triangle, hit.u, hit.v };
+	}
+
+	// Packet tests. All of them evaluate the same expressions in the same
+	// order, without fused multiply-adds, so that they produce the same
+	// results.
+	void test_packet_scalar_( BvhPacket const& aPacket, Rayf const& aRay, Hit_& aHit ) noexcept
+	{
+		Vec3f const d = aRay.direction;
+		for( std::size_t k = 0; k < kPacketSize_; ++k )
+		{
+			Vec3f const v0{ aPacket.v0[0][k], aPacket.v0[1][k], aPacket.v0[2][k] };
+			Vec3f const e1{ aPacket.e1[0][k], aPacket.e1[1][k], aPacket.e1[2][k] };
+			Vec3f const e2{ aPacket.e2[0][k], aPacket.e2[1][k], aPacket.e2[2][k] };
+
+			Vec3f const p{ d.y*e2.z - d.z*e2.y, d.z*e2.x - d.x*e2.z, d.x*e2.y - d.y*e2.x };
+			float const det = (e1.x*p.x + e1.y*p.y) + e1.z*p.z;
+			if( 0.f == det )
+				continue;
+
+			float const inv = 1.f / det;
+			Vec3f const s = aRay.origin - v0;
+			float const u = ((s.x*p.x + s.y*p.y) + s.z*p.z) * inv;
+
+			Vec3f const q{ s.y*e1.z - s.z*e1.y, s.z*e1.x - s.x*e1.z, s.x*e1.y - s.y*e1.x };
+			float const v = ((d.x*q.x + d.y*q.y) + d.z*q.z) * inv;
+			float const t = ((e2.x*q.x + e2.y*q.y) + e2.z*q.z) * inv;
+
+			if( u >= 0.f && v >= 0.f && u + v <= 1.f && t > 0.f && t < aHit.t )
+				aHit = Hit_{ t, aPacket.triangle[k], u, v };
+		}
+	}
+
+	std::optional<RayHit> intersect_scalar_( Bvh const& aBvh, Rayf const& aRay, float aMaxT ) noexcept
+	{
+		return traverse_( aBvh, aRay, aMaxT, &test_packet_scalar_ );
+	}
+
+	struct BvhKernels_
+	{
+		std::optional<RayHit> (*intersect)( Bvh const&, Rayf const&, float ) noexcept;
+	};
+
+	constexpr BvhKernels_ kScalarKernels_{ &intersect_scalar_ };
+
+	// Takes the closest of the (up to four) hits in aMask.
+	inline void take_closest_( int aMask, float const (&aT)[4], float const (&aU)[4], float const (&aV)[4], BvhPacket const& aPacket, Hit_& aHit ) noexcept
+	{
+		for( std::size_t k = 0; k < kPacketSize_; ++k )
+		{
+			if( (aMask >> k) & 1 && aT[k] < aHit.t )
+				aHit = Hit_{ aT[k], aPacket.triangle[k], aU[k], aV[k] };
+		}
+	}
+
+#	if defined(VMLIB_SIMD_X86)
+	// SSE2 kernel
+	void test_packet_sse2_( BvhPacket const& aPacket, Rayf const& aRay, Hit_& aHit ) noexcept
+	{
+		__m128 const dx = _mm_set1_ps( aRay.direction.x );
+		__m128 const dy = _mm_set1_ps( aRay.direction.y );
+		__m128 const dz = _mm_set1_ps( aRay.direction.z );
+
+		__m128 const e1x = _mm_loadu_ps( aPacket.e1[0] ), e1y = _mm_loadu_ps( aPacket.e1[1] ), e1z = _mm_loadu_ps( aPacket.e1[2] );
+		__m128 const e2x = _mm_loadu_ps( aPacket.e2[0] ), e2y = _mm_loadu_ps( aPacket.e2[1] ), e2z = _mm_loadu_ps( aPacket.e2[2] );
+
+		__m128 const px = _mm_sub_ps( _mm_mul_ps( dy, e2z ), _mm_mul_ps( dz, e2y ) );
+		__m128 const py = _mm_sub_ps( _mm_mul_ps( dz, e2x ), _mm_mul_ps( dx, e2z ) );
+		__m128 const pz = _mm_sub_ps( _mm_mul_ps( dx, e2y ), _mm_mul_ps( dy, e2x ) );
+		__m128 const det = _mm_add_ps( _mm_add_ps( _mm_mul_ps( e1x, px ), _mm_mul_ps( e1y, py ) ), _mm_mul_ps( e1z, pz ) );
+
+		__m128 const zero = _mm_setzero_ps();
+		__m128 const valid = _mm_cmpneq_ps( det, zero );
+		if( 0 == _mm_movemask_ps( valid ) )
+			return;
+
+		__m128 const inv = _mm_div_ps( _mm_set1_ps( 1.f ), det );
+
+		__m128 const sx = _mm_sub_ps( _mm_set1_ps( aRay.origin.x ), _mm_loadu_ps( aPacket.v0[0] ) );
+		__m128 const sy = _mm_sub_ps( _mm_set1_ps( aRay.origin.y ), _mm_loadu_ps( aPacket.v0[1] ) );
+		__m128 const sz = _mm_sub_ps( _mm_set1_ps( aRay.origin.z ), _mm_loadu_ps( aPacket.v0[2] ) );
+		__m128 const u = _mm_mul_ps( _mm_add_ps( _mm_add_ps( _mm_mul_ps( sx, px ), _mm_mul_ps( sy, py ) ), _mm_mul_ps( sz, pz ) ), inv );
+
+		__m128 const qx = _mm_sub_ps( _mm_mul_ps( sy, e1z ), _mm_mul_ps( sz, e1y ) );
+		__m128 const qy = _mm_sub_ps( _mm_mul_ps( sz, e1x ), _mm_mul_ps( sx, e1z ) );
+		__m128 const qz = _mm_sub_ps( _mm_mul_ps( sx, e1y ), _mm_mul_ps( sy, e1x ) );
+		__m128 const v = _mm_mul_ps( _mm_add_ps( _mm_add_ps( _mm_mul_ps( dx, qx ), _mm_mul_ps( dy, qy ) ), _mm_mul_ps( dz, qz ) ), inv );
+		__m128 const t = _mm_mul_ps( _mm_add_ps( _mm_add_ps( _mm_mul_ps( e2x, qx ), _mm_mul_ps( e2y, qy ) ), _mm_mul_ps( e2z, qz ) ), inv );
+
+		__m128 hit = _mm_and_ps( valid, _mm_cmpge_ps( u, zero ) );
+		hit = _mm_and_ps( hit, _mm_cmpge_ps( v, zero ) );
+		hit = _mm_and_ps( hit, _mm_cmple_ps( _mm_add_ps( u, v ), _mm_set1_ps( 1.f ) ) );
+		hit = _mm_and_ps( hit, _mm_cmpgt_ps( t, zero ) );
+		hit = _mm_and_ps( hit, _mm_cmplt_ps( t, _mm_set1_ps( aHit.t ) ) );
+
+		int const mask = _mm_movemask_ps( hit );
+		if( 0 == mask )
+			return;
+
+		float ts[4], us[4], vs[4];
+		_mm_storeu_ps( ts, t );
+		_mm_storeu_ps( us, u );
+		_mm_storeu_ps( vs, v );
+		take_closest_( mask, ts, us, vs, aPacket, aHit );
+	}
+
+	std::optional<RayHit> intersect_sse2_( Bvh const& aBvh, Rayf const& aRay, float aMaxT ) noexcept
+	{
+		return traverse_( aBvh, aRay, aMaxT, &test_packet_sse2_ );
+	}
+
+	constexpr BvhKernels_ kSse2Kernels_{ &intersect_sse2_ };
+#	endif // ~ VMLIB_SIMD_X86
+
+#	if defined(VMLIB_SIMD_NEON)
+	void test_packet_neon_( BvhPacket const& aPacket, Rayf const& aRay, Hit_& aHit ) noexcept
+	{
+		float32x4_t const dx = vdupq_n_f32( aRay.direction.x );
+		float32x4_t const dy = vdupq_n_f32( aRay.direction.y );
+		float32x4_t const dz = vdupq_n_f32( aRay.direction.z );
+
+		float32x4_t const e1x = vld1q_f32( aPacket.e1[0] ), e1y = vld1q_f32( aPacket.e1[1] ), e1z = vld1q_f32( aPacket.e1[2] );
+		float32x4_t const e2x = vld1q_f32( aPacket.e2[0] ), e2y = vld1q_f32( aPacket.e2[1] ), e2z = vld1q_f32( aPacket.e2[2] );
+
+		float32x4_t const px = vsubq_f32( vmulq_f32( dy, e2z ), vmulq_f32( dz, e2y ) );
+		float32x4_t const py = vsubq_f32( vmulq_f32( dz, e2x ), vmulq_f32( dx, e2z ) );
+		float32x4_t const pz = vsubq_f32( vmulq_f32( dx, e2y ), vmulq_f32( dy, e2x ) );
+		float32x4_t const det = vaddq_f32( vaddq_f32( vmulq_f32( e1x, px ), vmulq_f32( e1y, py ) ), vmulq_f32( e1z, pz ) );
+
+		float32x4_t const zero = vdupq_n_f32( 0.f );
+		uint32x4_t const valid = vmvnq_u32( vceqq_f32( det, zero ) );
+		if( 0 == vmaxvq_u32( valid ) )
+			return;
+
+		float32x4_t const inv = vdivq_f32( vdupq_n_f32( 1.f ), det );
+
+		float32x4_t const sx = vsubq_f32( vdupq_n_f32( aRay.origin.x ), vld1q_f32( aPacket.v0[0] ) );
+		float32x4_t const sy = vsubq_f32( vdupq_n_f32( aRay.origin.y ), vld1q_f32( aPacket.v0[1] ) );
+		float32x4_t const sz = vsubq_f32( vdupq_n_f32( aRay.origin.z ), vld1q_f32( aPacket.v0[2] ) );
+		float32x4_t const u = vmulq_f32( vaddq_f32( vaddq_f32( vmulq_f32( sx, px ), vmulq_f32( sy, py ) ), vmulq_f32( sz, pz ) ), inv );
+
+		float32x4_t const qx = vsubq_f32( vmulq_f32( sy, e1z ), vmulq_f32( sz, e1y ) );
+		float32x4_t const qy = vsubq_f32( vmulq_f32( sz, e1x ), vmulq_f32( sx, e1z ) );
+		float32x4_t const qz = vsubq_f32( vmulq_f32( sx, e1y ), vmulq_f32( sy, e1x ) );
+		float32x4_t const v = vmulq_f32( vaddq_f32( vaddq_f32( vmulq_f32( dx, qx ), vmulq_f32( dy, qy ) ), vmulq_f32( dz, qz ) ), inv );
+		float32x4_t const t = vmulq_f32( vaddq_f32( vaddq_f32( vmulq_f32( e2x, qx ), vmulq_f32( e2y, qy ) ), vmulq_f32( e2z, qz ) ), inv );
+
+		uint32x4_t hit = vandq_u32( valid, vcgeq_f32( u, zero ) );
+		hit = vandq_u32( hit, vcgeq_f32( v, zero ) );
+		hit = vandq_u32( hit, vcleq_f32( vaddq_f32( u, v ), vdupq_n_f32( 1.f ) ) );
+		hit = vandq_u32( hit, vcgtq_f32( t, zero ) );
+		hit = vandq_u32( hit, vcltq_f32( t, vdupq_n_f32( aHit.t ) ) );
+
+		int const mask = int(vgetq_lane_u32( hit, 0 ) & 1)
+			| int(vgetq_lane_u32( hit, 1 ) & 2)
+			| int(vgetq_lane_u32( hit, 2 ) & 4)
+			| int(vgetq_lane_u32( hit, 3 ) & 8)
+		;
+		if( 0 == mask )
+			return;
+
+		float ts[4], us[4], vs[4];
+		vst1q_f32( ts, t );
+		vst1q_f32( us, u );
+		vst1q_f32( vs, v );
+		take_closest_( mask, ts, us, vs, aPacket, aHit );
+	}
+
+	std::optional<RayHit> intersect_neon_( Bvh const& aBvh, Rayf const& aRay, float aMaxT ) noexcept
+	{
+		return traverse_( aBvh, aRay, aMaxT, &test_packet_neon_ );
+	}
+
+	constexpr BvhKernels_ kNeonKernels_{ &intersect_neon_ };
+#	endif // ~ VMLIB_SIMD_NEON
+
+	BvhKernels_ const& kernels_() noexcept
+	{
+		switch( simd_active_isa() )
+		{
+#			if defined(VMLIB_SIMD_X86)
+			case SimdIsa::sse2:
+			case SimdIsa::avx2: return kSse2Kernels_;
+#			endif
+#			if defined(VMLIB_SIMD_NEON)
+			case SimdIsa::neon: return kNeonKernels_;
+#			endif
+			default: return kScalarKernels_;
+		}
+	}
+}
+
+Bvh build_bvh( std::size_t aIndexCount, std::uint32_t const* aIndices, Vec3f const* aPositions )
+{
+	assert( aIndexCount % 3 == 0 );
+
+	Bvh ret;
+	if( aIndexCount < 3 )
+		return ret;
+
+	Builder_ builder( aIndexCount, aIndices, aPositions, ret );
+	builder.build();
+	return ret;
+}
+
+std::optional<RayHit> intersect( Bvh const& aBvh, Rayf const& aRay, float aMaxT )
+{
+	return kernels_().intersect( aBvh, aRay, aMaxT );
+}
+
+std::optional<float> intersect( Aabb3f const& aBox, Rayf const& aRay, float aMaxT ) noexcept
+{
+	RayBoxTest_ const box{ aRay.origin, Vec3f{ 1.f / aRay.direction.x, 1.f / aRay.direction.y, 1.f / aRay.direction.z } };
+
+	float const t = box( aBox, aMaxT );
+	if( t == std::numeric_limits<float>::infinity() || t >= aMaxT )
+		return {};
+	return t;
+}
+
+Rayf make_pick_ray( Mat44f const& aInverseClip, float aNdcX, float aNdcY ) noexcept
+{
+	Vec4f const n = aInverseClip * Vec4f{ aNdcX, aNdcY, -1.f, 1.f };
+	Vec4f const f = aInverseClip * Vec4f{ aNdcX, aNdcY, 1.f, 1.f };
+
+	Vec3f const start{ n.x / n.w, n.y / n.w, n.z / n.w };
+	Vec3f const end{ f.x / f.w, f.y / f.w, f.z / f.w };
+	return Rayf{ start, end - start };
+}
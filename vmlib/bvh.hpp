@@ -0,0 +1,99 @@
+#ifndef BVH_HPP_ACAB2EB3_77A3_4907_9C34_67E3013A3A22
+#define BVH_HPP_ACAB2EB3_77A3_4907_9C34_67E3013A3A22
+
+#include <limits>
+#include <vector>
+#include <optional>
+
+#include <cstddef>
+#include <cstdint>
+
+#include "vec3.hpp"
+#include "mat44.hpp"
+#include "bounds.hpp"
+
+/** Bounding volume hierarchy for ray queries against triangle meshes
+ *
+ * build_bvh() builds a binary BVH over an indexed triangle list. Each node
+ * is split where the surface area heuristic (SAH) estimates the lowest cost
+ * for a ray to traverse it, evaluated over a fixed number of bins of the
+ * triangle centroids per axis ("binned SAH", I. Wald, "On fast Construction
+ * of SAH-based Bounding Volume Hierarchies", 2007). Nodes stop being split
+ * once that does not pay off, or at four triangles.
+ *
+ * The triangles of each leaf are stored in packets of four, as one vertex and
+ * two edges per triangle in SoA layout, so that intersect() can test a ray
+ * against all four at once (Moeller-Trumbore). The packet test is dispatched
+ * like the kernels of frustum.hpp (see simd.hpp); AVX2 uses the SSE2 kernel,
+ * since the packets are four wide. All instruction sets return the same hits.
+ *
+ * Triangles are hit from either side. A BVH refers to the triangles by their
+ * position in the input (index / 3), and does not keep the positions or
+ * indices around.
+ *
+ * Example (picking, with clip = projection * world2camera * model2world):
+ *    Rayf const ray = make_pick_ray( invert( clip ), ndcX, ndcY );
+ *    if( auto const hit = intersect( bvh, ray ) )
+ *        ... triangle hit->triangle at ray.origin + hit->t * ray.direction ...
+ */
+struct Rayf
+{
+	Vec3f origin;
+	Vec3f direction; // need not be of unit length
+};
+
+struct RayHit
+{
+	float t; // origin + t * direction
+	std::uint32_t triangle;
+
+	// Barycentric coordinates of the hit point relative to the triangle's
+	// second and third corner.
+	float u, v;
+};
+
+struct BvhNode
+{
+	Aabb3f bounds;
+
+	// Inner nodes (packetCount == 0): first is the index of the left child;
+	// the right child follows it. Leaves: first is the index of the leaf's
+	// first packet.
+	std::uint32_t first;
+	std::uint32_t packetCount;
+};
+
+struct BvhPacket
+{
+	static constexpr std::uint32_t kNoTriangle = ~std::uint32_t(0);
+
+	// [axis][triangle]. Unused slots have zero edges and kNoTriangle.
+	float v0[3][4];
+	float e1[3][4];
+	float e2[3][4];
+	std::uint32_t triangle[4];
+};
+
+struct Bvh
+{
+	std::vector<BvhNode> nodes; // nodes[0] is the root
+	std::vector<BvhPacket> packets;
+};
+
+Bvh build_bvh( std::size_t aIndexCount, std::uint32_t const* aIndices, Vec3f const* aPositions );
+
+// Closest hit with 0 < t < aMaxT, if any.
+std::optional<RayHit> intersect( Bvh const& aBvh, Rayf const& aRay, float aMaxT = std::numeric_limits<float>::infinity() );
+
+// Distance (t) at which aRay enters aBox, if it does so with t < aMaxT; 0 if
+// it starts inside. E.g., to visit the BVHs of several objects nearest first.
+std::optional<float> intersect( Aabb3f const& aBox, Rayf const& aRay, float aMaxT = std::numeric_limits<float>::infinity() ) noexcept;
+
+// Ray through the point (aNdcX, aNdcY) in normalized device coordinates,
+// where aInverseClip is the inverse of the matrix that transforms into clip
+// space. The ray is in that matrix' source space (e.g. model space for
+// projection * world2camera * model2world), starts on the near plane and
+// reaches the far plane at t = 1.
+Rayf make_pick_ray( Mat44f const& aInverseClip, float aNdcX, float aNdcY ) noexcept;
+
+#endif // BVH_HPP_ACAB2EB3_77A3_4907_9C34_67E3013A3A22
@@ -0,0 +1,579 @@
+#include "fast_math.hpp"
+
+#include "simd.hpp"
+#include "parallel.hpp"
+
+using namespace detail_fast_math;
+
+namespace
+{
+	// About 1 ns per element, 3 ns for fast_normalize_n() (see
+	// parallel_for())
+	constexpr std::size_t kMinPerThread_ = 64*1024;
+
+	struct MathKernels_
+	{
+		void (*sin)( std::size_t, float const*, float*, float* ) noexcept;
+		void (*cos)( std::size_t, float const*, float*, float* ) noexcept;
+		void (*sincos)( std::size_t, float const*, float*, float* ) noexcept;
+		void (*atan2)( std::size_t, float const*, float const*, float* ) noexcept;
+		void (*rsqrt)( std::size_t, float const*, float* ) noexcept;
+		void (*normalize)( std::size_t, Vec3f const*, Vec3f* ) noexcept;
+	};
+
+	// Scalar kernels
+	template< bool tSin, bool tCos >
+	void sincos_scalar_( std::size_t aCount, float const* aX, float* aSin, float* aCos ) noexcept
+	{
+		for( std::size_t i = 0; i < aCount; ++i )
+		{
+			float s, c;
+			fast_sincos( aX[i], s, c );
+			if constexpr( tSin ) aSin[i] = s;
+			if constexpr( tCos ) aCos[i] = c;
+		}
+	}
+
+	void atan2_scalar_( std::size_t aCount, float const* aY, float const* aX, float* aOut ) noexcept
+	{
+		for( std::size_t i = 0; i < aCount; ++i )
+			aOut[i] = fast_atan2( aY[i], aX[i] );
+	}
+
+	void rsqrt_scalar_( std::size_t aCount, float const* aX, float* aOut ) noexcept
+	{
+		for( std::size_t i = 0; i < aCount; ++i )
+			aOut[i] = 1.f / std::sqrt( aX[i] );
+	}
+
+	void normalize_scalar_( std::size_t aCount, Vec3f const* aIn, Vec3f* aOut ) noexcept
+	{
+		for( std::size_t i = 0; i < aCount; ++i )
+			aOut[i] = normalize( aIn[i] );
+	}
+
+	constexpr MathKernels_ kScalarKernels_{
+		&sincos_scalar_<true,false>,
+		&sincos_scalar_<false,true>,
+		&sincos_scalar_<true,true>,
+		&atan2_scalar_,
+		&rsqrt_scalar_,
+		&normalize_scalar_
+	};
+
+#	if defined(VMLIB_SIMD_X86)
+	// SSE2 kernels, four values at a time. These mirror the scalar versions
+	// in fast_math.hpp, with selects instead of branches.
+	inline __m128 select_sse2_( __m128 aMask, __m128 aA, __m128 aB ) noexcept
+	{
+		return _mm_or_ps( _mm_and_ps( aMask, aA ), _mm_andnot_ps( aMask, aB ) );
+	}
+
+	inline void sincos_sse2_( __m128 aX, __m128& aSin, __m128& aCos ) noexcept
+	{
+		// cvtps rounds to nearest (unless MXCSR was changed).
+		__m128i const j = _mm_cvtps_epi32( _mm_mul_ps( aX, _mm_set1_ps( kTwoOverPi ) ) );
+		__m128 const jf = _mm_cvtepi32_ps( j );
+
+		__m128 r = _mm_sub_ps( aX, _mm_mul_ps( jf, _mm_set1_ps( kPio2A ) ) );
+		r = _mm_sub_ps( r, _mm_mul_ps( jf, _mm_set1_ps( kPio2B ) ) );
+		r = _mm_sub_ps( r, _mm_mul_ps( jf, _mm_set1_ps( kPio2C ) ) );
+		__m128 const z = _mm_mul_ps( r, r );
+
+		__m128 ps = _mm_add_ps( _mm_set1_ps( kSin2 ), _mm_mul_ps( z, _mm_set1_ps( kSin3 ) ) );
+		ps = _mm_add_ps( _mm_set1_ps( kSin1 ), _mm_mul_ps( z, ps ) );
+		ps = _mm_add_ps( r, _mm_mul_ps( _mm_mul_ps( r, z ), ps ) );
+
+		__m128 pc = _mm_add_ps( _mm_set1_ps( kCos2 ), _mm_mul_ps( z, _mm_set1_ps( kCos3 ) ) );
+		pc = _mm_add_ps( _mm_set1_ps( kCos1 ), _mm_mul_ps( z, pc ) );
+		pc = _mm_add_ps( _mm_sub_ps( _mm_set1_ps( 1.f ), _mm_mul_ps( _mm_set1_ps( 0.5f ), z ) ), _mm_mul_ps( _mm_mul_ps( z, z ), pc ) );
+
+		// Odd quadrants swap sin and cos; bit 1 of j (of j+1 for cos) is
+		// the sign.
+		__m128i const one = _mm_set1_epi32( 1 ), two = _mm_set1_epi32( 2 );
+		__m128 const swap = _mm_castsi128_ps( _mm_cmpeq_epi32( _mm_and_si128( j, one ), one ) );
+		__m128 const sinSign = _mm_castsi128_ps( _mm_slli_epi32( _mm_and_si128( j, two ), 30 ) );
+		__m128 const cosSign = _mm_castsi128_ps( _mm_slli_epi32( _mm_and_si128( _mm_add_epi32( j, one ), two ), 30 ) );
+
+		aSin = _mm_xor_ps( select_sse2_( swap, pc, ps ), sinSign );
+		aCos = _mm_xor_ps( select_sse2_( swap, ps, pc ), cosSign );
+	}
+
+	template< bool tSin, bool tCos >
+	void sincos_sse2_( std::size_t aCount, float const* aX, float* aSin, float* aCos ) noexcept
+	{
+		std::size_t i = 0;
+		for( ; i+4 <= aCount; i += 4 )
+		{
+			__m128 s, c;
+			sincos_sse2_( _mm_loadu_ps( aX+i ), s, c );
+			if constexpr( tSin ) _mm_storeu_ps( aSin+i, s );
+			if constexpr( tCos ) _mm_storeu_ps( aCos+i, c );
+		}
+
+		sincos_scalar_<tSin,tCos>( aCount-i, aX+i, tSin ? aSin+i : nullptr, tCos ? aCos+i : nullptr );
+	}
+
+	void atan2_sse2_( std::size_t aCount, float const* aY, float const* aX, float* aOut ) noexcept
+	{
+		__m128 const signMask = _mm_set1_ps( -0.f );
+
+		std::size_t i = 0;
+		for( ; i+4 <= aCount; i += 4 )
+		{
+			__m128 const x = _mm_loadu_ps( aX+i );
+			__m128 const y = _mm_loadu_ps( aY+i );
+			__m128 const ax = _mm_andnot_ps( signMask, x );
+			__m128 const ay = _mm_andnot_ps( signMask, y );
+			__m128 const mn = _mm_min_ps( ax, ay );
+			__m128 const mx = _mm_max_ps( ax, ay );
+
+			__m128 const upper = _mm_cmpgt_ps( mn, _mm_mul_ps( _mm_set1_ps( kTanPi8 ), mx ) );
+			__m128 const num = select_sse2_( upper, _mm_sub_ps( mn, mx ), mn );
+			__m128 const den = select_sse2_( upper, _mm_add_ps( mn, mx ), mx );
+			__m128 const t = _mm_div_ps( num, _mm_max_ps( den, _mm_set1_ps( 1e-30f ) ) );
+			__m128 const z = _mm_mul_ps( t, t );
+
+			__m128 p = _mm_add_ps( _mm_set1_ps( kAtan3 ), _mm_mul_ps( z, _mm_set1_ps( kAtan4 ) ) );
+			p = _mm_add_ps( _mm_set1_ps( kAtan2 ), _mm_mul_ps( z, p ) );
+			p = _mm_add_ps( _mm_set1_ps( kAtan1 ), _mm_mul_ps( z, p ) );
+			p = _mm_add_ps( t, _mm_mul_ps( _mm_mul_ps( t, z ), p ) );
+
+			__m128 r = _mm_add_ps( _mm_and_ps( upper, _mm_set1_ps( kPi4 ) ), p );
+			r = select_sse2_( _mm_cmpgt_ps( ay, ax ), _mm_sub_ps( _mm_set1_ps( kPi2 ), r ), r );
+
+			__m128 const xNeg = _mm_castsi128_ps( _mm_srai_epi32( _mm_castps_si128( x ), 31 ) );
+			r = select_sse2_( xNeg, _mm_sub_ps( _mm_set1_ps( kPi ), r ), r );
+
+			_mm_storeu_ps( aOut+i, _mm_or_ps( r, _mm_and_ps( signMask, y ) ) );
+		}
+
+		atan2_scalar_( aCount-i, aY+i, aX+i, aOut+i );
+	}
+
+	// rsqrtps is accurate to about 12 bits; one Newton-Raphson step,
+	//    y' = y * (1.5 - 0.5*x*y*y),
+	// brings this close to full precision.
+	inline __m128 rsqrt_sse2_( __m128 aX ) noexcept
+	{
+		__m128 const y = _mm_rsqrt_ps( aX );
+		__m128 const xyy = _mm_mul_ps( _mm_mul_ps( aX, y ), y );
+		return _mm_mul_ps( _mm_mul_ps( _mm_set1_ps( 0.5f ), y ), _mm_sub_ps( _mm_set1_ps( 3.f ), xyy ) );
+	}
+
+	void rsqrt_sse2_( std::size_t aCount, float const* aX, float* aOut ) noexcept
+	{
+		std::size_t i = 0;
+		for( ; i+4 <= aCount; i += 4 )
+			_mm_storeu_ps( aOut+i, rsqrt_sse2_( _mm_loadu_ps( aX+i ) ) );
+
+		rsqrt_scalar_( aCount-i, aX+i, aOut+i );
+	}
+
+	// Same (de)interleaving of four Vec3f as in transform_batch.cpp.
+	template< int tX, int tY, int tZ, int tW >
+	inline __m128 shuffle_( __m128 aA, __m128 aB ) noexcept
+	{
+		return _mm_shuffle_ps( aA, aB, _MM_SHUFFLE( tW, tZ, tY, tX ) );
+	}
+
+	void normalize_sse2_( std::size_t aCount, Vec3f const* aIn, Vec3f* aOut ) noexcept
+	{
+		std::size_t i = 0;
+		for( ; i+4 <= aCount; i += 4 )
+		{
+			float const* src = &aIn[i].x;
+			__m128 const a = _mm_loadu_ps( src+0 );
+			__m128 const b = _mm_loadu_ps( src+4 );
+			__m128 const c = _mm_loadu_ps( src+8 );
+
+			__m128 x = shuffle_<0,1,0,2>( shuffle_<0,3,2,3>( a, b ), shuffle_<2,2,1,1>( b, c ) );
+			__m128 y = shuffle_<0,2,0,2>( shuffle_<1,1,0,0>( a, b ), shuffle_<3,3,2,2>( b, c ) );
+			__m128 z = shuffle_<0,2,0,2>( shuffle_<2,2,1,1>( a, b ), shuffle_<0,0,3,3>( c, c ) );
+
+			__m128 const l2 = _mm_add_ps( _mm_add_ps( _mm_mul_ps( x, x ), _mm_mul_ps( y, y ) ), _mm_mul_ps( z, z ) );
+			__m128 const il = rsqrt_sse2_( l2 );
+			x = _mm_mul_ps( x, il );
+			y = _mm_mul_ps( y, il );
+			z = _mm_mul_ps( z, il );
+
+			float* dst = &aOut[i].x;
+			_mm_storeu_ps( dst+0, shuffle_<0,2,0,2>( shuffle_<0,0,0,0>( x, y ), shuffle_<0,0,1,1>( z, x ) ) );
+			_mm_storeu_ps( dst+4, shuffle_<0,2,0,2>( shuffle_<1,1,1,1>( y, z ), shuffle_<2,2,2,2>( x, y ) ) );
+			_mm_storeu_ps( dst+8, shuffle_<0,2,0,2>( shuffle_<2,2,3,3>( z, x ), shuffle_<3,3,3,3>( y, z ) ) );
+		}
+
+		normalize_scalar_( aCount-i, aIn+i, aOut+i );
+	}
+
+	constexpr MathKernels_ kSse2Kernels_{
+		&sincos_sse2_<true,false>,
+		&sincos_sse2_<false,true>,
+		&sincos_sse2_<true,true>,
+		&atan2_sse2_,
+		&rsqrt_sse2_,
+		&normalize_sse2_
+	};
+
+	// AVX2 kernels: eight values at a time, with FMA.
+	VMLIB_TARGET_AVX2
+	inline __m256 select_avx2_( __m256 aMask, __m256 aA, __m256 aB ) noexcept
+	{
+		return _mm256_blendv_ps( aB, aA, aMask );
+	}
+
+	VMLIB_TARGET_AVX2
+	inline void sincos_avx2_( __m256 aX, __m256& aSin, __m256& aCos ) noexcept
+	{
+		__m256 const jf = _mm256_round_ps( _mm256_mul_ps( aX, _mm256_set1_ps( kTwoOverPi ) ), _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC );
+		__m256i const j = _mm256_cvtps_epi32( jf );
+
+		__m256 r = _mm256_fnmadd_ps( jf, _mm256_set1_ps( kPio2A ), aX );
+		r = _mm256_fnmadd_ps( jf, _mm256_set1_ps( kPio2B ), r );
+		r = _mm256_fnmadd_ps( jf, _mm256_set1_ps( kPio2C ), r );
+		__m256 const z = _mm256_mul_ps( r, r );
+
+		__m256 ps = _mm256_fmadd_ps( z, _mm256_set1_ps( kSin3 ), _mm256_set1_ps( kSin2 ) );
+		ps = _mm256_fmadd_ps( z, ps, _mm256_set1_ps( kSin1 ) );
+		ps = _mm256_fmadd_ps( _mm256_mul_ps( r, z ), ps, r );
+
+		__m256 pc = _mm256_fmadd_ps( z, _mm256_set1_ps( kCos3 ), _mm256_set1_ps( kCos2 ) );
+		pc = _mm256_fmadd_ps( z, pc, _mm256_set1_ps( kCos1 ) );
+		pc = _mm256_fmadd_ps( _mm256_mul_ps( z, z ), pc, _mm256_fnmadd_ps( _mm256_set1_ps( 0.5f ), z, _mm256_set1_ps( 1.f ) ) );
+
+		__m256i const one = _mm256_set1_epi32( 1 ), two = _mm256_set1_epi32( 2 );
+		__m256 const swap = _mm256_castsi256_ps( _mm256_cmpeq_epi32( _mm256_and_si256( j, one ), one ) );
+		__m256 const sinSign = _mm256_castsi256_ps( _mm256_slli_epi32( _mm256_and_si256( j, two ), 30 ) );
+		__m256 const cosSign = _mm256_castsi256_ps( _mm256_slli_epi32( _mm256_and_si256( _mm256_add_epi32( j, one ), two ), 30 ) );
+
+		aSin = _mm256_xor_ps( select_avx2_( swap, pc, ps ), sinSign );
+		aCos = _mm256_xor_ps( select_avx2_( swap, ps, pc ), cosSign );
+	}
+
+	template< bool tSin, bool tCos > VMLIB_TARGET_AVX2
+	void sincos_avx2_( std::size_t aCount, float const* aX, float* aSin, float* aCos ) noexcept
+	{
+		std::size_t i = 0;
+		for( ; i+8 <= aCount; i += 8 )
+		{
+			__m256 s, c;
+			sincos_avx2_( _mm256_loadu_ps( aX+i ), s, c );
+			if constexpr( tSin ) _mm256_storeu_ps( aSin+i, s );
+			if constexpr( tCos ) _mm256_storeu_ps( aCos+i, c );
+		}
+
+		sincos_sse2_<tSin,tCos>( aCount-i, aX+i, tSin ? aSin+i : nullptr, tCos ? aCos+i : nullptr );
+	}
+
+	VMLIB_TARGET_AVX2
+	void atan2_avx2_( std::size_t aCount, float const* aY, float const* aX, float* aOut ) noexcept
+	{
+		__m256 const signMask = _mm256_set1_ps( -0.f );
+
+		std::size_t i = 0;
+		for( ; i+8 <= aCount; i += 8 )
+		{
+			__m256 const x = _mm256_loadu_ps( aX+i );
+			__m256 const y = _mm256_loadu_ps( aY+i );
+			__m256 const ax = _mm256_andnot_ps( signMask, x );
+			__m256 const ay = _mm256_andnot_ps( signMask, y );
+			__m256 const mn = _mm256_min_ps( ax, ay );
+			__m256 const mx = _mm256_max_ps( ax, ay );
+
+			__m256 const upper = _mm256_cmp_ps( mn, _mm256_mul_ps( _mm256_set1_ps( kTanPi8 ), mx ), _CMP_GT_OQ );
+			__m256 const num = select_avx2_( upper, _mm256_sub_ps( mn, mx ), mn );
+			__m256 const den = select_avx2_( upper, _mm256_add_ps( mn, mx ), mx );
+			__m256 const t = _mm256_div_ps( num, _mm256_max_ps( den, _mm256_set1_ps( 1e-30f ) ) );
+			__m256 const z = _mm256_mul_ps( t, t );
+
+			__m256 p = _mm256_fmadd_ps( z, _mm256_set1_ps( kAtan4 ), _mm256_set1_ps( kAtan3 ) );
+			p = _mm256_fmadd_ps( z, p, _mm256_set1_ps( kAtan2 ) );
+			p = _mm256_fmadd_ps( z, p, _mm256_set1_ps( kAtan1 ) );
+			p = _mm256_fmadd_ps( _mm256_mul_ps( t, z ), p, t );
+
+			__m256 r = _mm256_add_ps( _mm256_and_ps( upper, _mm256_set1_ps( kPi4 ) ), p );
+			r = select_avx2_( _mm256_cmp_ps( ay, ax, _CMP_GT_OQ ), _mm256_sub_ps( _mm256_set1_ps( kPi2 ), r ), r );
+			r = select_avx2_( x, _mm256_sub_ps( _mm256_set1_ps( kPi ), r ), r ); // blendv only looks at the sign bit
+
+			_mm256_storeu_ps( aOut+i, _mm256_or_ps( r, _mm256_and_ps( signMask, y ) ) );
+		}
+
+		atan2_sse2_( aCount-i, aY+i, aX+i, aOut+i );
+	}
+
+	VMLIB_TARGET_AVX2
+	inline __m256 rsqrt_avx2_( __m256 aX ) noexcept
+	{
+		__m256 const y = _mm256_rsqrt_ps( aX );
+		__m256 const xy = _mm256_mul_ps( aX, y );
+		return _mm256_mul_ps( _mm256_mul_ps( _mm256_set1_ps( 0.5f ), y ), _mm256_fnmadd_ps( xy, y, _mm256_set1_ps( 3.f ) ) );
+	}
+
+	VMLIB_TARGET_AVX2
+	void rsqrt_avx2_( std::size_t aCount, float const* aX, float* aOut ) noexcept
+	{
+		std::size_t i = 0;
+		for( ; i+8 <= aCount; i += 8 )
+			_mm256_storeu_ps( aOut+i, rsqrt_avx2_( _mm256_loadu_ps( aX+i ) ) );
+
+		rsqrt_sse2_( aCount-i, aX+i, aOut+i );
+	}
+
+	template< int tX, int tY, int tZ, int tW > VMLIB_TARGET_AVX2
+	inline __m256 shuffle2_( __m256 aA, __m256 aB ) noexcept
+	{
+		return _mm256_shuffle_ps( aA, aB, _MM_SHUFFLE( tW, tZ, tY, tX ) );
+	}
+
+	VMLIB_TARGET_AVX2
+	inline __m256 load2_( float const* aLo, float const* aHi ) noexcept
+	{
+		return _mm256_insertf128_ps( _mm256_castps128_ps256( _mm_loadu_ps( aLo ) ), _mm_loadu_ps( aHi ), 1 );
+	}
+	VMLIB_TARGET_AVX2
+	inline void store2_( float* aLo, float* aHi, __m256 aV ) noexcept
+	{
+		_mm_storeu_ps( aLo, _mm256_castps256_ps128( aV ) );
+		_mm_storeu_ps( aHi, _mm256_extractf128_ps( aV, 1 ) );
+	}
+
+	VMLIB_TARGET_AVX2
+	void normalize_avx2_( std::size_t aCount, Vec3f const* aIn, Vec3f* aOut ) noexcept
+	{
+		std::size_t i = 0;
+		for( ; i+8 <= aCount; i += 8 )
+		{
+			float const* src = &aIn[i].x;
+			__m256 const a = load2_( src+0, src+12 );
+			__m256 const b = load2_( src+4, src+16 );
+			__m256 const c = load2_( src+8, src+20 );
+
+			__m256 x = shuffle2_<0,1,0,2>( shuffle2_<0,3,2,3>( a, b ), shuffle2_<2,2,1,1>( b, c ) );
+			__m256 y = shuffle2_<0,2,0,2>( shuffle2_<1,1,0,0>( a, b ), shuffle2_<3,3,2,2>( b, c ) );
+			__m256 z = shuffle2_<0,2,0,2>( shuffle2_<2,2,1,1>( a, b ), shuffle2_<0,0,3,3>( c, c ) );
+
+			__m256 const l2 = _mm256_fmadd_ps( x, x, _mm256_fmadd_ps( y, y, _mm256_mul_ps( z, z ) ) );
+			__m256 const il = rsqrt_avx2_( l2 );
+			x = _mm256_mul_ps( x, il );
+			y = _mm256_mul_ps( y, il );
+			z = _mm256_mul_ps( z, il );
+
+			float* dst = &aOut[i].x;
+			store2_( dst+0, dst+12, shuffle2_<0,2,0,2>( shuffle2_<0,0,0,0>( x, y ), shuffle2_<0,0,1,1>( z, x ) ) );
+			store2_( dst+4, dst+16, shuffle2_<0,2,0,2>( shuffle2_<1,1,1,1>( y, z ), shuffle2_<2,2,2,2>( x, y ) ) );
+			store2_( dst+8, dst+20, shuffle2_<0,2,0,2>( shuffle2_<2,2,3,3>( z, x ), shuffle2_<3,3,3,3>( y, z ) ) );
+		}
+
+		normalize_sse2_( aCount-i, aIn+i, aOut+i );
+	}
+
+	constexpr MathKernels_ kAvx2Kernels_{
+		&sincos_avx2_<true,false>,
+		&sincos_avx2_<false,true>,
+		&sincos_avx2_<true,true>,
+		&atan2_avx2_,
+		&rsqrt_avx2_,
+		&normalize_avx2_
+	};
+#	endif // ~ VMLIB_SIMD_X86
+
+#	if defined(VMLIB_SIMD_NEON)
+	// NEON kernels, four values at a time.
+	inline void sincos_neon_( float32x4_t aX, float32x4_t& aSin, float32x4_t& aCos ) noexcept
+	{
+		int32x4_t const j = vcvtnq_s32_f32( vmulq_n_f32( aX, kTwoOverPi ) );
+		float32x4_t const jf = vcvtq_f32_s32( j );
+
+		float32x4_t r = vfmsq_n_f32( aX, jf, kPio2A );
+		r = vfmsq_n_f32( r, jf, kPio2B );
+		r = vfmsq_n_f32( r, jf, kPio2C );
+		float32x4_t const z = vmulq_f32( r, r );
+
+		float32x4_t ps = vfmaq_n_f32( vdupq_n_f32( kSin2 ), z, kSin3 );
+		ps = vfmaq_f32( vdupq_n_f32( kSin1 ), z, ps );
+		ps = vfmaq_f32( r, vmulq_f32( r, z ), ps );
+
+		float32x4_t pc = vfmaq_n_f32( vdupq_n_f32( kCos2 ), z, kCos3 );
+		pc = vfmaq_f32( vdupq_n_f32( kCos1 ), z, pc );
+		pc = vfmaq_f32( vfmsq_n_f32( vdupq_n_f32( 1.f ), z, 0.5f ), vmulq_f32( z, z ), pc );
+
+		int32x4_t const one = vdupq_n_s32( 1 ), two = vdupq_n_s32( 2 );
+		uint32x4_t const swap = vceqq_s32( vandq_s32( j, one ), one );
+		uint32x4_t const sinSign = vreinterpretq_u32_s32( vshlq_n_s32( vandq_s32( j, two ), 30 ) );
+		uint32x4_t const cosSign = vreinterpretq_u32_s32( vshlq_n_s32( vandq_s32( vaddq_s32( j, one ), two ), 30 ) );
+
+		aSin = vreinterpretq_f32_u32( veorq_u32( vreinterpretq_u32_f32( vbslq_f32( swap, pc, ps ) ), sinSign ) );
+		aCos = vreinterpretq_f32_u32( veorq_u32( vreinterpretq_u32_f32( vbslq_f32( swap, ps, pc ) ), cosSign ) );
+	}
+
+	template< bool tSin, bool tCos >
+	void sincos_neon_( std::size_t aCount, float const* aX, float* aSin, float* aCos ) noexcept
+	{
+		std::size_t i = 0;
+		for( ; i+4 <= aCount; i += 4 )
+		{
+			float32x4_t s, c;
+			sincos_neon_( vld1q_f32( aX+i ), s, c );
+			if constexpr( tSin ) vst1q_f32( aSin+i, s );
+			if constexpr( tCos ) vst1q_f32( aCos+i, c );
+		}
+
+		sincos_scalar_<tSin,tCos>( aCount-i, aX+i, tSin ? aSin+i : nullptr, tCos ? aCos+i : nullptr );
+	}
+
+	void atan2_neon_( std::size_t aCount, float const* aY, float const* aX, float* aOut ) noexcept
+	{
+		uint32x4_t const signMask = vdupq_n_u32( 0x80000000u );
+
+		std::size_t i = 0;
+		for( ; i+4 <= aCount; i += 4 )
+		{
+			float32x4_t const x = vld1q_f32( aX+i );
+			float32x4_t const y = vld1q_f32( aY+i );
+			float32x4_t const ax = vabsq_f32( x );
+			float32x4_t const ay = vabsq_f32( y );
+			float32x4_t const mn = vminq_f32( ax, ay );
+			float32x4_t const mx = vmaxq_f32( ax, ay );
+
+			uint32x4_t const upper = vcgtq_f32( mn, vmulq_n_f32( mx, kTanPi8 ) );
+			float32x4_t const num = vbslq_f32( upper, vsubq_f32( mn, mx ), mn );
+			float32x4_t const den = vbslq_f32( upper, vaddq_f32( mn, mx ), mx );
+			float32x4_t const t = vdivq_f32( num, vmaxq_f32( den, vdupq_n_f32( 1e-30f ) ) );
+			float32x4_t const z = vmulq_f32( t, t );
+
+			float32x4_t p = vfmaq_n_f32( vdupq_n_f32( kAtan3 ), z, kAtan4 );
+			p = vfmaq_f32( vdupq_n_f32( kAtan2 ), z, p );
+			p = vfmaq_f32( vdupq_n_f32( kAtan1 ), z, p );
+			p = vfmaq_f32( t, vmulq_f32( t, z ), p );
+
+			float32x4_t r = vaddq_f32( vbslq_f32( upper, vdupq_n_f32( kPi4 ), vdupq_n_f32( 0.f ) ), p );
+			r = vbslq_f32( vcgtq_f32( ay, ax ), vsubq_f32( vdupq_n_f32( kPi2 ), r ), r );
+
+			uint32x4_t const xNeg = vreinterpretq_u32_s32( vshrq_n_s32( vreinterpretq_s32_f32( x ), 31 ) );
+			r = vbslq_f32( xNeg, vsubq_f32( vdupq_n_f32( kPi ), r ), r );
+
+			uint32x4_t const ySign = vandq_u32( vreinterpretq_u32_f32( y ), signMask );
+			vst1q_f32( aOut+i, vreinterpretq_f32_u32( vorrq_u32( vreinterpretq_u32_f32( r ), ySign ) ) );
+		}
+
+		atan2_scalar_( aCount-i, aY+i, aX+i, aOut+i );
+	}
+
+	// vrsqrte is only accurate to about 8 bits, so this takes two
+	// Newton-Raphson steps (vrsqrts computes (3 - a*b)/2).
+	inline float32x4_t rsqrt_neon_( float32x4_t aX ) noexcept
+	{
+		float32x4_t y = vrsqrteq_f32( aX );
+		y = vmulq_f32( y, vrsqrtsq_f32( vmulq_f32( aX, y ), y ) );
+		y = vmulq_f32( y, vrsqrtsq_f32( vmulq_f32( aX, y ), y ) );
+		return y;
+	}
+
+	void rsqrt_neon_( std::size_t aCount, float const* aX, float* aOut ) noexcept
+	{
+		std::size_t i = 0;
+		for( ; i+4 <= aCount; i += 4 )
+			vst1q_f32( aOut+i, rsqrt_neon_( vld1q_f32( aX+i ) ) );
+
+		rsqrt_scalar_( aCount-i, aX+i, aOut+i );
+	}
+
+	void normalize_neon_( std::size_t aCount, Vec3f const* aIn, Vec3f* aOut ) noexcept
+	{
+		std::size_t i = 0;
+		for( ; i+4 <= aCount; i += 4 )
+		{
+			float32x4x3_t v = vld3q_f32( &aIn[i].x );
+
+			float32x4_t const l2 = vfmaq_f32( vfmaq_f32( vmulq_f32( v.val[2], v.val[2] ), v.val[1], v.val[1] ), v.val[0], v.val[0] );
+			float32x4_t const il = rsqrt_neon_( l2 );
+			v.val[0] = vmulq_f32( v.val[0], il );
+			v.val[1] = vmulq_f32( v.val[1], il );
+			v.val[2] = vmulq_f32( v.val[2], il );
+
+			vst3q_f32( &aOut[i].x, v );
+		}
+
+		normalize_scalar_( aCount-i, aIn+i, aOut+i );
+	}
+
+	constexpr MathKernels_ kNeonKernels_{
+		&sincos_neon_<true,false>,
+		&sincos_neon_<false,true>,
+		&sincos_neon_<true,true>,
+		&atan2_neon_,
+		&rsqrt_neon_,
+		&normalize_neon_
+	};
+#	endif // ~ VMLIB_SIMD_NEON
+
+	MathKernels_ const& kernels_() noexcept
+	{
+		switch( simd_active_isa() )
+		{
+#			if defined(VMLIB_SIMD_X86)
+			case SimdIsa::sse2: return kSse2Kernels_;
+			case SimdIsa::avx2: return kAvx2Kernels_;
+#			endif
+#			if defined(VMLIB_SIMD_NEON)
+			case SimdIsa::neon: return kNeonKernels_;
+#			endif
+			default: return kScalarKernels_;
+		}
+	}
+
+	using SinCosKernel_ = void (*)( std::size_t, float const*, float*, float* ) noexcept;
+
+	void run_sincos_( SinCosKernel_ aKernel, std::size_t aCount, float const* aX, float* aSin, float* aCos )
+	{
+		parallel_for( aCount, kMinPerThread_, [&] (std::size_t aBegin, std::size_t aEnd) {
+			aKernel( aEnd-aBegin, aX+aBegin, aSin ? aSin+aBegin : nullptr, aCos ? aCos+aBegin : nullptr );
+		} );
+	}
+}
+
+void fast_sin_n( std::size_t aCount, float const* aX, float* aSin )
+{
+	run_sincos_( kernels_().sin, aCount, aX, aSin, nullptr );
+}
+void fast_cos_n( std::size_t aCount, float const* aX, float* aCos )
+{
+	run_sincos_( kernels_().cos, aCount, aX, nullptr, aCos );
+}
+void fast_sincos_n( std::size_t aCount, float const* aX, float* aSin, float* aCos )
+{
+	if( !aCos )
+		fast_sin_n( aCount, aX, aSin );
+	else if( !aSin )
+		fast_cos_n( aCount, aX, aCos );
+	else
+		run_sincos_( kernels_().sincos, aCount, aX, aSin, aCos );
+}
+
+void fast_atan2_n( std::size_t aCount, float const* aY, float const* aX, float* aOut )
+{
+	auto const& kernels = kernels_();
+	parallel_for( aCount, kMinPerThread_, [&] (std::size_t aBegin, std::size_t aEnd) {
+		kernels.atan2( aEnd-aBegin, aY+aBegin, aX+aBegin, aOut+aBegin );
+	} );
+}
+
+void fast_rsqrt_n( std::size_t aCount, float const* aX, float* aOut )
+{
+	auto const& kernels = kernels_();
+	parallel_for( aCount, kMinPerThread_, [&] (std::size_t aBegin, std::size_t aEnd) {
+		kernels.rsqrt( aEnd-aBegin, aX+aBegin, aOut+aBegin );
+	} );
+}
+
+void fast_normalize_n( std::size_t aCount, Vec3f const* aIn, Vec3f* aOut )
+{
+	auto const& kernels = kernels_();
+	parallel_for( aCount, kMinPerThread_, [&] (std::size_t aBegin, std::size_t aEnd) {
+		kernels.normalize( aEnd-aBegin, aIn+aBegin, aOut+aBegin );
+	} );
+}
+void fast_normalize_n( std::vector<Vec3f>& aVectors )
+{
+	fast_normalize_n( aVectors.size(), aVectors.data(), aVectors.data() );
+}
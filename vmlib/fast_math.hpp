@@ -0,0 +1,165 @@
+#ifndef FAST_MATH_HPP_E41C1804_47C0_4EA7_A78C_561E293E03CA
+#define FAST_MATH_HPP_E41C1804_47C0_4EA7_A78C_561E293E03CA
+
+#include <vector>
+#include <algorithm>
+
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+#include "vec3.hpp"
+
+/** Fast approximate math functions
+ *
+ * Polynomial approximations of sin(), cos(), atan2() and friends that trade
+ * a few bits of precision for speed. The batched versions (suffix _n) process
+ * whole arrays with the SIMD instruction set selected by simd.hpp and split
+ * large inputs across multiple threads (see parallel.hpp). The scalar
+ * versions evaluate the same polynomials, one value at a time.
+ *
+ * Accuracy (maximum absolute error vs. the double precision result, measured
+ * over the stated domain; see vmlib-test/fast_math.cpp):
+ *
+ *   fast_sin, fast_cos, fast_sincos  |x| <= 8192         1.5e-7
+ *   fast_atan2                       all finite (y,x)    3.0e-7 (radians)
+ *   fast_rsqrt_n                     normal floats > 0   3.0e-7 (relative)
+ *   fast_normalize_n                 non-zero vectors    4.0e-7 (length - 1)
+ *
+ * For comparison, one ulp of a float in [0.5,1) is 6e-8. sin/cos reduce the
+ * argument to [-pi/4,pi/4] with a three-part pi/2 (Cody & Waite). Beyond the
+ * stated domain, the error grows with |x|: it is about 1e-6 up to |x| = 1e5,
+ * and the results are meaningless from about |x| = 1e6 on. Results are
+ * unspecified for non-finite inputs, for atan2 at (0,0) other than being
+ * finite, and for rsqrt/normalize of zero.
+ *
+ * Results may differ in the last bit between instruction sets (e.g., due to
+ * FMA), but all stay within the bounds above.
+ *
+ * The polynomials are from the Cephes library (S. L. Moshier, "Methods and
+ * Programs for Mathematical Functions", 1989).
+ *
+ * Example:
+ *    std::vector<float> angles = ..., s( angles.size() ), c( angles.size() );
+ *    fast_sincos_n( angles.size(), angles.data(), s.data(), c.data() );
+ */
+
+namespace detail_fast_math
+{
+	constexpr float kTwoOverPi = 0.636619772367581343f;
+
+	// pi/2 split into three parts; the first two have trailing zero bits, so
+	// that j*kPio2A and j*kPio2B are exact for moderately sized j.
+	constexpr float kPio2A = 1.5703125f;
+	constexpr float kPio2B = 4.837512969970703125e-4f;
+	constexpr float kPio2C = 7.54978995489188216e-8f;
+
+	// sin(r) and cos(r) for |r| <= pi/4
+	constexpr float kSin1 = -1.6666654611e-1f;
+	constexpr float kSin2 = 8.3321608736e-3f;
+	constexpr float kSin3 = -1.9515295891e-4f;
+
+	constexpr float kCos1 = 4.166664568298827e-2f;
+	constexpr float kCos2 = -1.388731625493765e-3f;
+	constexpr float kCos3 = 2.443315711809948e-5f;
+
+	// atan(t) for |t| <= tan(pi/8)
+	constexpr float kTanPi8 = 0.414213562373095049f;
+	constexpr float kAtan1 = -3.33329491539e-1f;
+	constexpr float kAtan2 = 1.99777106478e-1f;
+	constexpr float kAtan3 = -1.38776856032e-1f;
+	constexpr float kAtan4 = 8.05374449538e-2f;
+
+	constexpr float kPi = 3.14159265358979324f;
+	constexpr float kPi2 = 1.57079632679489662f;
+	constexpr float kPi4 = 0.785398163397448310f;
+}
+
+inline
+void fast_sincos( float aX, float& aSin, float& aCos ) noexcept
+{
+	using namespace detail_fast_math;
+
+	float const j = std::nearbyint( aX * kTwoOverPi );
+	float const r = ((aX - j*kPio2A) - j*kPio2B) - j*kPio2C;
+	float const z = r*r;
+
+	float const s = r + r*z*(kSin1 + z*(kSin2 + z*kSin3));
+	float const c = 1.f - 0.5f*z + z*z*(kCos1 + z*(kCos2 + z*kCos3));
+
+	// Odd quadrants swap sin and cos; bit 1 of the quadrant (of quadrant+1
+	// for cos) is the sign. Uses bit operations, like the SIMD kernels;
+	// branches mispredict on random inputs. The clamp keeps the conversion
+	// well-defined for huge and non-finite arguments.
+	std::uint32_t const q = std::uint32_t( std::int32_t( (j > -1e9f && j < 1e9f) ? j : 0.f ) );
+	std::uint32_t const swap = 0u - (q & 1u);
+
+	std::uint32_t sb, cb;
+	std::memcpy( &sb, &s, sizeof(float) );
+	std::memcpy( &cb, &c, sizeof(float) );
+
+	std::uint32_t const sinBits = ((cb & swap) | (sb & ~swap)) ^ ((q & 2u) << 30);
+	std::uint32_t const cosBits = ((sb & swap) | (cb & ~swap)) ^ (((q+1u) & 2u) << 30);
+	std::memcpy( &aSin, &sinBits, sizeof(float) );
+	std::memcpy( &aCos, &cosBits, sizeof(float) );
+}
+
+inline
+float fast_sin( float aX ) noexcept
+{
+	float s, c;
+	fast_sincos( aX, s, c );
+	return s;
+}
+inline
+float fast_cos( float aX ) noexcept
+{
+	float s, c;
+	fast_sincos( aX, s, c );
+	return c;
+}
+
+inline
+float fast_atan2( float aY, float aX ) noexcept
+{
+	using namespace detail_fast_math;
+
+	float const ax = std::abs( aX );
+	float const ay = std::abs( aY );
+	float const mn = std::min( ax, ay );
+	float const mx = std::max( ax, ay );
+
+	// atan(mn/mx) in [0,pi/4]. Above tan(pi/8), use
+	//    atan(a) = pi/4 + atan((a-1)/(a+1)).
+	bool const upper = mn > kTanPi8 * mx;
+	float const num = upper ? mn - mx : mn;
+	float const den = upper ? mn + mx : mx;
+	float const t = num / std::max( den, 1e-30f );
+	float const z = t*t;
+
+	float r = (upper ? kPi4 : 0.f) + (t + t*z*(kAtan1 + z*(kAtan2 + z*(kAtan3 + z*kAtan4))));
+	if( ay > ax ) r = kPi2 - r;
+	if( std::signbit( aX ) ) r = kPi - r;
+	return std::copysign( r, aY );
+}
+
+
+/* Batched versions
+ *
+ * Each output array has aCount elements. Outputs may alias their input, but
+ * not each other. fast_sincos_n accepts a null aSin or aCos if only one of
+ * them is needed (equivalent to fast_cos_n or fast_sin_n, respectively).
+ */
+void fast_sin_n( std::size_t aCount, float const* aX, float* aSin );
+void fast_cos_n( std::size_t aCount, float const* aX, float* aCos );
+void fast_sincos_n( std::size_t aCount, float const* aX, float* aSin, float* aCos );
+
+void fast_atan2_n( std::size_t aCount, float const* aY, float const* aX, float* aOut );
+
+void fast_rsqrt_n( std::size_t aCount, float const* aX, float* aOut );
+
+void fast_normalize_n( std::size_t aCount, Vec3f const* aIn, Vec3f* aOut );
+void fast_normalize_n( std::vector<Vec3f>& aVectors );
+
+#endif // FAST_MATH_HPP_E41C1804_47C0_4EA7_A78C_561E293E03CA
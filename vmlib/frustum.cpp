@@ -0,0 +1,312 @@
+#include "frustum.hpp"
+
+#include <atomic>
+
+#include "simd.hpp"
+#include "parallel.hpp"
+
+namespace
+{
+	// Testing a box takes only a few nanoseconds. Use threads only for very
+	// large inputs.
+	constexpr std::size_t kMinPerThread_ = 64*1024;
+
+	struct CullKernels_
+	{
+		std::size_t (*cull)( Frustumf const&, std::size_t, Aabb3f const*, std::uint8_t* ) noexcept;
+	};
+
+	// Scalar kernel
+	std::size_t cull_scalar_( Frustumf const& aFrustum, std::size_t aCount, Aabb3f const* aBoxes, std::uint8_t* aVisible ) noexcept
+	{
+		std::size_t visible = 0;
+		for( std::size_t i = 0; i < aCount; ++i )
+		{
+			aVisible[i] = intersects( aFrustum, aBoxes[i] ) ? 1 : 0;
+			visible += aVisible[i];
+		}
+		return visible;
+	}
+
+	constexpr CullKernels_ kScalarKernels_{ &cull_scalar_ };
+
+	// The SIMD kernels test four or eight boxes against one plane at a time,
+	// with the boxes in registers as center and half extent per axis (same
+	// test as in intersects()). Each box is loaded with two overlapping
+	// loads,
+	//    (min.x, min.y, min.z, max.x) and (min.z, max.x, max.y, max.z),
+	// which stay within the Aabb3f. Transposing four of each gives the
+	// per-axis registers.
+	inline std::size_t store_visible_( int aOutsideMask, std::size_t aCount, std::uint8_t* aVisible ) noexcept
+	{
+		std::size_t visible = 0;
+		for( std::size_t k = 0; k < aCount; ++k )
+		{
+			aVisible[k] = std::uint8_t( ~(aOutsideMask >> k) & 1 );
+			visible += aVisible[k];
+		}
+		return visible;
+	}
+
+#	if defined(VMLIB_SIMD_X86)
+	// SSE2 kernel
+	struct PlanesSse2_
+	{
+		__m128 nx[6], ny[6], nz[6], d[6];
+		__m128 ax[6], ay[6], az[6]; // |n|
+	};
+
+	inline PlanesSse2_ load_planes_sse2_( Frustumf const& aFrustum ) noexcept
+	{
+		PlanesSse2_ ret;
+		for( std::size_t p = 0; p < 6; ++p )
+		{
+			Planef const& plane = aFrustum.planes[p];
+			ret.nx[p] = _mm_set1_ps( plane.n.x );
+			ret.ny[p] = _mm_set1_ps( plane.n.y );
+			ret.nz[p] = _mm_set1_ps( plane.n.z );
+			ret.d[p] = _mm_set1_ps( plane.d );
+			ret.ax[p] = _mm_set1_ps( std::abs( plane.n.x ) );
+			ret.ay[p] = _mm_set1_ps( std::abs( plane.n.y ) );
+			ret.az[p] = _mm_set1_ps( std::abs( plane.n.z ) );
+		}
+		return ret;
+	}
+
+	std::size_t cull_sse2_( Frustumf const& aFrustum, std::size_t aCount, Aabb3f const* aBoxes, std::uint8_t* aVisible ) noexcept
+	{
+		PlanesSse2_ const pl = load_planes_sse2_( aFrustum );
+		__m128 const half = _mm_set1_ps( 0.5f );
+
+		std::size_t visible = 0;
+
+		std::size_t i = 0;
+		for( ; i+4 <= aCount; i += 4 )
+		{
+			__m128 a0 = _mm_loadu_ps( &aBoxes[i+0].min.x );
+			__m128 a1 = _mm_loadu_ps( &aBoxes[i+1].min.x );
+			__m128 a2 = _mm_loadu_ps( &aBoxes[i+2].min.x );
+			__m128 a3 = _mm_loadu_ps( &aBoxes[i+3].min.x );
+			_MM_TRANSPOSE4_PS( a0, a1, a2, a3 );
+
+			__m128 b0 = _mm_loadu_ps( &aBoxes[i+0].min.z );
+			__m128 b1 = _mm_loadu_ps( &aBoxes[i+1].min.z );
+			__m128 b2 = _mm_loadu_ps( &aBoxes[i+2].min.z );
+			__m128 b3 = _mm_loadu_ps( &aBoxes[i+3].min.z );
+			_MM_TRANSPOSE4_PS( b0, b1, b2, b3 );
+
+			__m128 const cx = _mm_mul_ps( _mm_add_ps( a0, b1 ), half );
+			__m128 const cy = _mm_mul_ps( _mm_add_ps( a1, b2 ), half );
+			__m128 const cz = _mm_mul_ps( _mm_add_ps( a2, b3 ), half );
+			__m128 const ex = _mm_mul_ps( _mm_sub_ps( b1, a0 ), half );
+			__m128 const ey = _mm_mul_ps( _mm_sub_ps( b2, a1 ), half );
+			__m128 const ez = _mm_mul_ps( _mm_sub_ps( b3, a2 ), half );
+
+			__m128 outside = _mm_setzero_ps();
+			for( std::size_t p = 0; p < 6; ++p )
+			{
+				__m128 const s = _mm_add_ps(
+					_mm_add_ps( _mm_mul_ps( pl.nx[p], cx ), _mm_mul_ps( pl.ny[p], cy ) ),
+					_mm_add_ps( _mm_mul_ps( pl.nz[p], cz ), pl.d[p] )
+				);
+				__m128 const r = _mm_add_ps(
+					_mm_add_ps( _mm_mul_ps( pl.ax[p], ex ), _mm_mul_ps( pl.ay[p], ey ) ),
+					_mm_mul_ps( pl.az[p], ez )
+				);
+				outside = _mm_or_ps( outside, _mm_cmplt_ps( _mm_add_ps( s, r ), _mm_setzero_ps() ) );
+			}
+
+			visible += store_visible_( _mm_movemask_ps( outside ), 4, aVisible+i );
+		}
+
+		return visible + cull_scalar_( aFrustum, aCount-i, aBoxes+i, aVisible+i );
+	}
+
+	constexpr CullKernels_ kSse2Kernels_{ &cull_sse2_ };
+
+	// AVX2 kernel. The low 128-bit lane holds boxes 0-3 and the high lane
+	// boxes 4-7, so that the transposes can stay within lanes.
+	VMLIB_TARGET_AVX2
+	inline __m256 load2_( float const* aLo, float const* aHi ) noexcept
+	{
+		return _mm256_insertf128_ps( _mm256_castps128_ps256( _mm_loadu_ps( aLo ) ), _mm_loadu_ps( aHi ), 1 );
+	}
+
+	VMLIB_TARGET_AVX2
+	inline void transpose_avx2_( __m256& aR0, __m256& aR1, __m256& aR2, __m256& aR3 ) noexcept
+	{
+		__m256 const t0 = _mm256_unpacklo_ps( aR0, aR1 );
+		__m256 const t1 = _mm256_unpacklo_ps( aR2, aR3 );
+		__m256 const t2 = _mm256_unpackhi_ps( aR0, aR1 );
+		__m256 const t3 = _mm256_unpackhi_ps( aR2, aR3 );
+		aR0 = _mm256_shuffle_ps( t0, t1, _MM_SHUFFLE( 1, 0, 1, 0 ) );
+		aR1 = _mm256_shuffle_ps( t0, t1, _MM_SHUFFLE( 3, 2, 3, 2 ) );
+		aR2 = _mm256_shuffle_ps( t2, t3, _MM_SHUFFLE( 1, 0, 1, 0 ) );
+		aR3 = _mm256_shuffle_ps( t2, t3, _MM_SHUFFLE( 3, 2, 3, 2 ) );
+	}
+
+	VMLIB_TARGET_AVX2
+	std::size_t cull_avx2_( Frustumf const& aFrustum, std::size_t aCount, Aabb3f const* aBoxes, std::uint8_t* aVisible ) noexcept
+	{
+		__m256 nx[6], ny[6], nz[6], d[6], ax[6], ay[6], az[6];
+		for( std::size_t p = 0; p < 6; ++p )
+		{
+			Planef const& plane = aFrustum.planes[p];
+			nx[p] = _mm256_set1_ps( plane.n.x );
+			ny[p] = _mm256_set1_ps( plane.n.y );
+			nz[p] = _mm256_set1_ps( plane.n.z );
+			d[p] = _mm256_set1_ps( plane.d );
+			ax[p] = _mm256_set1_ps( std::abs( plane.n.x ) );
+			ay[p] = _mm256_set1_ps( std::abs( plane.n.y ) );
+			az[p] = _mm256_set1_ps( std::abs( plane.n.z ) );
+		}
+
+		__m256 const half = _mm256_set1_ps( 0.5f );
+
+		std::size_t visible = 0;
+
+		std::size_t i = 0;
+		for( ; i+8 <= aCount; i += 8 )
+		{
+			__m256 a0 = load2_( &aBoxes[i+0].min.x, &aBoxes[i+4].min.x );
+			__m256 a1 = load2_( &aBoxes[i+1].min.x, &aBoxes[i+5].min.x );
+			__m256 a2 = load2_( &aBoxes[i+2].min.x, &aBoxes[i+6].min.x );
+			__m256 a3 = load2_( &aBoxes[i+3].min.x, &aBoxes[i+7].min.x );
+			transpose_avx2_( a0, a1, a2, a3 );
+
+			__m256 b0 = load2_( &aBoxes[i+0].min.z, &aBoxes[i+4].min.z );
+			__m256 b1 = load2_( &aBoxes[i+1].min.z, &aBoxes[i+5].min.z );
+			__m256 b2 = load2_( &aBoxes[i+2].min.z, &aBoxes[i+6].min.z );
+			__m256 b3 = load2_( &aBoxes[i+3].min.z, &aBoxes[i+7].min.z );
+			transpose_avx2_( b0, b1, b2, b3 );
+
+			__m256 const cx = _mm256_mul_ps( _mm256_add_ps( a0, b1 ), half );
+			__m256 const cy = _mm256_mul_ps( _mm256_add_ps( a1, b2 ), half );
+			__m256 const cz = _mm256_mul_ps( _mm256_add_ps( a2, b3 ), half );
+			__m256 const ex = _mm256_mul_ps( _mm256_sub_ps( b1, a0 ), half );
+			__m256 const ey = _mm256_mul_ps( _mm256_sub_ps( b2, a1 ), half );
+			__m256 const ez = _mm256_mul_ps( _mm256_sub_ps( b3, a2 ), half );
+
+			__m256 outside = _mm256_setzero_ps();
+			for( std::size_t p = 0; p < 6; ++p )
+			{
+				__m256 const s = _mm256_fmadd_ps( nx[p], cx, _mm256_fmadd_ps( ny[p], cy, _mm256_fmadd_ps( nz[p], cz, d[p] ) ) );
+				__m256 const r = _mm256_fmadd_ps( ax[p], ex, _mm256_fmadd_ps( ay[p], ey, _mm256_mul_ps( az[p], ez ) ) );
+				outside = _mm256_or_ps( outside, _mm256_cmp_ps( _mm256_add_ps( s, r ), _mm256_setzero_ps(), _CMP_LT_OQ ) );
+			}
+
+			visible += store_visible_( _mm256_movemask_ps( outside ), 8, aVisible+i );
+		}
+
+		return visible + cull_sse2_( aFrustum, aCount-i, aBoxes+i, aVisible+i );
+	}
+
+	constexpr CullKernels_ kAvx2Kernels_{ &cull_avx2_ };
+#	endif // ~ VMLIB_SIMD_X86
+
+#	if defined(VMLIB_SIMD_NEON)
+	inline void transpose_neon_( float32x4_t& aR0, float32x4_t& aR1, float32x4_t& aR2, float32x4_t& aR3 ) noexcept
+	{
+		float32x4x2_t const t01 = vtrnq_f32( aR0, aR1 );
+		float32x4x2_t const t23 = vtrnq_f32( aR2, aR3 );
+		aR0 = vcombine_f32( vget_low_f32( t01.val[0] ), vget_low_f32( t23.val[0] ) );
+		aR1 = vcombine_f32( vget_low_f32( t01.val[1] ), vget_low_f32( t23.val[1] ) );
+		aR2 = vcombine_f32( vget_high_f32( t01.val[0] ), vget_high_f32( t23.val[0] ) );
+		aR3 = vcombine_f32( vget_high_f32( t01.val[1] ), vget_high_f32( t23.val[1] ) );
+	}
+
+	std::size_t cull_neon_( Frustumf const& aFrustum, std::size_t aCount, Aabb3f const* aBoxes, std::uint8_t* aVisible ) noexcept
+	{
+		float32x4_t nx[6], ny[6], nz[6], d[6], ax[6], ay[6], az[6];
+		for( std::size_t p = 0; p < 6; ++p )
+		{
+			Planef const& plane = aFrustum.planes[p];
+			nx[p] = vdupq_n_f32( plane.n.x );
+			ny[p] = vdupq_n_f32( plane.n.y );
+			nz[p] = vdupq_n_f32( plane.n.z );
+			d[p] = vdupq_n_f32( plane.d );
+			ax[p] = vabsq_f32( nx[p] );
+			ay[p] = vabsq_f32( ny[p] );
+			az[p] = vabsq_f32( nz[p] );
+		}
+
+		float32x4_t const half = vdupq_n_f32( 0.5f );
+		float32x4_t const zero = vdupq_n_f32( 0.f );
+
+		std::size_t visible = 0;
+
+		std::size_t i = 0;
+		for( ; i+4 <= aCount; i += 4 )
+		{
+			float32x4_t a0 = vld1q_f32( &aBoxes[i+0].min.x );
+			float32x4_t a1 = vld1q_f32( &aBoxes[i+1].min.x );
+			float32x4_t a2 = vld1q_f32( &aBoxes[i+2].min.x );
+			float32x4_t a3 = vld1q_f32( &aBoxes[i+3].min.x );
+			transpose_neon_( a0, a1, a2, a3 );
+
+			float32x4_t b0 = vld1q_f32( &aBoxes[i+0].min.z );
+			float32x4_t b1 = vld1q_f32( &aBoxes[i+1].min.z );
+			float32x4_t b2 = vld1q_f32( &aBoxes[i+2].min.z );
+			float32x4_t b3 = vld1q_f32( &aBoxes[i+3].min.z );
+			transpose_neon_( b0, b1, b2, b3 );
+
+			float32x4_t const cx = vmulq_f32( vaddq_f32( a0, b1 ), half );
+			float32x4_t const cy = vmulq_f32( vaddq_f32( a1, b2 ), half );
+			float32x4_t const cz = vmulq_f32( vaddq_f32( a2, b3 ), half );
+			float32x4_t const ex = vmulq_f32( vsubq_f32( b1, a0 ), half );
+			float32x4_t const ey = vmulq_f32( vsubq_f32( b2, a1 ), half );
+			float32x4_t const ez = vmulq_f32( vsubq_f32( b3, a2 ), half );
+
+			uint32x4_t outside = vdupq_n_u32( 0 );
+			for( std::size_t p = 0; p < 6; ++p )
+			{
+				float32x4_t const s = vfmaq_f32( vfmaq_f32( vfmaq_f32( d[p], nz[p], cz ), ny[p], cy ), nx[p], cx );
+				float32x4_t const r = vfmaq_f32( vfmaq_f32( vmulq_f32( az[p], ez ), ay[p], ey ), ax[p], ex );
+				outside = vorrq_u32( outside, vcltq_f32( vaddq_f32( s, r ), zero ) );
+			}
+
+			int const mask = int(vgetq_lane_u32( outside, 0 ) & 1)
+				| int(vgetq_lane_u32( outside, 1 ) & 2)
+				| int(vgetq_lane_u32( outside, 2 ) & 4)
+				| int(vgetq_lane_u32( outside, 3 ) & 8)
+			;
+			visible += store_visible_( mask, 4, aVisible+i );
+		}
+
+		return visible + cull_scalar_( aFrustum, aCount-i, aBoxes+i, aVisible+i );
+	}
+
+	constexpr CullKernels_ kNeonKernels_{ &cull_neon_ };
+#	endif // ~ VMLIB_SIMD_NEON
+
+	CullKernels_ const& kernels_() noexcept
+	{
+		switch( simd_active_isa() )
+		{
+#			if defined(VMLIB_SIMD_X86)
+			case SimdIsa::sse2: return kSse2Kernels_;
+			case SimdIsa::avx2: return kAvx2Kernels_;
+#			endif
+#			if defined(VMLIB_SIMD_NEON)
+			case SimdIsa::neon: return kNeonKernels_;
+#			endif
+			default: return kScalarKernels_;
+		}
+	}
+}
+
+std::size_t frustum_cull( Frustumf const& aFrustum, std::size_t aCount, Aabb3f const* aBoxes, std::uint8_t* aVisible )
+{
+	auto const& kernels = kernels_();
+
+	std::atomic<std::size_t> visible{ 0 };
+	parallel_for( aCount, kMinPerThread_, [&] (std::size_t aBegin, std::size_t aEnd) {
+		visible += kernels.cull( aFrustum, aEnd-aBegin, aBoxes+aBegin, aVisible+aBegin );
+	} );
+	return visible;
+}
+std::size_t frustum_cull( Frustumf const& aFrustum, std::vector<Aabb3f> const& aBoxes, std::vector<std::uint8_t>& aVisible )
+{
+	aVisible.resize( aBoxes.size() );
+	return frustum_cull( aFrustum, aBoxes.size(), aBoxes.data(), aVisible.data() );
+}
@@ -0,0 +1,122 @@
+#ifndef FRUSTUM_HPP_0B8F9637_F4FB_40EE_9B7F_F447C42280FC
+#define FRUSTUM_HPP_0B8F9637_F4FB_40EE_9B7F_F447C42280FC
+
+#include <vector>
+
+#include <cmath>
+#include <cstdint>
+#include <cstddef>
+
+#include "vec3.hpp"
+#include "mat44.hpp"
+#include "bounds.hpp"
+
+/** Frustumf: view frustum as six planes
+ *
+ * The planes' normals point into the frustum and are of unit length. A
+ * frustum is extracted from a projection matrix (e.g., one returned by
+ * make_perspective_projection()) with make_frustum(). If the matrix also
+ * includes the world-to-camera transform, the planes are in world space:
+ *
+ *    Frustumf const frustum = make_frustum( projection * world2camera );
+ *    if( intersects( frustum, transform_aabb( model2world, bounds ) ) )
+ *        ... draw ...
+ *
+ * The box and sphere tests are conservative: objects outside of the frustum
+ * near its edges and corners may be reported as intersecting, but objects
+ * that intersect are never rejected.
+ */
+struct Frustumf
+{
+	enum Side
+	{
+		kLeft,
+		kRight,
+		kBottom,
+		kTop,
+		kNear,
+		kFar,
+		kSideCount
+	};
+
+	Planef planes[kSideCount];
+};
+
+// Planes from the rows of the clip matrix (G. Gribb and K. Hartmann, "Fast
+// Extraction of Viewing Frustum Planes from the World-View-Projection
+// Matrix", 2001). Uses OpenGL's clip space, -w <= z <= w.
+inline
+Frustumf make_frustum( Mat44f const& aProj ) noexcept
+{
+	auto const row = [&] (std::size_t aRow, float aSign) {
+		return normalize_plane( Planef{
+			{ aProj(3,0) + aSign*aProj(aRow,0), aProj(3,1) + aSign*aProj(aRow,1), aProj(3,2) + aSign*aProj(aRow,2) },
+			aProj(3,3) + aSign*aProj(aRow,3)
+		} );
+	};
+
+	Frustumf ret;
+	ret.planes[Frustumf::kLeft] = row( 0, +1.f );
+	ret.planes[Frustumf::kRight] = row( 0, -1.f );
+	ret.planes[Frustumf::kBottom] = row( 1, +1.f );
+	ret.planes[Frustumf::kTop] = row( 1, -1.f );
+	ret.planes[Frustumf::kNear] = row( 2, +1.f );
+	ret.planes[Frustumf::kFar] = row( 2, -1.f );
+	return ret;
+}
+
+inline
+bool intersects( Frustumf const& aFrustum, Vec3f aPoint ) noexcept
+{
+	for( auto const& plane : aFrustum.planes )
+	{
+		if( signed_distance( plane, aPoint ) < 0.f )
+			return false;
+	}
+	return true;
+}
+
+inline
+bool intersects( Frustumf const& aFrustum, Spheref const& aSphere ) noexcept
+{
+	for( auto const& plane : aFrustum.planes )
+	{
+		if( signed_distance( plane, aSphere.center ) < -aSphere.radius )
+			return false;
+	}
+	return true;
+}
+
+// A box is outside if it is entirely behind one of the planes. The distance
+// of its center is compared against the box' extent projected onto the
+// plane normal.
+inline
+bool intersects( Frustumf const& aFrustum, Aabb3f const& aBox ) noexcept
+{
+	Vec3f const c = center( aBox );
+	Vec3f const e = half_extent( aBox );
+
+	for( auto const& plane : aFrustum.planes )
+	{
+		float const r = std::abs(plane.n.x)*e.x + std::abs(plane.n.y)*e.y + std::abs(plane.n.z)*e.z;
+		if( signed_distance( plane, c ) + r < 0.f )
+			return false;
+	}
+	return true;
+}
+
+/* Batched frustum culling.
+ *
+ * Tests aCount boxes against the frustum at once, with the same result as
+ * intersects() for each of them: aVisible[i] is set to 1 if aBoxes[i]
+ * intersects the frustum and to 0 otherwise. Returns the number of visible
+ * boxes.
+ *
+ * The boxes are processed four (SSE2, NEON) or eight (AVX2) at a time, using
+ * the instruction set selected by simd.hpp. Large inputs are additionally
+ * split across multiple threads.
+ */
+std::size_t frustum_cull( Frustumf const& aFrustum, std::size_t aCount, Aabb3f const* aBoxes, std::uint8_t* aVisible );
+std::size_t frustum_cull( Frustumf const& aFrustum, std::vector<Aabb3f> const& aBoxes, std::vector<std::uint8_t>& aVisible );
+
+#endif // FRUSTUM_HPP_0B8F9637_F4FB_40EE_9B7F_F447C42280FC
@@ -13,7 +13,9 @@
  * See vec2f.hpp for discussion. Similar to the implementation, the Mat44f is
  * intentionally kept simple and somewhat bare bones.
  *
- * The matrix is stored in row-major order (careful when passing it to OpenGL).
+ * The matrix is stored in the order given by kMatrixLayout (see mat44.hpp).
+ * The storage is tightly packed (nine floats, no alignment beyond that of
+ * float), so arrays of Mat33f can be passed to glUniformMatrix3fv() as is.
  *
  * The overloaded operator () allows access to individual elements. Example:
  *    Mat33f m = ...;
@@ -26,6 +28,13 @@
  *   ⎜ 1,0  1,1  1,2  ⎟
  *   ⎝ 2,0  2,1  2,2  ⎠
  */
+// Offset of element (aI,aJ) in Mat33f::v.
+constexpr
+std::size_t mat33_index( std::size_t aI, std::size_t aJ ) noexcept
+{
+	return MatrixLayout::columnMajor == kMatrixLayout ? aJ*3 + aI : aI*3 + aJ;
+}
+
 struct Mat33f
 {
 	float v[9];
@@ -34,17 +43,31 @@ struct Mat33f
 	float& operator() (std::size_t aI, std::size_t aJ) noexcept
 	{
 		assert( aI < 3 && aJ < 3 );
-		return v[aI*3 + aJ];
+		return v[mat33_index( aI, aJ )];
 	}
 	constexpr
 	float const& operator() (std::size_t aI, std::size_t aJ) const noexcept
 	{
 		assert( aI < 3 && aJ < 3 );
-		return v[aI*3 + aJ];
+		return v[mat33_index( aI, aJ )];
 	}
 };
 
-// Identity matrix
+// Builds a Mat33f from its elements, listed row by row, independently of
+// kMatrixLayout. See mat44_from_rows().
+constexpr
+Mat33f mat33_from_rows( float const (&aRows)[9] ) noexcept
+{
+	Mat33f ret{};
+	for( std::size_t i = 0; i < 3; ++i )
+	{
+		for( std::size_t j = 0; j < 3; ++j )
+			ret(i,j) = aRows[i*3 + j];
+	}
+	return ret;
+}
+
+// Identity matrix (symmetric, so the same with either layout)
 constexpr Mat33f kIdentity33f = { {
 	1.f, 0.f, 0.f,
 	0.f, 1.f, 0.f,
@@ -56,11 +79,11 @@ constexpr Mat33f kIdentity33f = { {
 constexpr
 Vec3f operator*( Mat33f const& aLeft, Vec3f const& aRight ) noexcept
 {
-	//TODO: your implementation goes here
-	//TODO: remove the following when you start your implementation
-	(void)aLeft;   // Avoid warnings about unused arguments until the function
-	(void)aRight;  // is properly implemented.
-	return { 0.f, 0.f, 0.f };
+	return Vec3f{
+		aLeft(0,0) * aRight.x + aLeft(0,1) * aRight.y + aLeft(0,2) * aRight.z,
+		aLeft(1,0) * aRight.x + aLeft(1,1) * aRight.y + aLeft(1,2) * aRight.z,
+		aLeft(2,0) * aRight.x + aLeft(2,1) * aRight.y + aLeft(2,2) * aRight.z
+	};
 }
 
 // Functions:
@@ -76,4 +99,38 @@ Mat33f mat44_to_mat33( Mat44f const& aM )
 	return ret;
 }
 
+// Normal matrix for the model transform aM, i.e., the transposed inverse of
+// its upper 3x3 block. Same result as
+//    mat44_to_mat33( transpose( invert( aM ) ) )
+// for affine aM, but only uses the 3x3 block. The transposed inverse equals
+// the cofactor matrix divided by the determinant.
+inline
+Mat33f normal_matrix( Mat44f const& aM ) noexcept
+{
+	Mat33f ret;
+	ret(0,0) = aM(1,1)*aM(2,2) - aM(1,2)*aM(2,1);
+	ret(0,1) = aM(1,2)*aM(2,0) - aM(1,0)*aM(2,2);
+	ret(0,2) = aM(1,0)*aM(2,1) - aM(1,1)*aM(2,0);
+	ret(1,0) = aM(0,2)*aM(2,1) - aM(0,1)*aM(2,2);
+	ret(1,1) = aM(0,0)*aM(2,2) - aM(0,2)*aM(2,0);
+	ret(1,2) = aM(0,1)*aM(2,0) - aM(0,0)*aM(2,1);
+	ret(2,0) = aM(0,1)*aM(1,2) - aM(0,2)*aM(1,1);
+	ret(2,1) = aM(0,2)*aM(1,0) - aM(0,0)*aM(1,2);
+	ret(2,2) = aM(0,0)*aM(1,1) - aM(0,1)*aM(1,0);
+
+	float const invDet = 1.f / (aM(0,0)*ret(0,0) + aM(0,1)*ret(0,1) + aM(0,2)*ret(0,2));
+	for( auto& v : ret.v )
+		v *= invDet;
+
+	return ret;
+}
+
+// Normal matrix for a rigid body transform. The rotation is orthonormal, so
+// it is its own transposed inverse.
+inline
+Mat33f normal_matrix_rigid( Mat44f const& aM ) noexcept
+{
+	return mat44_to_mat33( aM );
+}
+
 #endif // MAT33_HPP_61F3107B_CBE4_48DE_9F39_EA959B4BF694
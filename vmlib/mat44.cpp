@@ -1,6 +1,5 @@
 #include "mat44.hpp"
 
-inline
 Mat44f invert( Mat44f const& aM ) noexcept
 {
 	// We could implement this with any number of methods, including Gaussian
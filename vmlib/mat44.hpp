@@ -8,9 +8,47 @@
 #include "vec3.hpp"
 #include "vec4.hpp"
 
+/** Matrix storage layout
+ *
+ * Mat44f and Mat33f are stored in row-major order by default. Defining
+ * VMLIB_MATRIX_COLUMN_MAJOR=1 switches both to column-major order, which is
+ * what OpenGL expects: matrices can then be passed to glUniformMatrix*fv()
+ * with transpose set to GL_FALSE, or copied directly into a uniform or
+ * storage buffer. The define must be the same for all translation units
+ * (premake5.lua sets it for the whole workspace).
+ *
+ * Element access via operator() works the same with either layout. Code that
+ * uses the raw array v directly must go through mat44_index() or
+ * mat33_index(), and matrices should be built with mat44_from_rows() or
+ * mat33_from_rows() instead of brace-initializing v.
+ */
+#if !defined(VMLIB_MATRIX_COLUMN_MAJOR)
+#	define VMLIB_MATRIX_COLUMN_MAJOR 0
+#endif
+
+enum class MatrixLayout
+{
+	rowMajor,
+	columnMajor
+};
+
+constexpr MatrixLayout kMatrixLayout = VMLIB_MATRIX_COLUMN_MAJOR
+	? MatrixLayout::columnMajor
+	: MatrixLayout::rowMajor
+;
+
+// Offset of element (aI,aJ) in Mat44f::v.
+constexpr
+std::size_t mat44_index( std::size_t aI, std::size_t aJ ) noexcept
+{
+	return MatrixLayout::columnMajor == kMatrixLayout ? aJ*4 + aI : aI*4 + aJ;
+}
+
 /** Mat44f: 4x4 matrix with floats
  *
- * The matrix is stored in row-major order (careful when passing it to OpenGL).
+ * The matrix is stored in the order given by kMatrixLayout (see above). The
+ * storage is 32-byte aligned, so that 128- and 256-bit loads of a row (or
+ * column) never straddle a cache line.
  *
  * The overloaded operator () allows access to individual elements. Example:
  *    Mat44f m = ...;
@@ -26,23 +64,41 @@
  */
 struct Mat44f
 {
-	float v[16];
+	alignas(32) float v[16];
 
 	constexpr
 	float& operator() (std::size_t aI, std::size_t aJ) noexcept
 	{
 		assert( aI < 4 && aJ < 4 );
-		return v[aI*4 + aJ];
+		return v[mat44_index( aI, aJ )];
 	}
 	constexpr
 	float const& operator() (std::size_t aI, std::size_t aJ) const noexcept
 	{
 		assert( aI < 4 && aJ < 4 );
-		return v[aI*4 + aJ];
+		return v[mat44_index( aI, aJ )];
 	}
 };
 
-// Identity matrix
+static_assert( sizeof(Mat44f) == 16*sizeof(float), "Mat44f must be tightly packed" );
+
+// Builds a Mat44f from its elements, listed row by row (i.e., in the order
+// the matrix is usually written down), independently of kMatrixLayout.
+constexpr
+Mat44f mat44_from_rows( float const (&aRows)[16] ) noexcept
+{
+	Mat44f ret{};
+	for( std::size_t i = 0; i < 4; ++i )
+	{
+		for( std::size_t j = 0; j < 4; ++j )
+			ret(i,j) = aRows[i*4 + j];
+	}
+	return ret;
+}
+
+// Identity matrix (symmetric, so the same with either layout). In typed
+// products (mat44_expr.hpp) it counts as a general matrix; Mat44Identity
+// folds away.
 constexpr Mat44f kIdentity44f = { {
 	1.f, 0.f, 0.f, 0.f,
 	0.f, 1.f, 0.f, 0.f,
@@ -80,6 +136,71 @@ constexpr Vec4f operator*(const Mat44f& aLeft, const Vec4f& aRight) noexcept {
 	return result;
 }
 // Functions:
+
+// True if the bottom row is (0,0,0,1), i.e., the matrix does not perform a
+// perspective transformation and w stays 1 for points.
+constexpr
+bool is_affine( Mat44f const& aM ) noexcept
+{
+	return 0.f == aM(3,0) && 0.f == aM(3,1) && 0.f == aM(3,2) && 1.f == aM(3,3);
+}
+
+// General 4x4 inverse. Defined in mat44.cpp.
+Mat44f invert( Mat44f const& aM ) noexcept;
+
+// Inverse of an affine matrix, i.e., one where is_affine() holds (rotation,
+// scaling, shearing and translation). Only the upper 3x3 block is inverted;
+// the inverse translation follows from it. Cheaper than invert().
+inline
+Mat44f invert_affine( Mat44f const& aM ) noexcept
+{
+	assert( is_affine( aM ) );
+
+	// Inverse of the 3x3 block via cofactors.
+	float const c00 = aM(1,1)*aM(2,2) - aM(1,2)*aM(2,1);
+	float const c01 = aM(1,2)*aM(2,0) - aM(1,0)*aM(2,2);
+	float const c02 = aM(1,0)*aM(2,1) - aM(1,1)*aM(2,0);
+
+	float const invDet = 1.f / (aM(0,0)*c00 + aM(0,1)*c01 + aM(0,2)*c02);
+
+	Mat44f ret = kIdentity44f;
+	ret(0,0) = c00 * invDet;
+	ret(1,0) = c01 * invDet;
+	ret(2,0) = c02 * invDet;
+	ret(0,1) = (aM(0,2)*aM(2,1) - aM(0,1)*aM(2,2)) * invDet;
+	ret(1,1) = (aM(0,0)*aM(2,2) - aM(0,2)*aM(2,0)) * invDet;
+	ret(2,1) = (aM(0,1)*aM(2,0) - aM(0,0)*aM(2,1)) * invDet;
+	ret(0,2) = (aM(0,1)*aM(1,2) - aM(0,2)*aM(1,1)) * invDet;
+	ret(1,2) = (aM(0,2)*aM(1,0) - aM(0,0)*aM(1,2)) * invDet;
+	ret(2,2) = (aM(0,0)*aM(1,1) - aM(0,1)*aM(1,0)) * invDet;
+
+	// -R^-1 t
+	for( std::size_t i = 0; i < 3; ++i )
+		ret(i,3) = -(ret(i,0)*aM(0,3) + ret(i,1)*aM(1,3) + ret(i,2)*aM(2,3));
+
+	return ret;
+}
+
+// Inverse of a rigid body transform (rotation and translation only). The
+// rotation is orthonormal, so its inverse is its transpose.
+inline
+Mat44f invert_rigid( Mat44f const& aM ) noexcept
+{
+	assert( is_affine( aM ) );
+
+	Mat44f ret = kIdentity44f;
+	for( std::size_t i = 0; i < 3; ++i )
+	{
+		for( std::size_t j = 0; j < 3; ++j )
+			ret(i,j) = aM(j,i);
+	}
+
+	for( std::size_t i = 0; i < 3; ++i )
+		ret(i,3) = -(ret(i,0)*aM(0,3) + ret(i,1)*aM(1,3) + ret(i,2)*aM(2,3));
+
+	return ret;
+}
+
 inline
 Mat44f transpose(Mat44f const& aM) noexcept
 {
@@ -97,12 +218,12 @@ Mat44f make_rotation_x(float aAngle) noexcept
 {
 	float cosA = std::cos(aAngle);
 	float sinA = std::sin(aAngle);
-	return {
+	return mat44_from_rows( {
 		1.f, 0.f, 0.f, 0.f,
 		0.f, cosA, -sinA, 0.f,
 		0.f, sinA, cosA, 0.f,
 		0.f, 0.f, 0.f, 1.f
-	};
+	} );
 
 }
 
@@ -112,12 +233,12 @@ Mat44f make_rotation_y(float aAngle) noexcept
 {
 	float cosA = std::cos(aAngle);
 	float sinA = std::sin(aAngle);
-	return {
+	return mat44_from_rows( {
 		cosA, 0.f, sinA, 0.f,
 		0.f, 1.f, 0.f, 0.f,
 		-sinA, 0.f, cosA, 0.f,
 		0.f, 0.f, 0.f, 1.f
-	};
+	} );
 }
 
 inline
@@ -125,23 +246,23 @@ Mat44f make_rotation_z(float aAngle) noexcept
 {
 	float cosA = std::cos(aAngle);
 	float sinA = std::sin(aAngle);
-	return {
+	return mat44_from_rows( {
 		cosA, -sinA, 0.f, 0.f,
 		sinA, cosA, 0.f, 0.f,
 		0.f, 0.f, 1.f, 0.f,
 		0.f, 0.f, 0.f, 1.f
-	};
+	} );
 }
 
 inline
 Mat44f make_translation(Vec3f aTranslation) noexcept
 {
-	return {
+	return mat44_from_rows( {
 		1.f, 0.f, 0.f, aTranslation[0],
 		0.f, 1.f, 0.f, aTranslation[1],
 		0.f, 0.f, 1.f, aTranslation[2],
 		0.f, 0.f, 0.f, 1.f
-	};
+	} );
 }
 
 inline
@@ -0,0 +1,400 @@
+#ifndef MAT44_EXPR_HPP_9CB8E575_2477_4D47_8247_598BAD82FEDC
+#define MAT44_EXPR_HPP_9CB8E575_2477_4D47_8247_598BAD82FEDC
+
+#include <type_traits>
+
+#include <cassert>
+#include <climits>
+#include <cstddef>
+
+#include "vec3.hpp"
+#include "mat44.hpp"
+
+/** Typed Mat44f products (opt-in)
+ *
+ * Chains such as
+ *    projection * world2camera * model2world
+ * compute a full 4x4 product (64 multiplies) per step. Most factors have far
+ * more structure than that: model and camera transforms are affine, the
+ * projection has only five non-zero elements, and identity or translation
+ * factors need no multiplies at all.
+ *
+ * This header adds matrix types that carry that structure in the type:
+ *
+ *    Mat44Identity     - the identity
+ *    Mat44Translation  - translation only
+ *    Mat44Affine       - bottom row is (0,0,0,1)
+ *    Mat44Perspective  - as returned by make_perspective_projection()
+ *
+ * Products involving at least one of these types do not compute anything
+ * immediately but build a Mat44Product expression. When the expression is
+ * converted to a Mat44f, the kinds of the factors decide at compile time
+ *  - which multiplication kernel is used (e.g., 12 multiplies for a
+ *    perspective times an affine matrix, 36 for two affine ones),
+ *  - the evaluation order, e.g., P * (V * M) instead of (P * V) * M, and
+ *  - that identity factors and translation-only prefixes fold away.
+ *
+ * Plain Mat44f operands are allowed and treated as general matrices. Products
+ * of two Mat44f still use operator* from mat44.hpp, so existing code is not
+ * affected.
+ *
+ * The kernels are chosen from the operand types alone, so kIdentity44f (a
+ * Mat44f like any other) does not fold away; it costs a general product.
+ * Changing its type would change what existing code such as
+ * "Mat44f m = kIdentity44f; m(0,3) = x;" or kIdentity44f.v means. Write
+ * Mat44Identity{} for identity factors that should fold.
+ *
+ * Example:
+ *    Mat44Perspective const proj = make_perspective_projection_expr( fov, aspect, 0.1f, 100.f );
+ *    Mat44f projCameraWorld = proj * Mat44Affine( world2camera ) * Mat44Affine( model2world );
+ *
+ * mat44_expr_cost() returns the number of multiplies an expression takes.
+ */
+
+enum class Mat44Kind
+{
+	identity,
+	translation,
+	affine,
+	perspective,
+	general
+};
+
+struct Mat44Identity
+{
+	static constexpr Mat44Kind kKind = Mat44Kind::identity;
+};
+
+struct Mat44Translation
+{
+	static constexpr Mat44Kind kKind = Mat44Kind::translation;
+
+	Vec3f t;
+};
+
+struct Mat44Affine
+{
+	static constexpr Mat44Kind kKind = Mat44Kind::affine;
+
+	// The bottom row of aM must be (0,0,0,1). It is not read.
+	constexpr explicit Mat44Affine( Mat44f const& aM ) noexcept
+		: m( aM )
+	{
+		assert( is_affine( aM ) );
+	}
+
+	Mat44f m;
+};
+
+// Non-zero elements: (0,0) = sx, (1,1) = sy, (2,2) = a, (2,3) = b and
+// (3,2) = -1.
+struct Mat44Perspective
+{
+	static constexpr Mat44Kind kKind = Mat44Kind::perspective;
+
+	float sx, sy, a, b;
+};
+
+inline
+Mat44Perspective make_perspective_projection_expr( float aFovInRadians, float aAspect, float aNear, float aFar ) noexcept
+{
+	float const s = 1.f / std::tan( aFovInRadians / 2.f );
+	float const nf = 1.f / (aFar - aNear);
+	return Mat44Perspective{ s / aAspect, s, -(aFar + aNear) * nf, -2.f * aFar * aNear * nf };
+}
+
+template< typename tLeft, typename tRight >
+struct Mat44Product;
+
+
+// Conversion of the factors to Mat44f
+constexpr
+Mat44f to_mat44( Mat44Identity ) noexcept
+{
+	return kIdentity44f;
+}
+constexpr
+Mat44f to_mat44( Mat44Translation const& aT ) noexcept
+{
+	return mat44_from_rows( {
+		1.f, 0.f, 0.f, aT.t.x,
+		0.f, 1.f, 0.f, aT.t.y,
+		0.f, 0.f, 1.f, aT.t.z,
+		0.f, 0.f, 0.f, 1.f
+	} );
+}
+constexpr
+Mat44f to_mat44( Mat44Affine const& aA ) noexcept
+{
+	Mat44f ret = aA.m;
+	ret(3,0) = ret(3,1) = ret(3,2) = 0.f;
+	ret(3,3) = 1.f;
+	return ret;
+}
+constexpr
+Mat44f to_mat44( Mat44Perspective const& aP ) noexcept
+{
+	return mat44_from_rows( {
+		aP.sx, 0.f, 0.f, 0.f,
+		0.f, aP.sy, 0.f, 0.f,
+		0.f, 0.f, aP.a, aP.b,
+		0.f, 0.f, -1.f, 0.f
+	} );
+}
+constexpr
+Mat44f const& to_mat44( Mat44f const& aM ) noexcept
+{
+	return aM;
+}
+
+
+namespace detail_mat44_expr
+{
+	template< typename tType >
+	struct IsLeaf : std::false_type {};
+
+	template<> struct IsLeaf<Mat44f> : std::true_type {};
+	template<> struct IsLeaf<Mat44Identity> : std::true_type {};
+	template<> struct IsLeaf<Mat44Translation> : std::true_type {};
+	template<> struct IsLeaf<Mat44Affine> : std::true_type {};
+	template<> struct IsLeaf<Mat44Perspective> : std::true_type {};
+
+	template< typename tType >
+	struct IsProduct : std::false_type {};
+
+	template< typename tLeft, typename tRight >
+	struct IsProduct<Mat44Product<tLeft,tRight>> : std::true_type {};
+
+	template< typename tType >
+	constexpr bool kIsExpr = IsLeaf<tType>::value || IsProduct<tType>::value;
+
+	// Only take over operator* if at least one side is not a plain Mat44f.
+	template< typename tLeft, typename tRight >
+	constexpr bool kUseExpr = kIsExpr<tLeft> && kIsExpr<tRight>
+		&& !(std::is_same_v<tLeft,Mat44f> && std::is_same_v<tRight,Mat44f>);
+
+	constexpr bool is_affine_kind( Mat44Kind aKind ) noexcept
+	{
+		return Mat44Kind::identity == aKind || Mat44Kind::translation == aKind || Mat44Kind::affine == aKind;
+	}
+
+	constexpr Mat44Kind product_kind( Mat44Kind aLeft, Mat44Kind aRight ) noexcept
+	{
+		if( Mat44Kind::identity == aLeft )
+			return aRight;
+		if( Mat44Kind::identity == aRight )
+			return aLeft;
+		if( is_affine_kind( aLeft ) && is_affine_kind( aRight ) )
+			return Mat44Kind::translation == aLeft && Mat44Kind::translation == aRight
+				? Mat44Kind::translation
+				: Mat44Kind::affine
+			;
+		return Mat44Kind::general;
+	}
+
+	// Multiplies needed by mul() below.
+	constexpr unsigned mul_cost( Mat44Kind aLeft, Mat44Kind aRight ) noexcept
+	{
+		if( Mat44Kind::identity == aLeft || Mat44Kind::identity == aRight )
+			return 0;
+		if( Mat44Kind::translation == aLeft && is_affine_kind( aRight ) )
+			return 0;
+		if( Mat44Kind::affine == aLeft && Mat44Kind::translation == aRight )
+			return 9;
+		if( Mat44Kind::affine == aLeft && Mat44Kind::affine == aRight )
+			return 36;
+		if( Mat44Kind::perspective == aLeft && Mat44Kind::translation == aRight )
+			return 3;
+		if( Mat44Kind::perspective == aLeft && Mat44Kind::affine == aRight )
+			return 12;
+		return 64;
+	}
+
+	// Kernels. Each returns the most specific type for the result.
+	constexpr Mat44Identity mul( Mat44Identity, Mat44Identity ) noexcept
+	{
+		return {};
+	}
+	template< typename tRight >
+	constexpr tRight const& mul( Mat44Identity, tRight const& aRight ) noexcept
+	{
+		return aRight;
+	}
+	template< typename tLeft >
+	constexpr tLeft const& mul( tLeft const& aLeft, Mat44Identity ) noexcept
+	{
+		return aLeft;
+	}
+
+	constexpr Mat44Translation mul( Mat44Translation const& aLeft, Mat44Translation const& aRight ) noexcept
+	{
+		return Mat44Translation{ aLeft.t + aRight.t };
+	}
+	constexpr Mat44Affine mul( Mat44Translation const& aLeft, Mat44Affine const& aRight ) noexcept
+	{
+		Mat44Affine ret = aRight;
+		ret.m(0,3) += aLeft.t.x;
+		ret.m(1,3) += aLeft.t.y;
+		ret.m(2,3) += aLeft.t.z;
+		return ret;
+	}
+	constexpr Mat44Affine mul( Mat44Affine const& aLeft, Mat44Translation const& aRight ) noexcept
+	{
+		Mat44Affine ret = aLeft;
+		for( std::size_t i = 0; i < 3; ++i )
+			ret.m(i,3) += aLeft.m(i,0)*aRight.t.x + aLeft.m(i,1)*aRight.t.y + aLeft.m(i,2)*aRight.t.z;
+		return ret;
+	}
+	constexpr Mat44Affine mul( Mat44Affine const& aLeft, Mat44Affine const& aRight ) noexcept
+	{
+		Mat44Affine ret = aLeft;
+		for( std::size_t i = 0; i < 3; ++i )
+		{
+			for( std::size_t j = 0; j < 4; ++j )
+			{
+				ret.m(i,j) = aLeft.m(i,0)*aRight.m(0,j) + aLeft.m(i,1)*aRight.m(1,j) + aLeft.m(i,2)*aRight.m(2,j);
+			}
+			ret.m(i,3) += aLeft.m(i,3);
+		}
+		return ret;
+	}
+	constexpr Mat44f mul( Mat44Perspective const& aLeft, Mat44Translation const& aRight ) noexcept
+	{
+		Mat44f ret = to_mat44( aLeft );
+		ret(0,3) = aLeft.sx * aRight.t.x;
+		ret(1,3) = aLeft.sy * aRight.t.y;
+		ret(2,3) = aLeft.a * aRight.t.z + aLeft.b;
+		ret(3,3) = -aRight.t.z;
+		return ret;
+	}
+	constexpr Mat44f mul( Mat44Perspective const& aLeft, Mat44Affine const& aRight ) noexcept
+	{
+		Mat44f ret{};
+		for( std::size_t j = 0; j < 4; ++j )
+		{
+			ret(0,j) = aLeft.sx * aRight.m(0,j);
+			ret(1,j) = aLeft.sy * aRight.m(1,j);
+			ret(2,j) = aLeft.a * aRight.m(2,j);
+			ret(3,j) = -aRight.m(2,j);
+		}
+		ret(2,3) += aLeft.b;
+		return ret;
+	}
+
+	// Everything else: full product.
+	template< typename tLeft, typename tRight >
+	constexpr Mat44f mul( tLeft const& aLeft, tRight const& aRight ) noexcept
+	{
+		return to_mat44( aLeft ) * to_mat44( aRight );
+	}
+
+
+	// Compile-time properties of an expression: the kind of its result, and
+	// the cost of evaluating it. For products of the form (A * B) * C, the
+	// cheaper of that and A * (B * C) is used.
+	template< typename tExpr >
+	struct Traits
+	{
+		static constexpr Mat44Kind kind = tExpr::kKind;
+		static constexpr unsigned cost = 0;
+		static constexpr bool reassociate = false;
+	};
+
+	template<>
+	struct Traits<Mat44f>
+	{
+		static constexpr Mat44Kind kind = Mat44Kind::general;
+		static constexpr unsigned cost = 0;
+		static constexpr bool reassociate = false;
+	};
+
+	template< typename tLeft, typename tRight >
+	struct RightAssocCost
+	{
+		static constexpr unsigned value = UINT_MAX;
+	};
+
+	template< typename tLeft, typename tRight >
+	struct Traits<Mat44Product<tLeft,tRight>>
+	{
+		static constexpr Mat44Kind kind = product_kind( Traits<tLeft>::kind, Traits<tRight>::kind );
+
+		static constexpr unsigned leftAssocCost = Traits<tLeft>::cost + Traits<tRight>::cost
+			+ mul_cost( Traits<tLeft>::kind, Traits<tRight>::kind );
+		static constexpr unsigned rightAssocCost = RightAssocCost<tLeft,tRight>::value;
+
+		static constexpr bool reassociate = rightAssocCost < leftAssocCost;
+		static constexpr unsigned cost = reassociate ? rightAssocCost : leftAssocCost;
+	};
+
+	template< typename tA, typename tB, typename tRight >
+	struct RightAssocCost<Mat44Product<tA,tB>, tRight>
+	{
+		using Inner = Mat44Product<tB,tRight>;
+		static constexpr unsigned value = Traits<tA>::cost + Traits<Inner>::cost
+			+ mul_cost( Traits<tA>::kind, Traits<Inner>::kind );
+	};
+
+
+	template< typename tExpr >
+	constexpr tExpr const& eval( tExpr const& aExpr ) noexcept
+	{
+		static_assert( IsLeaf<tExpr>::value );
+		return aExpr;
+	}
+
+	template< typename tLeft, typename tRight >
+	constexpr auto eval( Mat44Product<tLeft,tRight> const& aExpr ) noexcept
+	{
+		if constexpr( Traits<Mat44Product<tLeft,tRight>>::reassociate )
+		{
+			// (A * B) * C  ->  A * (B * C)
+			return mul(
+				eval( aExpr.left.left ),
+				eval( Mat44Product<decltype(aExpr.left.right),tRight>{ aExpr.left.right, aExpr.right } )
+			);
+		}
+		else
+		{
+			return mul( eval( aExpr.left ), eval( aExpr.right ) );
+		}
+	}
+}
+
+template< typename tLeft, typename tRight >
+struct Mat44Product
+{
+	tLeft left;
+	tRight right;
+
+	constexpr
+	operator Mat44f() const noexcept
+	{
+		return to_mat44( detail_mat44_expr::eval( *this ) );
+	}
+};
+
+template< typename tLeft, typename tRight, typename = std::enable_if_t<detail_mat44_expr::kUseExpr<tLeft,tRight>> >
+constexpr
+Mat44Product<tLeft,tRight> operator*( tLeft const& aLeft, tRight const& aRight ) noexcept
+{
+	return Mat44Product<tLeft,tRight>{ aLeft, aRight };
+}
+
+// Evaluates the expression into a Mat44f.
+template< typename tExpr, typename = std::enable_if_t<detail_mat44_expr::kIsExpr<tExpr>> >
+constexpr
+Mat44f evaluate( tExpr const& aExpr ) noexcept
+{
+	return to_mat44( detail_mat44_expr::eval( aExpr ) );
+}
+
+// Number of multiplies that evaluating the expression takes.
+template< typename tExpr >
+constexpr
+unsigned mat44_expr_cost() noexcept
+{
+	return detail_mat44_expr::Traits<tExpr>::cost;
+}
+
+#endif // MAT44_EXPR_HPP_9CB8E575_2477_4D47_8247_598BAD82FEDC
@@ -0,0 +1,524 @@
+#include "mat44_simd.hpp"
+
+namespace
+{
+	struct Mat44Kernels_
+	{
+		void (*mul)( std::size_t, Mat44f const*, Mat44f const*, Mat44f* ) noexcept;
+		void (*transform)( Mat44f const&, std::size_t, Vec4f const*, Vec4f* ) noexcept;
+		void (*transpose)( std::size_t, Mat44f const*, Mat44f* ) noexcept;
+		void (*invert)( std::size_t, Mat44f const*, Mat44f* ) noexcept;
+	};
+
+	// Scalar reference kernels. These just forward to the code in mat44.hpp
+	// and mat44.cpp.
+	void mul_scalar_( std::size_t aCount, Mat44f const* aLeft, Mat44f const* aRight, Mat44f* aOut ) noexcept
+	{
+		for( std::size_t i = 0; i < aCount; ++i )
+			aOut[i] = aLeft[i] * aRight[i];
+	}
+	void transform_scalar_( Mat44f const& aM, std::size_t aCount, Vec4f const* aIn, Vec4f* aOut ) noexcept
+	{
+		Mat44f const m = aM; // aOut might alias the matrix otherwise
+		for( std::size_t i = 0; i < aCount; ++i )
+			aOut[i] = m * aIn[i];
+	}
+	void transpose_scalar_( std::size_t aCount, Mat44f const* aIn, Mat44f* aOut ) noexcept
+	{
+		for( std::size_t i = 0; i < aCount; ++i )
+			aOut[i] = transpose( aIn[i] );
+	}
+	void invert_scalar_( std::size_t aCount, Mat44f const* aIn, Mat44f* aOut ) noexcept
+	{
+		for( std::size_t i = 0; i < aCount; ++i )
+			aOut[i] = invert( aIn[i] );
+	}
+
+	constexpr Mat44Kernels_ kScalarKernels_{ &mul_scalar_, &transform_scalar_, &transpose_scalar_, &invert_scalar_ };
+
+	// The SIMD kernels below work on the raw arrays and are written for
+	// row-major storage. With column-major storage, the arrays hold the
+	// transposed matrices instead. Transposing and inverting commute, so
+	// those kernels work unchanged. For products, (AB)^T = B^T A^T, so the
+	// operands are swapped. For the matrix-vector product, the arrays
+	// already hold the columns that the kernels would otherwise compute.
+	constexpr bool kColumnMajor_ = MatrixLayout::columnMajor == kMatrixLayout;
+
+	inline Mat44f const* mul_lhs_( Mat44f const* aLeft, Mat44f const* aRight ) noexcept
+	{
+		return kColumnMajor_ ? aRight : aLeft;
+	}
+	inline Mat44f const* mul_rhs_( Mat44f const* aLeft, Mat44f const* aRight ) noexcept
+	{
+		return kColumnMajor_ ? aLeft : aRight;
+	}
+
+#	if defined(VMLIB_SIMD_X86)
+	// SSE2 kernels. SSE2 is part of the x86-64 baseline, so these need no
+	// special compiler flags.
+	template< int tX, int tY, int tZ, int tW >
+	inline __m128 shuffle_( __m128 aA, __m128 aB ) noexcept
+	{
+		return _mm_shuffle_ps( aA, aB, _MM_SHUFFLE( tW, tZ, tY, tX ) );
+	}
+	template< int tX, int tY, int tZ, int tW >
+	inline __m128 swizzle_( __m128 aA ) noexcept
+	{
+		return _mm_castsi128_ps( _mm_shuffle_epi32( _mm_castps_si128( aA ), _MM_SHUFFLE( tW, tZ, tY, tX ) ) );
+	}
+
+	inline __m128 lincomb_( __m128 aA, __m128 aB0, __m128 aB1, __m128 aB2, __m128 aB3 ) noexcept
+	{
+		__m128 r = _mm_mul_ps( swizzle_<0,0,0,0>( aA ), aB0 );
+		r = _mm_add_ps( r, _mm_mul_ps( swizzle_<1,1,1,1>( aA ), aB1 ) );
+		r = _mm_add_ps( r, _mm_mul_ps( swizzle_<2,2,2,2>( aA ), aB2 ) );
+		r = _mm_add_ps( r, _mm_mul_ps( swizzle_<3,3,3,3>( aA ), aB3 ) );
+		return r;
+	}
+
+	void mul_sse2_( std::size_t aCount, Mat44f const* aLeft, Mat44f const* aRight, Mat44f* aOut ) noexcept
+	{
+		for( std::size_t i = 0; i < aCount; ++i )
+		{
+			float const* a = mul_lhs_( aLeft, aRight )[i].v;
+			float const* b = mul_rhs_( aLeft, aRight )[i].v;
+
+			__m128 const b0 = _mm_loadu_ps( b+0 );
+			__m128 const b1 = _mm_loadu_ps( b+4 );
+			__m128 const b2 = _mm_loadu_ps( b+8 );
+			__m128 const b3 = _mm_loadu_ps( b+12 );
+
+			// Row i of the result is a linear combination of the rows of the
+			// right hand side matrix.
+			__m128 const r0 = lincomb_( _mm_loadu_ps( a+0 ), b0, b1, b2, b3 );
+			__m128 const r1 = lincomb_( _mm_loadu_ps( a+4 ), b0, b1, b2, b3 );
+			__m128 const r2 = lincomb_( _mm_loadu_ps( a+8 ), b0, b1, b2, b3 );
+			__m128 const r3 = lincomb_( _mm_loadu_ps( a+12 ), b0, b1, b2, b3 );
+
+			float* out = aOut[i].v;
+			_mm_storeu_ps( out+0, r0 );
+			_mm_storeu_ps( out+4, r1 );
+			_mm_storeu_ps( out+8, r2 );
+			_mm_storeu_ps( out+12, r3 );
+		}
+	}
+
+	void transform_sse2_( Mat44f const& aM, std::size_t aCount, Vec4f const* aIn, Vec4f* aOut ) noexcept
+	{
+		// Transpose once (if stored row-major), so that each vector becomes a
+		// linear combination of the matrix' columns.
+		__m128 c0 = _mm_loadu_ps( aM.v+0 );
+		__m128 c1 = _mm_loadu_ps( aM.v+4 );
+		__m128 c2 = _mm_loadu_ps( aM.v+8 );
+		__m128 c3 = _mm_loadu_ps( aM.v+12 );
+		if constexpr( !kColumnMajor_ )
+			_MM_TRANSPOSE4_PS( c0, c1, c2, c3 );
+
+		for( std::size_t i = 0; i < aCount; ++i )
+		{
+			__m128 const v = _mm_loadu_ps( &aIn[i].x );
+			_mm_storeu_ps( &aOut[i].x, lincomb_( v, c0, c1, c2, c3 ) );
+		}
+	}
+
+	void transpose_sse2_( std::size_t aCount, Mat44f const* aIn, Mat44f* aOut ) noexcept
+	{
+		for( std::size_t i = 0; i < aCount; ++i )
+		{
+			__m128 r0 = _mm_loadu_ps( aIn[i].v+0 );
+			__m128 r1 = _mm_loadu_ps( aIn[i].v+4 );
+			__m128 r2 = _mm_loadu_ps( aIn[i].v+8 );
+			__m128 r3 = _mm_loadu_ps( aIn[i].v+12 );
+			_MM_TRANSPOSE4_PS( r0, r1, r2, r3 );
+			_mm_storeu_ps( aOut[i].v+0, r0 );
+			_mm_storeu_ps( aOut[i].v+4, r1 );
+			_mm_storeu_ps( aOut[i].v+8, r2 );
+			_mm_storeu_ps( aOut[i].v+12, r3 );
+		}
+	}
+
+	// Inverse via 2x2 blocks. The 4x4 matrix is split into
+	//
+	//   M = ⎛ A  B ⎞
+	//       ⎝ C  D ⎠
+	//
+	// where each 2x2 block is held in a single register as (00, 01, 10, 11).
+	// The adjugate of M can be expressed with 2x2 products of the blocks and
+	// their adjugates (A# = adj(A)):
+	//
+	//   |M| = |A||D| + |B||C| - tr((A#B)(D#C))
+	//    X# = |D|A - B(D#C),   Y# = |B|C - D(A#B)#
+	//    Z# = |C|B - A(D#C)#,  W# = |A|D - C(A#B)
+	//
+	// This is about half the work of the cofactor expansion in mat44.cpp.
+	inline __m128 mat2_mul_( __m128 aA, __m128 aB ) noexcept
+	{
+		return _mm_add_ps(
+			_mm_mul_ps( aA, swizzle_<0,3,0,3>( aB ) ),
+			_mm_mul_ps( swizzle_<1,0,3,2>( aA ), swizzle_<2,1,2,1>( aB ) )
+		);
+	}
+	inline __m128 mat2_adj_mul_( __m128 aA, __m128 aB ) noexcept
+	{
+		return _mm_sub_ps(
+			_mm_mul_ps( swizzle_<3,3,0,0>( aA ), aB ),
+			_mm_mul_ps( swizzle_<1,1,2,2>( aA ), swizzle_<2,3,0,1>( aB ) )
+		);
+	}
+	inline __m128 mat2_mul_adj_( __m128 aA, __m128 aB ) noexcept
+	{
+		return _mm_sub_ps(
+			_mm_mul_ps( aA, swizzle_<3,0,3,0>( aB ) ),
+			_mm_mul_ps( swizzle_<1,0,3,2>( aA ), swizzle_<2,1,2,1>( aB ) )
+		);
+	}
+
+	void invert_sse2_( std::size_t aCount, Mat44f const* aIn, Mat44f* aOut ) noexcept
+	{
+		for( std::size_t i = 0; i < aCount; ++i )
+		{
+			__m128 const r0 = _mm_loadu_ps( aIn[i].v+0 );
+			__m128 const r1 = _mm_loadu_ps( aIn[i].v+4 );
+			__m128 const r2 = _mm_loadu_ps( aIn[i].v+8 );
+			__m128 const r3 = _mm_loadu_ps( aIn[i].v+12 );
+
+			__m128 const A = _mm_movelh_ps( r0, r1 );
+			__m128 const B = _mm_movehl_ps( r1, r0 );
+			__m128 const C = _mm_movelh_ps( r2, r3 );
+			__m128 const D = _mm_movehl_ps( r3, r2 );
+
+			// (|A|, |B|, |C|, |D|)
+			__m128 const detSub = _mm_sub_ps(
+				_mm_mul_ps( shuffle_<0,2,0,2>( r0, r2 ), shuffle_<1,3,1,3>( r1, r3 ) ),
+				_mm_mul_ps( shuffle_<1,3,1,3>( r0, r2 ), shuffle_<0,2,0,2>( r1, r3 ) )
+			);
+			__m128 const detA = swizzle_<0,0,0,0>( detSub );
+			__m128 const detB = swizzle_<1,1,1,1>( detSub );
+			__m128 const detC = swizzle_<2,2,2,2>( detSub );
+			__m128 const detD = swizzle_<3,3,3,3>( detSub );
+
+			__m128 const D_C = mat2_adj_mul_( D, C );
+			__m128 const A_B = mat2_adj_mul_( A, B );
+
+			__m128 X_ = _mm_sub_ps( _mm_mul_ps( detD, A ), mat2_mul_( B, D_C ) );
+			__m128 W_ = _mm_sub_ps( _mm_mul_ps( detA, D ), mat2_mul_( C, A_B ) );
+			__m128 Y_ = _mm_sub_ps( _mm_mul_ps( detB, C ), mat2_mul_adj_( D, A_B ) );
+			__m128 Z_ = _mm_sub_ps( _mm_mul_ps( detC, B ), mat2_mul_adj_( A, D_C ) );
+
+			__m128 tr = _mm_mul_ps( A_B, swizzle_<0,2,1,3>( D_C ) );
+			tr = _mm_add_ps( tr, swizzle_<2,3,0,1>( tr ) );
+			tr = _mm_add_ps( tr, swizzle_<1,0,3,2>( tr ) );
+
+			__m128 detM = _mm_add_ps( _mm_mul_ps( detA, detD ), _mm_mul_ps( detB, detC ) );
+			detM = _mm_sub_ps( detM, tr );
+
+			__m128 const rcpDetM = _mm_div_ps( _mm_setr_ps( 1.f, -1.f, -1.f, 1.f ), detM );
+			X_ = _mm_mul_ps( X_, rcpDetM );
+			Y_ = _mm_mul_ps( Y_, rcpDetM );
+			Z_ = _mm_mul_ps( Z_, rcpDetM );
+			W_ = _mm_mul_ps( W_, rcpDetM );
+
+			// The final shuffles apply the outer adjugate and reassemble rows.
+			_mm_storeu_ps( aOut[i].v+0, shuffle_<3,1,3,1>( X_, Y_ ) );
+			_mm_storeu_ps( aOut[i].v+4, shuffle_<2,0,2,0>( X_, Y_ ) );
+			_mm_storeu_ps( aOut[i].v+8, shuffle_<3,1,3,1>( Z_, W_ ) );
+			_mm_storeu_ps( aOut[i].v+12, shuffle_<2,0,2,0>( Z_, W_ ) );
+		}
+	}
+
+	constexpr Mat44Kernels_ kSse2Kernels_{ &mul_sse2_, &transform_sse2_, &transpose_sse2_, &invert_sse2_ };
+
+	// AVX2 kernels. These process two rows (mul) or two vectors (transform)
+	// per 256-bit register. All shuffles stay within 128-bit lanes, which is
+	// where AVX is fast. Transposes are load/store bound, so the SSE2 version
+	// is used for those.
+	VMLIB_TARGET_AVX2
+	inline __m256 dup128_( __m128 aA ) noexcept
+	{
+		return _mm256_insertf128_ps( _mm256_castps128_ps256( aA ), aA, 1 );
+	}
+
+	VMLIB_TARGET_AVX2
+	inline __m256 lincomb2_( __m256 aA, __m256 aB0, __m256 aB1, __m256 aB2, __m256 aB3 ) noexcept
+	{
+		__m256 r = _mm256_mul_ps( _mm256_permute_ps( aA, 0x00 ), aB0 );
+		r = _mm256_fmadd_ps( _mm256_permute_ps( aA, 0x55 ), aB1, r );
+		r = _mm256_fmadd_ps( _mm256_permute_ps( aA, 0xaa ), aB2, r );
+		r = _mm256_fmadd_ps( _mm256_permute_ps( aA, 0xff ), aB3, r );
+		return r;
+	}
+
+	VMLIB_TARGET_AVX2
+	void mul_avx2_( std::size_t aCount, Mat44f const* aLeft, Mat44f const* aRight, Mat44f* aOut ) noexcept
+	{
+		for( std::size_t i = 0; i < aCount; ++i )
+		{
+			float const* a = mul_lhs_( aLeft, aRight )[i].v;
+			float const* b = mul_rhs_( aLeft, aRight )[i].v;
+
+			__m256 const b0 = _mm256_broadcast_ps( reinterpret_cast<__m128 const*>(b+0) );
+			__m256 const b1 = _mm256_broadcast_ps( reinterpret_cast<__m128 const*>(b+4) );
+			__m256 const b2 = _mm256_broadcast_ps( reinterpret_cast<__m128 const*>(b+8) );
+			__m256 const b3 = _mm256_broadcast_ps( reinterpret_cast<__m128 const*>(b+12) );
+
+			__m256 const r01 = lincomb2_( _mm256_loadu_ps( a+0 ), b0, b1, b2, b3 );
+			__m256 const r23 = lincomb2_( _mm256_loadu_ps( a+8 ), b0, b1, b2, b3 );
+
+			_mm256_storeu_ps( aOut[i].v+0, r01 );
+			_mm256_storeu_ps( aOut[i].v+8, r23 );
+		}
+	}
+
+	VMLIB_TARGET_AVX2
+	void transform_avx2_( Mat44f const& aM, std::size_t aCount, Vec4f const* aIn, Vec4f* aOut ) noexcept
+	{
+		__m128 c0 = _mm_loadu_ps( aM.v+0 );
+		__m128 c1 = _mm_loadu_ps( aM.v+4 );
+		__m128 c2 = _mm_loadu_ps( aM.v+8 );
+		__m128 c3 = _mm_loadu_ps( aM.v+12 );
+		if constexpr( !kColumnMajor_ )
+			_MM_TRANSPOSE4_PS( c0, c1, c2, c3 );
+
+		__m256 const cc0 = dup128_( c0 );
+		__m256 const cc1 = dup128_( c1 );
+		__m256 const cc2 = dup128_( c2 );
+		__m256 const cc3 = dup128_( c3 );
+
+		std::size_t i = 0;
+		for( ; i+2 <= aCount; i += 2 )
+		{
+			__m256 const v = _mm256_loadu_ps( &aIn[i].x );
+			_mm256_storeu_ps( &aOut[i].x, lincomb2_( v, cc0, cc1, cc2, cc3 ) );
+		}
+		if( i < aCount )
+		{
+			__m128 const v = _mm_loadu_ps( &aIn[i].x );
+			_mm_storeu_ps( &aOut[i].x, lincomb_( v, c0, c1, c2, c3 ) );
+		}
+	}
+
+	template< int tX, int tY, int tZ, int tW > VMLIB_TARGET_AVX2
+	inline __m256 shuffle2_( __m256 aA, __m256 aB ) noexcept
+	{
+		return _mm256_shuffle_ps( aA, aB, _MM_SHUFFLE( tW, tZ, tY, tX ) );
+	}
+	template< int tX, int tY, int tZ, int tW > VMLIB_TARGET_AVX2
+	inline __m256 swizzle2_( __m256 aA ) noexcept
+	{
+		return _mm256_permute_ps( aA, _MM_SHUFFLE( tW, tZ, tY, tX ) );
+	}
+
+	VMLIB_TARGET_AVX2
+	inline __m256 mat2_mul2_( __m256 aA, __m256 aB ) noexcept
+	{
+		return _mm256_fmadd_ps( aA, swizzle2_<0,3,0,3>( aB ),
+			_mm256_mul_ps( swizzle2_<1,0,3,2>( aA ), swizzle2_<2,1,2,1>( aB ) )
+		);
+	}
+	VMLIB_TARGET_AVX2
+	inline __m256 mat2_adj_mul2_( __m256 aA, __m256 aB ) noexcept
+	{
+		return _mm256_fmsub_ps( swizzle2_<3,3,0,0>( aA ), aB,
+			_mm256_mul_ps( swizzle2_<1,1,2,2>( aA ), swizzle2_<2,3,0,1>( aB ) )
+		);
+	}
+	VMLIB_TARGET_AVX2
+	inline __m256 mat2_mul_adj2_( __m256 aA, __m256 aB ) noexcept
+	{
+		return _mm256_fmsub_ps( aA, swizzle2_<3,0,3,0>( aB ),
+			_mm256_mul_ps( swizzle2_<1,0,3,2>( aA ), swizzle2_<2,1,2,1>( aB ) )
+		);
+	}
+
+	VMLIB_TARGET_AVX2
+	inline __m256 load_rows2_( Mat44f const& aM, Mat44f const& aN, std::size_t aRow ) noexcept
+	{
+		return _mm256_insertf128_ps(
+			_mm256_castps128_ps256( _mm_loadu_ps( aM.v + 4*aRow ) ),
+			_mm_loadu_ps( aN.v + 4*aRow ),
+			1
+		);
+	}
+	VMLIB_TARGET_AVX2
+	inline void store_rows2_( Mat44f& aM, Mat44f& aN, std::size_t aRow, __m256 aV ) noexcept
+	{
+		_mm_storeu_ps( aM.v + 4*aRow, _mm256_castps256_ps128( aV ) );
+		_mm_storeu_ps( aN.v + 4*aRow, _mm256_extractf128_ps( aV, 1 ) );
+	}
+
+	// Same algorithm as invert_sse2_(), but inverts two matrices at a time
+	// (one per 128-bit lane).
+	VMLIB_TARGET_AVX2
+	void invert_avx2_( std::size_t aCount, Mat44f const* aIn, Mat44f* aOut ) noexcept
+	{
+		std::size_t i = 0;
+		for( ; i+2 <= aCount; i += 2 )
+		{
+			__m256 const r0 = load_rows2_( aIn[i], aIn[i+1], 0 );
+			__m256 const r1 = load_rows2_( aIn[i], aIn[i+1], 1 );
+			__m256 const r2 = load_rows2_( aIn[i], aIn[i+1], 2 );
+			__m256 const r3 = load_rows2_( aIn[i], aIn[i+1], 3 );
+
+			__m256 const A = shuffle2_<0,1,0,1>( r0, r1 );
+			__m256 const B = shuffle2_<2,3,2,3>( r0, r1 );
+			__m256 const C = shuffle2_<0,1,0,1>( r2, r3 );
+			__m256 const D = shuffle2_<2,3,2,3>( r2, r3 );
+
+			__m256 const detSub = _mm256_fmsub_ps(
+				shuffle2_<0,2,0,2>( r0, r2 ), shuffle2_<1,3,1,3>( r1, r3 ),
+				_mm256_mul_ps( shuffle2_<1,3,1,3>( r0, r2 ), shuffle2_<0,2,0,2>( r1, r3 ) )
+			);
+			__m256 const detA = swizzle2_<0,0,0,0>( detSub );
+			__m256 const detB = swizzle2_<1,1,1,1>( detSub );
+			__m256 const detC = swizzle2_<2,2,2,2>( detSub );
+			__m256 const detD = swizzle2_<3,3,3,3>( detSub );
+
+			__m256 const D_C = mat2_adj_mul2_( D, C );
+			__m256 const A_B = mat2_adj_mul2_( A, B );
+
+			__m256 X_ = _mm256_fmsub_ps( detD, A, mat2_mul2_( B, D_C ) );
+			__m256 W_ = _mm256_fmsub_ps( detA, D, mat2_mul2_( C, A_B ) );
+			__m256 Y_ = _mm256_fmsub_ps( detB, C, mat2_mul_adj2_( D, A_B ) );
+			__m256 Z_ = _mm256_fmsub_ps( detC, B, mat2_mul_adj2_( A, D_C ) );
+
+			__m256 tr = _mm256_mul_ps( A_B, swizzle2_<0,2,1,3>( D_C ) );
+			tr = _mm256_add_ps( tr, swizzle2_<2,3,0,1>( tr ) );
+			tr = _mm256_add_ps( tr, swizzle2_<1,0,3,2>( tr ) );
+
+			__m256 detM = _mm256_fmadd_ps( detA, detD, _mm256_mul_ps( detB, detC ) );
+			detM = _mm256_sub_ps( detM, tr );
+
+			__m256 const rcpDetM = _mm256_div_ps( _mm256_setr_ps( 1.f, -1.f, -1.f, 1.f, 1.f, -1.f, -1.f, 1.f ), detM );
+			X_ = _mm256_mul_ps( X_, rcpDetM );
+			Y_ = _mm256_mul_ps( Y_, rcpDetM );
+			Z_ = _mm256_mul_ps( Z_, rcpDetM );
+			W_ = _mm256_mul_ps( W_, rcpDetM );
+
+			store_rows2_( aOut[i], aOut[i+1], 0, shuffle2_<3,1,3,1>( X_, Y_ ) );
+			store_rows2_( aOut[i], aOut[i+1], 1, shuffle2_<2,0,2,0>( X_, Y_ ) );
+			store_rows2_( aOut[i], aOut[i+1], 2, shuffle2_<3,1,3,1>( Z_, W_ ) );
+			store_rows2_( aOut[i], aOut[i+1], 3, shuffle2_<2,0,2,0>( Z_, W_ ) );
+		}
+
+		if( i < aCount )
+			invert_sse2_( aCount-i, aIn+i, aOut+i );
+	}
+
+	constexpr Mat44Kernels_ kAvx2Kernels_{ &mul_avx2_, &transform_avx2_, &transpose_sse2_, &invert_avx2_ };
+#	endif // ~ VMLIB_SIMD_X86
+
+#	if defined(VMLIB_SIMD_NEON)
+	// NEON kernels (AArch64). NEON has no cheap equivalent to the shuffles
+	// used by the block inverse, so invert() uses the scalar code.
+	inline float32x4_t lincomb_neon_( float32x4_t aA, float32x4_t aB0, float32x4_t aB1, float32x4_t aB2, float32x4_t aB3 ) noexcept
+	{
+		float32x4_t r = vmulq_laneq_f32( aB0, aA, 0 );
+		r = vfmaq_laneq_f32( r, aB1, aA, 1 );
+		r = vfmaq_laneq_f32( r, aB2, aA, 2 );
+		r = vfmaq_laneq_f32( r, aB3, aA, 3 );
+		return r;
+	}
+
+	void mul_neon_( std::size_t aCount, Mat44f const* aLeft, Mat44f const* aRight, Mat44f* aOut ) noexcept
+	{
+		for( std::size_t i = 0; i < aCount; ++i )
+		{
+			float32x4x4_t const a = vld1q_f32_x4( mul_lhs_( aLeft, aRight )[i].v );
+			float32x4x4_t const b = vld1q_f32_x4( mul_rhs_( aLeft, aRight )[i].v );
+
+			float32x4x4_t r;
+			r.val[0] = lincomb_neon_( a.val[0], b.val[0], b.val[1], b.val[2], b.val[3] );
+			r.val[1] = lincomb_neon_( a.val[1], b.val[0], b.val[1], b.val[2], b.val[3] );
+			r.val[2] = lincomb_neon_( a.val[2], b.val[0], b.val[1], b.val[2], b.val[3] );
+			r.val[3] = lincomb_neon_( a.val[3], b.val[0], b.val[1], b.val[2], b.val[3] );
+			vst1q_f32_x4( aOut[i].v, r );
+		}
+	}
+
+	void transform_neon_( Mat44f const& aM, std::size_t aCount, Vec4f const* aIn, Vec4f* aOut ) noexcept
+	{
+		// vld4q de-interleaves, which yields the columns of a row-major matrix.
+		// Column-major matrices are loaded as-is.
+		float32x4x4_t const c = kColumnMajor_ ? vld1q_f32_x4( aM.v ) : vld4q_f32( aM.v );
+		for( std::size_t i = 0; i < aCount; ++i )
+		{
+			float32x4_t const v = vld1q_f32( &aIn[i].x );
+			vst1q_f32( &aOut[i].x, lincomb_neon_( v, c.val[0], c.val[1], c.val[2], c.val[3] ) );
+		}
+	}
+
+	void transpose_neon_( std::size_t aCount, Mat44f const* aIn, Mat44f* aOut ) noexcept
+	{
+		for( std::size_t i = 0; i < aCount; ++i )
+		{
+			float32x4x4_t const c = vld4q_f32( aIn[i].v );
+			vst1q_f32_x4( aOut[i].v, c );
+		}
+	}
+
+	constexpr Mat44Kernels_ kNeonKernels_{ &mul_neon_, &transform_neon_, &transpose_neon_, &invert_scalar_ };
+#	endif // ~ VMLIB_SIMD_NEON
+
+	Mat44Kernels_ const& kernels_() noexcept
+	{
+		switch( simd_active_isa() )
+		{
+#			if defined(VMLIB_SIMD_X86)
+			case SimdIsa::sse2: return kSse2Kernels_;
+			case SimdIsa::avx2: return kAvx2Kernels_;
+#			endif
+#			if defined(VMLIB_SIMD_NEON)
+			case SimdIsa::neon: return kNeonKernels_;
+#			endif
+			default: return kScalarKernels_;
+		}
+	}
+}
+
+Mat44f mat44_mul( Mat44f const& aLeft, Mat44f const& aRight ) noexcept
+{
+	Mat44f ret;
+	kernels_().mul( 1, &aLeft, &aRight, &ret );
+	return ret;
+}
+
+Vec4f mat44_transform( Mat44f const& aLeft, Vec4f const& aRight ) noexcept
+{
+	Vec4f ret;
+	kernels_().transform( aLeft, 1, &aRight, &ret );
+	return ret;
+}
+
+Mat44f mat44_transpose( Mat44f const& aM ) noexcept
+{
+	Mat44f ret;
+	kernels_().transpose( 1, &aM, &ret );
+	return ret;
+}
+
+Mat44f mat44_invert( Mat44f const& aM ) noexcept
+{
+	Mat44f ret;
+	kernels_().invert( 1, &aM, &ret );
+	return ret;
+}
+
+void mat44_mul_n( std::size_t aCount, Mat44f const* aLeft, Mat44f const* aRight, Mat44f* aOut ) noexcept
+{
+	kernels_().mul( aCount, aLeft, aRight, aOut );
+}
+
+void mat44_transform_n( Mat44f const& aM, std::size_t aCount, Vec4f const* aIn, Vec4f* aOut ) noexcept
+{
+	kernels_().transform( aM, aCount, aIn, aOut );
+}
+
+void mat44_transpose_n( std::size_t aCount, Mat44f const* aIn, Mat44f* aOut ) noexcept
+{
+	kernels_().transpose( aCount, aIn, aOut );
+}
+
+void mat44_invert_n( std::size_t aCount, Mat44f const* aIn, Mat44f* aOut ) noexcept
+{
+	kernels_().invert( aCount, aIn, aOut );
+}
@@ -0,0 +1,33 @@
+#ifndef MAT44_SIMD_HPP_8DABE1A1_F412_4104_A5A6_010A2D140766
+#define MAT44_SIMD_HPP_8DABE1A1_F412_4104_A5A6_010A2D140766
+
+#include <cstddef>
+
+#include "vec4.hpp"
+#include "mat44.hpp"
+#include "simd.hpp"
+
+/* SIMD versions of the Mat44f kernels.
+ *
+ * These compute the same results as operator*, transpose() and invert() from
+ * mat44.hpp (up to floating point rounding), but use SSE2, AVX2 or NEON
+ * depending on what simd_active_isa() returns. The scalar code is always
+ * available as a fallback.
+ *
+ * The plain operators stay constexpr and scalar; use these in places where
+ * many matrices are processed. The _n variants work on arrays and amortize
+ * the dispatch, e.g., mat44_mul_n() computes aOut[i] = aLeft[i] * aRight[i].
+ * Output arrays may alias the corresponding input arrays.
+ */
+
+Mat44f mat44_mul( Mat44f const& aLeft, Mat44f const& aRight ) noexcept;
+Vec4f mat44_transform( Mat44f const& aLeft, Vec4f const& aRight ) noexcept;
+Mat44f mat44_transpose( Mat44f const& aM ) noexcept;
+Mat44f mat44_invert( Mat44f const& aM ) noexcept;
+
+void mat44_mul_n( std::size_t aCount, Mat44f const* aLeft, Mat44f const* aRight, Mat44f* aOut ) noexcept;
+void mat44_transform_n( Mat44f const& aM, std::size_t aCount, Vec4f const* aIn, Vec4f* aOut ) noexcept;
+void mat44_transpose_n( std::size_t aCount, Mat44f const* aIn, Mat44f* aOut ) noexcept;
+void mat44_invert_n( std::size_t aCount, Mat44f const* aIn, Mat44f* aOut ) noexcept;
+
+#endif // MAT44_SIMD_HPP_8DABE1A1_F412_4104_A5A6_010A2D140766
@@ -0,0 +1,602 @@
+#include "mesh_optimize.hpp"
+
+#include <limits>
+#include <vector>
+#include <numeric>
+#include <algorithm>
+
+#include <cmath>
+#include <cassert>
+
+#include "bounds.hpp"
+#include "parallel.hpp"
+
+namespace
+{
+	// Vertex cache optimization (Forsyth)
+	//
+	// Scoring parameters from the original article. Vertices in the three
+	// most recently used cache slots get a fixed score (the triangle they
+	// were used by was just emitted, so using them again gives no benefit
+	// over the rest of the cache with strip-like orders), the remaining slots
+	// decay with their position. Vertices with few remaining triangles get a
+	// boost, so that isolated triangles are not left behind.
+	constexpr std::size_t kLruCacheSize_ = 32;
+	constexpr float kCacheDecayPower_ = 1.5f;
+	constexpr float kLastTriangleScore_ = 0.75f;
+	constexpr float kValenceBoostScale_ = 2.f;
+	constexpr float kValenceBoostPower_ = 0.5f;
+
+	constexpr std::uint32_t kNoTriangle_ = ~std::uint32_t(0);
+
+	class VertexScores_
+	{
+		public:
+			VertexScores_()
+			{
+				mCache[0] = 0.f; // not in cache
+				for( std::size_t i = 0; i < kLruCacheSize_; ++i )
+				{
+					if( i < 3 )
+						mCache[i+1] = kLastTriangleScore_;
+					else
+					{
+						float const scale = 1.f / (kLruCacheSize_ - 3);
+						mCache[i+1] = std::pow( 1.f - (i - 3) * scale, kCacheDecayPower_ );
+					}
+				}
+
+				mValence[0] = 0.f; // unused, see operator()
+				for( std::size_t i = 1; i < kValenceTableSize; ++i )
+					mValence[i] = kValenceBoostScale_ * std::pow( float(i), -kValenceBoostPower_ );
+			}
+
+			// aCachePosition is -1 for vertices that are not in the cache.
+			float operator()( int aCachePosition, std::uint32_t aRemaining ) const noexcept
+			{
+				// Vertices without remaining triangles are never looked at
+				// again; their score does not matter.
+				if( 0 == aRemaining )
+					return -1.f;
+
+				float const valence = aRemaining < kValenceTableSize
+					? mValence[aRemaining]
+					: kValenceBoostScale_ * std::pow( float(aRemaining), -kValenceBoostPower_ )
+				;
+				return mCache[aCachePosition+1] + valence;
+			}
+
+		private:
+			static constexpr std::size_t kValenceTableSize = 64;
+
+			float mCache[kLruCacheSize_+1];
+			float mValence[kValenceTableSize];
+	};
+
+	// FIFO cache simulation. A vertex is in the cache if fewer than aCacheSize
+	// misses have happened since it was last loaded; reset() evicts
+	// everything by advancing the clock past the cache size.
+	class FifoCache_
+	{
+		public:
+			FifoCache_( std::size_t aVertexCount, std::size_t aCacheSize )
+				: mCacheSize( aCacheSize )
+				, mTime( aCacheSize + 1 )
+				, mLoadedAt( aVertexCount, 0 )
+			{}
+
+			// Returns true on a cache miss.
+			bool access( std::uint32_t aVertex ) noexcept
+			{
+				if( mTime - mLoadedAt[aVertex] <= mCacheSize )
+					return false;
+
+				mLoadedAt[aVertex] = mTime++;
+				return true;
+			}
+
+			unsigned access_triangle( std::uint32_t const* aTriangle ) noexcept
+			{
+				return unsigned(access( aTriangle[0] ))
+					+ unsigned(access( aTriangle[1] ))
+					+ unsigned(access( aTriangle[2] ))
+				;
+			}
+
+			void reset() noexcept
+			{
+				mTime += mCacheSize + 1;
+			}
+
+		private:
+			std::size_t mCacheSize;
+			std::size_t mTime;
+			std::vector<std::size_t> mLoadedAt;
+	};
+
+	// Overdraw optimization
+	constexpr std::size_t kFifoCacheSize_ = 16;
+
+	// Splits the triangles into clusters: at every triangle whose three
+	// vertices all miss the cache (the optimized order "restarted" there),
+	// and then within each of those clusters wherever the ACMR up to that
+	// point is within aThreshold of the cluster's ACMR. Returns the first
+	// triangle of each cluster followed by aTriangleCount.
+	std::vector<std::size_t> find_clusters_( std::size_t aTriangleCount, std::uint32_t const* aIndices, std::size_t aVertexCount, float aThreshold )
+	{
+		std::vector<std::size_t> hard;
+		FifoCache_ cache( aVertexCount, kFifoCacheSize_ );
+		for( std::size_t i = 0; i < aTriangleCount; ++i )
+		{
+			unsigned const misses = cache.access_triangle( aIndices + 3*i );
+			if( 0 == i || 3 == misses )
+				hard.emplace_back( i );
+		}
+		hard.emplace_back( aTriangleCount );
+
+		std::vector<std::size_t> ret;
+		for( std::size_t c = 0; c+1 < hard.size(); ++c )
+		{
+			std::size_t const begin = hard[c], end = hard[c+1];
+
+			cache.reset();
+			std::size_t clusterMisses = 0;
+			for( std::size_t i = begin; i < end; ++i )
+				clusterMisses += cache.access_triangle( aIndices + 3*i );
+
+			float const limit = aThreshold * float(clusterMisses) / float(end - begin);
+
+			ret.emplace_back( begin );
+
+			cache.reset();
+			std::size_t misses = 0, count = 0;
+			for( std::size_t i = begin; i < end; ++i )
+			{
+				misses += cache.access_triangle( aIndices + 3*i );
+				++count;
+
+				if( i+1 < end && float(misses) <= limit * float(count) )
+				{
+					ret.emplace_back( i+1 );
+					cache.reset();
+					misses = count = 0;
+				}
+			}
+		}
+
+		ret.emplace_back( aTriangleCount );
+		return ret;
+	}
+
+	// Overdraw analysis
+	//
+	// Edge function of the edge aA -> aB at aP: positive if aP is to its
+	// left. It is computed from the endpoints in a fixed order, so that the
+	// edge aB -> aA gives exactly the negated value, and a pixel center on an
+	// edge shared by two triangles is inside exactly one of them (see
+	// owns_edge_()).
+	struct Point2_
+	{
+		float x, y;
+	};
+
+	float edge_( Point2_ aA, Point2_ aB, Point2_ aP ) noexcept
+	{
+		bool const swapped = aB.x < aA.x || (aB.x == aA.x && aB.y < aA.y);
+		if( swapped )
+			std::swap( aA, aB );
+
+		float const e = (aB.x - aA.x) * (aP.y - aA.y) - (aB.y - aA.y) * (aP.x - aA.x);
+		return swapped ? -e : e;
+	}
+
+	bool owns_edge_( Point2_ aA, Point2_ aB ) noexcept
+	{
+		return aB.y < aA.y || (aB.y == aA.y && aB.x > aA.x);
+	}
+
+	struct OverdrawView_
+	{
+		std::size_t covered;
+		std::size_t shaded;
+	};
+
+	// Rasterizes the triangles looking along axis aAxis, from the positive
+	// (aFromPositive) or the negative end of aBounds. The image plane is
+	// spanned by the other two axes, in cyclic order, so that triangles
+	// that face the viewer are counter-clockwise in it when viewed from the
+	// positive end.
+	OverdrawView_ rasterize_view_( std::size_t aIndexCount, std::uint32_t const* aIndices, Vec3f const* aPositions, Aabb3f const& aBounds, std::size_t aAxis, bool aFromPositive, std::size_t aResolution )
+	{
+		std::size_t const u = (aAxis+1) % 3, v = (aAxis+2) % 3;
+
+		float const extent = std::max( aBounds.max[u] - aBounds.min[u], aBounds.max[v] - aBounds.min[v] );
+		if( !(extent > 0.f) )
+			return {};
+
+		float const scale = float(aResolution) / extent;
+		auto const pixels_ = [&] (std::size_t aI) {
+			float const size = std::ceil( (aBounds.max[aI] - aBounds.min[aI]) * scale );
+			return std::clamp<std::size_t>( std::size_t(size), 1, aResolution );
+		};
+		std::size_t const width = pixels_( u ), height = pixels_( v );
+
+		std::vector<float> depth( width*height, std::numeric_limits<float>::infinity() );
+		OverdrawView_ ret{};
+
+		for( std::size_t i = 0; i+2 < aIndexCount; i += 3 )
+		{
+			Point2_ p[3];
+			float z[3];
+			for( std::size_t k = 0; k < 3; ++k )
+			{
+				Vec3f const& pos = aPositions[aIndices[i+k]];
+				p[k] = Point2_{ (pos[u] - aBounds.min[u]) * scale, (pos[v] - aBounds.min[v]) * scale };
+				z[k] = aFromPositive ? aBounds.max[aAxis] - pos[aAxis] : pos[aAxis] - aBounds.min[aAxis];
+			}
+
+			// Back faces and triangles seen edge-on are culled. Viewed from
+			// the negative end, the image is mirrored, so front faces are
+			// clockwise; they are flipped to keep the edge functions positive
+			// inside.
+			float area = edge_( p[0], p[1], p[2] );
+			if( !aFromPositive )
+			{
+				area = -area;
+				std::swap( p[1], p[2] );
+				std::swap( z[1], z[2] );
+			}
+			if( !(area > 0.f) )
+				continue;
+
+			// Pixel centers (x+0.5, y+0.5) within the triangle's bounds
+			auto const first_ = [] (float aMin) {
+				return std::size_t(std::max( 0.f, std::ceil( aMin - 0.5f ) ));
+			};
+			auto const last_ = [] (float aMax, std::size_t aSize) {
+				return std::size_t(std::clamp( std::floor( aMax - 0.5f ) + 1.f, 0.f, float(aSize) ));
+			};
+			std::size_t const x0 = first_( std::min( { p[0].x, p[1].x, p[2].x } ) );
+			std::size_t const x1 = last_( std::max( { p[0].x, p[1].x, p[2].x } ), width );
+			std::size_t const y0 = first_( std::min( { p[0].y, p[1].y, p[2].y } ) );
+			std::size_t const y1 = last_( std::max( { p[0].y, p[1].y, p[2].y } ), height );
+
+			bool const owns0 = owns_edge_( p[1], p[2] );
+			bool const owns1 = owns_edge_( p[2], p[0] );
+			bool const owns2 = owns_edge_( p[0], p[1] );
+
+			for( std::size_t y = y0; y < y1; ++y )
+			{
+				for( std::size_t x = x0; x < x1; ++x )
+				{
+					Point2_ const c{ float(x) + 0.5f, float(y) + 0.5f };
+					float const w0 = edge_( p[1], p[2], c );
+					float const w1 = edge_( p[2], p[0], c );
+					float const w2 = edge_( p[0], p[1], c );
+
+					if( w0 < 0.f || w1 < 0.f || w2 < 0.f )
+						continue;
+					if( (0.f == w0 && !owns0) || (0.f == w1 && !owns1) || (0.f == w2 && !owns2) )
+						continue;
+
+					float const d = (w0 * z[0] + w1 * z[1] + w2 * z[2]) / area;
+					float& stored = depth[y*width + x];
+					if( d < stored )
+					{
+						if( std::isinf( stored ) )
+							++ret.covered;
+
+						stored = d;
+						++ret.shaded;
+					}
+				}
+			}
+		}
+
+		return ret;
+	}
+}
+
+VertexCacheStatistics analyze_vertex_cache( std::size_t aIndexCount, std::uint32_t const* aIndices, std::size_t aVertexCount, std::size_t aCacheSize )
+{
+	assert( 0 == aIndexCount % 3 );
+	assert( aCacheSize > 0 );
+
+	VertexCacheStatistics ret{};
+
+	FifoCache_ cache( aVertexCount, aCacheSize );
+	std::vector<bool> used( aVertexCount, false );
+	std::size_t unique = 0;
+
+	for( std::size_t i = 0; i < aIndexCount; ++i )
+	{
+		std::uint32_t const v = aIndices[i];
+		assert( v < aVertexCount );
+
+		if( cache.access( v ) )
+			++ret.transformedVertices;
+
+		if( !used[v] )
+		{
+			used[v] = true;
+			++unique;
+		}
+	}
+
+	if( aIndexCount )
+		ret.acmr = float(ret.transformedVertices) / float(aIndexCount / 3);
+	if( unique )
+		ret.atvr = float(ret.transformedVertices) / float(unique);
+
+	return ret;
+}
+
+OverdrawStatistics analyze_overdraw( std::size_t aIndexCount, std::uint32_t const* aIndices, std::size_t aVertexCount, Vec3f const* aPositions, std::size_t aResolution )
+{
+	assert( 0 == aIndexCount % 3 );
+	assert( aResolution > 0 );
+
+	OverdrawStatistics ret{};
+	if( 0 == aIndexCount )
+		return ret;
+
+	Aabb3f const bounds = make_aabb( aVertexCount, aPositions );
+
+	// One view per thread: each scans all triangles, but has its own depth
+	// buffer.
+	OverdrawView_ views[6];
+	parallel_for( 6, 1, [&] (std::size_t aBegin, std::size_t aEnd) {
+		for( std::size_t i = aBegin; i < aEnd; ++i )
+			views[i] = rasterize_view_( aIndexCount, aIndices, aPositions, bounds, i / 2, 0 == i % 2, aResolution );
+	} );
+
+	for( auto const& view : views )
+	{
+		ret.pixelsCovered += view.covered;
+		ret.pixelsShaded += view.shaded;
+	}
+
+	if( ret.pixelsCovered )
+		ret.overdraw = float(ret.pixelsShaded) / float(ret.pixelsCovered);
+
+	return ret;
+}
+
+void optimize_vertex_cache( std::size_t aIndexCount, std::uint32_t const* aIndices, std::size_t aVertexCount, std::uint32_t* aOut )
+{
+	assert( 0 == aIndexCount % 3 );
+
+	std::size_t const triangleCount = aIndexCount / 3;
+	if( 0 == triangleCount )
+		return;
+
+	// Copy the input, so that aOut may alias aIndices.
+	std::vector<std::uint32_t> const indices( aIndices, aIndices + aIndexCount );
+
+	// Vertex -> triangle adjacency. The first remaining[v] entries of each
+	// vertex' range are the triangles that have not been emitted yet.
+	std::vector<std::uint32_t> remaining( aVertexCount, 0 );
+	for( auto const v : indices )
+	{
+		assert( v < aVertexCount );
+		++remaining[v];
+	}
+
+	std::vector<std::size_t> offsets( aVertexCount + 1, 0 );
+	std::partial_sum( remaining.begin(), remaining.end(), offsets.begin() + 1 );
+
+	std::vector<std::uint32_t> adjacency( aIndexCount );
+	{
+		std::vector<std::size_t> fill( offsets.begin(), offsets.end() - 1 );
+		for( std::size_t i = 0; i < aIndexCount; ++i )
+			adjacency[fill[indices[i]]++] = std::uint32_t(i / 3);
+	}
+
+	// Scores
+	VertexScores_ const score;
+
+	std::vector<int> cachePosition( aVertexCount, -1 );
+	std::vector<float> vertexScore( aVertexCount );
+	for( std::size_t v = 0; v < aVertexCount; ++v )
+		vertexScore[v] = score( -1, remaining[v] );
+
+	std::vector<float> triangleScore( triangleCount );
+	for( std::size_t t = 0; t < triangleCount; ++t )
+	{
+		triangleScore[t] = vertexScore[indices[3*t+0]]
+			+ vertexScore[indices[3*t+1]]
+			+ vertexScore[indices[3*t+2]]
+		;
+	}
+
+	std::vector<bool> emitted( triangleCount, false );
+
+	std::uint32_t best = std::uint32_t(std::max_element( triangleScore.begin(), triangleScore.end() ) - triangleScore.begin());
+
+	// LRU cache. The new cache has room for the three vertices of the
+	// emitted triangle in front of the old contents; whatever ends up past
+	// kLruCacheSize_ is evicted.
+	std::vector<std::uint32_t> cache, newCache;
+	cache.reserve( kLruCacheSize_ + 3 );
+	newCache.reserve( kLruCacheSize_ + 3 );
+
+	std::size_t nextUnemitted = 0;
+	for( std::size_t out = 0; out < triangleCount; ++out )
+	{
+		// No candidate among the triangles using cached vertices: continue
+		// with the first triangle that has not been emitted yet. (Forsyth
+		// suggests a full search for the best triangle here; with the
+		// cache empty, all remaining triangles score similarly, and the
+		// input order is usually a better guess than an O(n) scan.)
+		if( kNoTriangle_ == best )
+		{
+			while( emitted[nextUnemitted] )
+				++nextUnemitted;
+			best = std::uint32_t(nextUnemitted);
+		}
+
+		std::uint32_t const* tri = indices.data() + 3*best;
+		aOut[3*out+0] = tri[0];
+		aOut[3*out+1] = tri[1];
+		aOut[3*out+2] = tri[2];
+		emitted[best] = true;
+
+		// Remove the triangle from its vertices' adjacency
+		for( int k = 0; k < 3; ++k )
+		{
+			std::uint32_t const v = tri[k];
+			std::uint32_t* adj = adjacency.data() + offsets[v];
+			std::uint32_t const count = remaining[v];
+
+			std::uint32_t const* it = std::find( adj, adj + count, best );
+			assert( it != adj + count );
+			std::swap( adj[it - adj], adj[count-1] );
+			--remaining[v];
+		}
+
+		// Update the cache
+		newCache.clear();
+		for( int k = 0; k < 3; ++k )
+		{
+			if( std::find( newCache.begin(), newCache.end(), tri[k] ) == newCache.end() )
+				newCache.emplace_back( tri[k] );
+		}
+		for( auto const v : cache )
+		{
+			if( v != tri[0] && v != tri[1] && v != tri[2] )
+				newCache.emplace_back( v );
+		}
+
+		for( std::size_t i = 0; i < newCache.size(); ++i )
+			cachePosition[newCache[i]] = i < kLruCacheSize_ ? int(i) : -1;
+
+		// Rescore the vertices whose position changed (including the evicted
+		// ones), and propagate the change to their remaining triangles.
+		for( auto const v : newCache )
+		{
+			float const s = score( cachePosition[v], remaining[v] );
+			float const delta = s - vertexScore[v];
+			vertexScore[v] = s;
+
+			std::uint32_t const* adj = adjacency.data() + offsets[v];
+			for( std::uint32_t i = 0; i < remaining[v]; ++i )
+				triangleScore[adj[i]] += delta;
+		}
+
+		if( newCache.size() > kLruCacheSize_ )
+			newCache.resize( kLruCacheSize_ );
+		cache.swap( newCache );
+
+		// Next triangle: best one using a cached vertex.
+		best = kNoTriangle_;
+		float bestScore = -1.f;
+		for( auto const v : cache )
+		{
+			std::uint32_t const* adj = adjacency.data() + offsets[v];
+			for( std::uint32_t i = 0; i < remaining[v]; ++i )
+			{
+				if( triangleScore[adj[i]] > bestScore )
+				{
+					bestScore = triangleScore[adj[i]];
+					best = adj[i];
+				}
+			}
+		}
+	}
+}
+
+void optimize_overdraw( std::size_t aIndexCount, std::uint32_t const* aIndices, std::size_t aVertexCount, Vec3f const* aPositions, std::uint32_t* aOut, float aThreshold )
+{
+	assert( 0 == aIndexCount % 3 );
+	assert( aIndices != aOut );
+
+	std::size_t const triangleCount = aIndexCount / 3;
+	if( 0 == triangleCount )
+		return;
+
+	auto const clusters = find_clusters_( triangleCount, aIndices, aVertexCount, aThreshold );
+	std::size_t const clusterCount = clusters.size() - 1;
+
+	// Area weighted centroid and normal of each cluster, and of the mesh.
+	// (The cross product's length is twice the triangle's area, which
+	// cancels out.)
+	std::vector<Vec3f> centroids( clusterCount ), normals( clusterCount );
+	Vec3f meshCentroid{ 0.f, 0.f, 0.f };
+	float meshArea = 0.f;
+
+	for( std::size_t c = 0; c < clusterCount; ++c )
+	{
+		Vec3f centroid{ 0.f, 0.f, 0.f }, normal{ 0.f, 0.f, 0.f };
+		float area = 0.f;
+
+		for( std::size_t t = clusters[c]; t < clusters[c+1]; ++t )
+		{
+			Vec3f const p0 = aPositions[aIndices[3*t+0]];
+			Vec3f const p1 = aPositions[aIndices[3*t+1]];
+			Vec3f const p2 = aPositions[aIndices[3*t+2]];
+
+			Vec3f const n = cross( p1 - p0, p2 - p0 );
+			float const a = length( n );
+
+			centroid += (a / 3.f) * (p0 + p1 + p2);
+			normal += n;
+			area += a;
+		}
+
+		meshCentroid += centroid;
+		meshArea += area;
+
+		centroids[c] = area > 0.f ? centroid / area : centroid;
+		normals[c] = normal;
+	}
+
+	if( meshArea > 0.f )
+		meshCentroid /= meshArea;
+
+	// Clusters that face away from the center are more likely to occlude
+	// others, and are drawn first.
+	std::vector<float> keys( clusterCount );
+	for( std::size_t c = 0; c < clusterCount; ++c )
+	{
+		float const len = length( normals[c] );
+		keys[c] = len > 0.f ? dot( centroids[c] - meshCentroid, normals[c] ) / len : 0.f;
+	}
+
+	std::vector<std::size_t> order( clusterCount );
+	std::iota( order.begin(), order.end(), std::size_t(0) );
+	std::stable_sort( order.begin(), order.end(), [&] (std::size_t aA, std::size_t aB) {
+		return keys[aA] > keys[aB];
+	} );
+
+	std::uint32_t* out = aOut;
+	for( auto const c : order )
+	{
+		out = std::copy( aIndices + 3*clusters[c], aIndices + 3*clusters[c+1], out );
+	}
+}
+
+std::size_t optimize_vertex_fetch_remap( std::size_t aIndexCount, std::uint32_t const* aIndices, std::size_t aVertexCount, std::uint32_t* aRemap )
+{
+	std::fill_n( aRemap, aVertexCount, kUnusedVertex );
+
+	std::uint32_t next = 0;
+	for( std::size_t i = 0; i < aIndexCount; ++i )
+	{
+		std::uint32_t const v = aIndices[i];
+		assert( v < aVertexCount );
+
+		if( kUnusedVertex == aRemap[v] )
+			aRemap[v] = next++;
+	}
+
+	return next;
+}
+
+void remap_indices( std::size_t aIndexCount, std::uint32_t const* aIndices, std::uint32_t const* aRemap, std::uint32_t* aOut )
+{
+	for( std::size_t i = 0; i < aIndexCount; ++i )
+	{
+		assert( kUnusedVertex != aRemap[aIndices[i]] );
+		aOut[i] = aRemap[aIndices[i]];
+	}
+}
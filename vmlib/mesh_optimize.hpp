@@ -0,0 +1,112 @@
+#ifndef MESH_OPTIMIZE_HPP_2601042A_B31E_4450_8608_B8BAC4D2B351
+#define MESH_OPTIMIZE_HPP_2601042A_B31E_4450_8608_B8BAC4D2B351
+
+#include <vector>
+
+#include <cstddef>
+#include <cstdint>
+
+#include "vec3.hpp"
+
+/** Index buffer optimization for indexed triangle meshes
+ *
+ * The functions work on plain triangle lists: three indices per triangle,
+ * referring to aVertexCount vertices. They are meant to be applied in the
+ * following order after a mesh has been loaded and welded:
+ *
+ *  1. optimize_vertex_cache() reorders the triangles so that vertices are
+ *     reused while they are still in the GPU's post-transform cache.
+ *  2. optimize_overdraw() reorders clusters of triangles from step 1 so that
+ *     outward facing parts of the mesh tend to be drawn first, without
+ *     losing much of the cache locality.
+ *  3. optimize_vertex_fetch_remap() computes a new vertex order (first use
+ *     by the index buffer), so that vertex fetches walk the vertex buffer
+ *     mostly linearly. The result is applied with remap_indices() and
+ *     remap_vertices().
+ *
+ * analyze_vertex_cache() and analyze_overdraw() measure the effect of steps 1
+ * and 2.
+ *
+ * Unless noted otherwise, the output index buffer may be the same as the
+ * input.
+ */
+
+/** Vertex cache statistics
+ *
+ * Computed by simulating a FIFO post-transform cache of aCacheSize entries.
+ * ACMR (average cache miss ratio) is the number of transformed vertices per
+ * triangle; it is 3 without any reuse, and approaches 0.5 for large regular
+ * grids. ATVR (average transformed vertex ratio) is the number of
+ * transformed vertices per vertex referenced by the index buffer; 1 is
+ * optimal.
+ */
+struct VertexCacheStatistics
+{
+	std::size_t transformedVertices;
+	float acmr;
+	float atvr;
+};
+
+VertexCacheStatistics analyze_vertex_cache( std::size_t aIndexCount, std::uint32_t const* aIndices, std::size_t aVertexCount, std::size_t aCacheSize = 16 );
+
+/** Overdraw statistics
+ *
+ * Estimated by rasterizing the mesh, in index buffer order, from the six
+ * axis-aligned directions: orthographic views of the mesh's bounding box at
+ * aResolution pixels along its larger side, with back faces (clockwise
+ * triangles) culled and an early depth test. Overdraw is the number of
+ * pixels shaded per pixel covered; 1 is optimal, and is reached when every
+ * pixel's nearest triangle is drawn first.
+ */
+struct OverdrawStatistics
+{
+	std::size_t pixelsCovered;
+	std::size_t pixelsShaded;
+	float overdraw;
+};
+
+OverdrawStatistics analyze_overdraw( std::size_t aIndexCount, std::uint32_t const* aIndices, std::size_t aVertexCount, Vec3f const* aPositions, std::size_t aResolution = 256 );
+
+
+// Reorders triangles for post-transform vertex cache locality, using T.
+// Forsyth's "Linear-Speed Vertex Cache Optimisation" (2006) with a simulated
+// LRU cache of 32 entries. The winding of each triangle is preserved.
+void optimize_vertex_cache( std::size_t aIndexCount, std::uint32_t const* aIndices, std::size_t aVertexCount, std::uint32_t* aOut );
+
+// Reorders clusters of triangles to reduce overdraw (P. V. Sander, D. Nehab
+// and J. Barczak, "Fast Triangle Reordering for Vertex Locality and Reduced
+// Overdraw", 2007). The input should be the output of optimize_vertex_cache();
+// it is split into clusters wherever the vertex cache restarts, and where the
+// clusters' ACMR would grow by at most aThreshold. Clusters are then sorted
+// so that those facing away from the mesh's center are drawn first.
+//
+// aOut must not alias aIndices.
+void optimize_overdraw( std::size_t aIndexCount, std::uint32_t const* aIndices, std::size_t aVertexCount, Vec3f const* aPositions, std::uint32_t* aOut, float aThreshold = 1.05f );
+
+// Computes a vertex order in which the vertices are first used by the index
+// buffer. aRemap[old] is the new index of vertex old, or kUnusedVertex if the
+// vertex is not referenced. Returns the number of referenced vertices.
+constexpr std::uint32_t kUnusedVertex = ~std::uint32_t(0);
+
+std::size_t optimize_vertex_fetch_remap( std::size_t aIndexCount, std::uint32_t const* aIndices, std::size_t aVertexCount, std::uint32_t* aRemap );
+
+void remap_indices( std::size_t aIndexCount, std::uint32_t const* aIndices, std::uint32_t const* aRemap, std::uint32_t* aOut );
+
+// Moves aVertices[i] to position aRemap[i] and drops unused vertices.
+// aUniqueCount is the value returned by optimize_vertex_fetch_remap().
+template< typename tVertex >
+void remap_vertices( std::vector<tVertex>& aVertices, std::uint32_t const* aRemap, std::size_t aUniqueCount )
+{
+	if( aVertices.empty() )
+		return;
+
+	std::vector<tVertex> ret( aUniqueCount );
+	for( std::size_t i = 0; i < aVertices.size(); ++i )
+	{
+		if( kUnusedVertex != aRemap[i] )
+			ret[aRemap[i]] = aVertices[i];
+	}
+	aVertices.swap( ret );
+}
+
+#endif // MESH_OPTIMIZE_HPP_2601042A_B31E_4450_8608_B8BAC4D2B351
@@ -0,0 +1,418 @@
+#include "mesh_simplify.hpp"
+
+#include <vector>
+#include <numeric>
+#include <algorithm>
+
+#include <cmath>
+#include <cstring>
+#include <cassert>
+
+namespace
+{
+	// Border edges get a constraint plane through the edge, perpendicular to
+	// the triangle. Its weight is the squared edge length times this.
+	constexpr double kBorderWeight_ = 10.0;
+
+	// Collapses that turn a triangle's normal by more than about 78 degrees
+	// (cos = 0.2) are rejected; they would fold the surface over.
+	constexpr float kMinNormalCos_ = 0.2f;
+
+	// Each pass collapses edges in order of increasing error, where each
+	// vertex takes part in at most one collapse. Edges whose error is more
+	// than this factor above that of the edge that would reach the target
+	// are left for the next pass, where their error is recomputed.
+	constexpr float kPassErrorSlack_ = 1.5f;
+
+	// Symmetric 4x4 matrix (upper triangle) and the total weight of the
+	// planes summed into it.
+	struct Quadric_
+	{
+		double a00, a01, a02, a03;
+		double a11, a12, a13;
+		double a22, a23;
+		double a33;
+		double weight;
+	};
+
+	// Quadric for the plane through aPoint with the unit normal aNormal.
+	Quadric_ make_plane_quadric_( Vec3f aNormal, Vec3f aPoint, double aWeight ) noexcept
+	{
+		double const x = aNormal.x, y = aNormal.y, z = aNormal.z;
+		double const d = -(x*aPoint.x + y*aPoint.y + z*aPoint.z);
+
+		Quadric_ q;
+		q.a00 = aWeight*x*x; q.a01 = aWeight*x*y; q.a02 = aWeight*x*z; q.a03 = aWeight*x*d;
+		q.a11 = aWeight*y*y; q.a12 = aWeight*y*z; q.a13 = aWeight*y*d;
+		q.a22 = aWeight*z*z; q.a23 = aWeight*z*d;
+		q.a33 = aWeight*d*d;
+		q.weight = aWeight;
+		return q;
+	}
+
+	void add_( Quadric_& aQ, Quadric_ const& aOther ) noexcept
+	{
+		aQ.a00 += aOther.a00; aQ.a01 += aOther.a01; aQ.a02 += aOther.a02; aQ.a03 += aOther.a03;
+		aQ.a11 += aOther.a11; aQ.a12 += aOther.a12; aQ.a13 += aOther.a13;
+		aQ.a22 += aOther.a22; aQ.a23 += aOther.a23;
+		aQ.a33 += aOther.a33;
+		aQ.weight += aOther.weight;
+	}
+
+	// Error of moving the vertices with the quadrics aA and aB to aPoint.
+	float collapse_error_( Quadric_ const& aA, Quadric_ const& aB, Vec3f aPoint ) noexcept
+	{
+		Quadric_ q = aA;
+		add_( q, aB );
+		if( q.weight <= 0.0 )
+			return 0.f;
+
+		double const x = aPoint.x, y = aPoint.y, z = aPoint.z;
+		double const e = q.a00*x*x + q.a11*y*y + q.a22*z*z + q.a33
+			+ 2.0 * (q.a01*x*y + q.a02*x*z + q.a12*y*z + q.a03*x + q.a13*y + q.a23*z)
+		;
+		return float(std::sqrt( std::max( e, 0.0 ) / q.weight ));
+	}
+
+	bool is_degenerate_( std::uint32_t const* aTri ) noexcept
+	{
+		return aTri[0] == aTri[1] || aTri[1] == aTri[2] || aTri[2] == aTri[0];
+	}
+
+	struct Collapse_
+	{
+		std::uint32_t from, to;
+		float error;
+	};
+
+	// Bit pattern of a position, for merging vertices at the same position.
+	struct PositionKey_
+	{
+		std::uint32_t bits[3];
+
+		explicit PositionKey_( Vec3f aPos ) noexcept
+		{
+			std::memcpy( bits+0, &aPos.x, sizeof(float) );
+			std::memcpy( bits+1, &aPos.y, sizeof(float) );
+			std::memcpy( bits+2, &aPos.z, sizeof(float) );
+			for( auto& b : bits )
+				b = (0x80000000u == b) ? 0u : b; // -0 -> +0
+		}
+
+		bool operator<( PositionKey_ const& aOther ) const noexcept
+		{
+			return std::lexicographical_compare( bits, bits+3, aOther.bits, aOther.bits+3 );
+		}
+		bool operator==( PositionKey_ const& aOther ) const noexcept
+		{
+			return std::equal( bits, bits+3, aOther.bits );
+		}
+	};
+}
+
+SimplifyResult simplify_mesh( std::size_t aIndexCount, std::uint32_t const* aIndices, std::size_t aVertexCount, Vec3f const* aPositions, SimplifyOptions const& aOptions, std::uint32_t* aOut )
+{
+	assert( 0 == aIndexCount % 3 );
+
+	// Group the referenced vertices by position. Simplification works on the
+	// groups; wedges[wedgeStart[g] .. wedgeStart[g+1]) are the vertices of
+	// group g.
+	std::vector<std::uint32_t> wedges;
+	{
+		std::vector<bool> seen( aVertexCount, false );
+		for( std::size_t i = 0; i < aIndexCount; ++i )
+		{
+			assert( aIndices[i] < aVertexCount );
+			if( !seen[aIndices[i]] )
+			{
+				seen[aIndices[i]] = true;
+				wedges.emplace_back( aIndices[i] );
+			}
+		}
+	}
+
+	std::stable_sort( wedges.begin(), wedges.end(), [&] (std::uint32_t aA, std::uint32_t aB) {
+		return PositionKey_( aPositions[aA] ) < PositionKey_( aPositions[aB] );
+	} );
+
+	std::vector<std::uint32_t> groupOf( aVertexCount, 0 );
+	std::vector<std::uint32_t> wedgeStart;
+	std::vector<Vec3f> positions;
+	for( std::size_t i = 0; i < wedges.size(); ++i )
+	{
+		if( 0 == i || !(PositionKey_( aPositions[wedges[i]] ) == PositionKey_( aPositions[wedges[i-1]] )) )
+		{
+			wedgeStart.emplace_back( std::uint32_t(i) );
+			positions.emplace_back( aPositions[wedges[i]] );
+		}
+		groupOf[wedges[i]] = std::uint32_t(positions.size() - 1);
+	}
+	wedgeStart.emplace_back( std::uint32_t(wedges.size()) );
+
+	std::size_t const groupCount = positions.size();
+
+	// Triangles in terms of groups, and the original vertex of each corner.
+	// Triangles with two corners at the same position cover no area and are
+	// dropped right away.
+	std::vector<std::uint32_t> tris, corners;
+	tris.reserve( aIndexCount );
+	corners.reserve( aIndexCount );
+	for( std::size_t i = 0; i < aIndexCount; i += 3 )
+	{
+		std::uint32_t const tri[3] = { groupOf[aIndices[i+0]], groupOf[aIndices[i+1]], groupOf[aIndices[i+2]] };
+		if( is_degenerate_( tri ) )
+			continue;
+
+		tris.insert( tris.end(), tri, tri+3 );
+		corners.insert( corners.end(), aIndices + i, aIndices + i+3 );
+	}
+
+	// Triangles around each group: adjacency[adjacencyStart[g] ..
+	// adjacencyStart[g+1]). Rebuilt at the start of each pass.
+	std::vector<std::uint32_t> adjacencyStart( groupCount + 1 ), adjacency;
+	auto const update_adjacency = [&] {
+		std::fill( adjacencyStart.begin(), adjacencyStart.end(), 0u );
+		for( auto const g : tris )
+			++adjacencyStart[g+1];
+
+		std::partial_sum( adjacencyStart.begin(), adjacencyStart.end(), adjacencyStart.begin() );
+		adjacency.resize( tris.size() );
+
+		std::vector<std::uint32_t> fill( adjacencyStart.begin(), adjacencyStart.end() - 1 );
+		for( std::size_t i = 0; i < tris.size(); ++i )
+			adjacency[fill[tris[i]]++] = std::uint32_t(i / 3);
+	};
+
+	// A directed edge whose reverse is not part of any triangle is a border
+	// edge.
+	auto const is_border_edge = [&] (std::uint32_t aFrom, std::uint32_t aTo) {
+		for( std::uint32_t i = adjacencyStart[aTo]; i < adjacencyStart[aTo+1]; ++i )
+		{
+			std::uint32_t const* tri = tris.data() + 3*adjacency[i];
+			for( std::size_t k = 0; k < 3; ++k )
+			{
+				if( aTo == tri[k] && aFrom == tri[(k+1)%3] )
+					return false;
+			}
+		}
+		return true;
+	};
+
+	// Quadrics: the planes of the triangles around each vertex, weighted by
+	// area, plus the border constraints.
+	std::vector<Quadric_> quadrics( groupCount, Quadric_{} );
+
+	update_adjacency();
+	for( std::size_t i = 0; i < tris.size(); i += 3 )
+	{
+		Vec3f const n = cross( positions[tris[i+1]] - positions[tris[i]], positions[tris[i+2]] - positions[tris[i]] );
+		float const len = length( n );
+		if( len <= 0.f )
+			continue;
+
+		Vec3f const normal = n / len;
+		Quadric_ const q = make_plane_quadric_( normal, positions[tris[i]], 0.5 * len );
+		for( std::size_t k = 0; k < 3; ++k )
+			add_( quadrics[tris[i+k]], q );
+
+		for( std::size_t k = 0; k < 3; ++k )
+		{
+			std::uint32_t const a = tris[i+k], b = tris[i+(k+1)%3];
+			if( !is_border_edge( a, b ) )
+				continue;
+
+			Vec3f const edge = positions[b] - positions[a];
+			Vec3f const side = cross( edge, normal );
+			float const sideLength = length( side );
+			if( sideLength <= 0.f )
+				continue;
+
+			Quadric_ const bq = make_plane_quadric_( side / sideLength, positions[a], kBorderWeight_ * dot( edge, edge ) );
+			add_( quadrics[a], bq );
+			add_( quadrics[b], bq );
+		}
+	}
+
+	// Collapse passes
+	std::size_t triangleCount = tris.size() / 3;
+	float maxError = 0.f;
+
+	std::vector<std::uint8_t> border( groupCount ), touched( groupCount );
+	std::vector<Collapse_> candidates;
+
+	while( 3*triangleCount > aOptions.targetIndexCount )
+	{
+		// Border vertices
+		std::fill( border.begin(), border.end(), std::uint8_t(0) );
+		for( std::size_t i = 0; i < tris.size(); i += 3 )
+		{
+			for( std::size_t k = 0; k < 3; ++k )
+			{
+				std::uint32_t const a = tris[i+k], b = tris[i+(k+1)%3];
+				if( is_border_edge( a, b ) )
+					border[a] = border[b] = 1;
+			}
+		}
+
+		// Candidates. Interior edges are seen once in each direction (from
+		// the two triangles that share them); border edges only once, so
+		// both directions are added there.
+		candidates.clear();
+		auto const consider = [&] (std::uint32_t aFrom, std::uint32_t aTo, bool aBorderEdge) {
+			if( border[aFrom] && (aOptions.lockBorder || !aBorderEdge) )
+				return;
+
+			float const error = collapse_error_( quadrics[aFrom], quadrics[aTo], positions[aTo] );
+			if( error <= aOptions.targetError )
+				candidates.emplace_back( Collapse_{ aFrom, aTo, error } );
+		};
+
+		for( std::size_t i = 0; i < tris.size(); i += 3 )
+		{
+			for( std::size_t k = 0; k < 3; ++k )
+			{
+				std::uint32_t const a = tris[i+k], b = tris[i+(k+1)%3];
+				bool const borderEdge = is_border_edge( a, b );
+
+				consider( a, b, borderEdge );
+				if( borderEdge )
+					consider( b, a, true );
+			}
+		}
+
+		if( candidates.empty() )
+			break;
+
+		auto const by_error = [] (Collapse_ const& aA, Collapse_ const& aB) {
+			return aA.error < aB.error;
+		};
+
+		// Most collapses remove two triangles. Only the candidates up to the
+		// pass' error limit need to be sorted.
+		std::size_t const goal = std::min( std::max<std::size_t>( (3*triangleCount - aOptions.targetIndexCount) / 6, 1 ), candidates.size() );
+		std::nth_element( candidates.begin(), candidates.begin() + (goal-1), candidates.end(), by_error );
+		float const passLimit = candidates[goal-1].error * kPassErrorSlack_;
+
+		auto const end = std::partition( candidates.begin(), candidates.end(), [passLimit] (Collapse_ const& aC) {
+			return aC.error <= passLimit;
+		} );
+		candidates.erase( end, candidates.end() );
+		std::sort( candidates.begin(), candidates.end(), by_error );
+
+		// Collapse
+		std::fill( touched.begin(), touched.end(), std::uint8_t(0) );
+
+		std::size_t collapsed = 0;
+		for( auto const& c : candidates )
+		{
+			if( 3*triangleCount <= aOptions.targetIndexCount )
+				break;
+
+			if( touched[c.from] || touched[c.to] )
+				continue;
+
+			std::uint32_t const* adj = adjacency.data() + adjacencyStart[c.from];
+			std::uint32_t const adjCount = adjacencyStart[c.from+1] - adjacencyStart[c.from];
+
+			// Reject collapses that flip triangles. Triangles that contain
+			// both endpoints disappear and are not checked.
+			bool flips = false;
+			for( std::uint32_t i = 0; i < adjCount && !flips; ++i )
+			{
+				std::uint32_t const* tri = tris.data() + 3*adj[i];
+				if( is_degenerate_( tri ) || tri[0] == c.to || tri[1] == c.to || tri[2] == c.to )
+					continue;
+
+				Vec3f p[3], q[3];
+				for( std::size_t k = 0; k < 3; ++k )
+				{
+					p[k] = positions[tri[k]];
+					q[k] = positions[c.from == tri[k] ? c.to : tri[k]];
+				}
+
+				Vec3f const n0 = cross( p[1] - p[0], p[2] - p[0] );
+				Vec3f const n1 = cross( q[1] - q[0], q[2] - q[0] );
+
+				float const l0 = length( n0 );
+				if( l0 > 0.f && dot( n0, n1 ) <= kMinNormalCos_ * l0 * length( n1 ) )
+					flips = true;
+			}
+
+			if( flips )
+				continue;
+
+			for( std::uint32_t i = 0; i < adjCount; ++i )
+			{
+				std::uint32_t* tri = tris.data() + 3*adj[i];
+				bool const wasDegenerate = is_degenerate_( tri );
+
+				for( std::size_t k = 0; k < 3; ++k )
+				{
+					if( c.from == tri[k] )
+						tri[k] = c.to;
+				}
+
+				if( !wasDegenerate && is_degenerate_( tri ) )
+					--triangleCount;
+			}
+
+			add_( quadrics[c.to], quadrics[c.from] );
+			touched[c.from] = touched[c.to] = 1;
+			maxError = std::max( maxError, c.error );
+			++collapsed;
+		}
+
+		if( 0 == collapsed )
+			break;
+
+		// Remove the collapsed triangles
+		std::size_t out = 0;
+		for( std::size_t i = 0; i < tris.size(); i += 3 )
+		{
+			if( is_degenerate_( tris.data() + i ) )
+				continue;
+
+			for( std::size_t k = 0; k < 3; ++k )
+			{
+				tris[out+k] = tris[i+k];
+				corners[out+k] = corners[i+k];
+			}
+			out += 3;
+		}
+		tris.resize( out );
+		corners.resize( out );
+		assert( out == 3*triangleCount );
+
+		update_adjacency();
+	}
+
+	// Back to vertices. Corners whose vertex was collapsed use the most
+	// similar vertex at the new position.
+	for( std::size_t i = 0; i < tris.size(); ++i )
+	{
+		std::uint32_t const v = corners[i], g = tris[i];
+		if( groupOf[v] == g )
+		{
+			aOut[i] = v;
+			continue;
+		}
+
+		std::uint32_t best = wedges[wedgeStart[g]];
+		if( aOptions.normals )
+		{
+			float bestDot = dot( aOptions.normals[best], aOptions.normals[v] );
+			for( std::uint32_t w = wedgeStart[g]+1; w < wedgeStart[g+1]; ++w )
+			{
+				float const d = dot( aOptions.normals[wedges[w]], aOptions.normals[v] );
+				if( d > bestDot )
+				{
+					bestDot = d;
+					best = wedges[w];
+				}
+			}
+		}
+		aOut[i] = best;
+	}
+
+	return SimplifyResult{ tris.size(), maxError };
+}
@@ -0,0 +1,64 @@
+#ifndef MESH_SIMPLIFY_HPP_FA01F1D4_4E10_4E5C_BCA4_C4799DFC14B8
+#define MESH_SIMPLIFY_HPP_FA01F1D4_4E10_4E5C_BCA4_C4799DFC14B8
+
+#include <limits>
+
+#include <cstddef>
+#include <cstdint>
+
+#include "vec3.hpp"
+
+/** Mesh simplification by quadric error edge collapses
+ *
+ * simplify_mesh() reduces the number of triangles of an indexed triangle
+ * list (three indices per triangle) by collapsing edges, using the quadric
+ * error metric of M. Garland and P. Heckbert ("Surface Simplification Using
+ * Quadric Error Metrics", 1997). Edges are collapsed onto one of their
+ * endpoints (half-edge collapses), so the simplified index buffer refers to
+ * the original vertices; the vertex buffer is not modified.
+ *
+ * Vertices with the same position but different attributes (e.g. along
+ * texture seams and hard edges) are treated as a single vertex while
+ * simplifying. When such a vertex is collapsed, the triangles around it
+ * switch to the vertex at the same position as the target that has the
+ * most similar normal (or, without normals, to an arbitrary one).
+ *
+ * Open borders are preserved by additional quadrics along the border edges,
+ * and border vertices only collapse along the border. With lockBorder, they
+ * do not collapse at all; meshes that are split into parts that are
+ * simplified separately stay watertight that way.
+ *
+ * Errors are distances in the units of the positions. They are estimates:
+ * the square root of the area weighted mean squared distance of a vertex to
+ * the planes of the triangles that were collapsed into it.
+ */
+struct SimplifyOptions
+{
+	// Stop once the index buffer has this many indices or fewer.
+	std::size_t targetIndexCount;
+
+	// Never collapse an edge with a larger error.
+	float targetError = std::numeric_limits<float>::max();
+
+	// Keep all vertices on open borders.
+	bool lockBorder = false;
+
+	// Optional per-vertex normals, used to pick between vertices at the
+	// same position (see above).
+	Vec3f const* normals = nullptr;
+};
+
+struct SimplifyResult
+{
+	// Number of indices written to the output.
+	std::size_t indexCount;
+
+	// Largest error of a collapsed edge.
+	float error;
+};
+
+// aOut must have room for aIndexCount indices, and may be the same as
+// aIndices. The triangles in the output keep their winding.
+SimplifyResult simplify_mesh( std::size_t aIndexCount, std::uint32_t const* aIndices, std::size_t aVertexCount, Vec3f const* aPositions, SimplifyOptions const& aOptions, std::uint32_t* aOut );
+
+#endif // MESH_SIMPLIFY_HPP_FA01F1D4_4E10_4E5C_BCA4_C4799DFC14B8
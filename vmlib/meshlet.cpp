@@ -0,0 +1,237 @@
+#include "meshlet.hpp"
+
+#include <limits>
+#include <algorithm>
+
+#include <cmath>
+#include <cassert>
+
+namespace
+{
+	constexpr std::uint32_t kNoMeshlet_ = ~std::uint32_t(0);
+
+	// Cones whose normals are spread this close to a hemisphere (cosine of
+	// the largest angle to the axis) are dropped: the camera would have to
+	// be almost exactly behind them for the test to succeed.
+	constexpr float kMinConeSpread_ = 0.1f;
+
+	// Cutoff of meshlets without a cone; is_backfacing() is never true.
+	constexpr float kNoCone_ = 2.f;
+
+	// Bounds and normal cone of aTriangleCount triangles starting at aIndices.
+	// aNormals is scratch space.
+	void compute_bounds_( std::uint32_t const* aIndices, std::size_t aTriangleCount, Vec3f const* aPositions, std::vector<std::uint32_t> const& aVertices, std::vector<Vec3f>& aNormals, Meshlet& aMeshlet )
+	{
+		aNormals.clear();
+		for( auto const v : aVertices )
+			aNormals.emplace_back( aPositions[v] );
+
+		aMeshlet.bounds = make_bounding_sphere( aNormals );
+		aMeshlet.coneApex = aMeshlet.bounds.center;
+		aMeshlet.coneAxis = Vec3f{ 0.f, 0.f, 0.f };
+		aMeshlet.coneCutoff = kNoCone_;
+
+		// Axis: average of the triangles' unit normals. Degenerate triangles
+		// get a zero normal and are skipped below.
+		aNormals.clear();
+		Vec3f sum{ 0.f, 0.f, 0.f };
+		for( std::size_t i = 0; i < aTriangleCount; ++i )
+		{
+			Vec3f const p0 = aPositions[aIndices[3*i+0]];
+			Vec3f const n = cross( aPositions[aIndices[3*i+1]] - p0, aPositions[aIndices[3*i+2]] - p0 );
+			float const len = length( n );
+
+			aNormals.emplace_back( len > 0.f ? n / len : Vec3f{ 0.f, 0.f, 0.f } );
+			sum += aNormals.back();
+		}
+
+		float const sumLength = length( sum );
+		if( sumLength <= 0.f )
+			return;
+
+		Vec3f const axis = sum / sumLength;
+
+		float minDot = 1.f;
+		for( auto const& n : aNormals )
+		{
+			if( dot( n, n ) > 0.f )
+				minDot = std::min( minDot, dot( n, axis ) );
+		}
+
+		if( minDot < kMinConeSpread_ )
+			return;
+
+		// Apex: the point on the axis through the center that is behind (or
+		// on) the planes of all triangles. A camera that sees the apex from
+		// within the cone's back side is behind all of the planes.
+		float maxT = -std::numeric_limits<float>::infinity();
+		for( std::size_t i = 0; i < aTriangleCount; ++i )
+		{
+			Vec3f const& n = aNormals[i];
+			if( dot( n, n ) > 0.f )
+				maxT = std::max( maxT, dot( aMeshlet.bounds.center - aPositions[aIndices[3*i]], n ) / dot( axis, n ) );
+		}
+
+		aMeshlet.coneApex = aMeshlet.bounds.center - axis * maxT;
+		aMeshlet.coneAxis = axis;
+		aMeshlet.coneCutoff = std::sqrt( std::max( 1.f - minDot*minDot, 0.f ) );
+	}
+}
+
+std::size_t build_meshlets( std::size_t aIndexCount, std::uint32_t const* aIndices, std::size_t aVertexCount, Vec3f const* aPositions, std::uint32_t* aOut, std::vector<Meshlet>& aMeshlets, std::uint32_t aIndexOffset )
+{
+	assert( aIndexCount % 3 == 0 );
+	assert( aOut != aIndices || 0 == aIndexCount );
+
+	std::size_t const triangleCount = aIndexCount / 3;
+
+	// Triangles of each vertex
+	std::vector<std::uint32_t> firstTriangle( aVertexCount + 1, 0 );
+	for( std::size_t i = 0; i < aIndexCount; ++i )
+		++firstTriangle[aIndices[i] + 1];
+	for( std::size_t v = 0; v < aVertexCount; ++v )
+		firstTriangle[v+1] += firstTriangle[v];
+
+	std::vector<std::uint32_t> vertexTriangles( aIndexCount );
+	{
+		std::vector<std::uint32_t> fill( firstTriangle.begin(), firstTriangle.end() - 1 );
+		for( std::size_t i = 0; i < aIndexCount; ++i )
+			vertexTriangles[fill[aIndices[i]]++] = std::uint32_t(i / 3);
+	}
+
+	// Grow meshlets
+	std::vector<std::uint8_t> emitted( triangleCount, 0 );
+	std::vector<std::uint32_t> vertexMeshlet( aVertexCount, kNoMeshlet_ );
+
+	std::vector<std::uint32_t> vertices, candidates;
+	std::vector<Vec3f> normals;
+
+	std::size_t const firstMeshlet = aMeshlets.size();
+	std::size_t out = 0;
+
+	for( std::size_t seed = 0; seed < triangleCount; ++seed )
+	{
+		if( emitted[seed] )
+			continue;
+
+		std::uint32_t const id = std::uint32_t(aMeshlets.size() - firstMeshlet);
+		std::size_t const first = out;
+		std::size_t triangles = 0;
+
+		vertices.clear();
+		candidates.clear();
+		Vec3f vertexSum{ 0.f, 0.f, 0.f };
+
+		auto const add = [&] (std::size_t aTriangle) {
+			emitted[aTriangle] = 1;
+			++triangles;
+
+			for( std::size_t j = 0; j < 3; ++j )
+			{
+				std::uint32_t const v = aIndices[3*aTriangle + j];
+				aOut[out++] = v;
+
+				if( id == vertexMeshlet[v] )
+					continue;
+
+				vertexMeshlet[v] = id;
+				vertices.emplace_back( v );
+				vertexSum += aPositions[v];
+				for( std::uint32_t k = firstTriangle[v]; k < firstTriangle[v+1]; ++k )
+				{
+					if( !emitted[vertexTriangles[k]] )
+						candidates.emplace_back( vertexTriangles[k] );
+				}
+			}
+		};
+
+		add( seed );
+		while( triangles < kMeshletMaxTriangles )
+		{
+			// Fewest new vertices first, then closest to the centroid of the
+			// meshlet's vertices, then earliest in the input.
+			Vec3f const centroid = vertexSum / float(vertices.size());
+
+			std::uint32_t best = kNoMeshlet_;
+			std::size_t bestNew = 4;
+			float bestDistance = 0.f;
+
+			for( std::size_t c = 0; c < candidates.size(); )
+			{
+				std::uint32_t const t = candidates[c];
+				if( emitted[t] )
+				{
+					candidates[c] = candidates.back();
+					candidates.pop_back();
+					continue;
+				}
+
+				std::uint32_t const* tri = aIndices + 3*t;
+				std::size_t const added = std::size_t(id != vertexMeshlet[tri[0]])
+					+ std::size_t(id != vertexMeshlet[tri[1]])
+					+ std::size_t(id != vertexMeshlet[tri[2]])
+				;
+				++c;
+
+				if( vertices.size() + added > kMeshletMaxVertices || added > bestNew )
+					continue;
+
+				Vec3f const d = aPositions[tri[0]] + aPositions[tri[1]] + aPositions[tri[2]] - 3.f * centroid;
+				float const distance = dot( d, d );
+				if( added < bestNew || distance < bestDistance || (distance == bestDistance && t < best) )
+				{
+					best = t;
+					bestNew = added;
+					bestDistance = distance;
+				}
+			}
+
+			if( kNoMeshlet_ == best )
+				break;
+
+			add( best );
+		}
+
+		Meshlet meshlet;
+		meshlet.firstIndex = aIndexOffset + std::uint32_t(first);
+		meshlet.indexCount = std::uint32_t(out - first);
+		compute_bounds_( aOut + first, triangles, aPositions, vertices, normals, meshlet );
+		aMeshlets.emplace_back( meshlet );
+	}
+
+	assert( out == aIndexCount );
+	return aMeshlets.size() - firstMeshlet;
+}
+
+std::size_t cull_meshlets( Frustumf const& aFrustum, Vec3f aCameraPosition, std::size_t aCount, Meshlet const* aMeshlets, std::vector<MeshletRange>& aRanges, bool aConeCulling )
+{
+	std::size_t visible = 0;
+	std::size_t const firstRange = aRanges.size();
+
+	for( std::size_t i = 0; i < aCount; ++i )
+	{
+		Meshlet const& meshlet = aMeshlets[i];
+		if( !intersects( aFrustum, meshlet.bounds ) )
+			continue;
+		if( aConeCulling && is_backfacing( meshlet, aCameraPosition ) )
+			continue;
+
+		++visible;
+
+		// Merge with the previous range if the two are adjacent. Ranges that
+		// were in aRanges before the call are left alone.
+		if( aRanges.size() > firstRange )
+		{
+			MeshletRange& last = aRanges.back();
+			if( last.firstIndex + last.indexCount == meshlet.firstIndex )
+			{
+				last.indexCount += meshlet.indexCount;
+				continue;
+			}
+		}
+
+		aRanges.emplace_back( MeshletRange{ meshlet.firstIndex, meshlet.indexCount } );
+	}
+
+	return visible;
+}
@@ -0,0 +1,85 @@
+#ifndef MESHLET_HPP_03B91298_4940_4ABC_B60B_C1535F4768A1
+#define MESHLET_HPP_03B91298_4940_4ABC_B60B_C1535F4768A1
+
+#include <vector>
+
+#include <cstddef>
+#include <cstdint>
+
+#include "vec3.hpp"
+#include "bounds.hpp"
+#include "frustum.hpp"
+
+/** Meshlets: small clusters of triangles that are culled on their own
+ *
+ * build_meshlets() reorders the triangles of an indexed triangle list into
+ * meshlets of at most kMeshletMaxVertices distinct vertices and
+ * kMeshletMaxTriangles triangles. Each meshlet is a contiguous range of the
+ * reordered index buffer, so it can be drawn with a plain draw call, and
+ * consecutive visible meshlets merge into a single one.
+ *
+ * Meshlets are grown greedily from a seed triangle (the first one of the
+ * input that is left), always adding the neighbouring triangle that needs
+ * the fewest new vertices and, among those, the one closest to the centroid
+ * of the meshlet. This keeps them compact, which is what makes their bounds
+ * useful. A meshlet ends when it is full or has no neighbours left.
+ *
+ * Each meshlet has a bounding sphere and a normal cone. The cone contains
+ * the normals of all of its triangles; if the camera is inside the cone's
+ * "back side" (see is_backfacing()), all triangles face away from the
+ * camera. This is only a valid reason to skip a meshlet if back faces are
+ * culled when drawing (glEnable(GL_CULL_FACE)). Meshlets whose normals
+ * spread over more than a hemisphere are never back facing.
+ *
+ * cull_meshlets() tests meshlets against a frustum and their cones against
+ * the camera position, and emits the index ranges of the visible ones. All
+ * of the inputs must be in the same space (typically the model space of
+ * the mesh; see make_frustum()).
+ */
+constexpr std::size_t kMeshletMaxVertices = 64;
+constexpr std::size_t kMeshletMaxTriangles = 124;
+
+struct Meshlet
+{
+	// Index range in the index buffer written by build_meshlets(), plus the
+	// offset passed to it.
+	std::uint32_t firstIndex;
+	std::uint32_t indexCount;
+
+	Spheref bounds;
+
+	// Normal cone. coneCutoff is the sine of the angle between the axis and
+	// the normal furthest from it, or larger than one if there is no cone.
+	Vec3f coneApex;
+	Vec3f coneAxis;
+	float coneCutoff;
+};
+
+// Index range of visible meshlets, see cull_meshlets().
+struct MeshletRange
+{
+	std::uint32_t firstIndex;
+	std::uint32_t indexCount;
+};
+
+// Reorders the aIndexCount indices into aOut (which must not alias aIndices)
+// and appends the meshlets to aMeshlets. aIndexOffset is added to the
+// meshlets' firstIndex; use it when aOut is part of a larger index buffer.
+// Degenerate triangles are kept, but do not contribute to the normal cones.
+// Returns the number of meshlets.
+std::size_t build_meshlets( std::size_t aIndexCount, std::uint32_t const* aIndices, std::size_t aVertexCount, Vec3f const* aPositions, std::uint32_t* aOut, std::vector<Meshlet>& aMeshlets, std::uint32_t aIndexOffset = 0 );
+
+// True if all triangles of aMeshlet face away from aCameraPosition.
+inline
+bool is_backfacing( Meshlet const& aMeshlet, Vec3f aCameraPosition ) noexcept
+{
+	Vec3f const d = aMeshlet.coneApex - aCameraPosition;
+	return dot( d, aMeshlet.coneAxis ) > aMeshlet.coneCutoff * length( d );
+}
+
+// Appends the index ranges of the meshlets that intersect aFrustum and, if
+// aConeCulling is set, are not back facing. Consecutive visible meshlets
+// are merged into one range. Returns the number of visible meshlets.
+std::size_t cull_meshlets( Frustumf const& aFrustum, Vec3f aCameraPosition, std::size_t aCount, Meshlet const* aMeshlets, std::vector<MeshletRange>& aRanges, bool aConeCulling = true );
+
+#endif // MESHLET_HPP_03B91298_4940_4ABC_B60B_C1535F4768A1
@@ -0,0 +1,80 @@
+#ifndef MODEL_TRANSFORM_HPP_B8A7F0D3_96C4_4E1B_8D3A_5F2C7E9A1B04
+#define MODEL_TRANSFORM_HPP_B8A7F0D3_96C4_4E1B_8D3A_5F2C7E9A1B04
+
+#include "mat33.hpp"
+#include "mat44.hpp"
+
+/** ModelTransform: model-to-world matrix with a cached normal matrix
+ *
+ * The normal matrix is computed on the first call to normalMatrix() after
+ * the transform was changed via set(), and reused until the next change. For
+ * static objects it is therefore computed once.
+ *
+ * If the transform is known to be rigid (rotation and translation only), pass
+ * kRigid to skip the inverse altogether.
+ *
+ * Example:
+ *    ModelTransform pad( make_translation( { 10.f, 0.f, 40.f } ), ModelTransform::kRigid );
+ *    ...
+ *    glUniformMatrix3fv( 1, 1, GL_FALSE, pad.normalMatrix().v ); // column-major, see kMatrixLayout
+ */
+class ModelTransform final
+{
+	public:
+		enum Kind
+		{
+			kAffine,
+			kRigid
+		};
+
+	public:
+		explicit ModelTransform( Mat44f const& aModel2World = kIdentity44f, Kind aKind = kAffine ) noexcept
+			: mModel2World( aModel2World )
+			, mKind( aKind )
+			, mNormalDirty( true )
+		{}
+
+	public:
+		void set( Mat44f const& aModel2World, Kind aKind = kAffine ) noexcept
+		{
+			mModel2World = aModel2World;
+			mKind = aKind;
+			mNormalDirty = true;
+		}
+
+		Mat44f const& model2world() const noexcept
+		{
+			return mModel2World;
+		}
+
+		Mat33f const& normalMatrix() const noexcept
+		{
+			if( mNormalDirty )
+			{
+				mNormalMatrix = kRigid == mKind
+					? normal_matrix_rigid( mModel2World )
+					: normal_matrix( mModel2World )
+				;
+				mNormalDirty = false;
+			}
+
+			return mNormalMatrix;
+		}
+
+		Mat44f inverse() const noexcept
+		{
+			return kRigid == mKind
+				? invert_rigid( mModel2World )
+				: invert_affine( mModel2World )
+			;
+		}
+
+	private:
+		Mat44f mModel2World;
+		Kind mKind;
+
+		mutable bool mNormalDirty;
+		mutable Mat33f mNormalMatrix;
+};
+
+#endif // MODEL_TRANSFORM_HPP_B8A7F0D3_96C4_4E1B_8D3A_5F2C7E9A1B04
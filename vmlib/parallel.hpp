@@ -0,0 +1,83 @@
+#ifndef PARALLEL_HPP_4659D81F_2024_4791_BA98_80F1ABE5F0B1
+#define PARALLEL_HPP_4659D81F_2024_4791_BA98_80F1ABE5F0B1
+
+#include <thread>
+#include <vector>
+#include <exception>
+#include <algorithm>
+
+#include <cstddef>
+
+/* Split the range [0, aCount) into contiguous chunks and process them on
+ * multiple threads. aFunc is called as aFunc( begin, end ).
+ *
+ * At most one chunk per hardware thread is created, and each chunk contains
+ * at least aMinChunk elements. Small inputs therefore run directly on the
+ * calling thread, without any threads being created. One chunk always runs
+ * on the calling thread.
+ *
+ * If aFunc throws, the first exception is rethrown on the calling thread once
+ * all chunks have finished.
+ *
+ * Creating and joining a thread takes about 20 microseconds (x86-64 Linux).
+ * A chunk should run a few times longer than that, at least about 50
+ * microseconds, or the thread costs more than it saves. Pick aMinChunk as
+ * 50 microseconds divided by the time per element, and note that time next
+ * to the constant.
+ */
+template< typename tFunc >
+void parallel_for( std::size_t aCount, std::size_t aMinChunk, tFunc&& aFunc )
+{
+	if( 0 == aCount )
+		return;
+
+	std::size_t const hardware = std::max( 1u, std::thread::hardware_concurrency() );
+	std::size_t const maxChunks = (aCount + aMinChunk - 1) / std::max<std::size_t>( aMinChunk, 1 );
+	std::size_t const chunks = std::min( hardware, maxChunks );
+
+	if( chunks <= 1 )
+	{
+		aFunc( std::size_t(0), aCount );
+		return;
+	}
+
+	std::vector<std::exception_ptr> errors( chunks );
+	auto run = [&] (std::size_t aChunk, std::size_t aBegin, std::size_t aEnd) {
+		try
+		{
+			aFunc( aBegin, aEnd );
+		}
+		catch( ... )
+		{
+			errors[aChunk] = std::current_exception();
+		}
+	};
+
+	std::vector<std::thread> threads;
+	threads.reserve( chunks-1 );
+
+	std::size_t const perChunk = aCount / chunks;
+	std::size_t const extra = aCount % chunks;
+
+	std::size_t begin = 0;
+	for( std::size_t c = 0; c < chunks; ++c )
+	{
+		std::size_t const end = begin + perChunk + (c < extra ? 1 : 0);
+		if( c+1 == chunks )
+			run( c, begin, end );
+		else
+			threads.emplace_back( run, c, begin, end );
+		begin = end;
+	}
+
+	for( auto& thread : threads )
+		thread.join();
+
+	for( auto const& error : errors )
+	{
+		if( error )
+			std::rethrow_exception( error );
+	}
+}
+
+#endif // PARALLEL_HPP_4659D81F_2024_4791_BA98_80F1ABE5F0B1
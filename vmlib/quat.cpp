@@ -0,0 +1,417 @@
+#include "quat.hpp"
+
+#include "simd.hpp"
+
+namespace
+{
+	struct QuatKernels_
+	{
+		void (*quat)( std::size_t, Quatf const*, Mat44f* ) noexcept;
+		void (*dual)( std::size_t, DualQuatf const*, Mat44f* ) noexcept;
+	};
+
+	// Scalar reference kernels
+	void quat_scalar_( std::size_t aCount, Quatf const* aIn, Mat44f* aOut ) noexcept
+	{
+		for( std::size_t i = 0; i < aCount; ++i )
+			aOut[i] = to_mat44( aIn[i] );
+	}
+	void dual_scalar_( std::size_t aCount, DualQuatf const* aIn, Mat44f* aOut ) noexcept
+	{
+		for( std::size_t i = 0; i < aCount; ++i )
+			aOut[i] = to_mat44( aIn[i] );
+	}
+
+	constexpr QuatKernels_ kScalarKernels_{ &quat_scalar_, &dual_scalar_ };
+
+	constexpr bool kColumnMajor_ = MatrixLayout::columnMajor == kMatrixLayout;
+
+	// The SIMD kernels convert four (SSE2, NEON) or eight (AVX2) quaternions
+	// at a time. The inputs are transposed into x, y, z and w registers, the
+	// twelve non-constant matrix elements are computed side by side, and the
+	// result is transposed back into rows (or columns, with column-major
+	// storage, see kMatrixLayout).
+#	if defined(VMLIB_SIMD_X86)
+	inline void transpose_sse2_( __m128& aR0, __m128& aR1, __m128& aR2, __m128& aR3 ) noexcept
+	{
+		_MM_TRANSPOSE4_PS( aR0, aR1, aR2, aR3 );
+	}
+
+	// Rotation part: r[0..2] = row 0, r[4..6] = row 1, r[8..10] = row 2.
+	inline void rotation_sse2_( __m128 aX, __m128 aY, __m128 aZ, __m128 aW, __m128* aR ) noexcept
+	{
+		__m128 const one = _mm_set1_ps( 1.f );
+		__m128 const x2 = _mm_add_ps( aX, aX ), y2 = _mm_add_ps( aY, aY ), z2 = _mm_add_ps( aZ, aZ );
+		__m128 const xx = _mm_mul_ps( aX, x2 ), yy = _mm_mul_ps( aY, y2 ), zz = _mm_mul_ps( aZ, z2 );
+		__m128 const xy = _mm_mul_ps( aX, y2 ), xz = _mm_mul_ps( aX, z2 ), yz = _mm_mul_ps( aY, z2 );
+		__m128 const wx = _mm_mul_ps( aW, x2 ), wy = _mm_mul_ps( aW, y2 ), wz = _mm_mul_ps( aW, z2 );
+
+		aR[0] = _mm_sub_ps( one, _mm_add_ps( yy, zz ) );
+		aR[1] = _mm_sub_ps( xy, wz );
+		aR[2] = _mm_add_ps( xz, wy );
+		aR[4] = _mm_add_ps( xy, wz );
+		aR[5] = _mm_sub_ps( one, _mm_add_ps( xx, zz ) );
+		aR[6] = _mm_sub_ps( yz, wx );
+		aR[8] = _mm_sub_ps( xz, wy );
+		aR[9] = _mm_add_ps( yz, wx );
+		aR[10] = _mm_sub_ps( one, _mm_add_ps( xx, yy ) );
+	}
+
+	// Stores four matrices, given by their top three rows in aR[4*row+col].
+	inline void store_sse2_( __m128* aR, Mat44f* aOut ) noexcept
+	{
+		if constexpr( kColumnMajor_ )
+		{
+			__m128 const zero = _mm_setzero_ps();
+			for( std::size_t col = 0; col < 4; ++col )
+			{
+				__m128 c[4] = { aR[col], aR[4+col], aR[8+col], 3 == col ? _mm_set1_ps( 1.f ) : zero };
+				transpose_sse2_( c[0], c[1], c[2], c[3] );
+				for( std::size_t k = 0; k < 4; ++k )
+					_mm_storeu_ps( aOut[k].v + 4*col, c[k] );
+			}
+		}
+		else
+		{
+			for( std::size_t row = 0; row < 3; ++row )
+			{
+				__m128* r = aR + 4*row;
+				transpose_sse2_( r[0], r[1], r[2], r[3] );
+				for( std::size_t k = 0; k < 4; ++k )
+					_mm_storeu_ps( aOut[k].v + 4*row, r[k] );
+			}
+
+			__m128 const last = _mm_setr_ps( 0.f, 0.f, 0.f, 1.f );
+			for( std::size_t k = 0; k < 4; ++k )
+				_mm_storeu_ps( aOut[k].v + 12, last );
+		}
+	}
+
+	void quat_sse2_( std::size_t aCount, Quatf const* aIn, Mat44f* aOut ) noexcept
+	{
+		std::size_t i = 0;
+		for( ; i+4 <= aCount; i += 4 )
+		{
+			__m128 x = _mm_loadu_ps( &aIn[i+0].x );
+			__m128 y = _mm_loadu_ps( &aIn[i+1].x );
+			__m128 z = _mm_loadu_ps( &aIn[i+2].x );
+			__m128 w = _mm_loadu_ps( &aIn[i+3].x );
+			transpose_sse2_( x, y, z, w );
+
+			__m128 r[12];
+			rotation_sse2_( x, y, z, w, r );
+			r[3] = r[7] = r[11] = _mm_setzero_ps();
+			store_sse2_( r, aOut+i );
+		}
+
+		quat_scalar_( aCount-i, aIn+i, aOut+i );
+	}
+	void dual_sse2_( std::size_t aCount, DualQuatf const* aIn, Mat44f* aOut ) noexcept
+	{
+		std::size_t i = 0;
+		for( ; i+4 <= aCount; i += 4 )
+		{
+			__m128 x = _mm_loadu_ps( &aIn[i+0].real.x );
+			__m128 y = _mm_loadu_ps( &aIn[i+1].real.x );
+			__m128 z = _mm_loadu_ps( &aIn[i+2].real.x );
+			__m128 w = _mm_loadu_ps( &aIn[i+3].real.x );
+			transpose_sse2_( x, y, z, w );
+
+			__m128 dx = _mm_loadu_ps( &aIn[i+0].dual.x );
+			__m128 dy = _mm_loadu_ps( &aIn[i+1].dual.x );
+			__m128 dz = _mm_loadu_ps( &aIn[i+2].dual.x );
+			__m128 dw = _mm_loadu_ps( &aIn[i+3].dual.x );
+			transpose_sse2_( dx, dy, dz, dw );
+
+			__m128 r[12];
+			rotation_sse2_( x, y, z, w, r );
+
+			// t = 2 (dual * conjugate(real)).xyz
+			__m128 const two = _mm_set1_ps( 2.f );
+			r[3] = _mm_mul_ps( two, _mm_add_ps(
+				_mm_sub_ps( _mm_mul_ps( dx, w ), _mm_mul_ps( dw, x ) ),
+				_mm_sub_ps( _mm_mul_ps( dz, y ), _mm_mul_ps( dy, z ) )
+			) );
+			r[7] = _mm_mul_ps( two, _mm_add_ps(
+				_mm_sub_ps( _mm_mul_ps( dy, w ), _mm_mul_ps( dw, y ) ),
+				_mm_sub_ps( _mm_mul_ps( dx, z ), _mm_mul_ps( dz, x ) )
+			) );
+			r[11] = _mm_mul_ps( two, _mm_add_ps(
+				_mm_sub_ps( _mm_mul_ps( dz, w ), _mm_mul_ps( dw, z ) ),
+				_mm_sub_ps( _mm_mul_ps( dy, x ), _mm_mul_ps( dx, y ) )
+			) );
+
+			store_sse2_( r, aOut+i );
+		}
+
+		dual_scalar_( aCount-i, aIn+i, aOut+i );
+	}
+
+	constexpr QuatKernels_ kSse2Kernels_{ &quat_sse2_, &dual_sse2_ };
+
+	// AVX2 kernels. The shuffles work on each 128-bit lane separately, so the
+	// low lane holds elements 0-3 and the high lane elements 4-7.
+	VMLIB_TARGET_AVX2
+	inline __m256 load2_( float const* aLo, float const* aHi ) noexcept
+	{
+		return _mm256_insertf128_ps( _mm256_castps128_ps256( _mm_loadu_ps( aLo ) ), _mm_loadu_ps( aHi ), 1 );
+	}
+	VMLIB_TARGET_AVX2
+	inline void store2_( float* aLo, float* aHi, __m256 aV ) noexcept
+	{
+		_mm_storeu_ps( aLo, _mm256_castps256_ps128( aV ) );
+		_mm_storeu_ps( aHi, _mm256_extractf128_ps( aV, 1 ) );
+	}
+
+	VMLIB_TARGET_AVX2
+	inline void transpose_avx2_( __m256& aR0, __m256& aR1, __m256& aR2, __m256& aR3 ) noexcept
+	{
+		__m256 const t0 = _mm256_unpacklo_ps( aR0, aR1 );
+		__m256 const t1 = _mm256_unpacklo_ps( aR2, aR3 );
+		__m256 const t2 = _mm256_unpackhi_ps( aR0, aR1 );
+		__m256 const t3 = _mm256_unpackhi_ps( aR2, aR3 );
+		aR0 = _mm256_shuffle_ps( t0, t1, _MM_SHUFFLE( 1, 0, 1, 0 ) );
+		aR1 = _mm256_shuffle_ps( t0, t1, _MM_SHUFFLE( 3, 2, 3, 2 ) );
+		aR2 = _mm256_shuffle_ps( t2, t3, _MM_SHUFFLE( 1, 0, 1, 0 ) );
+		aR3 = _mm256_shuffle_ps( t2, t3, _MM_SHUFFLE( 3, 2, 3, 2 ) );
+	}
+
+	VMLIB_TARGET_AVX2
+	inline void rotation_avx2_( __m256 aX, __m256 aY, __m256 aZ, __m256 aW, __m256* aR ) noexcept
+	{
+		__m256 const one = _mm256_set1_ps( 1.f );
+		__m256 const x2 = _mm256_add_ps( aX, aX ), y2 = _mm256_add_ps( aY, aY ), z2 = _mm256_add_ps( aZ, aZ );
+		__m256 const xx = _mm256_mul_ps( aX, x2 ), yy = _mm256_mul_ps( aY, y2 ), zz = _mm256_mul_ps( aZ, z2 );
+		__m256 const xy = _mm256_mul_ps( aX, y2 ), xz = _mm256_mul_ps( aX, z2 ), yz = _mm256_mul_ps( aY, z2 );
+		__m256 const wx = _mm256_mul_ps( aW, x2 ), wy = _mm256_mul_ps( aW, y2 ), wz = _mm256_mul_ps( aW, z2 );
+
+		aR[0] = _mm256_sub_ps( one, _mm256_add_ps( yy, zz ) );
+		aR[1] = _mm256_sub_ps( xy, wz );
+		aR[2] = _mm256_add_ps( xz, wy );
+		aR[4] = _mm256_add_ps( xy, wz );
+		aR[5] = _mm256_sub_ps( one, _mm256_add_ps( xx, zz ) );
+		aR[6] = _mm256_sub_ps( yz, wx );
+		aR[8] = _mm256_sub_ps( xz, wy );
+		aR[9] = _mm256_add_ps( yz, wx );
+		aR[10] = _mm256_sub_ps( one, _mm256_add_ps( xx, yy ) );
+	}
+
+	VMLIB_TARGET_AVX2
+	inline void store_avx2_( __m256* aR, Mat44f* aOut ) noexcept
+	{
+		if constexpr( kColumnMajor_ )
+		{
+			__m256 const zero = _mm256_setzero_ps();
+			for( std::size_t col = 0; col < 4; ++col )
+			{
+				__m256 c[4] = { aR[col], aR[4+col], aR[8+col], 3 == col ? _mm256_set1_ps( 1.f ) : zero };
+				transpose_avx2_( c[0], c[1], c[2], c[3] );
+				for( std::size_t k = 0; k < 4; ++k )
+					store2_( aOut[k].v + 4*col, aOut[k+4].v + 4*col, c[k] );
+			}
+		}
+		else
+		{
+			for( std::size_t row = 0; row < 3; ++row )
+			{
+				__m256* r = aR + 4*row;
+				transpose_avx2_( r[0], r[1], r[2], r[3] );
+				for( std::size_t k = 0; k < 4; ++k )
+					store2_( aOut[k].v + 4*row, aOut[k+4].v + 4*row, r[k] );
+			}
+
+			__m128 const last = _mm_setr_ps( 0.f, 0.f, 0.f, 1.f );
+			for( std::size_t k = 0; k < 8; ++k )
+				_mm_storeu_ps( aOut[k].v + 12, last );
+		}
+	}
+
+	VMLIB_TARGET_AVX2
+	void quat_avx2_( std::size_t aCount, Quatf const* aIn, Mat44f* aOut ) noexcept
+	{
+		std::size_t i = 0;
+		for( ; i+8 <= aCount; i += 8 )
+		{
+			__m256 x = load2_( &aIn[i+0].x, &aIn[i+4].x );
+			__m256 y = load2_( &aIn[i+1].x, &aIn[i+5].x );
+			__m256 z = load2_( &aIn[i+2].x, &aIn[i+6].x );
+			__m256 w = load2_( &aIn[i+3].x, &aIn[i+7].x );
+			transpose_avx2_( x, y, z, w );
+
+			__m256 r[12];
+			rotation_avx2_( x, y, z, w, r );
+			r[3] = r[7] = r[11] = _mm256_setzero_ps();
+			store_avx2_( r, aOut+i );
+		}
+
+		quat_sse2_( aCount-i, aIn+i, aOut+i );
+	}
+	VMLIB_TARGET_AVX2
+	void dual_avx2_( std::size_t aCount, DualQuatf const* aIn, Mat44f* aOut ) noexcept
+	{
+		std::size_t i = 0;
+		for( ; i+8 <= aCount; i += 8 )
+		{
+			__m256 x = load2_( &aIn[i+0].real.x, &aIn[i+4].real.x );
+			__m256 y = load2_( &aIn[i+1].real.x, &aIn[i+5].real.x );
+			__m256 z = load2_( &aIn[i+2].real.x, &aIn[i+6].real.x );
+			__m256 w = load2_( &aIn[i+3].real.x, &aIn[i+7].real.x );
+			transpose_avx2_( x, y, z, w );
+
+			__m256 dx = load2_( &aIn[i+0].dual.x, &aIn[i+4].dual.x );
+			__m256 dy = load2_( &aIn[i+1].dual.x, &aIn[i+5].dual.x );
+			__m256 dz = load2_( &aIn[i+2].dual.x, &aIn[i+6].dual.x );
+			__m256 dw = load2_( &aIn[i+3].dual.x, &aIn[i+7].dual.x );
+			transpose_avx2_( dx, dy, dz, dw );
+
+			__m256 r[12];
+			rotation_avx2_( x, y, z, w, r );
+
+			__m256 const two = _mm256_set1_ps( 2.f );
+			r[3] = _mm256_mul_ps( two, _mm256_fmsub_ps( dz, y, _mm256_fmsub_ps( dw, x, _mm256_fmsub_ps( dx, w, _mm256_mul_ps( dy, z ) ) ) ) );
+			r[7] = _mm256_mul_ps( two, _mm256_fmsub_ps( dx, z, _mm256_fmsub_ps( dw, y, _mm256_fmsub_ps( dy, w, _mm256_mul_ps( dz, x ) ) ) ) );
+			r[11] = _mm256_mul_ps( two, _mm256_fmsub_ps( dy, x, _mm256_fmsub_ps( dw, z, _mm256_fmsub_ps( dz, w, _mm256_mul_ps( dx, y ) ) ) ) );
+
+			store_avx2_( r, aOut+i );
+		}
+
+		dual_sse2_( aCount-i, aIn+i, aOut+i );
+	}
+
+	constexpr QuatKernels_ kAvx2Kernels_{ &quat_avx2_, &dual_avx2_ };
+#	endif // ~ VMLIB_SIMD_X86
+
+#	if defined(VMLIB_SIMD_NEON)
+	inline void transpose_neon_( float32x4_t& aR0, float32x4_t& aR1, float32x4_t& aR2, float32x4_t& aR3 ) noexcept
+	{
+		float32x4x2_t const t01 = vtrnq_f32( aR0, aR1 );
+		float32x4x2_t const t23 = vtrnq_f32( aR2, aR3 );
+		aR0 = vcombine_f32( vget_low_f32( t01.val[0] ), vget_low_f32( t23.val[0] ) );
+		aR1 = vcombine_f32( vget_low_f32( t01.val[1] ), vget_low_f32( t23.val[1] ) );
+		aR2 = vcombine_f32( vget_high_f32( t01.val[0] ), vget_high_f32( t23.val[0] ) );
+		aR3 = vcombine_f32( vget_high_f32( t01.val[1] ), vget_high_f32( t23.val[1] ) );
+	}
+
+	inline void rotation_neon_( float32x4_t aX, float32x4_t aY, float32x4_t aZ, float32x4_t aW, float32x4_t* aR ) noexcept
+	{
+		float32x4_t const one = vdupq_n_f32( 1.f );
+		float32x4_t const x2 = vaddq_f32( aX, aX ), y2 = vaddq_f32( aY, aY ), z2 = vaddq_f32( aZ, aZ );
+		float32x4_t const xx = vmulq_f32( aX, x2 ), yy = vmulq_f32( aY, y2 ), zz = vmulq_f32( aZ, z2 );
+		float32x4_t const xy = vmulq_f32( aX, y2 ), xz = vmulq_f32( aX, z2 ), yz = vmulq_f32( aY, z2 );
+		float32x4_t const wx = vmulq_f32( aW, x2 ), wy = vmulq_f32( aW, y2 ), wz = vmulq_f32( aW, z2 );
+
+		aR[0] = vsubq_f32( one, vaddq_f32( yy, zz ) );
+		aR[1] = vsubq_f32( xy, wz );
+		aR[2] = vaddq_f32( xz, wy );
+		aR[4] = vaddq_f32( xy, wz );
+		aR[5] = vsubq_f32( one, vaddq_f32( xx, zz ) );
+		aR[6] = vsubq_f32( yz, wx );
+		aR[8] = vsubq_f32( xz, wy );
+		aR[9] = vaddq_f32( yz, wx );
+		aR[10] = vsubq_f32( one, vaddq_f32( xx, yy ) );
+	}
+
+	inline void store_neon_( float32x4_t* aR, Mat44f* aOut ) noexcept
+	{
+		if constexpr( kColumnMajor_ )
+		{
+			float32x4_t const zero = vdupq_n_f32( 0.f );
+			for( std::size_t col = 0; col < 4; ++col )
+			{
+				float32x4_t c[4] = { aR[col], aR[4+col], aR[8+col], 3 == col ? vdupq_n_f32( 1.f ) : zero };
+				transpose_neon_( c[0], c[1], c[2], c[3] );
+				for( std::size_t k = 0; k < 4; ++k )
+					vst1q_f32( aOut[k].v + 4*col, c[k] );
+			}
+		}
+		else
+		{
+			for( std::size_t row = 0; row < 3; ++row )
+			{
+				float32x4_t* r = aR + 4*row;
+				transpose_neon_( r[0], r[1], r[2], r[3] );
+				for( std::size_t k = 0; k < 4; ++k )
+					vst1q_f32( aOut[k].v + 4*row, r[k] );
+			}
+
+			float const kLast[4] = { 0.f, 0.f, 0.f, 1.f };
+			float32x4_t const last = vld1q_f32( kLast );
+			for( std::size_t k = 0; k < 4; ++k )
+				vst1q_f32( aOut[k].v + 12, last );
+		}
+	}
+
+	void quat_neon_( std::size_t aCount, Quatf const* aIn, Mat44f* aOut ) noexcept
+	{
+		std::size_t i = 0;
+		for( ; i+4 <= aCount; i += 4 )
+		{
+			// vld4q de-interleaves x, y, z and w directly.
+			float32x4x4_t const q = vld4q_f32( &aIn[i].x );
+
+			float32x4_t r[12];
+			rotation_neon_( q.val[0], q.val[1], q.val[2], q.val[3], r );
+			r[3] = r[7] = r[11] = vdupq_n_f32( 0.f );
+			store_neon_( r, aOut+i );
+		}
+
+		quat_scalar_( aCount-i, aIn+i, aOut+i );
+	}
+	void dual_neon_( std::size_t aCount, DualQuatf const* aIn, Mat44f* aOut ) noexcept
+	{
+		std::size_t i = 0;
+		for( ; i+4 <= aCount; i += 4 )
+		{
+			float32x4_t x = vld1q_f32( &aIn[i+0].real.x );
+			float32x4_t y = vld1q_f32( &aIn[i+1].real.x );
+			float32x4_t z = vld1q_f32( &aIn[i+2].real.x );
+			float32x4_t w = vld1q_f32( &aIn[i+3].real.x );
+			transpose_neon_( x, y, z, w );
+
+			float32x4_t dx = vld1q_f32( &aIn[i+0].dual.x );
+			float32x4_t dy = vld1q_f32( &aIn[i+1].dual.x );
+			float32x4_t dz = vld1q_f32( &aIn[i+2].dual.x );
+			float32x4_t dw = vld1q_f32( &aIn[i+3].dual.x );
+			transpose_neon_( dx, dy, dz, dw );
+
+			float32x4_t r[12];
+			rotation_neon_( x, y, z, w, r );
+
+			float32x4_t const two = vdupq_n_f32( 2.f );
+			r[3] = vmulq_f32( two, vfmsq_f32( vfmsq_f32( vfmaq_f32( vmulq_f32( dx, w ), dz, y ), dw, x ), dy, z ) );
+			r[7] = vmulq_f32( two, vfmsq_f32( vfmsq_f32( vfmaq_f32( vmulq_f32( dy, w ), dx, z ), dw, y ), dz, x ) );
+			r[11] = vmulq_f32( two, vfmsq_f32( vfmsq_f32( vfmaq_f32( vmulq_f32( dz, w ), dy, x ), dw, z ), dx, y ) );
+
+			store_neon_( r, aOut+i );
+		}
+
+		dual_scalar_( aCount-i, aIn+i, aOut+i );
+	}
+
+	constexpr QuatKernels_ kNeonKernels_{ &quat_neon_, &dual_neon_ };
+#	endif // ~ VMLIB_SIMD_NEON
+
+	QuatKernels_ const& kernels_() noexcept
+	{
+		switch( simd_active_isa() )
+		{
+#			if defined(VMLIB_SIMD_X86)
+			case SimdIsa::sse2: return kSse2Kernels_;
+			case SimdIsa::avx2: return kAvx2Kernels_;
+#			endif
+#			if defined(VMLIB_SIMD_NEON)
+			case SimdIsa::neon: return kNeonKernels_;
+#			endif
+			default: return kScalarKernels_;
+		}
+	}
+}
+
+void quat_to_mat44_n( std::size_t aCount, Quatf const* aIn, Mat44f* aOut ) noexcept
+{
+	kernels_().quat( aCount, aIn, aOut );
+}
+void dual_quat_to_mat44_n( std::size_t aCount, DualQuatf const* aIn, Mat44f* aOut ) noexcept
+{
+	kernels_().dual( aCount, aIn, aOut );
+}
@@ -0,0 +1,274 @@
+#ifndef QUAT_HPP_D8B14394_1D22_4E71_8920_DB62A8652CF2
+#define QUAT_HPP_D8B14394_1D22_4E71_8920_DB62A8652CF2
+
+#include <cmath>
+#include <cstddef>
+
+#include "vec3.hpp"
+#include "mat33.hpp"
+#include "mat44.hpp"
+
+/** Quatf: rotation quaternion with floats
+ *
+ * The quaternion is stored as (x, y, z, w), where w is the scalar part. Only
+ * unit quaternions represent rotations; the functions below assume their
+ * inputs are normalized unless noted otherwise.
+ *
+ * Composition follows the matrix convention: for rotations a and b,
+ *    to_mat44( a * b ) == to_mat44( a ) * to_mat44( b )
+ * i.e., b is applied first. Composing two quaternions takes 16 multiplies,
+ * compared to 64 for a Mat44f product.
+ *
+ * Example:
+ *    Quatf q = make_quat_rotation( { 0.f, 0.f, 1.f }, angle );
+ *    Mat44f model2world = make_translation( pos ) * to_mat44( q );
+ */
+struct Quatf
+{
+	float x, y, z, w;
+};
+
+constexpr Quatf kIdentityQuatf = { 0.f, 0.f, 0.f, 1.f };
+
+constexpr
+Quatf operator*( Quatf const& aLeft, Quatf const& aRight ) noexcept
+{
+	return Quatf{
+		aLeft.w*aRight.x + aLeft.x*aRight.w + aLeft.y*aRight.z - aLeft.z*aRight.y,
+		aLeft.w*aRight.y - aLeft.x*aRight.z + aLeft.y*aRight.w + aLeft.z*aRight.x,
+		aLeft.w*aRight.z + aLeft.x*aRight.y - aLeft.y*aRight.x + aLeft.z*aRight.w,
+		aLeft.w*aRight.w - aLeft.x*aRight.x - aLeft.y*aRight.y - aLeft.z*aRight.z
+	};
+}
+
+constexpr
+Quatf operator+( Quatf const& aLeft, Quatf const& aRight ) noexcept
+{
+	return Quatf{ aLeft.x + aRight.x, aLeft.y + aRight.y, aLeft.z + aRight.z, aLeft.w + aRight.w };
+}
+
+constexpr
+Quatf operator*( float aScalar, Quatf const& aQ ) noexcept
+{
+	return Quatf{ aScalar * aQ.x, aScalar * aQ.y, aScalar * aQ.z, aScalar * aQ.w };
+}
+
+constexpr
+float dot( Quatf const& aLeft, Quatf const& aRight ) noexcept
+{
+	return aLeft.x*aRight.x + aLeft.y*aRight.y + aLeft.z*aRight.z + aLeft.w*aRight.w;
+}
+
+// The conjugate is the inverse rotation for unit quaternions.
+constexpr
+Quatf conjugate( Quatf const& aQ ) noexcept
+{
+	return Quatf{ -aQ.x, -aQ.y, -aQ.z, aQ.w };
+}
+
+// Not an overload of normalize(): that would make normalize( { x, y, z } )
+// ambiguous for Vec3f.
+inline
+Quatf normalize_quat( Quatf const& aQ ) noexcept
+{
+	return (1.f / std::sqrt( dot( aQ, aQ ) )) * aQ;
+}
+
+// Rotation by aAngle radians around the unit axis aAxis.
+inline
+Quatf make_quat_rotation( Vec3f aAxis, float aAngle ) noexcept
+{
+	float const s = std::sin( 0.5f * aAngle );
+	return Quatf{ s * aAxis.x, s * aAxis.y, s * aAxis.z, std::cos( 0.5f * aAngle ) };
+}
+
+// Rotates the vector aV, i.e., to_mat33( aQ ) * aV. Uses the form
+//    v' = v + w t + q.xyz × t,  with t = 2 (q.xyz × v)
+constexpr
+Vec3f rotate( Quatf const& aQ, Vec3f aV ) noexcept
+{
+	Vec3f const u{ aQ.x, aQ.y, aQ.z };
+	Vec3f const c{ u.y*aV.z - u.z*aV.y, u.z*aV.x - u.x*aV.z, u.x*aV.y - u.y*aV.x };
+	Vec3f const t = 2.f * c;
+	return aV + aQ.w * t + Vec3f{ u.y*t.z - u.z*t.y, u.z*t.x - u.x*t.z, u.x*t.y - u.y*t.x };
+}
+
+// Normalized linear interpolation along the shorter arc. Cheaper than slerp()
+// and fine for small steps, but the angular velocity is not constant.
+inline
+Quatf nlerp( Quatf const& aA, Quatf const& aB, float aT ) noexcept
+{
+	float const sign = dot( aA, aB ) < 0.f ? -1.f : 1.f;
+	return normalize_quat( (1.f - aT) * aA + (sign * aT) * aB );
+}
+
+// Spherical linear interpolation along the shorter arc. Falls back to nlerp()
+// when the two rotations are nearly identical, where the sin() terms lose
+// precision.
+inline
+Quatf slerp( Quatf const& aA, Quatf const& aB, float aT ) noexcept
+{
+	float d = dot( aA, aB );
+	Quatf b = aB;
+	if( d < 0.f )
+	{
+		d = -d;
+		b = -1.f * aB;
+	}
+
+	if( d > 0.9995f )
+		return nlerp( aA, b, aT );
+
+	float const theta = std::acos( d );
+	float const invSin = 1.f / std::sin( theta );
+	float const wa = std::sin( (1.f - aT) * theta ) * invSin;
+	float const wb = std::sin( aT * theta ) * invSin;
+	return wa * aA + wb * b;
+}
+
+inline
+Mat33f to_mat33( Quatf const& aQ ) noexcept
+{
+	float const xx = aQ.x*aQ.x, yy = aQ.y*aQ.y, zz = aQ.z*aQ.z;
+	float const xy = aQ.x*aQ.y, xz = aQ.x*aQ.z, yz = aQ.y*aQ.z;
+	float const wx = aQ.w*aQ.x, wy = aQ.w*aQ.y, wz = aQ.w*aQ.z;
+
+	return mat33_from_rows( {
+		1.f - 2.f*(yy + zz), 2.f*(xy - wz), 2.f*(xz + wy),
+		2.f*(xy + wz), 1.f - 2.f*(xx + zz), 2.f*(yz - wx),
+		2.f*(xz - wy), 2.f*(yz + wx), 1.f - 2.f*(xx + yy)
+	} );
+}
+
+inline
+Mat44f to_mat44( Quatf const& aQ ) noexcept
+{
+	Mat33f const r = to_mat33( aQ );
+	return mat44_from_rows( {
+		r(0,0), r(0,1), r(0,2), 0.f,
+		r(1,0), r(1,1), r(1,2), 0.f,
+		r(2,0), r(2,1), r(2,2), 0.f,
+		0.f, 0.f, 0.f, 1.f
+	} );
+}
+
+
+/** DualQuatf: rigid body transform (rotation and translation) as a dual
+ * quaternion
+ *
+ * real holds the rotation, dual encodes the translation t as
+ *    dual = 0.5 * (t,0) * real
+ *
+ * Like for Quatf, a * b applies b first. A DualQuatf is 8 floats compared to
+ * 16 for a Mat44f, and composing two costs 48 multiplies instead of 64. Since
+ * rotation and translation stay separated, they can also be interpolated
+ * without shearing artefacts.
+ *
+ * Example:
+ *    DualQuatf stage = make_dual_quat( make_quat_rotation( axis, a ), offset );
+ *    DualQuatf world = vehicle * stage;
+ *    Mat44f model2world = to_mat44( world );
+ */
+struct DualQuatf
+{
+	Quatf real;
+	Quatf dual;
+};
+
+constexpr DualQuatf kIdentityDualQuatf = { { 0.f, 0.f, 0.f, 1.f }, { 0.f, 0.f, 0.f, 0.f } };
+
+// Rotate by aRotation, then translate by aTranslation.
+constexpr
+DualQuatf make_dual_quat( Quatf const& aRotation, Vec3f aTranslation ) noexcept
+{
+	return DualQuatf{
+		aRotation,
+		0.5f * (Quatf{ aTranslation.x, aTranslation.y, aTranslation.z, 0.f } * aRotation)
+	};
+}
+
+constexpr
+DualQuatf operator*( DualQuatf const& aLeft, DualQuatf const& aRight ) noexcept
+{
+	return DualQuatf{
+		aLeft.real * aRight.real,
+		aLeft.real * aRight.dual + aLeft.dual * aRight.real
+	};
+}
+
+constexpr
+DualQuatf conjugate( DualQuatf const& aQ ) noexcept
+{
+	return DualQuatf{ conjugate( aQ.real ), conjugate( aQ.dual ) };
+}
+
+// Rescales to unit length and removes the part of dual that is not
+// orthogonal to real. Use after many compositions to counter drift.
+inline
+DualQuatf normalize_dual_quat( DualQuatf const& aQ ) noexcept
+{
+	float const inv = 1.f / std::sqrt( dot( aQ.real, aQ.real ) );
+	Quatf const real = inv * aQ.real;
+	Quatf const dual = inv * aQ.dual;
+	return DualQuatf{ real, dual + (-dot( real, dual )) * real };
+}
+
+constexpr
+Vec3f translation( DualQuatf const& aQ ) noexcept
+{
+	Quatf const t = aQ.dual * conjugate( aQ.real );
+	return Vec3f{ 2.f * t.x, 2.f * t.y, 2.f * t.z };
+}
+
+constexpr
+Vec3f transform_point( DualQuatf const& aQ, Vec3f aP ) noexcept
+{
+	return rotate( aQ.real, aP ) + translation( aQ );
+}
+
+// Dual quaternion linear blending: normalized linear interpolation of both
+// parts along the shorter arc.
+inline
+DualQuatf nlerp( DualQuatf const& aA, DualQuatf const& aB, float aT ) noexcept
+{
+	float const sign = dot( aA.real, aB.real ) < 0.f ? -1.f : 1.f;
+	return normalize_dual_quat( DualQuatf{
+		(1.f - aT) * aA.real + (sign * aT) * aB.real,
+		(1.f - aT) * aA.dual + (sign * aT) * aB.dual
+	} );
+}
+
+// Interpolates the rotation with slerp() and the translation linearly. This
+// is not the screw-linear interpolation (ScLERP), but the rotation has
+// constant angular velocity and the path of the origin is a straight line,
+// which is usually what animation wants.
+inline
+DualQuatf slerp( DualQuatf const& aA, DualQuatf const& aB, float aT ) noexcept
+{
+	Vec3f const ta = translation( aA );
+	Vec3f const tb = translation( aB );
+	return make_dual_quat( slerp( aA.real, aB.real, aT ), ta + aT * (tb - ta) );
+}
+
+inline
+Mat44f to_mat44( DualQuatf const& aQ ) noexcept
+{
+	Mat44f ret = to_mat44( aQ.real );
+	Vec3f const t = translation( aQ );
+	ret(0,3) = t.x;
+	ret(1,3) = t.y;
+	ret(2,3) = t.z;
+	return ret;
+}
+
+
+/* Batched conversion
+ *
+ * Converts arrays of unit (dual) quaternions to matrices using the SIMD
+ * instruction set selected by simd.hpp. Same results as calling to_mat44()
+ * on each element, up to floating point rounding. Defined in quat.cpp.
+ */
+void quat_to_mat44_n( std::size_t aCount, Quatf const* aIn, Mat44f* aOut ) noexcept;
+void dual_quat_to_mat44_n( std::size_t aCount, DualQuatf const* aIn, Mat44f* aOut ) noexcept;
+
+#endif // QUAT_HPP_D8B14394_1D22_4E71_8920_DB62A8652CF2
@@ -0,0 +1,121 @@
+#include "simd.hpp"
+
+#include <atomic>
+#include <initializer_list>
+
+#include <cstdlib>
+#include <cstring>
+
+#if defined(VMLIB_SIMD_X86) && defined(_MSC_VER)
+#	include <intrin.h>
+#endif
+
+namespace
+{
+	constexpr int kUnset_ = -1;
+	std::atomic<int> gActiveIsa_{ kUnset_ };
+
+	SimdIsa detect_()
+	{
+#		if defined(VMLIB_SIMD_X86)
+#			if defined(_MSC_VER)
+		int info[4];
+		__cpuid( info, 0 );
+		if( info[0] >= 7 )
+		{
+			__cpuid( info, 1 );
+			bool const fma = (info[2] & (1<<12)) != 0;
+			bool const osxsave = (info[2] & (1<<27)) != 0;
+			bool const avx = (info[2] & (1<<28)) != 0;
+
+			__cpuidex( info, 7, 0 );
+			bool const avx2 = (info[1] & (1<<5)) != 0;
+
+			// The OS must also save the YMM registers on context switches.
+			if( fma && osxsave && avx && avx2 && (_xgetbv( 0 ) & 0x6) == 0x6 )
+				return SimdIsa::avx2;
+		}
+		return SimdIsa::sse2;
+#			else
+		__builtin_cpu_init();
+		if( __builtin_cpu_supports( "avx2" ) && __builtin_cpu_supports( "fma" ) )
+			return SimdIsa::avx2;
+		return SimdIsa::sse2;
+#			endif
+#		elif defined(VMLIB_SIMD_NEON)
+		return SimdIsa::neon;
+#		else
+		return SimdIsa::scalar;
+#		endif
+	}
+
+	SimdIsa from_env_( SimdIsa aDefault )
+	{
+		char const* env = std::getenv( "VMLIB_SIMD" );
+		if( !env )
+			return aDefault;
+
+		for( auto const isa : { SimdIsa::scalar, SimdIsa::sse2, SimdIsa::avx2, SimdIsa::neon } )
+		{
+			if( 0 == std::strcmp( env, simd_isa_name( isa ) ) && simd_isa_supported( isa ) )
+				return isa;
+		}
+
+		return aDefault;
+	}
+}
+
+SimdIsa simd_detect_isa() noexcept
+{
+	static SimdIsa const isa = detect_();
+	return isa;
+}
+
+SimdIsa simd_active_isa() noexcept
+{
+	int isa = gActiveIsa_.load( std::memory_order_relaxed );
+	if( kUnset_ == isa )
+	{
+		int expected = kUnset_;
+		gActiveIsa_.compare_exchange_strong( expected, int(from_env_( simd_detect_isa() )) );
+		isa = gActiveIsa_.load( std::memory_order_relaxed );
+	}
+
+	return SimdIsa(isa);
+}
+
+bool simd_isa_supported( SimdIsa aIsa ) noexcept
+{
+	auto const best = simd_detect_isa();
+	switch( aIsa )
+	{
+		case SimdIsa::scalar: return true;
+		case SimdIsa::sse2: return SimdIsa::sse2 == best || SimdIsa::avx2 == best;
+		case SimdIsa::avx2: return SimdIsa::avx2 == best;
+		case SimdIsa::neon: return SimdIsa::neon == best;
+	}
+
+	return false;
+}
+
+bool simd_set_isa( SimdIsa aIsa ) noexcept
+{
+	if( !simd_isa_supported( aIsa ) )
+		return false;
+
+	gActiveIsa_.store( int(aIsa), std::memory_order_relaxed );
+	return true;
+}
+
+char const* simd_isa_name( SimdIsa aIsa ) noexcept
+{
+	switch( aIsa )
+	{
+		case SimdIsa::scalar: return "scalar";
+		case SimdIsa::sse2: return "sse2";
+		case SimdIsa::avx2: return "avx2";
+		case SimdIsa::neon: return "neon";
+	}
+
+	return "unknown";
+}
@@ -0,0 +1,52 @@
+#ifndef SIMD_HPP_9C923FAC_1AC6_425B_AC64_AE2666B54E80
+#define SIMD_HPP_9C923FAC_1AC6_425B_AC64_AE2666B54E80
+
+// Runtime instruction set selection for the SIMD kernels in vmlib.
+//
+// The kernels (see mat44_simd.hpp and friends) are compiled for several
+// instruction sets. The best one supported by the CPU is picked the first
+// time a kernel is called. The choice can be overridden with the VMLIB_SIMD
+// environment variable ("scalar", "sse2", "avx2" or "neon"), or from code via
+// simd_set_isa(), which is mainly useful for tests and benchmarks.
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#	define VMLIB_SIMD_X86 1
+#	include <immintrin.h>
+#elif defined(__aarch64__) || defined(_M_ARM64)
+#	define VMLIB_SIMD_NEON 1
+#	include <arm_neon.h>
+#endif
+
+// GCC and clang only allow intrinsics for instruction sets that are enabled
+// for the current function. VMLIB_TARGET_AVX2 enables AVX2+FMA for a single
+// function, so that the kernels can be built without -mavx2 and selected at
+// runtime. MSVC does not need this.
+#if defined(VMLIB_SIMD_X86) && (defined(__GNUC__) || defined(__clang__))
+#	define VMLIB_TARGET_AVX2 __attribute__((target("avx2,fma")))
+#else
+#	define VMLIB_TARGET_AVX2
+#endif
+
+enum class SimdIsa
+{
+	scalar,
+	sse2,
+	avx2,
+	neon
+};
+
+// Best instruction set supported by the CPU (ignores any override).
+SimdIsa simd_detect_isa() noexcept;
+
+// Instruction set currently used by the dispatched kernels.
+SimdIsa simd_active_isa() noexcept;
+
+bool simd_isa_supported( SimdIsa ) noexcept;
+
+// Override the active instruction set. Returns false (and leaves the current
+// selection untouched) if the CPU does not support the requested one.
+bool simd_set_isa( SimdIsa ) noexcept;
+
+char const* simd_isa_name( SimdIsa ) noexcept;
+
+#endif // SIMD_HPP_9C923FAC_1AC6_425B_AC64_AE2666B54E80
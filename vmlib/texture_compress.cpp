@@ -0,0 +1,614 @@
+#include "texture_compress.hpp"
+
+#include <algorithm>
+
+#include <cmath>
+#include <cassert>
+#include <cstring>
+
+#include "simd.hpp"
+#include "parallel.hpp"
+
+namespace
+{
+	// About 15 ns per output texel, and 2000 ns per BC7 block. Both give chunks
+	// of a millisecond or more, well above the minimum (see parallel_for()).
+	constexpr std::size_t kMinTexelsPerThread_ = 64*1024;
+	constexpr std::size_t kMinBlocksPerThread_ = 1024;
+
+	// sRGB conversion tables
+	//
+	// Linear values are encoded by looking up the top bits of their float
+	// representation: values in [2^-13, 1] are split into 2^9 buckets per
+	// power of two. Each bucket is narrow enough that all of its values map
+	// to within about 0.2 of the same sRGB value. Everything below 2^-13
+	// encodes to zero anyway.
+	constexpr std::uint32_t kEncodeMinBits_ = 114u << 23; // 2^-13
+	constexpr std::uint32_t kEncodeOneBits_ = 127u << 23; // 1.0
+	constexpr unsigned kEncodeShift_ = 23 - 9;
+	constexpr std::size_t kEncodeSize_ = ((kEncodeOneBits_ - kEncodeMinBits_) >> kEncodeShift_) + 1;
+
+	struct SrgbTables_
+	{
+		// [0,256): sRGB to linear. [256,512): alpha, as the unchanged value.
+		float decode[512];
+
+		// Linear to sRGB. Padded so that 32-bit gathers stay in bounds.
+		std::uint8_t encode[kEncodeSize_ + 3];
+	};
+
+	float bits_to_float_( std::uint32_t aBits ) noexcept
+	{
+		float ret;
+		std::memcpy( &ret, &aBits, sizeof(float) );
+		return ret;
+	}
+
+	SrgbTables_ make_srgb_tables_()
+	{
+		SrgbTables_ ret{};
+		for( int i = 0; i < 256; ++i )
+		{
+			double const c = i / 255.0;
+			ret.decode[i] = float(c <= 0.04045 ? c / 12.92 : std::pow( (c + 0.055) / 1.055, 2.4 ));
+			ret.decode[256+i] = float(i);
+		}
+
+		for( std::size_t i = 0; i < kEncodeSize_; ++i )
+		{
+			// Center of the bucket; the last one only holds 1.0.
+			std::uint32_t const bits = kEncodeMinBits_ + std::uint32_t(i << kEncodeShift_);
+			double const l = i+1 == kEncodeSize_ ? 1.0 : bits_to_float_( bits + (1u << (kEncodeShift_-1)) );
+			double const c = l <= 0.0031308 ? 12.92 * l : 1.055 * std::pow( l, 1.0/2.4 ) - 0.055;
+			ret.encode[i] = std::uint8_t(std::lround( std::clamp( c, 0.0, 1.0 ) * 255.0 ));
+		}
+		return ret;
+	}
+
+	SrgbTables_ const& srgb_tables_()
+	{
+		static SrgbTables_ const tables = make_srgb_tables_();
+		return tables;
+	}
+
+	// Downsampling kernels. Each computes one output row from the two input
+	// rows aRow0 and aRow1. The second texel of each 2x2 block is aDx bytes
+	// after the first (4, or 0 for images that are one texel wide).
+	//
+	// All kernels add the four texels in the same order and only scale by
+	// 0.25, which is exact, so their results are identical.
+	using DownsampleKernel_ = void (*)( std::size_t, std::uint8_t const*, std::uint8_t const*, std::size_t, std::uint8_t*, SrgbTables_ const& ) noexcept;
+
+	struct TextureKernels_
+	{
+		DownsampleKernel_ downsample;
+	};
+
+	inline std::uint8_t encode_srgb_( float aLinear, SrgbTables_ const& aTables ) noexcept
+	{
+		float const c = std::min( std::max( aLinear, bits_to_float_( kEncodeMinBits_ ) ), 1.f );
+
+		std::uint32_t bits;
+		std::memcpy( &bits, &c, sizeof(float) );
+		return aTables.encode[(bits - kEncodeMinBits_) >> kEncodeShift_];
+	}
+
+	void downsample_scalar_( std::size_t aOutWidth, std::uint8_t const* aRow0, std::uint8_t const* aRow1, std::size_t aDx, std::uint8_t* aOut, SrgbTables_ const& aTables ) noexcept
+	{
+		for( std::size_t x = 0; x < aOutWidth; ++x )
+		{
+			std::uint8_t const* p0 = aRow0 + 8*x;
+			std::uint8_t const* p1 = p0 + aDx;
+			std::uint8_t const* p2 = aRow1 + 8*x;
+			std::uint8_t const* p3 = p2 + aDx;
+
+			for( std::size_t c = 0; c < 4; ++c )
+			{
+				float const* table = aTables.decode + (3 == c ? 256 : 0);
+				float const s = (((table[p0[c]] + table[p1[c]]) + table[p2[c]]) + table[p3[c]]) * 0.25f;
+
+				aOut[4*x+c] = 3 == c ? std::uint8_t(int(s + 0.5f)) : encode_srgb_( s, aTables );
+			}
+		}
+	}
+
+	constexpr TextureKernels_ kScalarKernels_{
+		&downsample_scalar_
+	};
+
+#	if defined(VMLIB_SIMD_X86)
+	// SSE2 kernel, one output texel (four channels) at a time. The table
+	// lookups remain scalar; SSE2 has no gathers.
+	inline __m128 load_linear_sse2_( std::uint8_t const* aTexel, SrgbTables_ const& aTables ) noexcept
+	{
+		return _mm_setr_ps( aTables.decode[aTexel[0]], aTables.decode[aTexel[1]], aTables.decode[aTexel[2]], aTables.decode[256+aTexel[3]] );
+	}
+
+	void downsample_sse2_( std::size_t aOutWidth, std::uint8_t const* aRow0, std::uint8_t const* aRow1, std::size_t aDx, std::uint8_t* aOut, SrgbTables_ const& aTables ) noexcept
+	{
+		__m128 const minLinear = _mm_castsi128_ps( _mm_set1_epi32( int(kEncodeMinBits_) ) );
+		__m128i const minBits = _mm_set1_epi32( int(kEncodeMinBits_) );
+
+		for( std::size_t x = 0; x < aOutWidth; ++x )
+		{
+			std::uint8_t const* p0 = aRow0 + 8*x;
+			std::uint8_t const* p2 = aRow1 + 8*x;
+
+			__m128 s = _mm_add_ps( load_linear_sse2_( p0, aTables ), load_linear_sse2_( p0 + aDx, aTables ) );
+			s = _mm_add_ps( s, load_linear_sse2_( p2, aTables ) );
+			s = _mm_add_ps( s, load_linear_sse2_( p2 + aDx, aTables ) );
+			s = _mm_mul_ps( s, _mm_set1_ps( 0.25f ) );
+
+			__m128 const c = _mm_min_ps( _mm_max_ps( s, minLinear ), _mm_set1_ps( 1.f ) );
+			__m128i const index = _mm_srli_epi32( _mm_sub_epi32( _mm_castps_si128( c ), minBits ), kEncodeShift_ );
+			__m128i const alpha = _mm_cvttps_epi32( _mm_add_ps( s, _mm_set1_ps( 0.5f ) ) );
+
+			alignas(16) std::int32_t idx[4], a[4];
+			_mm_store_si128( reinterpret_cast<__m128i*>(idx), index );
+			_mm_store_si128( reinterpret_cast<__m128i*>(a), alpha );
+
+			aOut[4*x+0] = aTables.encode[idx[0]];
+			aOut[4*x+1] = aTables.encode[idx[1]];
+			aOut[4*x+2] = aTables.encode[idx[2]];
+			aOut[4*x+3] = std::uint8_t(a[3]);
+		}
+	}
+
+	constexpr TextureKernels_ kSse2Kernels_{
+		&downsample_sse2_
+	};
+
+	// AVX2 kernel, two output texels at a time, with gathers for the table
+	// lookups.
+	VMLIB_TARGET_AVX2
+	inline __m256 load_linear_avx2_( std::uint8_t const* aTexels, SrgbTables_ const& aTables ) noexcept
+	{
+		// Two texels; alpha lanes look up the second half of the table.
+		__m128i const bytes = _mm_loadl_epi64( reinterpret_cast<__m128i const*>(aTexels) );
+		__m256i const index = _mm256_add_epi32( _mm256_cvtepu8_epi32( bytes ), _mm256_setr_epi32( 0, 0, 0, 256, 0, 0, 0, 256 ) );
+		return _mm256_i32gather_ps( aTables.decode, index, 4 );
+	}
+
+	VMLIB_TARGET_AVX2
+	void downsample_avx2_( std::size_t aOutWidth, std::uint8_t const* aRow0, std::uint8_t const* aRow1, std::size_t aDx, std::uint8_t* aOut, SrgbTables_ const& aTables ) noexcept
+	{
+		__m256 const minLinear = _mm256_castsi256_ps( _mm256_set1_epi32( int(kEncodeMinBits_) ) );
+		__m256i const minBits = _mm256_set1_epi32( int(kEncodeMinBits_) );
+
+		// Moves the low byte of each 32-bit lane to the bottom of its half.
+		__m256i const packBytes = _mm256_setr_epi8(
+			0, 4, 8, 12, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+			0, 4, 8, 12, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1
+		);
+
+		std::size_t x = 0;
+		if( 4 == aDx )
+		{
+			for( ; x+2 <= aOutWidth; x += 2 )
+			{
+				// Input texels of output texels x (a) and x+1 (b)
+				//   r0 = [a0 a1], r1 = [b0 b1], r2 = [a2 a3], r3 = [b2 b3]
+				__m256 const r0 = load_linear_avx2_( aRow0 + 8*x, aTables );
+				__m256 const r1 = load_linear_avx2_( aRow0 + 8*x + 8, aTables );
+				__m256 const r2 = load_linear_avx2_( aRow1 + 8*x, aTables );
+				__m256 const r3 = load_linear_avx2_( aRow1 + 8*x + 8, aTables );
+
+				__m256 s = _mm256_add_ps( _mm256_permute2f128_ps( r0, r1, 0x20 ), _mm256_permute2f128_ps( r0, r1, 0x31 ) );
+				s = _mm256_add_ps( s, _mm256_permute2f128_ps( r2, r3, 0x20 ) );
+				s = _mm256_add_ps( s, _mm256_permute2f128_ps( r2, r3, 0x31 ) );
+				s = _mm256_mul_ps( s, _mm256_set1_ps( 0.25f ) );
+
+				__m256 const c = _mm256_min_ps( _mm256_max_ps( s, minLinear ), _mm256_set1_ps( 1.f ) );
+				__m256i const index = _mm256_srli_epi32( _mm256_sub_epi32( _mm256_castps_si256( c ), minBits ), kEncodeShift_ );
+				__m256i const color = _mm256_and_si256( _mm256_i32gather_epi32( reinterpret_cast<int const*>(aTables.encode), index, 1 ), _mm256_set1_epi32( 0xff ) );
+				__m256i const alpha = _mm256_cvttps_epi32( _mm256_add_ps( s, _mm256_set1_ps( 0.5f ) ) );
+
+				__m256i const packed = _mm256_shuffle_epi8( _mm256_blend_epi32( color, alpha, 0x88 ), packBytes );
+				std::uint32_t const lo = std::uint32_t(_mm_cvtsi128_si32( _mm256_castsi256_si128( packed ) ));
+				std::uint32_t const hi = std::uint32_t(_mm_cvtsi128_si32( _mm256_extracti128_si256( packed, 1 ) ));
+				std::memcpy( aOut + 4*x, &lo, 4 );
+				std::memcpy( aOut + 4*x + 4, &hi, 4 );
+			}
+		}
+
+		downsample_sse2_( aOutWidth-x, aRow0 + 8*x, aRow1 + 8*x, aDx, aOut + 4*x, aTables );
+	}
+
+	constexpr TextureKernels_ kAvx2Kernels_{
+		&downsample_avx2_
+	};
+#	endif // ~ VMLIB_SIMD_X86
+
+#	if defined(VMLIB_SIMD_NEON)
+	// NEON kernel, one output texel (four channels) at a time.
+	inline float32x4_t load_linear_neon_( std::uint8_t const* aTexel, SrgbTables_ const& aTables ) noexcept
+	{
+		float const v[4] = { aTables.decode[aTexel[0]], aTables.decode[aTexel[1]], aTables.decode[aTexel[2]], aTables.decode[256+aTexel[3]] };
+		return vld1q_f32( v );
+	}
+
+	void downsample_neon_( std::size_t aOutWidth, std::uint8_t const* aRow0, std::uint8_t const* aRow1, std::size_t aDx, std::uint8_t* aOut, SrgbTables_ const& aTables ) noexcept
+	{
+		float32x4_t const minLinear = vreinterpretq_f32_u32( vdupq_n_u32( kEncodeMinBits_ ) );
+		uint32x4_t const minBits = vdupq_n_u32( kEncodeMinBits_ );
+
+		for( std::size_t x = 0; x < aOutWidth; ++x )
+		{
+			std::uint8_t const* p0 = aRow0 + 8*x;
+			std::uint8_t const* p2 = aRow1 + 8*x;
+
+			float32x4_t s = vaddq_f32( load_linear_neon_( p0, aTables ), load_linear_neon_( p0 + aDx, aTables ) );
+			s = vaddq_f32( s, load_linear_neon_( p2, aTables ) );
+			s = vaddq_f32( s, load_linear_neon_( p2 + aDx, aTables ) );
+			s = vmulq_n_f32( s, 0.25f );
+
+			float32x4_t const c = vminq_f32( vmaxq_f32( s, minLinear ), vdupq_n_f32( 1.f ) );
+			uint32x4_t const index = vshrq_n_u32( vsubq_u32( vreinterpretq_u32_f32( c ), minBits ), kEncodeShift_ );
+			int32x4_t const alpha = vcvtq_s32_f32( vaddq_f32( s, vdupq_n_f32( 0.5f ) ) );
+
+			aOut[4*x+0] = aTables.encode[vgetq_lane_u32( index, 0 )];
+			aOut[4*x+1] = aTables.encode[vgetq_lane_u32( index, 1 )];
+			aOut[4*x+2] = aTables.encode[vgetq_lane_u32( index, 2 )];
+			aOut[4*x+3] = std::uint8_t(vgetq_lane_s32( alpha, 3 ));
+		}
+	}
+
+	constexpr TextureKernels_ kNeonKernels_{
+		&downsample_neon_
+	};
+#	endif // ~ VMLIB_SIMD_NEON
+
+	TextureKernels_ const& kernels_() noexcept
+	{
+		switch( simd_active_isa() )
+		{
+#			if defined(VMLIB_SIMD_X86)
+			case SimdIsa::sse2: return kSse2Kernels_;
+			case SimdIsa::avx2: return kAvx2Kernels_;
+#			endif
+#			if defined(VMLIB_SIMD_NEON)
+			case SimdIsa::neon: return kNeonKernels_;
+#			endif
+			default: return kScalarKernels_;
+		}
+	}
+
+
+	// BC7 mode 6
+	//
+	// 128 bits, least significant bit first:
+	//    7 bits     mode (0000001, i.e. bit 6 set)
+	//    8 x 7 bits endpoints: R0 R1 G0 G1 B0 B1 A0 A1
+	//    2 x 1 bit  p-bits P0 P1; endpoint i is (value << 1) | Pi
+	//    63 bits    indices, four bits per texel in row-major order, except
+	//               three for texel 0 (the "anchor", whose top bit is
+	//               implicitly zero)
+	constexpr int kBc7Weights4_[16] = { 0, 4, 9, 13, 17, 21, 26, 30, 34, 38, 43, 47, 51, 55, 60, 64 };
+
+	// Largest index whose weight is at most w, for w in [0,64]. The nearest
+	// weight is then that of this index or of the next one.
+	constexpr int kBc7WeightIndex_[65] = {
+		0, 0, 0, 0, 1, 1, 1, 1, 1, 2, 2, 2, 2, 3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 5,
+		6, 6, 6, 6, 7, 7, 7, 7, 8, 8, 8, 8, 9, 9, 9, 9, 9, 10, 10, 10, 10, 11, 11, 11, 11,
+		12, 12, 12, 12, 13, 13, 13, 13, 13, 14, 14, 14, 14, 15
+	};
+
+	struct Bc7Endpoint_
+	{
+		int q[4]; // 7-bit values
+		int p;    // p-bit
+
+		int value( int aChannel ) const noexcept { return (q[aChannel] << 1) | p; }
+	};
+
+	struct Bc7Candidate_
+	{
+		Bc7Endpoint_ e[2];
+		int index[16];
+		long error;
+	};
+
+	Bc7Endpoint_ quantize_bc7_( float const (&aColor)[4] )
+	{
+		Bc7Endpoint_ best{};
+		float bestError = -1.f;
+		for( int p = 0; p < 2; ++p )
+		{
+			Bc7Endpoint_ e{};
+			e.p = p;
+
+			float error = 0.f;
+			for( int c = 0; c < 4; ++c )
+			{
+				e.q[c] = std::clamp( int((aColor[c] - p) * 0.5f + 0.5f), 0, 127 );
+				float const d = float(e.value( c )) - aColor[c];
+				error += d*d;
+			}
+
+			if( bestError < 0.f || error < bestError )
+			{
+				best = e;
+				bestError = error;
+			}
+		}
+		return best;
+	}
+
+	// Picks the index of each texel for the endpoints in aCandidate, and
+	// computes the total squared error.
+	void assign_bc7_indices_( int const (&aTexels)[16][4], Bc7Candidate_& aCandidate )
+	{
+		int palette[16][4];
+		for( int i = 0; i < 16; ++i )
+		{
+			int const w = kBc7Weights4_[i];
+			for( int c = 0; c < 4; ++c )
+				palette[i][c] = ((64 - w) * aCandidate.e[0].value( c ) + w * aCandidate.e[1].value( c ) + 32) >> 6;
+		}
+
+		int axis[4];
+		long axisLength = 0;
+		for( int c = 0; c < 4; ++c )
+		{
+			axis[c] = palette[15][c] - palette[0][c];
+			axisLength += long(axis[c]) * axis[c];
+		}
+
+		aCandidate.error = 0;
+		for( int t = 0; t < 16; ++t )
+		{
+			// Estimate from the projection onto the endpoint line, then
+			// check the neighbouring indices.
+			int guess = 0;
+			if( axisLength > 0 )
+			{
+				long dot = 0;
+				for( int c = 0; c < 4; ++c )
+					dot += long(aTexels[t][c] - palette[0][c]) * axis[c];
+
+				int const w = std::clamp( int(64 * dot / axisLength), 0, 64 );
+				guess = kBc7WeightIndex_[w];
+			}
+
+			long bestError = -1;
+			for( int i = guess; i <= std::min( guess+1, 15 ); ++i )
+			{
+				long error = 0;
+				for( int c = 0; c < 4; ++c )
+				{
+					long const d = aTexels[t][c] - palette[i][c];
+					error += d*d;
+				}
+
+				if( bestError < 0 || error < bestError )
+				{
+					bestError = error;
+					aCandidate.index[t] = i;
+				}
+			}
+
+			aCandidate.error += bestError;
+		}
+	}
+
+	Bc7Candidate_ make_bc7_candidate_( int const (&aTexels)[16][4], float const (&aE0)[4], float const (&aE1)[4] )
+	{
+		Bc7Candidate_ ret;
+		ret.e[0] = quantize_bc7_( aE0 );
+		ret.e[1] = quantize_bc7_( aE1 );
+		assign_bc7_indices_( aTexels, ret );
+		return ret;
+	}
+
+	void encode_bc7_block_( int const (&aTexels)[16][4], std::uint8_t* aOut )
+	{
+		// Principal axis of the texels (power iteration on the covariance)
+		float mean[4] = {};
+		for( auto const& t : aTexels )
+		{
+			for( int c = 0; c < 4; ++c )
+				mean[c] += t[c];
+		}
+		for( auto& m : mean )
+			m /= 16.f;
+
+		float cov[4][4] = {};
+		for( auto const& t : aTexels )
+		{
+			float d[4];
+			for( int c = 0; c < 4; ++c )
+				d[c] = t[c] - mean[c];
+			for( int i = 0; i < 4; ++i )
+			{
+				for( int j = i; j < 4; ++j )
+					cov[i][j] += d[i] * d[j];
+			}
+		}
+		for( int i = 0; i < 4; ++i )
+		{
+			for( int j = 0; j < i; ++j )
+				cov[i][j] = cov[j][i];
+		}
+
+		float axis[4] = { 1.f, 1.f, 1.f, 1.f };
+		for( int iter = 0; iter < 8; ++iter )
+		{
+			float next[4];
+			float length = 0.f;
+			for( int i = 0; i < 4; ++i )
+			{
+				next[i] = cov[i][0]*axis[0] + cov[i][1]*axis[1] + cov[i][2]*axis[2] + cov[i][3]*axis[3];
+				length = std::max( length, std::abs( next[i] ) );
+			}
+
+			if( length < 1e-6f )
+				break;
+
+			for( int i = 0; i < 4; ++i )
+				axis[i] = next[i] / length;
+		}
+
+		// Endpoints: the extreme projections onto the axis
+		float axisLength = 0.f;
+		for( auto const a : axis )
+			axisLength += a*a;
+
+		float tmin = 0.f, tmax = 0.f;
+		if( axisLength > 1e-6f )
+		{
+			for( auto const& t : aTexels )
+			{
+				float proj = 0.f;
+				for( int c = 0; c < 4; ++c )
+					proj += (t[c] - mean[c]) * axis[c];
+				proj /= axisLength;
+
+				tmin = std::min( tmin, proj );
+				tmax = std::max( tmax, proj );
+			}
+		}
+
+		float e0[4], e1[4];
+		for( int c = 0; c < 4; ++c )
+		{
+			e0[c] = std::clamp( mean[c] + tmin * axis[c], 0.f, 255.f );
+			e1[c] = std::clamp( mean[c] + tmax * axis[c], 0.f, 255.f );
+		}
+
+		Bc7Candidate_ best = make_bc7_candidate_( aTexels, e0, e1 );
+
+		// Least squares refit of the endpoints to the chosen indices:
+		// minimize sum |(1-w) e0 + w e1 - t|^2 over e0 and e1.
+		if( best.error > 0 )
+		{
+			float a = 0.f, b = 0.f, d = 0.f;
+			float r0[4] = {}, r1[4] = {};
+			for( int t = 0; t < 16; ++t )
+			{
+				float const w = kBc7Weights4_[best.index[t]] / 64.f;
+				float const iw = 1.f - w;
+				a += iw*iw;
+				b += iw*w;
+				d += w*w;
+				for( int c = 0; c < 4; ++c )
+				{
+					r0[c] += iw * aTexels[t][c];
+					r1[c] += w * aTexels[t][c];
+				}
+			}
+
+			float const det = a*d - b*b;
+			if( std::abs( det ) > 1e-6f )
+			{
+				for( int c = 0; c < 4; ++c )
+				{
+					e0[c] = std::clamp( (d*r0[c] - b*r1[c]) / det, 0.f, 255.f );
+					e1[c] = std::clamp( (a*r1[c] - b*r0[c]) / det, 0.f, 255.f );
+				}
+
+				Bc7Candidate_ const refit = make_bc7_candidate_( aTexels, e0, e1 );
+				if( refit.error < best.error )
+					best = refit;
+			}
+		}
+
+		// The anchor index must be below 8; otherwise swap the endpoints.
+		if( best.index[0] >= 8 )
+		{
+			std::swap( best.e[0], best.e[1] );
+			for( auto& i : best.index )
+				i = 15 - i;
+		}
+
+		// Pack
+		std::memset( aOut, 0, 16 );
+		unsigned bit = 0;
+		auto const put = [&] (unsigned aValue, unsigned aBits) {
+			for( unsigned i = 0; i < aBits; ++i, ++bit )
+				aOut[bit >> 3] |= std::uint8_t(((aValue >> i) & 1u) << (bit & 7));
+		};
+
+		put( 1u << 6, 7 );
+		for( int c = 0; c < 4; ++c )
+		{
+			put( unsigned(best.e[0].q[c]), 7 );
+			put( unsigned(best.e[1].q[c]), 7 );
+		}
+		put( unsigned(best.e[0].p), 1 );
+		put( unsigned(best.e[1].p), 1 );
+
+		put( unsigned(best.index[0]), 3 );
+		for( int t = 1; t < 16; ++t )
+			put( unsigned(best.index[t]), 4 );
+		assert( 128 == bit );
+	}
+}
+
+std::size_t mip_size( std::size_t aSize, std::size_t aLevel ) noexcept
+{
+	return aLevel >= 8*sizeof(std::size_t) ? 1 : std::max<std::size_t>( aSize >> aLevel, 1 );
+}
+
+std::size_t mip_level_count( std::size_t aWidth, std::size_t aHeight ) noexcept
+{
+	std::size_t levels = 1;
+	for( std::size_t size = std::max( aWidth, aHeight ); size > 1; size >>= 1 )
+		++levels;
+	return levels;
+}
+
+void downsample_srgb8( std::size_t aWidth, std::size_t aHeight, std::uint8_t const* aIn, std::uint8_t* aOut )
+{
+	assert( aWidth > 0 && aHeight > 0 );
+
+	std::size_t const outWidth = mip_size( aWidth, 1 );
+	std::size_t const outHeight = mip_size( aHeight, 1 );
+	std::size_t const dx = aWidth > 1 ? 4 : 0;
+	std::size_t const dy = aHeight > 1 ? 4*aWidth : 0;
+
+	auto const& kernels = kernels_();
+	auto const& tables = srgb_tables_();
+
+	std::size_t const minRows = std::max<std::size_t>( kMinTexelsPerThread_ / outWidth, 1 );
+	parallel_for( outHeight, minRows, [&] (std::size_t aBegin, std::size_t aEnd) {
+		for( std::size_t y = aBegin; y < aEnd; ++y )
+		{
+			std::uint8_t const* row0 = aIn + 2*y * 4*aWidth;
+			kernels.downsample( outWidth, row0, row0 + dy, dx, aOut + y * 4*outWidth, tables );
+		}
+	} );
+}
+
+std::size_t bc7_size( std::size_t aWidth, std::size_t aHeight ) noexcept
+{
+	return ((aWidth + 3) / 4) * ((aHeight + 3) / 4) * 16;
+}
+
+void compress_bc7( std::size_t aWidth, std::size_t aHeight, std::uint8_t const* aRgba, std::uint8_t* aOut )
+{
+	assert( aWidth > 0 && aHeight > 0 );
+
+	std::size_t const blocksX = (aWidth + 3) / 4;
+	std::size_t const blocksY = (aHeight + 3) / 4;
+
+	std::size_t const minRows = std::max<std::size_t>( kMinBlocksPerThread_ / blocksX, 1 );
+	parallel_for( blocksY, minRows, [&] (std::size_t aBegin, std::size_t aEnd) {
+		int texels[16][4];
+		for( std::size_t by = aBegin; by < aEnd; ++by )
+		{
+			for( std::size_t bx = 0; bx < blocksX; ++bx )
+			{
+				for( std::size_t t = 0; t < 16; ++t )
+				{
+					std::size_t const x = std::min( 4*bx + t % 4, aWidth-1 );
+					std::size_t const y = std::min( 4*by + t / 4, aHeight-1 );
+					std::uint8_t const* texel = aRgba + 4 * (y * aWidth + x);
+					for( int c = 0; c < 4; ++c )
+						texels[t][c] = texel[c];
+				}
+
+				encode_bc7_block_( texels, aOut + 16 * (by * blocksX + bx) );
+			}
+		}
+	} );
+}
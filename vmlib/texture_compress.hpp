@@ -0,0 +1,54 @@
+#ifndef TEXTURE_COMPRESS_HPP_8E7123E2_EE60_4E1E_9FB2_215813172287
+#define TEXTURE_COMPRESS_HPP_8E7123E2_EE60_4E1E_9FB2_215813172287
+
+#include <cstddef>
+#include <cstdint>
+
+/** Mip generation and block compression for RGBA8 textures
+ *
+ * Images are arrays of RGBA8 texels, row by row, without padding. Color
+ * channels are sRGB encoded; alpha is linear.
+ *
+ * downsample_srgb8() computes the next level of a mip chain. Each output
+ * texel is the average of a 2x2 block of input texels. The color channels
+ * are converted to linear before averaging and back to sRGB afterwards, so
+ * the mips keep the brightness of the full image (averaging the sRGB values
+ * directly darkens them; the same thing glGenerateMipmap() does on some
+ * drivers). The conversions use tables, and the kernels are dispatched like
+ * those of fast_math.hpp (see simd.hpp). All instruction sets produce the
+ * same results, which are within one unit of the exact result.
+ *
+ * compress_bc7() encodes an image as BC7 (BPTC; GL_COMPRESSED_RGBA_BPTC_UNORM
+ * and GL_COMPRESSED_SRGB_ALPHA_BPTC_UNORM, core since OpenGL 4.2). Each 4x4
+ * block is stored in 16 bytes, a quarter of the size of RGBA8. The encoder
+ * only uses mode 6 (one pair of RGBA endpoints with 7 bits per channel plus
+ * a shared low bit per endpoint, and 16 interpolation steps); this handles
+ * smooth images such as photographs and terrain well, and is fast. The
+ * endpoints start on the principal axis of the block's colors, and are then
+ * refit by least squares to the chosen indices. Blocks are encoded on
+ * multiple threads (see parallel.hpp). Blocks that extend beyond the edge of
+ * the image repeat the last row and column.
+ *
+ * Both work with any size, including sizes that are not a multiple of four
+ * or of two. downsample_srgb8() drops the last row and/or column of odd
+ * sized images, as do most box filters.
+ */
+
+// Size of the mip level aLevel (level 0 = full size) of an image that is
+// aSize texels wide or high.
+std::size_t mip_size( std::size_t aSize, std::size_t aLevel ) noexcept;
+
+// Levels in a complete mip chain, down to 1x1.
+std::size_t mip_level_count( std::size_t aWidth, std::size_t aHeight ) noexcept;
+
+// aOut must have room for mip_size( aWidth, 1 ) x mip_size( aHeight, 1 )
+// texels, and must not overlap aIn.
+void downsample_srgb8( std::size_t aWidth, std::size_t aHeight, std::uint8_t const* aIn, std::uint8_t* aOut );
+
+// Size in bytes of a BC7 image: 16 bytes per 4x4 block.
+std::size_t bc7_size( std::size_t aWidth, std::size_t aHeight ) noexcept;
+
+// aOut must have room for bc7_size( aWidth, aHeight ) bytes.
+void compress_bc7( std::size_t aWidth, std::size_t aHeight, std::uint8_t const* aRgba, std::uint8_t* aOut );
+
+#endif // TEXTURE_COMPRESS_HPP_8E7123E2_EE60_4E1E_9FB2_215813172287
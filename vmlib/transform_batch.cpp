@@ -0,0 +1,496 @@
+#include "transform_batch.hpp"
+
+#include <cmath>
+
+#include "simd.hpp"
+#include "parallel.hpp"
+
+namespace
+{
+	// About 3 ns per element (see parallel_for())
+	constexpr std::size_t kMinPerThread_ = 32*1024;
+
+	struct Xform_
+	{
+		Mat44f m;
+		bool project;   // divide by w
+		bool normalize; // normalize results
+	};
+
+	struct BatchKernels_
+	{
+		void (*aos)( Xform_ const&, std::size_t, Vec3f const*, Vec3f* ) noexcept;
+		void (*soa)( Xform_ const&, std::size_t, Vec3fSoaConst, Vec3fSoa ) noexcept;
+	};
+
+	// Scalar kernels
+	template< bool tProject, bool tNormalize >
+	inline void xform_scalar_( Mat44f const& aM, float& aX, float& aY, float& aZ ) noexcept
+	{
+		float x = aM(0,0)*aX + aM(0,1)*aY + aM(0,2)*aZ + aM(0,3);
+		float y = aM(1,0)*aX + aM(1,1)*aY + aM(1,2)*aZ + aM(1,3);
+		float z = aM(2,0)*aX + aM(2,1)*aY + aM(2,2)*aZ + aM(2,3);
+
+		if constexpr( tProject )
+		{
+			float const w = aM(3,0)*aX + aM(3,1)*aY + aM(3,2)*aZ + aM(3,3);
+			x /= w;
+			y /= w;
+			z /= w;
+		}
+		if constexpr( tNormalize )
+		{
+			float const l = std::sqrt( x*x + y*y + z*z );
+			x /= l;
+			y /= l;
+			z /= l;
+		}
+
+		aX = x;
+		aY = y;
+		aZ = z;
+	}
+
+	template< bool tProject, bool tNormalize >
+	void aos_scalar_( Mat44f const& aM, std::size_t aCount, Vec3f const* aIn, Vec3f* aOut ) noexcept
+	{
+		for( std::size_t i = 0; i < aCount; ++i )
+		{
+			Vec3f v = aIn[i];
+			xform_scalar_<tProject,tNormalize>( aM, v.x, v.y, v.z );
+			aOut[i] = v;
+		}
+	}
+	template< bool tProject, bool tNormalize >
+	void soa_scalar_( Mat44f const& aM, std::size_t aCount, Vec3fSoaConst aIn, Vec3fSoa aOut ) noexcept
+	{
+		for( std::size_t i = 0; i < aCount; ++i )
+		{
+			float x = aIn.x[i], y = aIn.y[i], z = aIn.z[i];
+			xform_scalar_<tProject,tNormalize>( aM, x, y, z );
+			aOut.x[i] = x;
+			aOut.y[i] = y;
+			aOut.z[i] = z;
+		}
+	}
+
+	// Picks the template instance for the runtime flags.
+#	define VMLIB_XFORM_DISPATCH_( fn, params, ... ) do {                   \
+		if( params.project )                                                \
+			params.normalize ? fn<true,true>( __VA_ARGS__ )                 \
+			                 : fn<true,false>( __VA_ARGS__ );               \
+		else                                                                \
+			params.normalize ? fn<false,true>( __VA_ARGS__ )                \
+			                 : fn<false,false>( __VA_ARGS__ );              \
+	} while(0)                                                              \
+	/*ENDM*/
+
+	void aos_scalar_dispatch_( Xform_ const& aX, std::size_t aCount, Vec3f const* aIn, Vec3f* aOut ) noexcept
+	{
+		VMLIB_XFORM_DISPATCH_( aos_scalar_, aX, aX.m, aCount, aIn, aOut );
+	}
+	void soa_scalar_dispatch_( Xform_ const& aX, std::size_t aCount, Vec3fSoaConst aIn, Vec3fSoa aOut ) noexcept
+	{
+		VMLIB_XFORM_DISPATCH_( soa_scalar_, aX, aX.m, aCount, aIn, aOut );
+	}
+
+	constexpr BatchKernels_ kScalarKernels_{ &aos_scalar_dispatch_, &soa_scalar_dispatch_ };
+
+#	if defined(VMLIB_SIMD_X86)
+	// SSE2 kernels. Four points are processed at a time. For the AoS layout,
+	// the 12 floats of four Vec3f are loaded with three 128-bit loads and
+	// shuffled into x, y and z registers (and back before storing).
+	template< int tX, int tY, int tZ, int tW >
+	inline __m128 shuffle_( __m128 aA, __m128 aB ) noexcept
+	{
+		return _mm_shuffle_ps( aA, aB, _MM_SHUFFLE( tW, tZ, tY, tX ) );
+	}
+
+	inline void aos_to_soa_( __m128 aA, __m128 aB, __m128 aC, __m128& aX, __m128& aY, __m128& aZ ) noexcept
+	{
+		// a = (x0 y0 z0 x1), b = (y1 z1 x2 y2), c = (z2 x3 y3 z3)
+		aX = shuffle_<0,1,0,2>( shuffle_<0,3,2,3>( aA, aB ), shuffle_<2,2,1,1>( aB, aC ) );
+		aY = shuffle_<0,2,0,2>( shuffle_<1,1,0,0>( aA, aB ), shuffle_<3,3,2,2>( aB, aC ) );
+		aZ = shuffle_<0,2,0,2>( shuffle_<2,2,1,1>( aA, aB ), shuffle_<0,0,3,3>( aC, aC ) );
+	}
+	inline void soa_to_aos_( __m128 aX, __m128 aY, __m128 aZ, __m128& aA, __m128& aB, __m128& aC ) noexcept
+	{
+		aA = shuffle_<0,2,0,2>( shuffle_<0,0,0,0>( aX, aY ), shuffle_<0,0,1,1>( aZ, aX ) );
+		aB = shuffle_<0,2,0,2>( shuffle_<1,1,1,1>( aY, aZ ), shuffle_<2,2,2,2>( aX, aY ) );
+		aC = shuffle_<0,2,0,2>( shuffle_<2,2,3,3>( aZ, aX ), shuffle_<3,3,3,3>( aY, aZ ) );
+	}
+
+	template< bool tProject, bool tNormalize >
+	inline void xform_sse2_( __m128 const* aM, __m128& aX, __m128& aY, __m128& aZ ) noexcept
+	{
+		__m128 x = _mm_add_ps( _mm_add_ps( _mm_mul_ps( aM[0], aX ), _mm_mul_ps( aM[1], aY ) ), _mm_add_ps( _mm_mul_ps( aM[2], aZ ), aM[3] ) );
+		__m128 y = _mm_add_ps( _mm_add_ps( _mm_mul_ps( aM[4], aX ), _mm_mul_ps( aM[5], aY ) ), _mm_add_ps( _mm_mul_ps( aM[6], aZ ), aM[7] ) );
+		__m128 z = _mm_add_ps( _mm_add_ps( _mm_mul_ps( aM[8], aX ), _mm_mul_ps( aM[9], aY ) ), _mm_add_ps( _mm_mul_ps( aM[10], aZ ), aM[11] ) );
+
+		if constexpr( tProject )
+		{
+			__m128 const w = _mm_add_ps( _mm_add_ps( _mm_mul_ps( aM[12], aX ), _mm_mul_ps( aM[13], aY ) ), _mm_add_ps( _mm_mul_ps( aM[14], aZ ), aM[15] ) );
+			x = _mm_div_ps( x, w );
+			y = _mm_div_ps( y, w );
+			z = _mm_div_ps( z, w );
+		}
+		if constexpr( tNormalize )
+		{
+			__m128 const l2 = _mm_add_ps( _mm_add_ps( _mm_mul_ps( x, x ), _mm_mul_ps( y, y ) ), _mm_mul_ps( z, z ) );
+			__m128 const il = _mm_div_ps( _mm_set1_ps( 1.f ), _mm_sqrt_ps( l2 ) );
+			x = _mm_mul_ps( x, il );
+			y = _mm_mul_ps( y, il );
+			z = _mm_mul_ps( z, il );
+		}
+
+		aX = x;
+		aY = y;
+		aZ = z;
+	}
+
+	template< bool tProject, bool tNormalize >
+	void aos_sse2_( Mat44f const& aM, std::size_t aCount, Vec3f const* aIn, Vec3f* aOut ) noexcept
+	{
+		__m128 m[16];
+		for( std::size_t i = 0; i < 16; ++i )
+			m[i] = _mm_set1_ps( aM(i/4, i%4) );
+
+		std::size_t i = 0;
+		for( ; i+4 <= aCount; i += 4 )
+		{
+			float const* src = &aIn[i].x;
+			__m128 x, y, z;
+			aos_to_soa_( _mm_loadu_ps( src+0 ), _mm_loadu_ps( src+4 ), _mm_loadu_ps( src+8 ), x, y, z );
+
+			xform_sse2_<tProject,tNormalize>( m, x, y, z );
+
+			__m128 a, b, c;
+			soa_to_aos_( x, y, z, a, b, c );
+			float* dst = &aOut[i].x;
+			_mm_storeu_ps( dst+0, a );
+			_mm_storeu_ps( dst+4, b );
+			_mm_storeu_ps( dst+8, c );
+		}
+
+		aos_scalar_<tProject,tNormalize>( aM, aCount-i, aIn+i, aOut+i );
+	}
+	template< bool tProject, bool tNormalize >
+	void soa_sse2_( Mat44f const& aM, std::size_t aCount, Vec3fSoaConst aIn, Vec3fSoa aOut ) noexcept
+	{
+		__m128 m[16];
+		for( std::size_t i = 0; i < 16; ++i )
+			m[i] = _mm_set1_ps( aM(i/4, i%4) );
+
+		std::size_t i = 0;
+		for( ; i+4 <= aCount; i += 4 )
+		{
+			__m128 x = _mm_loadu_ps( aIn.x+i );
+			__m128 y = _mm_loadu_ps( aIn.y+i );
+			__m128 z = _mm_loadu_ps( aIn.z+i );
+
+			xform_sse2_<tProject,tNormalize>( m, x, y, z );
+
+			_mm_storeu_ps( aOut.x+i, x );
+			_mm_storeu_ps( aOut.y+i, y );
+			_mm_storeu_ps( aOut.z+i, z );
+		}
+
+		soa_scalar_<tProject,tNormalize>( aM, aCount-i,
+			Vec3fSoaConst{ aIn.x+i, aIn.y+i, aIn.z+i },
+			Vec3fSoa{ aOut.x+i, aOut.y+i, aOut.z+i }
+		);
+	}
+
+	void aos_sse2_dispatch_( Xform_ const& aX, std::size_t aCount, Vec3f const* aIn, Vec3f* aOut ) noexcept
+	{
+		VMLIB_XFORM_DISPATCH_( aos_sse2_, aX, aX.m, aCount, aIn, aOut );
+	}
+	void soa_sse2_dispatch_( Xform_ const& aX, std::size_t aCount, Vec3fSoaConst aIn, Vec3fSoa aOut ) noexcept
+	{
+		VMLIB_XFORM_DISPATCH_( soa_sse2_, aX, aX.m, aCount, aIn, aOut );
+	}
+
+	constexpr BatchKernels_ kSse2Kernels_{ &aos_sse2_dispatch_, &soa_sse2_dispatch_ };
+
+	// AVX2 kernels: eight points at a time. The AoS shuffles are the same as
+	// for SSE2, applied independently to each 128-bit lane. The low lane
+	// holds points 0-3 and the high lane points 4-7.
+	template< int tX, int tY, int tZ, int tW > VMLIB_TARGET_AVX2
+	inline __m256 shuffle2_( __m256 aA, __m256 aB ) noexcept
+	{
+		return _mm256_shuffle_ps( aA, aB, _MM_SHUFFLE( tW, tZ, tY, tX ) );
+	}
+
+	VMLIB_TARGET_AVX2
+	inline __m256 load2_( float const* aLo, float const* aHi ) noexcept
+	{
+		return _mm256_insertf128_ps( _mm256_castps128_ps256( _mm_loadu_ps( aLo ) ), _mm_loadu_ps( aHi ), 1 );
+	}
+	VMLIB_TARGET_AVX2
+	inline void store2_( float* aLo, float* aHi, __m256 aV ) noexcept
+	{
+		_mm_storeu_ps( aLo, _mm256_castps256_ps128( aV ) );
+		_mm_storeu_ps( aHi, _mm256_extractf128_ps( aV, 1 ) );
+	}
+
+	template< bool tProject, bool tNormalize > VMLIB_TARGET_AVX2
+	inline void xform_avx2_( __m256 const* aM, __m256& aX, __m256& aY, __m256& aZ ) noexcept
+	{
+		__m256 x = _mm256_fmadd_ps( aM[0], aX, _mm256_fmadd_ps( aM[1], aY, _mm256_fmadd_ps( aM[2], aZ, aM[3] ) ) );
+		__m256 y = _mm256_fmadd_ps( aM[4], aX, _mm256_fmadd_ps( aM[5], aY, _mm256_fmadd_ps( aM[6], aZ, aM[7] ) ) );
+		__m256 z = _mm256_fmadd_ps( aM[8], aX, _mm256_fmadd_ps( aM[9], aY, _mm256_fmadd_ps( aM[10], aZ, aM[11] ) ) );
+
+		if constexpr( tProject )
+		{
+			__m256 const w = _mm256_fmadd_ps( aM[12], aX, _mm256_fmadd_ps( aM[13], aY, _mm256_fmadd_ps( aM[14], aZ, aM[15] ) ) );
+			x = _mm256_div_ps( x, w );
+			y = _mm256_div_ps( y, w );
+			z = _mm256_div_ps( z, w );
+		}
+		if constexpr( tNormalize )
+		{
+			__m256 const l2 = _mm256_fmadd_ps( x, x, _mm256_fmadd_ps( y, y, _mm256_mul_ps( z, z ) ) );
+			__m256 const il = _mm256_div_ps( _mm256_set1_ps( 1.f ), _mm256_sqrt_ps( l2 ) );
+			x = _mm256_mul_ps( x, il );
+			y = _mm256_mul_ps( y, il );
+			z = _mm256_mul_ps( z, il );
+		}
+
+		aX = x;
+		aY = y;
+		aZ = z;
+	}
+
+	template< bool tProject, bool tNormalize > VMLIB_TARGET_AVX2
+	void aos_avx2_( Mat44f const& aM, std::size_t aCount, Vec3f const* aIn, Vec3f* aOut ) noexcept
+	{
+		__m256 m[16];
+		for( std::size_t i = 0; i < 16; ++i )
+			m[i] = _mm256_set1_ps( aM(i/4, i%4) );
+
+		std::size_t i = 0;
+		for( ; i+8 <= aCount; i += 8 )
+		{
+			float const* src = &aIn[i].x;
+			__m256 const a = load2_( src+0, src+12 );
+			__m256 const b = load2_( src+4, src+16 );
+			__m256 const c = load2_( src+8, src+20 );
+
+			__m256 x = shuffle2_<0,1,0,2>( shuffle2_<0,3,2,3>( a, b ), shuffle2_<2,2,1,1>( b, c ) );
+			__m256 y = shuffle2_<0,2,0,2>( shuffle2_<1,1,0,0>( a, b ), shuffle2_<3,3,2,2>( b, c ) );
+			__m256 z = shuffle2_<0,2,0,2>( shuffle2_<2,2,1,1>( a, b ), shuffle2_<0,0,3,3>( c, c ) );
+
+			xform_avx2_<tProject,tNormalize>( m, x, y, z );
+
+			float* dst = &aOut[i].x;
+			store2_( dst+0, dst+12, shuffle2_<0,2,0,2>( shuffle2_<0,0,0,0>( x, y ), shuffle2_<0,0,1,1>( z, x ) ) );
+			store2_( dst+4, dst+16, shuffle2_<0,2,0,2>( shuffle2_<1,1,1,1>( y, z ), shuffle2_<2,2,2,2>( x, y ) ) );
+			store2_( dst+8, dst+20, shuffle2_<0,2,0,2>( shuffle2_<2,2,3,3>( z, x ), shuffle2_<3,3,3,3>( y, z ) ) );
+		}
+
+		aos_sse2_<tProject,tNormalize>( aM, aCount-i, aIn+i, aOut+i );
+	}
+	template< bool tProject, bool tNormalize > VMLIB_TARGET_AVX2
+	void soa_avx2_( Mat44f const& aM, std::size_t aCount, Vec3fSoaConst aIn, Vec3fSoa aOut ) noexcept
+	{
+		__m256 m[16];
+		for( std::size_t i = 0; i < 16; ++i )
+			m[i] = _mm256_set1_ps( aM(i/4, i%4) );
+
+		std::size_t i = 0;
+		for( ; i+8 <= aCount; i += 8 )
+		{
+			__m256 x = _mm256_loadu_ps( aIn.x+i );
+			__m256 y = _mm256_loadu_ps( aIn.y+i );
+			__m256 z = _mm256_loadu_ps( aIn.z+i );
+
+			xform_avx2_<tProject,tNormalize>( m, x, y, z );
+
+			_mm256_storeu_ps( aOut.x+i, x );
+			_mm256_storeu_ps( aOut.y+i, y );
+			_mm256_storeu_ps( aOut.z+i, z );
+		}
+
+		soa_sse2_<tProject,tNormalize>( aM, aCount-i,
+			Vec3fSoaConst{ aIn.x+i, aIn.y+i, aIn.z+i },
+			Vec3fSoa{ aOut.x+i, aOut.y+i, aOut.z+i }
+		);
+	}
+
+	VMLIB_TARGET_AVX2
+	void aos_avx2_dispatch_( Xform_ const& aX, std::size_t aCount, Vec3f const* aIn, Vec3f* aOut ) noexcept
+	{
+		VMLIB_XFORM_DISPATCH_( aos_avx2_, aX, aX.m, aCount, aIn, aOut );
+	}
+	VMLIB_TARGET_AVX2
+	void soa_avx2_dispatch_( Xform_ const& aX, std::size_t aCount, Vec3fSoaConst aIn, Vec3fSoa aOut ) noexcept
+	{
+		VMLIB_XFORM_DISPATCH_( soa_avx2_, aX, aX.m, aCount, aIn, aOut );
+	}
+
+	constexpr BatchKernels_ kAvx2Kernels_{ &aos_avx2_dispatch_, &soa_avx2_dispatch_ };
+#	endif // ~ VMLIB_SIMD_X86
+
+#	if defined(VMLIB_SIMD_NEON)
+	// NEON kernels. vld3q/vst3q (de)interleave Vec3f data directly.
+	template< bool tProject, bool tNormalize >
+	inline void xform_neon_( float32x4_t const* aM, float32x4_t& aX, float32x4_t& aY, float32x4_t& aZ ) noexcept
+	{
+		float32x4_t x = vfmaq_f32( vfmaq_f32( vfmaq_f32( aM[3], aM[2], aZ ), aM[1], aY ), aM[0], aX );
+		float32x4_t y = vfmaq_f32( vfmaq_f32( vfmaq_f32( aM[7], aM[6], aZ ), aM[5], aY ), aM[4], aX );
+		float32x4_t z = vfmaq_f32( vfmaq_f32( vfmaq_f32( aM[11], aM[10], aZ ), aM[9], aY ), aM[8], aX );
+
+		if constexpr( tProject )
+		{
+			float32x4_t const w = vfmaq_f32( vfmaq_f32( vfmaq_f32( aM[15], aM[14], aZ ), aM[13], aY ), aM[12], aX );
+			x = vdivq_f32( x, w );
+			y = vdivq_f32( y, w );
+			z = vdivq_f32( z, w );
+		}
+		if constexpr( tNormalize )
+		{
+			float32x4_t const l2 = vfmaq_f32( vfmaq_f32( vmulq_f32( z, z ), y, y ), x, x );
+			float32x4_t const il = vdivq_f32( vdupq_n_f32( 1.f ), vsqrtq_f32( l2 ) );
+			x = vmulq_f32( x, il );
+			y = vmulq_f32( y, il );
+			z = vmulq_f32( z, il );
+		}
+
+		aX = x;
+		aY = y;
+		aZ = z;
+	}
+
+	template< bool tProject, bool tNormalize >
+	void aos_neon_( Mat44f const& aM, std::size_t aCount, Vec3f const* aIn, Vec3f* aOut ) noexcept
+	{
+		float32x4_t m[16];
+		for( std::size_t i = 0; i < 16; ++i )
+			m[i] = vdupq_n_f32( aM(i/4, i%4) );
+
+		std::size_t i = 0;
+		for( ; i+4 <= aCount; i += 4 )
+		{
+			float32x4x3_t v = vld3q_f32( &aIn[i].x );
+			xform_neon_<tProject,tNormalize>( m, v.val[0], v.val[1], v.val[2] );
+			vst3q_f32( &aOut[i].x, v );
+		}
+
+		aos_scalar_<tProject,tNormalize>( aM, aCount-i, aIn+i, aOut+i );
+	}
+	template< bool tProject, bool tNormalize >
+	void soa_neon_( Mat44f const& aM, std::size_t aCount, Vec3fSoaConst aIn, Vec3fSoa aOut ) noexcept
+	{
+		float32x4_t m[16];
+		for( std::size_t i = 0; i < 16; ++i )
+			m[i] = vdupq_n_f32( aM(i/4, i%4) );
+
+		std::size_t i = 0;
+		for( ; i+4 <= aCount; i += 4 )
+		{
+			float32x4_t x = vld1q_f32( aIn.x+i );
+			float32x4_t y = vld1q_f32( aIn.y+i );
+			float32x4_t z = vld1q_f32( aIn.z+i );
+
+			xform_neon_<tProject,tNormalize>( m, x, y, z );
+
+			vst1q_f32( aOut.x+i, x );
+			vst1q_f32( aOut.y+i, y );
+			vst1q_f32( aOut.z+i, z );
+		}
+
+		soa_scalar_<tProject,tNormalize>( aM, aCount-i,
+			Vec3fSoaConst{ aIn.x+i, aIn.y+i, aIn.z+i },
+			Vec3fSoa{ aOut.x+i, aOut.y+i, aOut.z+i }
+		);
+	}
+
+	void aos_neon_dispatch_( Xform_ const& aX, std::size_t aCount, Vec3f const* aIn, Vec3f* aOut ) noexcept
+	{
+		VMLIB_XFORM_DISPATCH_( aos_neon_, aX, aX.m, aCount, aIn, aOut );
+	}
+	void soa_neon_dispatch_( Xform_ const& aX, std::size_t aCount, Vec3fSoaConst aIn, Vec3fSoa aOut ) noexcept
+	{
+		VMLIB_XFORM_DISPATCH_( soa_neon_, aX, aX.m, aCount, aIn, aOut );
+	}
+
+	constexpr BatchKernels_ kNeonKernels_{ &aos_neon_dispatch_, &soa_neon_dispatch_ };
+#	endif // ~ VMLIB_SIMD_NEON
+
+#	undef VMLIB_XFORM_DISPATCH_
+
+	BatchKernels_ const& kernels_() noexcept
+	{
+		switch( simd_active_isa() )
+		{
+#			if defined(VMLIB_SIMD_X86)
+			case SimdIsa::sse2: return kSse2Kernels_;
+			case SimdIsa::avx2: return kAvx2Kernels_;
+#			endif
+#			if defined(VMLIB_SIMD_NEON)
+			case SimdIsa::neon: return kNeonKernels_;
+#			endif
+			default: return kScalarKernels_;
+		}
+	}
+
+	Xform_ make_point_xform_( Mat44f const& aM )
+	{
+		return Xform_{ aM, !is_affine( aM ), false };
+	}
+	Xform_ make_vector_xform_( Mat33f const& aM, bool aRenormalize )
+	{
+		Mat44f m = kIdentity44f;
+		for( std::size_t i = 0; i < 3; ++i )
+		{
+			for( std::size_t j = 0; j < 3; ++j )
+				m(i,j) = aM(i,j);
+		}
+		return Xform_{ m, false, aRenormalize };
+	}
+
+	void run_aos_( Xform_ const& aX, std::size_t aCount, Vec3f const* aIn, Vec3f* aOut )
+	{
+		auto const& kernels = kernels_();
+		parallel_for( aCount, kMinPerThread_, [&] (std::size_t aBegin, std::size_t aEnd) {
+			kernels.aos( aX, aEnd-aBegin, aIn+aBegin, aOut+aBegin );
+		} );
+	}
+	void run_soa_( Xform_ const& aX, std::size_t aCount, Vec3fSoaConst aIn, Vec3fSoa aOut )
+	{
+		auto const& kernels = kernels_();
+		parallel_for( aCount, kMinPerThread_, [&] (std::size_t aBegin, std::size_t aEnd) {
+			kernels.soa( aX, aEnd-aBegin,
+				Vec3fSoaConst{ aIn.x+aBegin, aIn.y+aBegin, aIn.z+aBegin },
+				Vec3fSoa{ aOut.x+aBegin, aOut.y+aBegin, aOut.z+aBegin }
+			);
+		} );
+	}
+}
+
+void transform_points( Mat44f const& aM, std::size_t aCount, Vec3f const* aIn, Vec3f* aOut )
+{
+	run_aos_( make_point_xform_( aM ), aCount, aIn, aOut );
+}
+void transform_points( Mat44f const& aM, std::vector<Vec3f>& aPoints )
+{
+	transform_points( aM, aPoints.size(), aPoints.data(), aPoints.data() );
+}
+
+void transform_vectors( Mat33f const& aM, std::size_t aCount, Vec3f const* aIn, Vec3f* aOut, bool aRenormalize )
+{
+	run_aos_( make_vector_xform_( aM, aRenormalize ), aCount, aIn, aOut );
+}
+void transform_vectors( Mat33f const& aM, std::vector<Vec3f>& aVectors, bool aRenormalize )
+{
+	transform_vectors( aM, aVectors.size(), aVectors.data(), aVectors.data(), aRenormalize );
+}
+
+void transform_points_soa( Mat44f const& aM, std::size_t aCount, Vec3fSoaConst aIn, Vec3fSoa aOut )
+{
+	run_soa_( make_point_xform_( aM ), aCount, aIn, aOut );
+}
+void transform_vectors_soa( Mat33f const& aM, std::size_t aCount, Vec3fSoaConst aIn, Vec3fSoa aOut, bool aRenormalize )
+{
+	run_soa_( make_vector_xform_( aM, aRenormalize ), aCount, aIn, aOut );
+}
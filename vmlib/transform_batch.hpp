@@ -0,0 +1,52 @@
+#ifndef TRANSFORM_BATCH_HPP_C1A3D0F4_5B1E_4E57_9A0E_2E4C2B1D7A61
+#define TRANSFORM_BATCH_HPP_C1A3D0F4_5B1E_4E57_9A0E_2E4C2B1D7A61
+
+#include <vector>
+
+#include <cstddef>
+
+#include "vec3.hpp"
+#include "mat33.hpp"
+#include "mat44.hpp"
+
+/* Batched transformation of vertex streams.
+ *
+ * These functions transform whole arrays of points or directions with a
+ * single matrix. They use the SIMD instruction set selected by simd.hpp and
+ * split large inputs across multiple threads (see parallel.hpp). Outputs may
+ * alias the inputs, i.e., in-place transformation is fine.
+ *
+ * transform_points() computes (M * (p,1)).xyz / w. The divide by w is skipped
+ * when the matrix is affine (see is_affine()), which is the common case for
+ * model transforms.
+ *
+ * transform_vectors() computes M * v, e.g., for normals with a normal matrix.
+ * If aRenormalize is set, the results are normalized afterwards.
+ *
+ * The _soa variants take separate x, y and z arrays.
+ */
+void transform_points( Mat44f const& aM, std::size_t aCount, Vec3f const* aIn, Vec3f* aOut );
+void transform_points( Mat44f const& aM, std::vector<Vec3f>& aPoints );
+
+void transform_vectors( Mat33f const& aM, std::size_t aCount, Vec3f const* aIn, Vec3f* aOut, bool aRenormalize = false );
+void transform_vectors( Mat33f const& aM, std::vector<Vec3f>& aVectors, bool aRenormalize = false );
+
+
+struct Vec3fSoa
+{
+	float* x;
+	float* y;
+	float* z;
+};
+
+struct Vec3fSoaConst
+{
+	float const* x;
+	float const* y;
+	float const* z;
+};
+
+void transform_points_soa( Mat44f const& aM, std::size_t aCount, Vec3fSoaConst aIn, Vec3fSoa aOut );
+void transform_vectors_soa( Mat33f const& aM, std::size_t aCount, Vec3fSoaConst aIn, Vec3fSoa aOut, bool aRenormalize = false );
+
+#endif // TRANSFORM_BATCH_HPP_C1A3D0F4_5B1E_4E57_9A0E_2E4C2B1D7A61
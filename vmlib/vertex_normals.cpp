@@ -0,0 +1,423 @@
+#include "vertex_normals.hpp"
+
+#include <limits>
+#include <thread>
+#include <vector>
+#include <algorithm>
+
+#include <cmath>
+#include <cassert>
+
+#include "simd.hpp"
+#include "parallel.hpp"
+#include "fast_math.hpp"
+
+namespace
+{
+	// Triangles per thread. Each one is a few gathers, a cross product and a
+	// handful of dot products.
+	constexpr std::size_t kMinTrianglesPerThread_ = 16*1024;
+
+	// Corners per thread when sorting them by vertex. Each one is a counter
+	// increment and, later, a scattered store.
+	constexpr std::size_t kMinCornersPerThread_ = 64*1024;
+
+	// Vertices per thread when summing their corners, and per block of the
+	// prefix sum over the vertices.
+	constexpr std::size_t kMinVerticesPerThread_ = 16*1024;
+
+	// Triangles whose corner angles are computed at once. The inputs of
+	// fast_atan2_n() stay in the cache, and the call overhead is small.
+	constexpr std::size_t kAngleBlock_ = 4096;
+
+	// Vertices whose sums are computed at once, before they are finalized.
+	constexpr std::size_t kSumBlock_ = 4096;
+
+	std::uint32_t vertex_( std::uint32_t const* aIndices, std::size_t aCorner ) noexcept
+	{
+		return aIndices ? aIndices[aCorner] : std::uint32_t(aCorner);
+	}
+
+	// Corner sums. aSums[i] is the sum of aValues[c] over the corners c of
+	// vertex aFirst+i, added in the order listed in aCorners. Each lane is
+	// added in the same order by all kernels, so they give identical results.
+	struct CornerKernels_
+	{
+		void (*sum)( std::size_t, std::size_t, std::uint32_t const*, std::uint32_t const*, Vec4f const*, Vec4f* ) noexcept;
+	};
+
+	void sum_scalar_( std::size_t aFirst, std::size_t aLast, std::uint32_t const* aOffsets, std::uint32_t const* aCorners, Vec4f const* aValues, Vec4f* aSums ) noexcept
+	{
+		for( std::size_t v = aFirst; v < aLast; ++v )
+		{
+			Vec4f sum{ 0.f, 0.f, 0.f, 0.f };
+			for( std::uint32_t i = aOffsets[v]; i < aOffsets[v+1]; ++i )
+				sum += aValues[aCorners[i]];
+			aSums[v-aFirst] = sum;
+		}
+	}
+
+	constexpr CornerKernels_ kScalarKernels_{
+		&sum_scalar_
+	};
+
+#	if defined(VMLIB_SIMD_X86)
+	void sum_sse2_( std::size_t aFirst, std::size_t aLast, std::uint32_t const* aOffsets, std::uint32_t const* aCorners, Vec4f const* aValues, Vec4f* aSums ) noexcept
+	{
+		for( std::size_t v = aFirst; v < aLast; ++v )
+		{
+			__m128 sum = _mm_setzero_ps();
+			for( std::uint32_t i = aOffsets[v]; i < aOffsets[v+1]; ++i )
+				sum = _mm_add_ps( sum, _mm_loadu_ps( &aValues[aCorners[i]].x ) );
+			_mm_storeu_ps( &aSums[v-aFirst].x, sum );
+		}
+	}
+
+	constexpr CornerKernels_ kSse2Kernels_{
+		&sum_sse2_
+	};
+#	endif // ~ VMLIB_SIMD_X86
+
+#	if defined(VMLIB_SIMD_NEON)
+	void sum_neon_( std::size_t aFirst, std::size_t aLast, std::uint32_t const* aOffsets, std::uint32_t const* aCorners, Vec4f const* aValues, Vec4f* aSums ) noexcept
+	{
+		for( std::size_t v = aFirst; v < aLast; ++v )
+		{
+			float32x4_t sum = vdupq_n_f32( 0.f );
+			for( std::uint32_t i = aOffsets[v]; i < aOffsets[v+1]; ++i )
+				sum = vaddq_f32( sum, vld1q_f32( &aValues[aCorners[i]].x ) );
+			vst1q_f32( &aSums[v-aFirst].x, sum );
+		}
+	}
+
+	constexpr CornerKernels_ kNeonKernels_{
+		&sum_neon_
+	};
+#	endif // ~ VMLIB_SIMD_NEON
+
+	// A single four-wide add per corner; AVX2 has nothing to add to that.
+	CornerKernels_ const& kernels_() noexcept
+	{
+		switch( simd_active_isa() )
+		{
+#			if defined(VMLIB_SIMD_X86)
+			case SimdIsa::sse2: return kSse2Kernels_;
+			case SimdIsa::avx2: return kSse2Kernels_;
+#			endif
+#			if defined(VMLIB_SIMD_NEON)
+			case SimdIsa::neon: return kNeonKernels_;
+#			endif
+			default: return kScalarKernels_;
+		}
+	}
+
+	// The corners (3*triangle + k) of each vertex v, in ascending order, are
+	// corners[offsets[v]] up to, but excluding, corners[offsets[v+1]].
+	struct VertexCorners_
+	{
+		std::vector<std::uint32_t> offsets;
+		std::vector<std::uint32_t> corners;
+	};
+
+	// Counting sort of the corners by vertex. The corners are split into one
+	// range per thread, and each range counts its vertices in its own row of
+	// a histogram. Per vertex, the rows are then prefix summed across the
+	// ranges, and the vertex totals across the vertices (in parallel blocks,
+	// as loadobj.cpp does for its output). Each range finally writes its
+	// corners at its own cursors, so they land in ascending order without
+	// atomics or sorting.
+	VertexCorners_ make_vertex_corners_( std::size_t aCornerCount, std::uint32_t const* aIndices, std::size_t aVertexCount )
+	{
+		assert( aCornerCount <= std::numeric_limits<std::uint32_t>::max() );
+
+		// The histogram has one row of aVertexCount counters per range. It is
+		// kept no larger than the corner list.
+		std::size_t const hardware = std::max( 1u, std::thread::hardware_concurrency() );
+		std::size_t const maxRanges = std::min( aCornerCount / kMinCornersPerThread_, aCornerCount / std::max<std::size_t>( aVertexCount, 1 ) );
+		std::size_t const ranges = std::clamp<std::size_t>( maxRanges, 1, hardware );
+		std::size_t const perRange = (aCornerCount + ranges - 1) / ranges;
+
+		std::vector<std::uint32_t> rows( ranges * aVertexCount );
+		parallel_for( ranges, 1, [&] (std::size_t aBegin, std::size_t aEnd) {
+			for( std::size_t r = aBegin; r < aEnd; ++r )
+			{
+				std::uint32_t* row = rows.data() + r * aVertexCount;
+				std::size_t const last = std::min( aCornerCount, (r+1) * perRange );
+				for( std::size_t c = r * perRange; c < last; ++c )
+					++row[vertex_( aIndices, c )];
+			}
+		} );
+
+		// Per vertex, the rows become the position of each range's first
+		// corner among the vertex's corners, and offsets[v+1] the number of
+		// corners. Per block of vertices, the counts are then summed, the
+		// block sums prefix summed, and the blocks turn their counts into
+		// offsets.
+		VertexCorners_ ret;
+		ret.offsets.resize( aVertexCount+1 );
+
+		std::size_t const blocks = (aVertexCount + kMinVerticesPerThread_ - 1) / kMinVerticesPerThread_;
+		std::vector<std::uint32_t> blockOffsets( blocks+1 );
+		parallel_for( blocks, 1, [&] (std::size_t aBegin, std::size_t aEnd) {
+			for( std::size_t b = aBegin; b < aEnd; ++b )
+			{
+				std::uint32_t blockSum = 0;
+				std::size_t const last = std::min( aVertexCount, (b+1) * kMinVerticesPerThread_ );
+				for( std::size_t v = b * kMinVerticesPerThread_; v < last; ++v )
+				{
+					std::uint32_t count = 0;
+					for( std::size_t r = 0; r < ranges; ++r )
+					{
+						std::uint32_t& row = rows[r * aVertexCount + v];
+						std::uint32_t const n = row;
+						row = count;
+						count += n;
+					}
+
+					ret.offsets[v+1] = count;
+					blockSum += count;
+				}
+				blockOffsets[b+1] = blockSum;
+			}
+		} );
+
+		for( std::size_t b = 0; b < blocks; ++b )
+			blockOffsets[b+1] += blockOffsets[b];
+
+		parallel_for( blocks, 1, [&] (std::size_t aBegin, std::size_t aEnd) {
+			for( std::size_t b = aBegin; b < aEnd; ++b )
+			{
+				std::uint32_t offset = blockOffsets[b];
+				std::size_t const last = std::min( aVertexCount, (b+1) * kMinVerticesPerThread_ );
+				for( std::size_t v = b * kMinVerticesPerThread_; v < last; ++v )
+				{
+					offset += ret.offsets[v+1];
+					ret.offsets[v+1] = offset;
+				}
+			}
+		} );
+
+		ret.corners.resize( aCornerCount );
+		parallel_for( ranges, 1, [&] (std::size_t aBegin, std::size_t aEnd) {
+			for( std::size_t r = aBegin; r < aEnd; ++r )
+			{
+				std::uint32_t* row = rows.data() + r * aVertexCount;
+				std::size_t const last = std::min( aCornerCount, (r+1) * perRange );
+				for( std::size_t c = r * perRange; c < last; ++c )
+				{
+					std::uint32_t const v = vertex_( aIndices, c );
+					ret.corners[ret.offsets[v] + row[v]++] = std::uint32_t(c);
+				}
+			}
+		} );
+
+		return ret;
+	}
+
+	// Calls aTriangle( t, p0, p1, p2, n ) for each triangle t, where n is its
+	// unit normal (zero if it is degenerate). The Vec4f that it returns is
+	// stored for each corner of the triangle, scaled by the angle at that
+	// corner, in aValues (three per triangle).
+	template< typename tTriangle >
+	void for_each_triangle_( std::size_t aTriangleCount, std::uint32_t const* aIndices, Vec3f const* aPositions, std::vector<Vec4f>& aValues, tTriangle&& aTriangle )
+	{
+		aValues.resize( 3*aTriangleCount );
+
+		parallel_for( aTriangleCount, kMinTrianglesPerThread_, [&] (std::size_t aBegin, std::size_t aEnd) {
+			// |cross( a, b )| is twice the triangle's area for any two of
+			// its edges a and b, so the angle between them is
+			//    atan2( twiceArea, dot( a, b ) ).
+			std::vector<float> twiceArea( 3*kAngleBlock_ ), cosines( 3*kAngleBlock_ ), angles( 3*kAngleBlock_ );
+			std::vector<Vec4f> values( kAngleBlock_ );
+
+			for( std::size_t first = aBegin; first < aEnd; first += kAngleBlock_ )
+			{
+				std::size_t const count = std::min( kAngleBlock_, aEnd - first );
+				for( std::size_t i = 0; i < count; ++i )
+				{
+					std::size_t const t = first + i;
+					Vec3f const p0 = aPositions[vertex_( aIndices, 3*t+0 )];
+					Vec3f const p1 = aPositions[vertex_( aIndices, 3*t+1 )];
+					Vec3f const p2 = aPositions[vertex_( aIndices, 3*t+2 )];
+
+					Vec3f const n = cross( p1 - p0, p2 - p0 );
+					float const len = length( n );
+					values[i] = aTriangle( t, p0, p1, p2, len > 0.f ? n / len : Vec3f{ 0.f, 0.f, 0.f } );
+
+					twiceArea[3*i+0] = twiceArea[3*i+1] = twiceArea[3*i+2] = len;
+					cosines[3*i+0] = dot( p1 - p0, p2 - p0 );
+					cosines[3*i+1] = dot( p2 - p1, p0 - p1 );
+					cosines[3*i+2] = dot( p0 - p2, p1 - p2 );
+				}
+
+				fast_atan2_n( 3*count, twiceArea.data(), cosines.data(), angles.data() );
+
+				for( std::size_t i = 0; i < 3*count; ++i )
+					aValues[3*first + i] = values[i/3] * angles[i];
+			}
+		} );
+	}
+
+	// Calls aVertex( v, sum ) for each vertex v, where sum is the sum of the
+	// values of its corners (see for_each_triangle_()). Each thread reads
+	// only the corners of its own vertices, in the fixed order of
+	// make_vertex_corners_(), so the results do not depend on the number of
+	// threads.
+	template< typename tVertex >
+	void for_each_vertex_( std::size_t aCornerCount, std::uint32_t const* aIndices, std::size_t aVertexCount, std::vector<Vec4f> const& aValues, tVertex&& aVertex )
+	{
+		VertexCorners_ const map = make_vertex_corners_( aCornerCount, aIndices, aVertexCount );
+		auto const sum = kernels_().sum;
+
+		parallel_for( aVertexCount, kMinVerticesPerThread_, [&] (std::size_t aBegin, std::size_t aEnd) {
+			std::vector<Vec4f> sums( std::min( kSumBlock_, aEnd - aBegin ) );
+
+			for( std::size_t first = aBegin; first < aEnd; first += kSumBlock_ )
+			{
+				std::size_t const last = std::min( first + kSumBlock_, aEnd );
+				sum( first, last, map.offsets.data(), map.corners.data(), aValues.data(), sums.data() );
+
+				for( std::size_t v = first; v < last; ++v )
+					aVertex( v, sums[v-first] );
+			}
+		} );
+	}
+
+	// Calls aVertex( v, sum ) for each vertex v, with the angle-weighted sum
+	// of its triangles' unit normals.
+	template< typename tVertex >
+	void normal_sums_( std::size_t aIndexCount, std::uint32_t const* aIndices, std::size_t aVertexCount, Vec3f const* aPositions, tVertex&& aVertex )
+	{
+		std::size_t const triangles = aIndexCount / 3;
+
+		std::vector<Vec4f> values;
+		for_each_triangle_( triangles, aIndices, aPositions, values, [] (std::size_t, Vec3f, Vec3f, Vec3f, Vec3f aN) {
+			return Vec4f{ aN.x, aN.y, aN.z, 0.f };
+		} );
+
+		for_each_vertex_( 3*triangles, aIndices, aVertexCount, values, [&] (std::size_t aV, Vec4f aSum) {
+			aVertex( aV, Vec3f{ aSum.x, aSum.y, aSum.z } );
+		} );
+	}
+
+	Vec3f any_perpendicular_( Vec3f aNormal ) noexcept
+	{
+		if( dot( aNormal, aNormal ) <= 0.f )
+			return Vec3f{ 1.f, 0.f, 0.f };
+
+		Vec3f const axis = std::abs( aNormal.x ) < 0.9f ? Vec3f{ 1.f, 0.f, 0.f } : Vec3f{ 0.f, 1.f, 0.f };
+		return normalize( cross( cross( aNormal, axis ), aNormal ) );
+	}
+}
+
+std::size_t split_mirrored_vertices( std::size_t aIndexCount, std::uint32_t* aIndices, std::size_t aVertexCount, Vec2f const* aTextcoords, std::vector<std::uint32_t>& aSources )
+{
+	assert( aIndices );
+	std::size_t const triangles = aIndexCount / 3;
+
+	// Sign of each triangle's UV area (zero if it has none)
+	std::vector<std::int8_t> signs( triangles );
+	parallel_for( triangles, kMinTrianglesPerThread_, [&] (std::size_t aBegin, std::size_t aEnd) {
+		for( std::size_t t = aBegin; t < aEnd; ++t )
+		{
+			Vec2f const t0 = aTextcoords[aIndices[3*t+0]];
+			Vec2f const d1 = aTextcoords[aIndices[3*t+1]] - t0;
+			Vec2f const d2 = aTextcoords[aIndices[3*t+2]] - t0;
+
+			float const area = d1.x * d2.y - d1.y * d2.x;
+			signs[t] = std::int8_t(area < 0.f ? -1 : (area > 0.f ? 1 : 0));
+		}
+	} );
+
+	VertexCorners_ const map = make_vertex_corners_( 3*triangles, aIndices, aVertexCount );
+
+	std::vector<std::uint8_t> mirrored( aVertexCount );
+	parallel_for( aVertexCount, kMinVerticesPerThread_, [&] (std::size_t aBegin, std::size_t aEnd) {
+		for( std::size_t v = aBegin; v < aEnd; ++v )
+		{
+			bool positive = false, negative = false;
+			for( std::uint32_t i = map.offsets[v]; i < map.offsets[v+1]; ++i )
+			{
+				std::int8_t const sign = signs[map.corners[i] / 3];
+				positive = positive || sign > 0;
+				negative = negative || sign < 0;
+			}
+			mirrored[v] = positive && negative;
+		}
+	} );
+
+	// Seams are a small fraction of the vertices; the copies are numbered
+	// in vertex order.
+	std::size_t const first = aSources.size();
+	for( std::size_t v = 0; v < aVertexCount; ++v )
+	{
+		if( !mirrored[v] )
+			continue;
+
+		auto const copy = std::uint32_t(aVertexCount + aSources.size() - first);
+		for( std::uint32_t i = map.offsets[v]; i < map.offsets[v+1]; ++i )
+		{
+			std::uint32_t const c = map.corners[i];
+			if( signs[c / 3] < 0 )
+				aIndices[c] = copy;
+		}
+
+		aSources.emplace_back( std::uint32_t(v) );
+	}
+
+	return aSources.size() - first;
+}
+
+void compute_vertex_normals( std::size_t aIndexCount, std::uint32_t const* aIndices, std::size_t aVertexCount, Vec3f const* aPositions, Vec3f* aNormals )
+{
+	normal_sums_( aIndexCount, aIndices, aVertexCount, aPositions, [&] (std::size_t aV, Vec3f aSum) {
+		float const len = length( aSum );
+		aNormals[aV] = len > 0.f ? aSum / len : Vec3f{ 0.f, 0.f, 0.f };
+	} );
+}
+
+void compute_vertex_normal_sums( std::size_t aIndexCount, std::uint32_t const* aIndices, std::size_t aVertexCount, Vec3f const* aPositions, Vec3f* aSums )
+{
+	normal_sums_( aIndexCount, aIndices, aVertexCount, aPositions, [&] (std::size_t aV, Vec3f aSum) {
+		aSums[aV] = aSum;
+	} );
+}
+
+void compute_vertex_tangents( std::size_t aIndexCount, std::uint32_t const* aIndices, std::size_t aVertexCount, Vec3f const* aPositions, Vec3f const* aNormals, Vec2f const* aTextcoords, Vec4f* aTangents )
+{
+	std::size_t const triangles = aIndexCount / 3;
+
+	// Per triangle: the unit direction in which u grows, and the sign of the
+	// UV area in w (all zero if the triangle has no area or no UV area).
+	// With edges e1, e2 and their UV deltas d1, d2,
+	//    dP/du = (e1 * d2.y - e2 * d1.y) / (d1.x * d2.y - d1.y * d2.x).
+	std::vector<Vec4f> values;
+	for_each_triangle_( triangles, aIndices, aPositions, values, [&] (std::size_t aT, Vec3f aP0, Vec3f aP1, Vec3f aP2, Vec3f aN) {
+		Vec2f const t0 = aTextcoords[vertex_( aIndices, 3*aT+0 )];
+		Vec2f const d1 = aTextcoords[vertex_( aIndices, 3*aT+1 )] - t0;
+		Vec2f const d2 = aTextcoords[vertex_( aIndices, 3*aT+2 )] - t0;
+
+		float const area = d1.x * d2.y - d1.y * d2.x;
+		float const sign = area < 0.f ? -1.f : 1.f;
+
+		Vec3f const u = (aP1 - aP0) * d2.y - (aP2 - aP0) * d1.y;
+		float const len = length( u );
+		if( 0.f == area || len <= 0.f || dot( aN, aN ) <= 0.f )
+			return Vec4f{ 0.f, 0.f, 0.f, 0.f };
+
+		Vec3f const dir = u * (sign / len);
+		return Vec4f{ dir.x, dir.y, dir.z, sign };
+	} );
+
+	// The angle-weighted sum of the directions is projected onto the tangent
+	// plane of the vertex; the sum of the signed angles gives the handedness.
+	for_each_vertex_( 3*triangles, aIndices, aVertexCount, values, [&] (std::size_t aV, Vec4f aSum) {
+		Vec3f const n = aNormals[aV];
+		Vec3f const sum{ aSum.x, aSum.y, aSum.z };
+		Vec3f const projected = sum - n * dot( n, sum );
+
+		float const len = length( projected );
+		Vec3f const t = len > 0.f ? projected / len : any_perpendicular_( n );
+		aTangents[aV] = Vec4f{ t.x, t.y, t.z, aSum.w < 0.f ? -1.f : 1.f };
+	} );
+}
@@ -0,0 +1,87 @@
+#ifndef VERTEX_NORMALS_HPP_1E40D83D_70CD_437E_840E_3872D0E088E3
+#define VERTEX_NORMALS_HPP_1E40D83D_70CD_437E_840E_3872D0E088E3
+
+#include <vector>
+
+#include <cstddef>
+#include <cstdint>
+
+#include "vec2.hpp"
+#include "vec3.hpp"
+#include "vec4.hpp"
+
+/** Smooth vertex normals and tangents of indexed triangle meshes
+ *
+ * compute_vertex_normals() sets the normal of each vertex to the normalized
+ * sum of the unit normals of its triangles, each weighted by the angle of
+ * the triangle at the vertex (G. Thuermer and C. A. Wuethrich, "Computing
+ * Vertex Normals from Polygonal Facets", 1998). Unlike area weights, angle weights do not
+ * depend on how a surface is triangulated, so long thin triangles of scans
+ * and terrains do not skew the result.
+ *
+ * compute_vertex_tangents() computes tangents in the manner of MikkTSpace
+ * (M. Mikkelsen, "Simulation of Wrinkled Surfaces Revisited", 2008): per
+ * triangle, the direction in which the first texture coordinate grows, with
+ * the sign of the UV area; per vertex, the angle-weighted sum of those
+ * directions, projected onto the vertex's tangent plane and normalized. The w
+ * component is the handedness, so that the bitangent is
+ *    w * cross( normal, tangent.xyz ).
+ * A shader that reconstructs the bitangent this way matches baked normal
+ * maps. A vertex can only have one handedness, so at a mirrored UV seam,
+ * where triangles of opposite handedness share vertices, the angle-weighted
+ * majority wins and the tangents of the other side are wrong. Welding does
+ * not separate those vertices, since both sides have the same texture
+ * coordinates along the seam. Call split_mirrored_vertices() first, as
+ * MikkTSpace does.
+ *
+ * Both work on a triangle list of aIndexCount indices into aVertexCount
+ * vertices, or on an unindexed list (aIndices null; triangle i is vertices
+ * 3i, 3i+1, 3i+2). The triangles are processed in parallel (see
+ * parallel.hpp), with the corner angles computed by fast_atan2_n(). The
+ * corners are then sorted by vertex (a parallel counting sort), and each
+ * thread sums the contributions of its own vertices' corners with the
+ * active SIMD instruction set (see simd.hpp). The corners of a vertex are
+ * always added in triangle order, so the results do not depend on the
+ * number of threads. The outputs must not alias the inputs.
+ *
+ * Vertices without any non-degenerate triangle get a zero normal, and a
+ * tangent perpendicular to their normal (or the X axis, if the normal is
+ * zero). The same goes for the tangents of vertices whose triangles have no
+ * UV area.
+ *
+ * Example:
+ *    std::vector<Vec3f> normals( positions.size() );
+ *    compute_vertex_normals( indices.size(), indices.data(), positions.size(), positions.data(), normals.data() );
+ */
+void compute_vertex_normals( std::size_t aIndexCount, std::uint32_t const* aIndices, std::size_t aVertexCount, Vec3f const* aPositions, Vec3f* aNormals );
+
+// As compute_vertex_normals(), but stores the angle-weighted sums without
+// normalizing them. The sums of several parts of a mesh (e.g., of tiles that
+// share the vertices along their borders) can then be added up, so that the
+// normalized result is the same as for the whole mesh.
+void compute_vertex_normal_sums( std::size_t aIndexCount, std::uint32_t const* aIndices, std::size_t aVertexCount, Vec3f const* aPositions, Vec3f* aSums );
+
+// aNormals are the (unit) vertex normals, e.g. from compute_vertex_normals().
+void compute_vertex_tangents( std::size_t aIndexCount, std::uint32_t const* aIndices, std::size_t aVertexCount, Vec3f const* aPositions, Vec3f const* aNormals, Vec2f const* aTextcoords, Vec4f* aTangents );
+
+// Splits vertices at mirrored UV seams: each vertex that is used both by
+// triangles with a positive and with a negative UV area gets a copy, and
+// the corners of the negative triangles are moved to it. Copy i is vertex
+// aVertexCount+i; its source vertex is appended to aSources. Returns the
+// number of copies. aIndices must not be null.
+std::size_t split_mirrored_vertices( std::size_t aIndexCount, std::uint32_t* aIndices, std::size_t aVertexCount, Vec2f const* aTextcoords, std::vector<std::uint32_t>& aSources );
+
+// Appends the copies made by split_mirrored_vertices() to a vertex
+// attribute. Empty attributes are left alone.
+template< typename tVertex >
+void append_vertex_copies( std::vector<tVertex>& aVertices, std::vector<std::uint32_t> const& aSources )
+{
+	if( aVertices.empty() )
+		return;
+
+	aVertices.reserve( aVertices.size() + aSources.size() );
+	for( auto const source : aSources )
+		aVertices.push_back( aVertices[source] );
+}
+
+#endif // VERTEX_NORMALS_HPP_1E40D83D_70CD_437E_840E_3872D0E088E3